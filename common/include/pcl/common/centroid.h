@@ -274,6 +274,26 @@ namespace pcl
                                   Eigen::Matrix<Scalar, 4, 1> &centroid);
 
 
+  /** \brief Compute the normalized 3x3 covariance matrix and the centroid of a given set of points in a single,
+    * vectorized loop. Every point is processed as one 4-float packet: its coordinates are taken relative to the
+    * first valid point and multiplied by each of them, which accumulates a row of the second moments together with
+    * the first moment. Shifting the points keeps the float sums small for local neighborhoods, so the result is as
+    * accurate as the two pass computation (see \ref compute3DCentroid and \ref computeCovarianceMatrix) even for
+    * points far away from the origin, which the plain single pass \ref computeMeanAndCovarianceMatrix is not.
+    * \param[in] cloud the input point cloud
+    * \param[in] indices subset of points given by their indices
+    * \param[out] covariance_matrix the resultant 3x3 covariance matrix
+    * \param[out] centroid the centroid of the set of points in the cloud
+    * \return number of valid point used to determine the covariance matrix.
+    * In case of dense point clouds, this is the same as the size of \a indices.
+    * \ingroup common
+    */
+  template <typename PointT> inline unsigned int
+  computeMeanAndCovarianceMatrixVectorized (const pcl::PointCloud<PointT> &cloud,
+                                            const std::vector<int> &indices,
+                                            Eigen::Matrix3f &covariance_matrix,
+                                            Eigen::Vector4f &centroid);
+
   /** \brief Compute the normalized 3x3 covariance matrix for a already demeaned point cloud.
     * Normalized means that every entry has been divided by the number of entries in indices.
     * For small number of points, or if you want explicitely the sample-variance, scale the covariance matrix
@@ -626,6 +626,63 @@ pcl::computeMeanAndCovarianceMatrix (const pcl::PointCloud<PointT> &cloud,
   return (computeMeanAndCovarianceMatrix (cloud, indices.indices, covariance_matrix, centroid));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> inline unsigned int
+pcl::computeMeanAndCovarianceMatrixVectorized (const pcl::PointCloud<PointT> &cloud,
+                                               const std::vector<int> &indices,
+                                               Eigen::Matrix3f &covariance_matrix,
+                                               Eigen::Vector4f &centroid)
+{
+  std::vector<int>::const_iterator iIt = indices.begin ();
+  if (!cloud.is_dense)
+    while (iIt != indices.end () && !isFinite (cloud[*iIt]))
+      ++iIt;
+  if (iIt == indices.end ())
+    return (0);
+
+  // The points are shifted so that their last coordinate becomes 1: p = (x, y, z, 1) - (x0, y0, z0, 0)
+  const Eigen::Array4f mask (1.0f, 1.0f, 1.0f, 0.0f), unit_w (0.0f, 0.0f, 0.0f, 1.0f);
+  const Eigen::Array4f origin = cloud[*iIt].getArray4fMap () * mask;
+
+  // accu_x = sum (p * x) = (xx, xy, xz, x), and likewise for y and z
+  Eigen::Array4f accu_x = Eigen::Array4f::Zero ();
+  Eigen::Array4f accu_y = Eigen::Array4f::Zero ();
+  Eigen::Array4f accu_z = Eigen::Array4f::Zero ();
+  size_t point_count = 0;
+  for (; iIt != indices.end (); ++iIt)
+  {
+    if (!cloud.is_dense && !isFinite (cloud[*iIt]))
+      continue;
+
+    const Eigen::Array4f p = (cloud[*iIt].getArray4fMap () - origin) * mask + unit_w;
+    accu_x += p * p[0];
+    accu_y += p * p[1];
+    accu_z += p * p[2];
+    ++point_count;
+  }
+
+  const float scale = 1.0f / static_cast<float> (point_count);
+  accu_x *= scale;
+  accu_y *= scale;
+  accu_z *= scale;
+
+  centroid[0] = accu_x[3] + origin[0];
+  centroid[1] = accu_y[3] + origin[1];
+  centroid[2] = accu_z[3] + origin[2];
+  centroid[3] = 0;
+  covariance_matrix.coeffRef (0) = accu_x[0] - accu_x[3] * accu_x[3];
+  covariance_matrix.coeffRef (1) = accu_x[1] - accu_x[3] * accu_y[3];
+  covariance_matrix.coeffRef (2) = accu_x[2] - accu_x[3] * accu_z[3];
+  covariance_matrix.coeffRef (4) = accu_y[1] - accu_y[3] * accu_y[3];
+  covariance_matrix.coeffRef (5) = accu_y[2] - accu_y[3] * accu_z[3];
+  covariance_matrix.coeffRef (8) = accu_z[2] - accu_z[3] * accu_z[3];
+  covariance_matrix.coeffRef (3) = covariance_matrix.coeff (1);
+  covariance_matrix.coeffRef (6) = covariance_matrix.coeff (2);
+  covariance_matrix.coeffRef (7) = covariance_matrix.coeff (5);
+
+  return (static_cast<unsigned int> (point_count));
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename Scalar> void
 pcl::demeanPointCloud (ConstCloudIterator<PointT> &cloud_iterator,
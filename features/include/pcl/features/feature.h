@@ -118,6 +118,8 @@ namespace pcl
 
       typedef pcl::PointCloud<PointOutT> PointCloudOut;
 
+      typedef boost::shared_ptr<const pcl::search::Neighborhoods> NeighborhoodsConstPtr;
+
       typedef boost::function<int (size_t, double, std::vector<int> &, std::vector<float> &)> SearchMethod;
       typedef boost::function<int (const PointCloudIn &cloud, size_t index, double, std::vector<int> &, std::vector<float> &)> SearchMethodSurface;
 
@@ -127,7 +129,7 @@ namespace pcl
         feature_name_ (), search_method_surface_ (),
         surface_(), tree_(),
         search_parameter_(0), search_radius_(0), k_(0),
-        fake_surface_(false)
+        fake_surface_(false), neighborhoods_ (), use_neighborhoods_ (false)
       {}
 
       /** \brief Provide a pointer to a dataset to add additional information
@@ -165,6 +167,31 @@ namespace pcl
         return (tree_);
       }
 
+      /** \brief Provide the precomputed neighbors of every point of the input cloud, to be used instead of
+        * searching for them during \ref compute.
+        *
+        * Several features estimated with the same search parameter on the same cloud can then share a
+        * single (batch, parallel) neighbor search:
+        * \code
+        * boost::shared_ptr<pcl::search::Neighborhoods> neighborhoods (new pcl::search::Neighborhoods);
+        * tree->setInputCloud (cloud);
+        * tree->radiusSearch (*cloud, std::vector<int> (), radius, *neighborhoods);
+        * normal_estimation.setSearchNeighborhoods (neighborhoods);
+        * fpfh_estimation.setSearchNeighborhoods (neighborhoods);
+        * \endcode
+        * The neighborhoods must hold one neighbor list per point of the input cloud, in point order, found in
+        * the search surface with the same radius or k as set on this feature. They are only used for the
+        * queries made with that parameter on the input cloud; any other query still goes through the search
+        * method, so passing the same one through \ref setSearchMethod also avoids rebuilding it.
+        * \param[in] neighborhoods the neighbors of the input points, or an empty pointer to search again
+        */
+      inline void
+      setSearchNeighborhoods (const NeighborhoodsConstPtr &neighborhoods) { neighborhoods_ = neighborhoods; }
+
+      /** \brief Get the precomputed neighborhoods of the input points, if any. */
+      inline NeighborhoodsConstPtr
+      getSearchNeighborhoods () const { return (neighborhoods_); }
+
       /** \brief Get the internal search parameter. */
       inline double
       getSearchParameter () const
@@ -257,6 +284,12 @@ namespace pcl
       /** \brief If no surface is given, we use the input PointCloud as the surface. */
       bool fake_surface_;
 
+      /** \brief The precomputed neighbors of every point of the input cloud. */
+      NeighborhoodsConstPtr neighborhoods_;
+
+      /** \brief Whether \a neighborhoods_ matches the input cloud of the current computation. */
+      bool use_neighborhoods_;
+
       /** \brief Search for k-nearest neighbors using the spatial locator from
         * \a setSearchmethod, and the given surface from \a setSearchSurface.
         * \param[in] index the index of the query point
@@ -271,7 +304,7 @@ namespace pcl
       searchForNeighbors (size_t index, double parameter,
                           std::vector<int> &indices, std::vector<float> &distances) const
       {
-        return (search_method_surface_ (*input_, index, parameter, indices, distances));
+        return (searchForNeighbors (*input_, index, parameter, indices, distances));
       }
 
       /** \brief Search for k-nearest neighbors using the spatial locator from
@@ -289,6 +322,13 @@ namespace pcl
       searchForNeighbors (const PointCloudIn &cloud, size_t index, double parameter,
                           std::vector<int> &indices, std::vector<float> &distances) const
       {
+        if (use_neighborhoods_ && &cloud == input_.get () && parameter == search_parameter_)
+        {
+          const size_t begin = neighborhoods_->offsets[index], end = neighborhoods_->offsets[index + 1];
+          indices.assign (neighborhoods_->indices.begin () + begin, neighborhoods_->indices.begin () + end);
+          distances.assign (neighborhoods_->sqr_distances.begin () + begin, neighborhoods_->sqr_distances.begin () + end);
+          return (static_cast<int> (end - begin));
+        }
         return (search_method_surface_ (cloud, index, parameter, indices, distances));
       }
 
@@ -41,6 +41,7 @@
 #define PCL_FPFH_H_
 
 #include <pcl/features/feature.h>
+#include <pcl/features/pfh.h>
 #include <set>
 
 namespace pcl
@@ -94,7 +95,8 @@ namespace pcl
       FPFHEstimation () : 
         nr_bins_f1_ (11), nr_bins_f2_ (11), nr_bins_f3_ (11), 
         hist_f1_ (), hist_f2_ (), hist_f3_ (), fpfh_histogram_ (),
-        d_pi_ (1.0f / (2.0f * static_cast<float> (M_PI)))
+        d_pi_ (1.0f / (2.0f * static_cast<float> (M_PI))),
+        pair_batch_ ()
       {
         feature_name_ = "FPFHEstimation";
       };
@@ -214,6 +216,9 @@ namespace pcl
       /** \brief Float constant = 1.0 / (2.0 * M_PI) */
       float d_pi_; 
 
+      /** \brief Placeholder for the neighbors of a point and their pair features. */
+      PairFeatureBatch pair_batch_;
+
     private:
       /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
         * \param[out] output the output point cloud 
@@ -77,13 +77,18 @@ namespace pcl
       using Feature<PointInT, PointOutT>::indices_;
       using Feature<PointInT, PointOutT>::k_;
       using Feature<PointInT, PointOutT>::search_parameter_;
+      using Feature<PointInT, PointOutT>::search_radius_;
       using Feature<PointInT, PointOutT>::input_;
       using Feature<PointInT, PointOutT>::surface_;
+      using Feature<PointInT, PointOutT>::tree_;
+      using Feature<PointInT, PointOutT>::neighborhoods_;
+      using Feature<PointInT, PointOutT>::use_neighborhoods_;
       using FeatureFromNormals<PointInT, PointNT, PointOutT>::normals_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f1_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f2_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f3_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::weightPointSPFHSignature;
+      using FPFHEstimation<PointInT, PointNT, PointOutT>::d_pi_;
 
       typedef typename Feature<PointInT, PointOutT>::PointCloudOut PointCloudOut;
 
@@ -105,11 +110,40 @@ namespace pcl
       /** \brief Estimate the Fast Point Feature Histograms (FPFH) descriptors at a set of points given by
         * <setInputCloud (), setIndices ()> using the surface in setSearchSurface () and the spatial locator in
         * setSearchMethod ()
+        *
+        * The neighbors of all the query points are searched once, in parallel, and kept for both passes: they give
+        * the SPFH signatures of the query points (when the surface is the input cloud) and then the FPFH ones. The
+        * SPFH signatures are stored in a single contiguous buffer and every thread reuses its own scratch buffers,
+        * so nothing is allocated per point.
         * \param[out] output the resultant point cloud model dataset that contains the FPFH feature estimates
         */
       void 
       computeFeature (PointCloudOut &output);
 
+      /** \brief Estimate the SPFH signature of a surface point, as FPFHEstimation::computePointSPFHSignature does.
+        * \param[in] p_idx the index of the point in the surface
+        * \param[in] indices the indices of its neighbors in the surface
+        * \param[in] nr_indices the number of neighbors
+        * \param[in] pair_batch scratch buffer for the pair features of the calling thread
+        * \param[out] spfh_histogram the zero initialized f1, f2 and f3 histograms, one after the other
+        */
+      void
+      computeSPFHSignature (int p_idx, const int *indices, size_t nr_indices, PairFeatureBatch &pair_batch,
+                            float *spfh_histogram) const;
+
+      /** \brief Combine the SPFH signatures of the neighbors of a query point into its FPFH signature, as
+        * FPFHEstimation::weightPointSPFHSignature does.
+        * \param[in] spfh_histograms the SPFH signatures, one after the other
+        * \param[in] spfh_hist_lookup the position of the SPFH signature of each surface point
+        * \param[in] indices the indices of the neighbors in the surface
+        * \param[in] dists the squared distances to the neighbors
+        * \param[in] nr_indices the number of neighbors
+        * \param[out] fpfh_histogram the resultant FPFH signature
+        */
+      void
+      weightSPFHSignatures (const std::vector<float> &spfh_histograms, const std::vector<int> &spfh_hist_lookup,
+                            const int *indices, const float *dists, size_t nr_indices, float *fpfh_histogram) const;
+
     public:
       /** \brief The number of subdivisions for each angular feature interval. */
       int nr_bins_f1_, nr_bins_f2_, nr_bins_f3_;
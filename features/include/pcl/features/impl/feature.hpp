@@ -167,6 +167,17 @@ pcl::Feature<PointInT, PointOutT>::initCompute ()
       return (false);
     }
   }
+
+  // Use the precomputed neighborhoods only if they hold the neighbors of every input point
+  use_neighborhoods_ = false;
+  if (neighborhoods_)
+  {
+    if (neighborhoods_->size () == input_->points.size ())
+      use_neighborhoods_ = true;
+    else
+      PCL_WARN ("[pcl::%s::compute] The precomputed neighborhoods cover %zu points instead of the %zu input points, searching again.\n",
+                getClassName ().c_str (), neighborhoods_->size (), input_->points.size ());
+  }
   return (true);
 }
 
@@ -180,6 +191,7 @@ pcl::Feature<PointInT, PointOutT>::deinitCompute ()
     surface_.reset ();
     fake_surface_ = false;
   }
+  use_neighborhoods_ = false;
   return (true);
 }
 
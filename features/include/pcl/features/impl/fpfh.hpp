@@ -62,7 +62,6 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computePointSPFHSignature (
     int p_idx, int row, const std::vector<int> &indices,
     Eigen::MatrixXf &hist_f1, Eigen::MatrixXf &hist_f2, Eigen::MatrixXf &hist_f3)
 {
-  Eigen::Vector4f pfh_tuple;
   // Get the number of bins from the histograms size
   int nr_bins_f1 = static_cast<int> (hist_f1.cols ());
   int nr_bins_f2 = static_cast<int> (hist_f2.cols ());
@@ -71,29 +70,28 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computePointSPFHSignature (
   // Factorization constant
   float hist_incr = 100.0f / static_cast<float>(indices.size () - 1);
 
-  // Iterate over all the points in the neighborhood
+  // Compute the pairs P to NNi all at once, minus the query point itself. Degenerate pairs get zero features
+  // and are binned as such, as computePairFeatures never fails here.
+  pair_batch_.clear ();
   for (size_t idx = 0; idx < indices.size (); ++idx)
-  {
-    // Avoid unnecessary returns
-    if (p_idx == indices[idx])
-        continue;
-
-    // Compute the pair P to NNi
-    if (!computePairFeatures (cloud, normals, p_idx, indices[idx], pfh_tuple[0], pfh_tuple[1], pfh_tuple[2], pfh_tuple[3]))
-        continue;
+    if (p_idx != indices[idx])
+      pair_batch_.push_back (cloud.points[indices[idx]], normals.points[indices[idx]]);
+  pair_batch_.compute (cloud.points[p_idx].getVector4fMap (), normals.points[p_idx].getNormalVector4fMap ());
 
+  for (size_t idx = 0; idx < pair_batch_.size (); ++idx)
+  {
     // Normalize the f1, f2, f3 features and push them in the histogram
-    int h_index = static_cast<int> (floor (nr_bins_f1 * ((pfh_tuple[0] + M_PI) * d_pi_)));
+    int h_index = static_cast<int> (floor (nr_bins_f1 * ((pair_batch_.f1[idx] + M_PI) * d_pi_)));
     if (h_index < 0)           h_index = 0;
     if (h_index >= nr_bins_f1) h_index = nr_bins_f1 - 1;
     hist_f1 (row, h_index) += hist_incr;
 
-    h_index = static_cast<int> (floor (nr_bins_f2 * ((pfh_tuple[1] + 1.0) * 0.5)));
+    h_index = static_cast<int> (floor (nr_bins_f2 * ((pair_batch_.f2[idx] + 1.0) * 0.5)));
     if (h_index < 0)           h_index = 0;
     if (h_index >= nr_bins_f2) h_index = nr_bins_f2 - 1;
     hist_f2 (row, h_index) += hist_incr;
 
-    h_index = static_cast<int> (floor (nr_bins_f3 * ((pfh_tuple[2] + 1.0) * 0.5)));
+    h_index = static_cast<int> (floor (nr_bins_f3 * ((pair_batch_.f3[idx] + 1.0) * 0.5)));
     if (h_index < 0)           h_index = 0;
     if (h_index >= nr_bins_f3) h_index = nr_bins_f3 - 1;
     hist_f3 (row, h_index) += hist_incr;
@@ -41,110 +41,213 @@
 #define PCL_FEATURES_IMPL_FPFH_OMP_H_
 
 #include <pcl/features/fpfh_omp.h>
+#include <pcl/features/pfh.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> void
-pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeSPFHSignature (
+    int p_idx, const int *indices, size_t nr_indices, PairFeatureBatch &pair_batch, float *spfh_histogram) const
 {
-  std::vector<int> spfh_indices_vec;
-  std::vector<int> spfh_hist_lookup (surface_->points.size ());
-
-  // Build a list of (unique) indices for which we will need to compute SPFH signatures
-  // (We need an SPFH signature for every point that is a neighbor of any point in input_[indices_])
-  if (surface_ != input_ ||
-      indices_->size () != surface_->points.size ())
-  { 
-    std::vector<int> nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-    std::vector<float> nn_dists (k_); 
-
-    std::set<int> spfh_indices_set;
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
-    {
-      int p_idx = (*indices_)[idx];
-      if (this->searchForNeighbors (p_idx, search_parameter_, nn_indices, nn_dists) == 0)
-        continue;
-      
-      spfh_indices_set.insert (nn_indices.begin (), nn_indices.end ());
-    }
-    spfh_indices_vec.resize (spfh_indices_set.size ());
-    std::copy (spfh_indices_set.begin (), spfh_indices_set.end (), spfh_indices_vec.begin ());
-  }
-  else
+  float *hist_f2 = spfh_histogram + nr_bins_f1_;
+  float *hist_f3 = hist_f2 + nr_bins_f2_;
+
+  // Factorization constant
+  float hist_incr = 100.0f / static_cast<float>(nr_indices - 1);
+
+  // Degenerate pairs are binned with zero features, as in FPFHEstimation
+  pair_batch.clear ();
+  for (size_t idx = 0; idx < nr_indices; ++idx)
+    if (p_idx != indices[idx])
+      pair_batch.push_back (surface_->points[indices[idx]], normals_->points[indices[idx]]);
+  pair_batch.compute (surface_->points[p_idx].getVector4fMap (), normals_->points[p_idx].getNormalVector4fMap ());
+
+  for (size_t idx = 0; idx < pair_batch.size (); ++idx)
   {
-    // Special case: When a feature must be computed at every point, there is no need for a neighborhood search
-    spfh_indices_vec.resize (indices_->size ());
-    for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
-      spfh_indices_vec[idx] = idx;
+    const float f1 = pair_batch.f1[idx], f2 = pair_batch.f2[idx], f3 = pair_batch.f3[idx];
+
+    // Normalize the f1, f2, f3 features and push them in the histogram
+    int h_index = static_cast<int> (floor (nr_bins_f1_ * ((f1 + M_PI) * d_pi_)));
+    if (h_index < 0)            h_index = 0;
+    if (h_index >= nr_bins_f1_) h_index = nr_bins_f1_ - 1;
+    spfh_histogram[h_index] += hist_incr;
+
+    h_index = static_cast<int> (floor (nr_bins_f2_ * ((f2 + 1.0) * 0.5)));
+    if (h_index < 0)            h_index = 0;
+    if (h_index >= nr_bins_f2_) h_index = nr_bins_f2_ - 1;
+    hist_f2[h_index] += hist_incr;
+
+    h_index = static_cast<int> (floor (nr_bins_f3_ * ((f3 + 1.0) * 0.5)));
+    if (h_index < 0)            h_index = 0;
+    if (h_index >= nr_bins_f3_) h_index = nr_bins_f3_ - 1;
+    hist_f3[h_index] += hist_incr;
   }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::weightSPFHSignatures (
+    const std::vector<float> &spfh_histograms, const std::vector<int> &spfh_hist_lookup,
+    const int *indices, const float *dists, size_t nr_indices, float *fpfh_histogram) const
+{
+  const int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
+  const int nr_bins_f12 = nr_bins_f1_ + nr_bins_f2_;
+  double sum_f1 = 0.0, sum_f2 = 0.0, sum_f3 = 0.0;
+
+  std::fill (fpfh_histogram, fpfh_histogram + nr_bins, 0.0f);
+
+  for (size_t idx = 0; idx < nr_indices; ++idx)
+  {
+    // Minus the query point itself
+    if (dists[idx] == 0)
+      continue;
+
+    // Standard weighting function used
+    const float weight = 1.0f / dists[idx];
+    const float *spfh_histogram = &spfh_histograms[static_cast<size_t> (spfh_hist_lookup[indices[idx]]) * nr_bins];
 
-  // Initialize the arrays that will store the SPFH signatures
-  size_t data_size = spfh_indices_vec.size ();
-  hist_f1_.setZero (data_size, nr_bins_f1_);
-  hist_f2_.setZero (data_size, nr_bins_f2_);
-  hist_f3_.setZero (data_size, nr_bins_f3_);
+    // Weight the SPFH of the query point with the SPFH of its neighbors
+    for (int f_i = 0; f_i < nr_bins_f1_; ++f_i)
+    {
+      float val = spfh_histogram[f_i] * weight;
+      sum_f1 += val;
+      fpfh_histogram[f_i] += val;
+    }
+    for (int f_i = nr_bins_f1_; f_i < nr_bins_f12; ++f_i)
+    {
+      float val = spfh_histogram[f_i] * weight;
+      sum_f2 += val;
+      fpfh_histogram[f_i] += val;
+    }
+    for (int f_i = nr_bins_f12; f_i < nr_bins; ++f_i)
+    {
+      float val = spfh_histogram[f_i] * weight;
+      sum_f3 += val;
+      fpfh_histogram[f_i] += val;
+    }
+  }
 
-  std::vector<int> nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-  std::vector<float> nn_dists (k_); 
+  // Histogram values sum up to 100
+  if (sum_f1 != 0)
+    sum_f1 = 100.0 / sum_f1;
+  if (sum_f2 != 0)
+    sum_f2 = 100.0 / sum_f2;
+  if (sum_f3 != 0)
+    sum_f3 = 100.0 / sum_f3;
 
-  // Compute SPFH signatures for every point that needs them
+  for (int f_i = 0; f_i < nr_bins_f1_; ++f_i)
+    fpfh_histogram[f_i] *= static_cast<float> (sum_f1);
+  for (int f_i = nr_bins_f1_; f_i < nr_bins_f12; ++f_i)
+    fpfh_histogram[f_i] *= static_cast<float> (sum_f2);
+  for (int f_i = nr_bins_f12; f_i < nr_bins; ++f_i)
+    fpfh_histogram[f_i] *= static_cast<float> (sum_f3);
+}
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+{
 #ifdef _OPENMP
-#pragma omp parallel for shared (spfh_hist_lookup) private (nn_indices, nn_dists) num_threads(threads_)
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#else
+  const int nr_threads = 1;
 #endif
-  for (int i = 0; i < static_cast<int> (spfh_indices_vec.size ()); ++i)
-  {
-    // Get the next point index
-    int p_idx = spfh_indices_vec[i];
-
-    // Find the neighborhood around p_idx
-    if (this->searchForNeighbors (*surface_, p_idx, search_parameter_, nn_indices, nn_dists) == 0)
-      continue;
+  const int nr_queries = static_cast<int> (indices_->size ());
+  const int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
 
-    // Estimate the SPFH signature around p_idx
-    this->computePointSPFHSignature (*surface_, *normals_, p_idx, i, nn_indices, hist_f1_, hist_f2_, hist_f3_);
+  // Search the neighbors of all the query points at once, unless they were given precomputed. Their lists are
+  // used for the FPFH signatures, and for the SPFH signatures of the query points when surface_ is input_.
+  pcl::search::Neighborhoods query_neighbors;
+  if (!use_neighborhoods_)
+  {
+    if (k_ != 0)
+      tree_->nearestKSearch (*input_, *indices_, k_, query_neighbors, static_cast<unsigned int> (nr_threads));
+    else
+      tree_->radiusSearch (*input_, *indices_, search_radius_, query_neighbors, 0, static_cast<unsigned int> (nr_threads));
+  }
+  // The rows of precomputed neighborhoods are indexed by point, those of query_neighbors by query
+  const pcl::search::Neighborhoods &neighbors = use_neighborhoods_ ? *neighborhoods_ : query_neighbors;
 
-    // Populate a lookup table for converting a point index to its corresponding row in the spfh_hist_* matrices
-    spfh_hist_lookup[p_idx] = i;
+  // Find the row holding the neighbors of each surface point, if any
+  std::vector<int> neighbors_row;
+  if (surface_ == input_)
+  {
+    if (use_neighborhoods_)
+    {
+      neighbors_row.resize (surface_->points.size ());
+      for (int p_idx = 0; p_idx < static_cast<int> (neighbors_row.size ()); ++p_idx)
+        neighbors_row[p_idx] = p_idx;
+    }
+    else
+    {
+      neighbors_row.assign (surface_->points.size (), -1);
+      for (int idx = 0; idx < nr_queries; ++idx)
+        neighbors_row[(*indices_)[idx]] = idx;
+    }
   }
 
-  // Intialize the array that will store the FPFH signature
-  int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
+  // We need an SPFH signature for every point that is a neighbor of any point in input_[indices_]. They are
+  // stored one after the other in a single buffer, and spfh_hist_lookup maps a point index to its signature.
+  std::vector<int> spfh_hist_lookup (surface_->points.size (), -1);
+  for (int idx = 0; idx < nr_queries; ++idx)
+  {
+    const size_t row = use_neighborhoods_ ? (*indices_)[idx] : idx;
+    for (size_t i = neighbors.offsets[row]; i < neighbors.offsets[row + 1]; ++i)
+      spfh_hist_lookup[neighbors.indices[i]] = 0;
+  }
+  std::vector<int> spfh_indices;
+  for (int p_idx = 0; p_idx < static_cast<int> (spfh_hist_lookup.size ()); ++p_idx)
+    if (spfh_hist_lookup[p_idx] == 0)
+    {
+      spfh_hist_lookup[p_idx] = static_cast<int> (spfh_indices.size ());
+      spfh_indices.push_back (p_idx);
+    }
+  std::vector<float> spfh_histograms (spfh_indices.size () * nr_bins, 0.0f);
 
-  nn_indices.clear();
-  nn_dists.clear();
+  // Compute the SPFH signatures, reusing the neighbors of the query points
+  std::vector<int> nn_indices;
+  std::vector<float> nn_dists;
+  PairFeatureBatch pair_batch;
+#ifdef _OPENMP
+#pragma omp parallel for private (nn_indices, nn_dists, pair_batch) num_threads (nr_threads) schedule (dynamic, 64)
+#endif
+  for (int i = 0; i < static_cast<int> (spfh_indices.size ()); ++i)
+  {
+    const int p_idx = spfh_indices[i];
+    const int row = neighbors_row.empty () ? -1 : neighbors_row[p_idx];
+    if (row >= 0)
+    {
+      const size_t begin = neighbors.offsets[row], end = neighbors.offsets[row + 1];
+      if (begin != end)
+        computeSPFHSignature (p_idx, &neighbors.indices[begin], end - begin, pair_batch, &spfh_histograms[static_cast<size_t> (i) * nr_bins]);
+    }
+    else if (this->searchForNeighbors (*surface_, p_idx, search_parameter_, nn_indices, nn_dists) != 0)
+      computeSPFHSignature (p_idx, &nn_indices[0], nn_indices.size (), pair_batch, &spfh_histograms[static_cast<size_t> (i) * nr_bins]);
+  }
 
-  // Iterate over the entire index vector
+  // Compute the FPFH signatures as weighted combinations of the SPFH signatures of the neighbors
 #ifdef _OPENMP
-#pragma omp parallel for shared (output) private (nn_indices, nn_dists) num_threads(threads_)
+#pragma omp parallel for shared (output) num_threads (nr_threads) schedule (dynamic, 64)
 #endif
-  for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
+  for (int idx = 0; idx < nr_queries; ++idx)
   {
-    // Find the indices of point idx's neighbors...
-    if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+    const size_t row = use_neighborhoods_ ? (*indices_)[idx] : idx;
+    const size_t begin = neighbors.offsets[row], end = neighbors.offsets[row + 1];
+    if (!isFinite ((*input_)[(*indices_)[idx]]) || begin == end)
     {
       for (int d = 0; d < nr_bins; ++d)
         output.points[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
-  
+
       output.is_dense = false;
       continue;
     }
 
-
-    // ... and remap the nn_indices values so that they represent row indices in the spfh_hist_* matrices 
-    // instead of indices into surface_->points
-    for (size_t i = 0; i < nn_indices.size (); ++i)
-      nn_indices[i] = spfh_hist_lookup[nn_indices[i]];
-
-    // Compute the FPFH signature (i.e. compute a weighted combination of local SPFH signatures) ...
-    Eigen::VectorXf fpfh_histogram = Eigen::VectorXf::Zero (nr_bins);
-    weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, nn_indices, nn_dists, fpfh_histogram);
-
-    // ...and copy it into the output cloud
-    for (int d = 0; d < nr_bins; ++d)
-      output.points[idx].histogram[d] = fpfh_histogram[d];
+    weightSPFHSignatures (spfh_histograms, spfh_hist_lookup, &neighbors.indices[begin], &neighbors.sqr_distances[begin],
+                          end - begin, output.points[idx].histogram);
   }
-
 }
 
 #define PCL_INSTANTIATE_FPFHEstimationOMP(T,NT,OutT) template class PCL_EXPORTS pcl::FPFHEstimationOMP<T,NT,OutT>;
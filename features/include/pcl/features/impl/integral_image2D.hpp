@@ -40,6 +40,10 @@
 #define PCL_INTEGRAL_IMAGE2D_IMPL_H_
 
 #include <cstddef>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename DataType, unsigned Dimension> void
@@ -52,16 +56,31 @@ pcl::IntegralImage2D<DataType, Dimension>::setSecondOrderComputation (bool compu
 template <typename DataType, unsigned Dimension> void
 pcl::IntegralImage2D<DataType, Dimension>::setInput (const DataType * data, unsigned width,unsigned height, unsigned element_stride, unsigned row_stride)
 {
-  if ((width + 1) * (height + 1) > first_order_integral_image_.size () )
+  width_  = width;
+  height_ = height;
+  const size_t size = (width_ + 1) * (height_ + 1);
+  finite_values_integral_image_.resize (size);
+  if (single_precision_)
   {
-    width_  = width;
-    height_ = height;
-    first_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    finite_values_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+    // release the double precision images, the whole point is to not keep them around
+    std::vector<ElementType, Eigen::aligned_allocator<ElementType> > ().swap (first_order_integral_image_);
+    std::vector<SecondOrderType, Eigen::aligned_allocator<SecondOrderType> > ().swap (second_order_integral_image_);
+    first_order_integral_image_single_.resize (size);
     if (compute_second_order_integral_images_)
-      second_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+      second_order_integral_image_single_.resize (size);
+    computeIntegralImages (data, row_stride, element_stride, &first_order_integral_image_single_[0],
+                           compute_second_order_integral_images_ ? &second_order_integral_image_single_[0] : static_cast<SingleSecondOrderType*> (NULL));
+  }
+  else
+  {
+    std::vector<SingleElementType, Eigen::aligned_allocator<SingleElementType> > ().swap (first_order_integral_image_single_);
+    std::vector<SingleSecondOrderType, Eigen::aligned_allocator<SingleSecondOrderType> > ().swap (second_order_integral_image_single_);
+    first_order_integral_image_.resize (size);
+    if (compute_second_order_integral_images_)
+      second_order_integral_image_.resize (size);
+    computeIntegralImages (data, row_stride, element_stride, &first_order_integral_image_[0],
+                           compute_second_order_integral_images_ ? &second_order_integral_image_[0] : static_cast<SecondOrderType*> (NULL));
   }
-  computeIntegralImages (data, row_stride, element_stride);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -69,13 +88,7 @@ template <typename DataType, unsigned Dimension> typename pcl::IntegralImage2D<D
 pcl::IntegralImage2D<DataType, Dimension>::getFirstOrderSum (
     unsigned start_x, unsigned start_y, unsigned width, unsigned height) const
 {
-  const unsigned upper_left_idx      = start_y * (width_ + 1) + start_x;
-  const unsigned upper_right_idx     = upper_left_idx + width;
-  const unsigned lower_left_idx      = (start_y + height) * (width_ + 1) + start_x;
-  const unsigned lower_right_idx     = lower_left_idx + width;
-
-  return (first_order_integral_image_[lower_right_idx] + first_order_integral_image_[upper_left_idx]  -
-          first_order_integral_image_[upper_right_idx] - first_order_integral_image_[lower_left_idx]  );
+  return (getFirstOrderSumSE (start_x, start_y, start_x + width, start_y + height));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -83,13 +96,7 @@ template <typename DataType, unsigned Dimension> typename pcl::IntegralImage2D<D
 pcl::IntegralImage2D<DataType, Dimension>::getSecondOrderSum (
     unsigned start_x, unsigned start_y, unsigned width, unsigned height) const
 {
-  const unsigned upper_left_idx      = start_y * (width_ + 1) + start_x;
-  const unsigned upper_right_idx     = upper_left_idx + width;
-  const unsigned lower_left_idx      = (start_y + height) * (width_ + 1) + start_x;
-  const unsigned lower_right_idx     = lower_left_idx + width;
-
-  return (second_order_integral_image_[lower_right_idx] + second_order_integral_image_[upper_left_idx]  -
-          second_order_integral_image_[upper_right_idx] - second_order_integral_image_[lower_left_idx]  );
+  return (getSecondOrderSumSE (start_x, start_y, start_x + width, start_y + height));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -97,13 +104,7 @@ template <typename DataType, unsigned Dimension> unsigned
 pcl::IntegralImage2D<DataType, Dimension>::getFiniteElementsCount (
     unsigned start_x, unsigned start_y, unsigned width, unsigned height) const
 {
-  const unsigned upper_left_idx      = start_y * (width_ + 1) + start_x;
-  const unsigned upper_right_idx     = upper_left_idx + width;
-  const unsigned lower_left_idx      = (start_y + height) * (width_ + 1) + start_x;
-  const unsigned lower_right_idx     = lower_left_idx + width;
-
-  return (finite_values_integral_image_[lower_right_idx] + finite_values_integral_image_[upper_left_idx]  -
-          finite_values_integral_image_[upper_right_idx] - finite_values_integral_image_[lower_left_idx]  );
+  return (getFiniteElementsCountSE (start_x, start_y, start_x + width, start_y + height));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -111,11 +112,18 @@ template <typename DataType, unsigned Dimension> typename pcl::IntegralImage2D<D
 pcl::IntegralImage2D<DataType, Dimension>::getFirstOrderSumSE (
     unsigned start_x, unsigned start_y, unsigned end_x, unsigned end_y) const
 {
+  typedef typename IntegralImageTypeTraits<DataType>::IntegralType IntegralType;
   const unsigned upper_left_idx      = start_y * (width_ + 1) + start_x;
   const unsigned upper_right_idx     = start_y * (width_ + 1) + end_x;
   const unsigned lower_left_idx      = end_y * (width_ + 1) + start_x;
   const unsigned lower_right_idx     = end_y * (width_ + 1) + end_x;
 
+  if (single_precision_)
+    return (first_order_integral_image_single_[lower_right_idx].template cast<IntegralType> () +
+            first_order_integral_image_single_[upper_left_idx].template cast<IntegralType> () -
+            first_order_integral_image_single_[upper_right_idx].template cast<IntegralType> () -
+            first_order_integral_image_single_[lower_left_idx].template cast<IntegralType> ());
+
   return (first_order_integral_image_[lower_right_idx] + first_order_integral_image_[upper_left_idx]  -
           first_order_integral_image_[upper_right_idx] - first_order_integral_image_[lower_left_idx]  );
 }
@@ -125,11 +133,18 @@ template <typename DataType, unsigned Dimension> typename pcl::IntegralImage2D<D
 pcl::IntegralImage2D<DataType, Dimension>::getSecondOrderSumSE (
     unsigned start_x, unsigned start_y, unsigned end_x, unsigned end_y) const
 {
+  typedef typename IntegralImageTypeTraits<DataType>::IntegralType IntegralType;
   const unsigned upper_left_idx      = start_y * (width_ + 1) + start_x;
   const unsigned upper_right_idx     = start_y * (width_ + 1) + end_x;
   const unsigned lower_left_idx      = end_y * (width_ + 1) + start_x;
   const unsigned lower_right_idx     = end_y * (width_ + 1) + end_x;
 
+  if (single_precision_)
+    return (second_order_integral_image_single_[lower_right_idx].template cast<IntegralType> () +
+            second_order_integral_image_single_[upper_left_idx].template cast<IntegralType> () -
+            second_order_integral_image_single_[upper_right_idx].template cast<IntegralType> () -
+            second_order_integral_image_single_[lower_left_idx].template cast<IntegralType> ());
+
   return (second_order_integral_image_[lower_right_idx] + second_order_integral_image_[upper_left_idx]  -
           second_order_integral_image_[upper_right_idx] - second_order_integral_image_[lower_left_idx]  );
 }
@@ -149,70 +164,89 @@ pcl::IntegralImage2D<DataType, Dimension>::getFiniteElementsCountSE (
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-template <typename DataType, unsigned Dimension> void
+template <typename DataType, unsigned Dimension> template <typename FirstOrderT, typename SecondOrderT> void
 pcl::IntegralImage2D<DataType, Dimension>::computeIntegralImages (
-    const DataType *data, unsigned row_stride, unsigned element_stride)
+    const DataType *data, unsigned row_stride, unsigned element_stride,
+    FirstOrderT *first_order, SecondOrderT *second_order)
 {
-  ElementType* previous_row = &first_order_integral_image_[0];
-  ElementType* current_row  = previous_row + (width_ + 1);
-  memset (previous_row, 0, sizeof (ElementType) * (width_ + 1));
-
-  unsigned* count_previous_row = &finite_values_integral_image_[0];
-  unsigned* count_current_row  = count_previous_row + (width_ + 1);
-  memset (count_previous_row, 0, sizeof (unsigned) * (width_ + 1));
+  typedef typename IntegralImageTypeTraits<DataType>::IntegralType IntegralType;
+  typedef typename FirstOrderT::Scalar FirstOrderScalar;
+  typedef typename SecondOrderT::Scalar SecondOrderScalar;
+
+  const unsigned stride = width_ + 1;
+  const int height = static_cast<int> (height_);
+  // width of the column blocks of the second pass: two rows of a block stay in L1
+  const int block_width = 64;
+  const int nr_blocks = (static_cast<int> (stride) + block_width - 1) / block_width;
+  unsigned* count = &finite_values_integral_image_[0];
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
+  for (unsigned colIdx = 0; colIdx < stride; ++colIdx)
+  {
+    first_order [colIdx].setZero ();
+    count [colIdx] = 0;
+    if (second_order)
+      second_order [colIdx].setZero ();
+  }
 
-  if (!compute_second_order_integral_images_)
+  // first pass: the rows are independent prefix sums, accumulated in the integral type
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+  for (int rowIdx = 0; rowIdx < height; ++rowIdx)
   {
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1))
+    const DataType* row_data = data + rowIdx * row_stride;
+    const unsigned offset = (rowIdx + 1) * stride;
+    FirstOrderT* current_row = first_order + offset;
+    SecondOrderT* so_current_row = second_order ? second_order + offset : NULL;
+    unsigned* count_current_row = count + offset;
+
+    ElementType sum = ElementType::Zero ();
+    SecondOrderType so_sum = SecondOrderType::Zero ();
+    unsigned finite_count = 0;
+
+    current_row [0].setZero ();
+    count_current_row [0] = 0;
+    if (so_current_row)
+      so_current_row [0].setZero ();
+    for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
     {
-      current_row [0].setZero ();
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      const InputType* element = reinterpret_cast <const InputType*> (&row_data [valIdx]);
+      if (pcl_isfinite (element->sum ()))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        const InputType* element = reinterpret_cast <const InputType*> (&data [valIdx]);
-        if (pcl_isfinite (element->sum ()))
+        sum += element->template cast<IntegralType> ();
+        ++finite_count;
+        if (so_current_row)
         {
-          current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
-          ++(count_current_row [colIdx + 1]);
+          for (unsigned myIdx = 0, elIdx = 0; myIdx < Dimension; ++myIdx)
+            for (unsigned mxIdx = myIdx; mxIdx < Dimension; ++mxIdx, ++elIdx)
+              so_sum [elIdx] += (*element)[myIdx] * (*element)[mxIdx];
         }
       }
+      current_row [colIdx + 1] = sum.template cast<FirstOrderScalar> ();
+      count_current_row [colIdx + 1] = finite_count;
+      if (so_current_row)
+        so_current_row [colIdx + 1] = so_sum.template cast<SecondOrderScalar> ();
     }
   }
-  else
+
+  // second pass: add up the row sums down each block of columns
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+  for (int blockIdx = 0; blockIdx < nr_blocks; ++blockIdx)
   {
-    SecondOrderType* so_previous_row = &second_order_integral_image_[0];
-    SecondOrderType* so_current_row  = so_previous_row + (width_ + 1);
-    memset (so_previous_row, 0, sizeof (SecondOrderType) * (width_ + 1));
-
-    SecondOrderType so_element;
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1),
-                                                so_previous_row = so_current_row, so_current_row += (width_ + 1))
+    const unsigned begin = blockIdx * block_width;
+    const unsigned end = std::min (begin + block_width, stride);
+    for (unsigned rowIdx = 2; rowIdx <= height_; ++rowIdx)
     {
-      current_row [0].setZero ();
-      so_current_row [0].setZero ();
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      const unsigned offset = rowIdx * stride;
+      for (unsigned colIdx = begin; colIdx < end; ++colIdx)
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-
-        const InputType* element = reinterpret_cast <const InputType*> (&data [valIdx]);
-        if (pcl_isfinite (element->sum ()))
-        {
-          current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
-          ++(count_current_row [colIdx + 1]);
-          for (unsigned myIdx = 0, elIdx = 0; myIdx < Dimension; ++myIdx)
-            for (unsigned mxIdx = myIdx; mxIdx < Dimension; ++mxIdx, ++elIdx)
-              so_current_row [colIdx + 1][elIdx] += (*element)[myIdx] * (*element)[mxIdx];
-        }
+        first_order [offset + colIdx] += first_order [offset - stride + colIdx];
+        count [offset + colIdx] += count [offset - stride + colIdx];
       }
+      if (second_order)
+        for (unsigned colIdx = begin; colIdx < end; ++colIdx)
+          second_order [offset + colIdx] += second_order [offset - stride + colIdx];
     }
   }
 }
@@ -222,16 +256,30 @@ pcl::IntegralImage2D<DataType, Dimension>::computeIntegralImages (
 template <typename DataType> void
 pcl::IntegralImage2D<DataType, 1>::setInput (const DataType * data, unsigned width,unsigned height, unsigned element_stride, unsigned row_stride)
 {
-  if ((width + 1) * (height + 1) > first_order_integral_image_.size () )
+  width_  = width;
+  height_ = height;
+  const size_t size = (width_ + 1) * (height_ + 1);
+  finite_values_integral_image_.resize (size);
+  if (single_precision_)
+  {
+    std::vector<ElementType, Eigen::aligned_allocator<ElementType> > ().swap (first_order_integral_image_);
+    std::vector<SecondOrderType, Eigen::aligned_allocator<SecondOrderType> > ().swap (second_order_integral_image_);
+    first_order_integral_image_single_.resize (size);
+    if (compute_second_order_integral_images_)
+      second_order_integral_image_single_.resize (size);
+    computeIntegralImages (data, row_stride, element_stride, &first_order_integral_image_single_[0],
+                           compute_second_order_integral_images_ ? &second_order_integral_image_single_[0] : static_cast<SingleSecondOrderType*> (NULL));
+  }
+  else
   {
-    width_  = width;
-    height_ = height;
-    first_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    finite_values_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+    std::vector<SingleElementType, Eigen::aligned_allocator<SingleElementType> > ().swap (first_order_integral_image_single_);
+    std::vector<SingleSecondOrderType, Eigen::aligned_allocator<SingleSecondOrderType> > ().swap (second_order_integral_image_single_);
+    first_order_integral_image_.resize (size);
     if (compute_second_order_integral_images_)
-      second_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+      second_order_integral_image_.resize (size);
+    computeIntegralImages (data, row_stride, element_stride, &first_order_integral_image_[0],
+                           compute_second_order_integral_images_ ? &second_order_integral_image_[0] : static_cast<SecondOrderType*> (NULL));
   }
-  computeIntegralImages (data, row_stride, element_stride);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -239,13 +287,7 @@ template <typename DataType> typename pcl::IntegralImage2D<DataType, 1>::Element
 pcl::IntegralImage2D<DataType, 1>::getFirstOrderSum (
     unsigned start_x, unsigned start_y, unsigned width, unsigned height) const
 {
-  const unsigned upper_left_idx      = start_y * (width_ + 1) + start_x;
-  const unsigned upper_right_idx     = upper_left_idx + width;
-  const unsigned lower_left_idx      = (start_y + height) * (width_ + 1) + start_x;
-  const unsigned lower_right_idx     = lower_left_idx + width;
-
-  return (first_order_integral_image_[lower_right_idx] + first_order_integral_image_[upper_left_idx]  -
-          first_order_integral_image_[upper_right_idx] - first_order_integral_image_[lower_left_idx]  );
+  return (getFirstOrderSumSE (start_x, start_y, start_x + width, start_y + height));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -253,13 +295,7 @@ template <typename DataType> typename pcl::IntegralImage2D<DataType, 1>::SecondO
 pcl::IntegralImage2D<DataType, 1>::getSecondOrderSum (
     unsigned start_x, unsigned start_y, unsigned width, unsigned height) const
 {
-  const unsigned upper_left_idx      = start_y * (width_ + 1) + start_x;
-  const unsigned upper_right_idx     = upper_left_idx + width;
-  const unsigned lower_left_idx      = (start_y + height) * (width_ + 1) + start_x;
-  const unsigned lower_right_idx     = lower_left_idx + width;
-
-  return (second_order_integral_image_[lower_right_idx] + second_order_integral_image_[upper_left_idx]  -
-          second_order_integral_image_[upper_right_idx] - second_order_integral_image_[lower_left_idx]  );
+  return (getSecondOrderSumSE (start_x, start_y, start_x + width, start_y + height));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -267,13 +303,7 @@ template <typename DataType> unsigned
 pcl::IntegralImage2D<DataType, 1>::getFiniteElementsCount (
     unsigned start_x, unsigned start_y, unsigned width, unsigned height) const
 {
-  const unsigned upper_left_idx      = start_y * (width_ + 1) + start_x;
-  const unsigned upper_right_idx     = upper_left_idx + width;
-  const unsigned lower_left_idx      = (start_y + height) * (width_ + 1) + start_x;
-  const unsigned lower_right_idx     = lower_left_idx + width;
-
-  return (finite_values_integral_image_[lower_right_idx] + finite_values_integral_image_[upper_left_idx]  -
-          finite_values_integral_image_[upper_right_idx] - finite_values_integral_image_[lower_left_idx]  );
+  return (getFiniteElementsCountSE (start_x, start_y, start_x + width, start_y + height));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -286,6 +316,12 @@ pcl::IntegralImage2D<DataType, 1>::getFirstOrderSumSE (
   const unsigned lower_left_idx      = end_y * (width_ + 1) + start_x;
   const unsigned lower_right_idx     = end_y * (width_ + 1) + end_x;
 
+  if (single_precision_)
+    return (static_cast<ElementType> (first_order_integral_image_single_[lower_right_idx]) +
+            static_cast<ElementType> (first_order_integral_image_single_[upper_left_idx]) -
+            static_cast<ElementType> (first_order_integral_image_single_[upper_right_idx]) -
+            static_cast<ElementType> (first_order_integral_image_single_[lower_left_idx]));
+
   return (first_order_integral_image_[lower_right_idx] + first_order_integral_image_[upper_left_idx]  -
           first_order_integral_image_[upper_right_idx] - first_order_integral_image_[lower_left_idx]  );
 }
@@ -300,6 +336,12 @@ pcl::IntegralImage2D<DataType, 1>::getSecondOrderSumSE (
   const unsigned lower_left_idx      = end_y * (width_ + 1) + start_x;
   const unsigned lower_right_idx     = end_y * (width_ + 1) + end_x;
 
+  if (single_precision_)
+    return (static_cast<SecondOrderType> (second_order_integral_image_single_[lower_right_idx]) +
+            static_cast<SecondOrderType> (second_order_integral_image_single_[upper_left_idx]) -
+            static_cast<SecondOrderType> (second_order_integral_image_single_[upper_right_idx]) -
+            static_cast<SecondOrderType> (second_order_integral_image_single_[lower_left_idx]));
+
   return (second_order_integral_image_[lower_right_idx] + second_order_integral_image_[upper_left_idx]  -
           second_order_integral_image_[upper_right_idx] - second_order_integral_image_[lower_left_idx]  );
 }
@@ -319,66 +361,77 @@ pcl::IntegralImage2D<DataType, 1>::getFiniteElementsCountSE (
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-template <typename DataType> void
+template <typename DataType> template <typename FirstOrderT, typename SecondOrderT> void
 pcl::IntegralImage2D<DataType, 1>::computeIntegralImages (
-    const DataType *data, unsigned row_stride, unsigned element_stride)
+    const DataType *data, unsigned row_stride, unsigned element_stride,
+    FirstOrderT *first_order, SecondOrderT *second_order)
 {
-  ElementType* previous_row = &first_order_integral_image_[0];
-  ElementType* current_row  = previous_row + (width_ + 1);
-  memset (previous_row, 0, sizeof (ElementType) * (width_ + 1));
-
-  unsigned* count_previous_row = &finite_values_integral_image_[0];
-  unsigned* count_current_row  = count_previous_row + (width_ + 1);
-  memset (count_previous_row, 0, sizeof (unsigned) * (width_ + 1));
-
-  if (!compute_second_order_integral_images_)
+  const unsigned stride = width_ + 1;
+  const int height = static_cast<int> (height_);
+  // width of the column blocks of the second pass: two rows of a block stay in L1
+  const int block_width = 64;
+  const int nr_blocks = (static_cast<int> (stride) + block_width - 1) / block_width;
+  unsigned* count = &finite_values_integral_image_[0];
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
+  memset (first_order, 0, sizeof (FirstOrderT) * stride);
+  memset (count, 0, sizeof (unsigned) * stride);
+  if (second_order)
+    memset (second_order, 0, sizeof (SecondOrderT) * stride);
+
+  // first pass: the rows are independent prefix sums, accumulated in the integral type
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+  for (int rowIdx = 0; rowIdx < height; ++rowIdx)
   {
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1))
+    const DataType* row_data = data + rowIdx * row_stride;
+    const unsigned offset = (rowIdx + 1) * stride;
+    FirstOrderT* current_row = first_order + offset;
+    SecondOrderT* so_current_row = second_order ? second_order + offset : NULL;
+    unsigned* count_current_row = count + offset;
+
+    ElementType sum = 0;
+    SecondOrderType so_sum = 0;
+    unsigned finite_count = 0;
+
+    current_row [0] = 0;
+    count_current_row [0] = 0;
+    if (so_current_row)
+      so_current_row [0] = 0;
+    for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
     {
-      current_row [0] = 0.0;
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      if (pcl_isfinite (row_data [valIdx]))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        if (pcl_isfinite (data [valIdx]))
-        {
-          current_row [colIdx + 1] += data [valIdx];
-          ++(count_current_row [colIdx + 1]);
-        }
+        sum += row_data [valIdx];
+        so_sum += row_data [valIdx] * row_data [valIdx];
+        ++finite_count;
       }
+      current_row [colIdx + 1] = static_cast<FirstOrderT> (sum);
+      count_current_row [colIdx + 1] = finite_count;
+      if (so_current_row)
+        so_current_row [colIdx + 1] = static_cast<SecondOrderT> (so_sum);
     }
   }
-  else
+
+  // second pass: add up the row sums down each block of columns
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+  for (int blockIdx = 0; blockIdx < nr_blocks; ++blockIdx)
   {
-    SecondOrderType* so_previous_row = &second_order_integral_image_[0];
-    SecondOrderType* so_current_row  = so_previous_row + (width_ + 1);
-    memset (so_previous_row, 0, sizeof (SecondOrderType) * (width_ + 1));
-
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1),
-                                                so_previous_row = so_current_row, so_current_row += (width_ + 1))
+    const unsigned begin = blockIdx * block_width;
+    const unsigned end = std::min (begin + block_width, stride);
+    for (unsigned rowIdx = 2; rowIdx <= height_; ++rowIdx)
     {
-      current_row [0] = 0.0;
-      so_current_row [0] = 0.0;
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      const unsigned offset = rowIdx * stride;
+      for (unsigned colIdx = begin; colIdx < end; ++colIdx)
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        if (pcl_isfinite (data[valIdx]))
-        {
-          current_row [colIdx + 1] += data[valIdx];
-          so_current_row [colIdx + 1] += data[valIdx] * data[valIdx];
-          ++(count_current_row [colIdx + 1]);
-        }
+        first_order [offset + colIdx] += first_order [offset - stride + colIdx];
+        count [offset + colIdx] += count [offset - stride + colIdx];
       }
+      if (second_order)
+        for (unsigned colIdx = begin; colIdx < end; ++colIdx)
+          second_order [offset + colIdx] += second_order [offset - stride + colIdx];
     }
   }
 }
 #endif    // PCL_INTEGRAL_IMAGE2D_IMPL_H_
-
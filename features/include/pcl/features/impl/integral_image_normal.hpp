@@ -39,6 +39,9 @@
 #include <pcl/features/boost.h>
 #include <pcl/features/integral_image_normal.h>
 #include <pcl/features/normal_3d.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT>
@@ -111,6 +114,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initSimple3DGradientMet
   const float *data_ = reinterpret_cast<const float*> (&input_->points[0]);
 
   integral_image_XYZ_.setSecondOrderComputation (false);
+  integral_image_XYZ_.setNumberOfThreads (threads_);
+  integral_image_XYZ_.setSinglePrecision (use_single_precision_);
   integral_image_XYZ_.setInput (data_, input_->width, input_->height, element_stride, row_stride);
 
   init_simple_3d_gradient_ = true;
@@ -129,6 +134,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initCovarianceMatrixMet
   const float *data_ = reinterpret_cast<const float*> (&input_->points[0]);
 
   integral_image_XYZ_.setSecondOrderComputation (true);
+  integral_image_XYZ_.setNumberOfThreads (threads_);
+  integral_image_XYZ_.setSinglePrecision (use_single_precision_);
   integral_image_XYZ_.setInput (data_, input_->width, input_->height, element_stride, row_stride);
 
   init_covariance_matrix_ = true;
@@ -146,26 +153,27 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverage3DGradientMe
   memset (diff_x_, 0, sizeof(float) * data_size);
   memset (diff_y_, 0, sizeof(float) * data_size);
 
+  const int width = static_cast<int> (input_->width);
+  const int height = static_cast<int> (input_->height);
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
   // x u x
   // l x r
   // x d x
-  const PointInT* point_up = &(input_->points [1]);
-  const PointInT* point_dn = point_up + (input_->width << 1);//&(input_->points [1 + (input_->width << 1)]);
-  const PointInT* point_lf = &(input_->points [input_->width]);
-  const PointInT* point_rg = point_lf + 2; //&(input_->points [input_->width + 2]);
-  float* diff_x_ptr = diff_x_ + ((input_->width + 1) << 2);
-  float* diff_y_ptr = diff_y_ + ((input_->width + 1) << 2);
-  unsigned diff_skip = 8; // skip last element in row and the first in the next row
-
-  for (size_t ri = 1; ri < input_->height - 1; ++ri
-                                             , point_up += input_->width
-                                             , point_dn += input_->width
-                                             , point_lf += input_->width
-                                             , point_rg += input_->width
-                                             , diff_x_ptr += diff_skip
-                                             , diff_y_ptr += diff_skip)
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+  for (int ri = 1; ri < height - 1; ++ri)
   {
-    for (size_t ci = 0; ci < input_->width - 2; ++ci, diff_x_ptr += 4, diff_y_ptr += 4)
+    const PointInT* point_up = &(input_->points [(ri - 1) * width + 1]);
+    const PointInT* point_dn = &(input_->points [(ri + 1) * width + 1]);
+    const PointInT* point_lf = &(input_->points [ri * width]);
+    const PointInT* point_rg = point_lf + 2;
+    // the first and last element of each row stay zero
+    float* diff_x_ptr = diff_x_ + ((ri * width + 1) << 2);
+    float* diff_y_ptr = diff_y_ + ((ri * width + 1) << 2);
+
+    for (int ci = 0; ci < width - 2; ++ci, diff_x_ptr += 4, diff_y_ptr += 4)
     {
       diff_x_ptr[0] = point_rg[ci].x - point_lf[ci].x;
       diff_x_ptr[1] = point_rg[ci].y - point_lf[ci].y;
@@ -178,6 +186,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverage3DGradientMe
   }
 
   // Compute integral images
+  integral_image_DX_.setNumberOfThreads (threads_);
+  integral_image_DX_.setSinglePrecision (use_single_precision_);
+  integral_image_DY_.setNumberOfThreads (threads_);
+  integral_image_DY_.setSinglePrecision (use_single_precision_);
   integral_image_DX_.setInput (diff_x_, input_->width, input_->height, 4, input_->width << 2);
   integral_image_DY_.setInput (diff_y_, input_->width, input_->height, 4, input_->width << 2);
   init_covariance_matrix_ = init_depth_change_ = init_simple_3d_gradient_ = false;
@@ -196,6 +208,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverageDepthChangeM
   const float *data_ = reinterpret_cast<const float*> (&input_->points[0]);
 
   // integral image over the z - value
+  integral_image_depth_.setNumberOfThreads (threads_);
+  integral_image_depth_.setSinglePrecision (use_single_precision_);
   integral_image_depth_.setInput (&(data_[2]), input_->width, input_->height, element_stride, row_stride);
   init_depth_change_ = true;
   init_covariance_matrix_ = init_average_3d_gradient_ = init_simple_3d_gradient_ = false;
@@ -203,17 +217,46 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverageDepthChangeM
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
-pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
-    const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initCurrentMethod ()
 {
-  float bad_point = std::numeric_limits<float>::quiet_NaN ();
-
   if (normal_estimation_method_ == COVARIANCE_MATRIX)
   {
     if (!init_covariance_matrix_)
       initCovarianceMatrixMethod ();
+  }
+  else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT)
+  {
+    if (!init_average_3d_gradient_)
+      initAverage3DGradientMethod ();
+  }
+  else if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE)
+  {
+    if (!init_depth_change_)
+      initAverageDepthChangeMethod ();
+  }
+  else if (normal_estimation_method_ == SIMPLE_3D_GRADIENT)
+  {
+    if (!init_simple_3d_gradient_)
+      initSimple3DGradientMethod ();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
+    const int pos_x, const int pos_y, const int rect_width, const int rect_height,
+    const unsigned point_index, PointOutT &normal) const
+{
+  const int rect_width_2 = rect_width / 2;
+  const int rect_width_4 = rect_width / 4;
+  const int rect_height_2 = rect_height / 2;
+  const int rect_height_4 = rect_height / 4;
 
-    unsigned count = integral_image_XYZ_.getFiniteElementsCount (pos_x - (rect_width_2_), pos_y - (rect_height_2_), rect_width_, rect_height_);
+  float bad_point = std::numeric_limits<float>::quiet_NaN ();
+
+  if (normal_estimation_method_ == COVARIANCE_MATRIX)
+  {
+    unsigned count = integral_image_XYZ_.getFiniteElementsCount (pos_x - (rect_width_2), pos_y - (rect_height_2), rect_width, rect_height);
 
     // no valid points within the rectangular reagion?
     if (count == 0)
@@ -225,8 +268,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
     EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
     Eigen::Vector3f center;
     typename IntegralImage2D<float, 3>::SecondOrderType so_elements;
-    center = integral_image_XYZ_.getFirstOrderSum(pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_).template cast<float> ();
-    so_elements = integral_image_XYZ_.getSecondOrderSum(pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    center = integral_image_XYZ_.getFirstOrderSum(pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height).template cast<float> ();
+    so_elements = integral_image_XYZ_.getSecondOrderSum(pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     covariance_matrix.coeffRef (0) = static_cast<float> (so_elements [0]);
     covariance_matrix.coeffRef (1) = covariance_matrix.coeffRef (3) = static_cast<float> (so_elements [1]);
@@ -252,18 +295,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT)
   {
-    if (!init_average_3d_gradient_)
-      initAverage3DGradientMethod ();
-
-    unsigned count_x = integral_image_DX_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    unsigned count_y = integral_image_DY_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    unsigned count_x = integral_image_DX_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    unsigned count_y = integral_image_DY_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
     if (count_x == 0 || count_y == 0)
     {
       normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = std::numeric_limits<float>::quiet_NaN ();
       return;
     }
-    Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
     double normal_length = normal_vector.squaredNorm ();
@@ -291,25 +331,22 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   else if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE)
   {
-    if (!init_depth_change_)
-      initAverageDepthChangeMethod ();
-
-//    unsigned count = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+//    unsigned count = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 //    if (count == 0)
 //    {
 //      normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = std::numeric_limits<float>::quiet_NaN ();
 //      return;
 //    }
-//    const float mean_L_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_ - 1, pos_y - rect_height_2_    , rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_R_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_ + 1, pos_y - rect_height_2_    , rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_U_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_    , pos_y - rect_height_2_ - 1, rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_D_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_    , pos_y - rect_height_2_ + 1, rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
+//    const float mean_L_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2 - 1, pos_y - rect_height_2    , rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_R_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2 + 1, pos_y - rect_height_2    , rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_U_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2    , pos_y - rect_height_2 - 1, rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_D_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2    , pos_y - rect_height_2 + 1, rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
 
     // width and height are at least 3 x 3
-    unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_);
-    unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_);
+    unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2);
+    unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2);
+    unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2);
+    unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2);
 
     if (count_L_z == 0 || count_R_z == 0 || count_U_z == 0 || count_D_z == 0)
     {
@@ -317,15 +354,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
       return;
     }
 
-    float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_L_z);
-    float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_R_z);
-    float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_) / count_U_z);
-    float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_) / count_D_z);
+    float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2) / count_L_z);
+    float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2) / count_R_z);
+    float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2) / count_U_z);
+    float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2) / count_D_z);
 
-    PointInT pointL = input_->points[point_index - rect_width_4_ - 1];
-    PointInT pointR = input_->points[point_index + rect_width_4_ + 1];
-    PointInT pointU = input_->points[point_index - rect_height_4_ * input_->width - 1];
-    PointInT pointD = input_->points[point_index + rect_height_4_ * input_->width + 1];
+    PointInT pointL = input_->points[point_index - rect_width_4 - 1];
+    PointInT pointR = input_->points[point_index + rect_width_4 + 1];
+    PointInT pointU = input_->points[point_index - rect_height_4 * input_->width - 1];
+    PointInT pointD = input_->points[point_index + rect_height_4 * input_->width + 1];
 
     const float mean_x_z = mean_R_z - mean_L_z;
     const float mean_y_z = mean_D_z - mean_U_z;
@@ -361,15 +398,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   else if (normal_estimation_method_ == SIMPLE_3D_GRADIENT)
   {
-    if (!init_simple_3d_gradient_)
-      initSimple3DGradientMethod ();
-
     // this method does not work if lots of NaNs are in the neighborhood of the point
-    Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2_, pos_y - rect_height_2_, 1, rect_height_) -
-                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, 1, rect_height_);
+    Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2, pos_y - rect_height_2, 1, rect_height) -
+                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, 1, rect_height);
 
-    Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y + rect_height_2_, rect_width_, 1) -
-                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, 1);
+    Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y + rect_height_2, rect_width, 1) -
+                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, 1);
     Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
     double normal_length = normal_vector.squaredNorm ();
     if (normal_length == 0.0f)
@@ -400,6 +434,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   return;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
+    const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
+{
+  initCurrentMethod ();
+  computePointNormal (pos_x, pos_y, rect_width_, rect_height_, point_index, normal);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename T>
 void
@@ -501,8 +544,14 @@ sumArea (int start_x, int start_y, int end_x, int end_y, const int width, const
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirror (
-    const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
+    const int pos_x, const int pos_y, const int rect_width, const int rect_height,
+    const unsigned point_index, PointOutT &normal) const
 {
+  const int rect_width_2 = rect_width / 2;
+  const int rect_width_4 = rect_width / 4;
+  const int rect_height_2 = rect_height / 2;
+  const int rect_height_4 = rect_height / 4;
+
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
   const int width = input_->width;
@@ -510,13 +559,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
 
   if (normal_estimation_method_ == COVARIANCE_MATRIX) // ==============================================================
   {
-    if (!init_covariance_matrix_)
-      initCovarianceMatrixMethod ();
-
-    const int start_x = pos_x - rect_width_2_;
-    const int start_y = pos_y - rect_height_2_;
-    const int end_x = start_x + rect_width_;
-    const int end_y = start_y + rect_height_;
+    const int start_x = pos_x - rect_width_2;
+    const int start_y = pos_y - rect_height_2;
+    const int end_x = start_x + rect_width;
+    const int end_y = start_y + rect_height;
 
     unsigned count = 0;
     sumArea<unsigned>(start_x, start_y, end_x, end_y, width, height, boost::bind(&IntegralImage2D<float, 3>::getFiniteElementsCountSE, &integral_image_XYZ_, _1, _2, _3, _4), count);
@@ -578,13 +624,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
   }
   else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT) // =======================================================
   {
-    if (!init_average_3d_gradient_)
-      initAverage3DGradientMethod ();
-
-    const int start_x = pos_x - rect_width_2_;
-    const int start_y = pos_y - rect_height_2_;
-    const int end_x = start_x + rect_width_;
-    const int end_y = start_y + rect_height_;
+    const int start_x = pos_x - rect_width_2;
+    const int start_y = pos_y - rect_height_2;
+    const int end_x = start_x + rect_width;
+    const int end_y = start_y + rect_height;
 
     unsigned count_x = 0;
     unsigned count_y = 0;
@@ -598,8 +641,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
       normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = std::numeric_limits<float>::quiet_NaN ();
       return;
     }
-    //Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    //Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    //Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    //Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     Eigen::Vector3d gradient_x (0, 0, 0);
     Eigen::Vector3d gradient_y (0, 0, 0);
@@ -634,22 +677,19 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
   }
   else if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE) // ======================================================
   {
-    if (!init_depth_change_)
-      initAverageDepthChangeMethod ();
-
-    //const size_t point_index_L = point_index - rect_width_4_ - 1;
-    //const size_t point_index_R = point_index + rect_width_4_ + 1;
-    //const size_t point_index_U = point_index - rect_height_4_ * width - 1;
-    //const size_t point_index_D = point_index + rect_height_4_ * width + 1;
+    //const size_t point_index_L = point_index - rect_width_4 - 1;
+    //const size_t point_index_R = point_index + rect_width_4 + 1;
+    //const size_t point_index_U = point_index - rect_height_4 * width - 1;
+    //const size_t point_index_D = point_index + rect_height_4 * width + 1;
 
-    int point_index_L_x = pos_x - rect_width_4_ - 1;
+    int point_index_L_x = pos_x - rect_width_4 - 1;
     int point_index_L_y = pos_y;
-    int point_index_R_x = pos_x + rect_width_4_ + 1;
+    int point_index_R_x = pos_x + rect_width_4 + 1;
     int point_index_R_y = pos_y;
     int point_index_U_x = pos_x - 1;
-    int point_index_U_y = pos_y - rect_height_4_;
+    int point_index_U_y = pos_y - rect_height_4;
     int point_index_D_x = pos_x + 1;
-    int point_index_D_y = pos_y + rect_height_4_;
+    int point_index_D_y = pos_y + rect_height_4;
 
     if (point_index_L_x < 0)
       point_index_L_x = -point_index_L_x;
@@ -665,10 +705,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     if (point_index_D_y >= height)
       point_index_D_y = height-(point_index_D_y-(height-1));
 
-    //const size_t min_x = pos_x - rect_width_4_ - 1;
-    //const size_t max_x = pos_x + rect_width_4_ + 1;
-    //const size_t min_y = pos_y - rect_height_4_ - 1;
-    //const size_t max_y = pos_y + rect_height_4_ + 1;
+    //const size_t min_x = pos_x - rect_width_4 - 1;
+    //const size_t max_x = pos_x + rect_width_4 + 1;
+    //const size_t min_y = pos_y - rect_height_4 - 1;
+    //const size_t max_y = pos_y + rect_height_4 + 1;
 
     //if (min_x >= width || max_x >= width || min_y >= height || max_y >= height)
     //{
@@ -677,31 +717,31 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     //}
 
 
-    const int start_x_L = pos_x - rect_width_2_;
-    const int start_y_L = pos_y - rect_height_4_;
-    const int end_x_L = start_x_L + rect_width_2_;
-    const int end_y_L = start_y_L + rect_height_2_;
+    const int start_x_L = pos_x - rect_width_2;
+    const int start_y_L = pos_y - rect_height_4;
+    const int end_x_L = start_x_L + rect_width_2;
+    const int end_y_L = start_y_L + rect_height_2;
 
     const int start_x_R = pos_x + 1;
-    const int start_y_R = pos_y - rect_height_4_;
-    const int end_x_R = start_x_R + rect_width_2_;
-    const int end_y_R = start_y_R + rect_height_2_;
+    const int start_y_R = pos_y - rect_height_4;
+    const int end_x_R = start_x_R + rect_width_2;
+    const int end_y_R = start_y_R + rect_height_2;
 
-    const int start_x_U = pos_x - rect_width_4_;
-    const int start_y_U = pos_y - rect_height_2_;
-    const int end_x_U = start_x_U + rect_width_2_;
-    const int end_y_U = start_y_U + rect_height_2_;
+    const int start_x_U = pos_x - rect_width_4;
+    const int start_y_U = pos_y - rect_height_2;
+    const int end_x_U = start_x_U + rect_width_2;
+    const int end_y_U = start_y_U + rect_height_2;
 
-    const int start_x_D = pos_x - rect_width_4_;
+    const int start_x_D = pos_x - rect_width_4;
     const int start_y_D = pos_y + 1;
-    const int end_x_D = start_x_D + rect_width_2_;
-    const int end_y_D = start_y_D + rect_height_2_;
+    const int end_x_D = start_x_D + rect_width_2;
+    const int end_y_D = start_y_D + rect_height_2;
 
     // width and height are at least 3 x 3
-    //unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    //unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    //unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_);
-    //unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_);
+    //unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2);
+    //unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2);
+    //unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2);
+    //unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2);
 
     unsigned count_L_z = 0;
     unsigned count_R_z = 0;
@@ -719,10 +759,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
       return;
     }
 
-    //float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_L_z);
-    //float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_R_z);
-    //float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_) / count_U_z);
-    //float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_) / count_D_z);
+    //float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2) / count_L_z);
+    //float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2) / count_R_z);
+    //float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2) / count_U_z);
+    //float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2) / count_D_z);
 
     float mean_L_z = 0;
     float mean_R_z = 0;
@@ -740,10 +780,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     mean_D_z /= float (count_D_z);
 
 
-    //PointInT pointL = input_->points[point_index - rect_width_4_ - 1];
-    //PointInT pointR = input_->points[point_index + rect_width_4_ + 1];
-    //PointInT pointU = input_->points[point_index - rect_height_4_ * input_->width - 1];
-    //PointInT pointD = input_->points[point_index + rect_height_4_ * input_->width + 1];
+    //PointInT pointL = input_->points[point_index - rect_width_4 - 1];
+    //PointInT pointR = input_->points[point_index + rect_width_4 + 1];
+    //PointInT pointU = input_->points[point_index - rect_height_4 * input_->width - 1];
+    //PointInT pointD = input_->points[point_index + rect_height_4 * input_->width + 1];
     PointInT pointL = input_->points[point_index_L_y*width + point_index_L_x];
     PointInT pointR = input_->points[point_index_R_y*width + point_index_R_x];
     PointInT pointU = input_->points[point_index_U_y*width + point_index_U_x];
@@ -789,28 +829,28 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     //  initSimple3DGradientMethod ();
 
     //// this method does not work if lots of NaNs are in the neighborhood of the point
-    ////Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2_, pos_y - rect_height_2_, 1, rect_height_) -
-    ////                             integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, 1, rect_height_);
+    ////Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2, pos_y - rect_height_2, 1, rect_height) -
+    ////                             integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, 1, rect_height);
 
-    ////Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y + rect_height_2_, rect_width_, 1) -
-    ////                             integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, 1);
+    ////Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y + rect_height_2, rect_width, 1) -
+    ////                             integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, 1);
 
 
-    //const int start_x = pos_x - rect_width_2_;
-    //const int start_y = pos_y - rect_height_2_;
-    //const int end_x = start_x + rect_width_;
-    //const int end_y = start_y + rect_height_;
+    //const int start_x = pos_x - rect_width_2;
+    //const int start_y = pos_y - rect_height_2;
+    //const int end_x = start_x + rect_width;
+    //const int end_y = start_y + rect_height;
 
     //Eigen::Vector3d gradient_x (0, 0, 0);
     //Eigen::Vector3d gradient_y (0, 0, 0);
 
-    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2_,  pos_y - rect_height_2_,  pos_x - rect_width_2_ + 1,  pos_y - rect_height_2_ + rect_height_, width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_x);
+    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2,  pos_y - rect_height_2,  pos_x - rect_width_2 + 1,  pos_y - rect_height_2 + rect_height, width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_x);
     //gradient_x *= -1;
-    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x + rect_width_2_,  pos_y - rect_height_2_,  pos_x + rect_width_2_ + 1,  pos_y - rect_height_2_ + rect_height_, width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_x);
+    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x + rect_width_2,  pos_y - rect_height_2,  pos_x + rect_width_2 + 1,  pos_y - rect_height_2 + rect_height, width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_x);
 
-    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2_,  pos_y - rect_height_2_,  pos_x - rect_width_2_ + rect_width_,  pos_y - rect_height_2_ + 1,  width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_y);
+    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2,  pos_y - rect_height_2,  pos_x - rect_width_2 + rect_width,  pos_y - rect_height_2 + 1,  width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_y);
     //gradient_y *= -1;
-    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2_,  pos_y + rect_height_2_,  pos_x - rect_width_2_ + rect_width_,  pos_y + rect_height_2_ + 1,  width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_y);
+    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2,  pos_y + rect_height_2,  pos_x - rect_width_2 + rect_width,  pos_y + rect_height_2 + 1,  width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_y);
 
 
     //Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
@@ -843,6 +883,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
   return;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirror (
+    const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
+{
+  initCurrentMethod ();
+  computePointNormalMirror (pos_x, pos_y, rect_width_, rect_height_, point_index, normal);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &output)
@@ -852,36 +901,38 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
   
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
+  const int width = static_cast<int> (input_->width);
+  const int height = static_cast<int> (input_->height);
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
+  // the normal loops below only read the integral images, so they have to be ready beforehand
+  initCurrentMethod ();
+
   // compute depth-change map
+  // A point is marked if the edge to its right or lower neighbor is a depth change (the threshold depends on the
+  // point itself), or if it is the right or lower end of such an edge. Each row only writes its own points.
   unsigned char * depthChangeMap = new unsigned char[input_->points.size ()];
-  memset (depthChangeMap, 255, input_->points.size ());
 
-  unsigned index = 0;
-  for (unsigned int ri = 0; ri < input_->height-1; ++ri)
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+  for (int ri = 0; ri < height; ++ri)
   {
-    for (unsigned int ci = 0; ci < input_->width-1; ++ci, ++index)
+    for (int ci = 0; ci < width; ++ci)
     {
-      index = ri * input_->width + ci;
-
-      const float depth  = input_->points [index].z;
-      const float depthR = input_->points [index + 1].z;
-      const float depthD = input_->points [index + input_->width].z;
-
-      //const float depthDependendDepthChange = (max_depth_change_factor_ * (fabs(depth)+1.0f))/(500.0f*0.001f);
-      const float depthDependendDepthChange = (max_depth_change_factor_ * (fabsf (depth) + 1.0f) * 2.0f);
-
-      if (fabs (depth - depthR) > depthDependendDepthChange
-        || !pcl_isfinite (depth) || !pcl_isfinite (depthR))
-      {
-        depthChangeMap[index] = 0;
-        depthChangeMap[index+1] = 0;
-      }
-      if (fabs (depth - depthD) > depthDependendDepthChange
-        || !pcl_isfinite (depth) || !pcl_isfinite (depthD))
-      {
-        depthChangeMap[index] = 0;
-        depthChangeMap[index + input_->width] = 0;
-      }
+      const int index = ri * width + ci;
+      const float depth = input_->points [index].z;
+      bool depth_change = false;
+
+      if (ri < height - 1 && ci < width - 1)
+        depth_change = isDepthChange (depth, input_->points [index + 1].z) ||
+                       isDepthChange (depth, input_->points [index + width].z);
+      if (!depth_change && ci > 0 && ri < height - 1)
+        depth_change = isDepthChange (input_->points [index - 1].z, depth);
+      if (!depth_change && ri > 0 && ci < width - 1)
+        depth_change = isDepthChange (input_->points [index - width].z, depth);
+
+      depthChangeMap[index] = depth_change ? 0 : 255;
     }
   }
 
@@ -890,7 +941,9 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
   if (distance_map_ != NULL) delete distance_map_;
   distance_map_ = new float[input_->points.size ()];
   float *distanceMap = distance_map_;
-  for (size_t index = 0; index < input_->points.size (); ++index)
+  const int nr_points = static_cast<int> (input_->points.size ());
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+  for (int index = 0; index < nr_points; ++index)
   {
     if (depthChangeMap[index] == 0)
       distanceMap[index] = 0.0f;
@@ -942,6 +995,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
     current_row -= input_->width;
   }
 
+  // The normal loops below run over bands of rows in parallel. Every point only reads the integral images and
+  // writes its own output, so the result does not depend on the number of threads.
   if (border_policy_ == BORDER_POLICY_IGNORE)
   {
     // Set all normals that we do not touch to NaN
@@ -975,15 +1030,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
       }
     }
 
+    const int border_int = static_cast<int> (border);
     if (use_depth_dependent_smoothing_)
     {
-      index = border + input_->width * border;
-      unsigned skip = (border << 1);
-      for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
+#pragma omp parallel for num_threads (nr_threads) schedule (dynamic, 8)
+      for (int ri = border_int; ri < height - border_int; ++ri)
       {
-        for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
+        for (int ci = border_int; ci < width - border_int; ++ci)
         {
-          index = ri * input_->width + ci;
+          const unsigned index = ri * width + ci;
 
           const float depth = input_->points[index].z;
           if (!pcl_isfinite (depth))
@@ -997,8 +1052,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
 
           if (smoothing > 2.0f)
           {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormal (ci, ri, index, output [index]);
+            const int rect_size = static_cast<int> (smoothing);
+            computePointNormal (ci, ri, rect_size, rect_size, index, output [index]);
           }
           else
           {
@@ -1012,13 +1067,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
     {
       float smoothing_constant = normal_smoothing_size_;
 
-      index = border + input_->width * border;
-      unsigned skip = (border << 1);
-      for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
+#pragma omp parallel for num_threads (nr_threads) schedule (dynamic, 8)
+      for (int ri = border_int; ri < height - border_int; ++ri)
       {
-        for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
+        for (int ci = border_int; ci < width - border_int; ++ci)
         {
-          index = ri * input_->width + ci;
+          const unsigned index = ri * width + ci;
 
           if (!pcl_isfinite (input_->points[index].z))
           {
@@ -1031,8 +1085,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
 
           if (smoothing > 2.0f)
           {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormal (ci, ri, index, output [index]);
+            const int rect_size = static_cast<int> (smoothing);
+            computePointNormal (ci, ri, rect_size, rect_size, index, output [index]);
           }
           else
           {
@@ -1049,15 +1103,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
 
     if (use_depth_dependent_smoothing_)
     {
-      //index = 0;
-      //unsigned skip = 0;
-      //for (unsigned ri = 0; ri < input_->height; ++ri, index += skip)
-      for (unsigned ri = 0; ri < input_->height; ++ri)
+#pragma omp parallel for num_threads (nr_threads) schedule (dynamic, 8)
+      for (int ri = 0; ri < height; ++ri)
       {
-        //for (unsigned ci = 0; ci < input_->width; ++ci, ++index)
-        for (unsigned ci = 0; ci < input_->width; ++ci)
+        for (int ci = 0; ci < width; ++ci)
         {
-          index = ri * input_->width + ci;
+          const unsigned index = ri * width + ci;
 
           const float depth = input_->points[index].z;
           if (!pcl_isfinite (depth))
@@ -1071,8 +1122,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
 
           if (smoothing > 2.0f)
           {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormalMirror (ci, ri, index, output [index]);
+            const int rect_size = static_cast<int> (smoothing);
+            computePointNormalMirror (ci, ri, rect_size, rect_size, index, output [index]);
           }
           else
           {
@@ -1086,15 +1137,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
     {
       float smoothing_constant = normal_smoothing_size_;
 
-      //index = border + input_->width * border;
-      //unsigned skip = (border << 1);
-      //for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
-      for (unsigned ri = 0; ri < input_->height; ++ri)
+#pragma omp parallel for num_threads (nr_threads) schedule (dynamic, 8)
+      for (int ri = 0; ri < height; ++ri)
       {
-        //for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
-        for (unsigned ci = 0; ci < input_->width; ++ci)
+        for (int ci = 0; ci < width; ++ci)
         {
-          index = ri * input_->width + ci;
+          const unsigned index = ri * width + ci;
 
           if (!pcl_isfinite (input_->points[index].z))
           {
@@ -1107,8 +1155,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
 
           if (smoothing > 2.0f)
           {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormalMirror (ci, ri, index, output [index]);
+            const int rect_size = static_cast<int> (smoothing);
+            computePointNormalMirror (ci, ri, rect_size, rect_size, index, output [index]);
           }
           else
           {
@@ -74,13 +74,26 @@ pcl::NormalEstimationOMP<PointInT, Eigen::MatrixXf>::computeFeatureEigen (pcl::P
 
     // 16-bytes aligned placeholder for the XYZ centroid of a surface patch
     Eigen::Vector4f xyz_centroid;
-    // Estimate the XYZ centroid
-    compute3DCentroid (*surface_, nn_indices, xyz_centroid);
-
     // Placeholder for the 3x3 covariance matrix at each surface patch
     EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
-    // Compute the 3x3 covariance matrix
-    computeCovarianceMatrix (*surface_, nn_indices, xyz_centroid, covariance_matrix);
+    unsigned int nr_valid;
+    if (use_vectorized_covariance_)
+      nr_valid = computeMeanAndCovarianceMatrixVectorized (*surface_, nn_indices, covariance_matrix, xyz_centroid);
+    else
+    {
+      // Estimate the XYZ centroid
+      nr_valid = compute3DCentroid (*surface_, nn_indices, xyz_centroid);
+      // Compute the 3x3 covariance matrix
+      if (nr_valid != 0)
+        computeCovarianceMatrix (*surface_, nn_indices, xyz_centroid, covariance_matrix);
+    }
+    // No finite neighbor to fit a plane to, as in computePointNormal
+    if (nr_valid == 0)
+    {
+      output.points (idx, 0) = output.points (idx, 1) = output.points (idx, 2) = output.points (idx, 3) = std::numeric_limits<float>::quiet_NaN ();
+      output.is_dense = false;
+      continue;
+    }
 
     // Get the plane normal and surface curvature
     solvePlaneParameters (covariance_matrix,
@@ -122,13 +135,26 @@ pcl::NormalEstimationOMP<PointInT, PointOutT>::computeFeature (PointCloudOut &ou
 
     // 16-bytes aligned placeholder for the XYZ centroid of a surface patch
     Eigen::Vector4f xyz_centroid;
-    // Estimate the XYZ centroid
-    compute3DCentroid (*surface_, nn_indices, xyz_centroid);
-
     // Placeholder for the 3x3 covariance matrix at each surface patch
     EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
-    // Compute the 3x3 covariance matrix
-    computeCovarianceMatrix (*surface_, nn_indices, xyz_centroid, covariance_matrix);
+    unsigned int nr_valid;
+    if (use_vectorized_covariance_)
+      nr_valid = computeMeanAndCovarianceMatrixVectorized (*surface_, nn_indices, covariance_matrix, xyz_centroid);
+    else
+    {
+      // Estimate the XYZ centroid
+      nr_valid = compute3DCentroid (*surface_, nn_indices, xyz_centroid);
+      // Compute the 3x3 covariance matrix
+      if (nr_valid != 0)
+        computeCovarianceMatrix (*surface_, nn_indices, xyz_centroid, covariance_matrix);
+    }
+    // No finite neighbor to fit a plane to, as in computePointNormal
+    if (nr_valid == 0)
+    {
+      output.points[idx].normal[0] = output.points[idx].normal[1] = output.points[idx].normal[2] = output.points[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
+      output.is_dense = false;
+      continue;
+    }
 
     // Get the plane normal and surface curvature
     solvePlaneParameters (covariance_matrix,
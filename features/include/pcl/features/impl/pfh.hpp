@@ -72,6 +72,17 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
   // Iterate over all the points in the neighborhood
   for (size_t i_idx = 0; i_idx < indices.size (); ++i_idx)
   {
+    // Without a cache, compute the pairs NNi to all valid NNj at once
+    size_t batch_idx = 0;
+    if (!use_cache_ && isFinite (cloud.points[indices[i_idx]]))
+    {
+      pair_batch_.clear ();
+      for (size_t j_idx = 0; j_idx < i_idx; ++j_idx)
+        if (isFinite (cloud.points[indices[j_idx]]))
+          pair_batch_.push_back (cloud.points[indices[j_idx]], normals.points[indices[j_idx]]);
+      pair_batch_.compute (cloud.points[indices[i_idx]].getVector4fMap (), normals.points[indices[i_idx]].getNormalVector4fMap ());
+    }
+
     for (size_t j_idx = 0; j_idx < i_idx; ++j_idx)
     {
       // If the 3D points are invalid, don't bother estimating, just continue
@@ -107,9 +118,13 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
         }
       }
       else
-        if (!computePairFeatures (cloud, normals, indices[i_idx], indices[j_idx],
-                                  pfh_tuple_[0], pfh_tuple_[1], pfh_tuple_[2], pfh_tuple_[3]))
-          continue;
+      {
+        pfh_tuple_[0] = pair_batch_.f1[batch_idx];
+        pfh_tuple_[1] = pair_batch_.f2[batch_idx];
+        pfh_tuple_[2] = pair_batch_.f3[batch_idx];
+        pfh_tuple_[3] = pair_batch_.f4[batch_idx];
+        ++batch_idx;
+      }
 
       // Normalize the f1, f2, f3 features and push them in the histogram
       f_index_[0] = static_cast<int> (floor (nr_split * ((pfh_tuple_[0] + M_PI) * d_pi_)));
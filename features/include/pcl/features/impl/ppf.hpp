@@ -64,31 +64,38 @@ pcl::PPFEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
   output.width = static_cast<uint32_t> (output.points.size ());
   output.is_dense = true;
 
+  // Every reference point is paired with the whole cloud, so gather it once and compute the pairs in batches
+  PairFeatureBatch pair_batch;
+  for (size_t j = 0; j < input_->points.size (); ++j)
+    pair_batch.push_back (input_->points[j], normals_->points[j]);
+
   // Compute point pair features for every pair of points in the cloud
   for (size_t index_i = 0; index_i < indices_->size (); ++index_i)
   {
     size_t i = (*indices_)[index_i];
+    pair_batch.compute (input_->points[i].getVector4fMap (), normals_->points[i].getNormalVector4fMap ());
+
+    // The transformation aligning the reference normal with the x axis only depends on the reference point
+    Eigen::Vector3f model_reference_point = input_->points[i].getVector3fMap (),
+                    model_reference_normal = normals_->points[i].getNormalVector3fMap ();
+    Eigen::AngleAxisf rotation_mg (acosf (model_reference_normal.dot (Eigen::Vector3f::UnitX ())),
+                                   model_reference_normal.cross (Eigen::Vector3f::UnitX ()).normalized ());
+    Eigen::Affine3f transform_mg = Eigen::Translation3f ( rotation_mg * ((-1) * model_reference_point)) * rotation_mg;
+
     for (size_t j = 0 ; j < input_->points.size (); ++j)
     {
       PointOutT p;
       if (i != j)
       {
-        if (//pcl::computePPFPairFeature
-            pcl::computePairFeatures (input_->points[i].getVector4fMap (),
-                                      normals_->points[i].getNormalVector4fMap (),
-                                      input_->points[j].getVector4fMap (),
-                                      normals_->points[j].getNormalVector4fMap (),
-                                      p.f1, p.f2, p.f3, p.f4))
+        if (pair_batch.valid[j])
         {
+          p.f1 = pair_batch.f1[j];
+          p.f2 = pair_batch.f2[j];
+          p.f3 = pair_batch.f3[j];
+          p.f4 = pair_batch.f4[j];
+
           // Calculate alpha_m angle
-          Eigen::Vector3f model_reference_point = input_->points[i].getVector3fMap (),
-                          model_reference_normal = normals_->points[i].getNormalVector3fMap (),
-                          model_point = input_->points[j].getVector3fMap ();
-          Eigen::AngleAxisf rotation_mg (acosf (model_reference_normal.dot (Eigen::Vector3f::UnitX ())),
-                                         model_reference_normal.cross (Eigen::Vector3f::UnitX ()).normalized ());
-          Eigen::Affine3f transform_mg = Eigen::Translation3f ( rotation_mg * ((-1) * model_reference_point)) * rotation_mg;
-
-          Eigen::Vector3f model_point_transformed = transform_mg * model_point;
+          Eigen::Vector3f model_point_transformed = transform_mg * input_->points[j].getVector3fMap ();
           float angle = atan2f ( -model_point_transformed(2), model_point_transformed(1));
           if (sin (angle) * model_point_transformed(2) < 0.0f)
             angle *= (-1);
@@ -124,31 +131,38 @@ pcl::PPFEstimation<PointInT, PointNT, Eigen::MatrixXf>::computeFeatureEigen (pcl
   output.width = static_cast<uint32_t> (indices_->size () * input_->points.size ());
 
   output.is_dense = true;
+  // Every reference point is paired with the whole cloud, so gather it once and compute the pairs in batches
+  PairFeatureBatch pair_batch;
+  for (size_t j = 0; j < input_->points.size (); ++j)
+    pair_batch.push_back (input_->points[j], normals_->points[j]);
+
   // Compute point pair features for every pair of points in the cloud
   for (size_t index_i = 0; index_i < indices_->size (); ++index_i)
   {
     size_t i = (*indices_)[index_i];
+    pair_batch.compute (input_->points[i].getVector4fMap (), normals_->points[i].getNormalVector4fMap ());
+
+    // The transformation aligning the reference normal with the x axis only depends on the reference point
+    Eigen::Vector3f model_reference_point = input_->points[i].getVector3fMap (),
+                    model_reference_normal = normals_->points[i].getNormalVector3fMap ();
+    Eigen::AngleAxisf rotation_mg (acosf (model_reference_normal.dot (Eigen::Vector3f::UnitX ())),
+                                   model_reference_normal.cross (Eigen::Vector3f::UnitX ()).normalized ());
+    Eigen::Affine3f transform_mg = Eigen::Translation3f ( rotation_mg * ((-1) * model_reference_point)) * rotation_mg;
+
     for (size_t j = 0 ; j < input_->points.size (); ++j)
     {
       Eigen::VectorXf p (5);
       if (i != j)
       {
-        if (//pcl::computePPFPairFeature
-            pcl::computePairFeatures (input_->points[i].getVector4fMap (),
-                                      normals_->points[i].getNormalVector4fMap (),
-                                      input_->points[j].getVector4fMap (),
-                                      normals_->points[j].getNormalVector4fMap (),
-                                      p (0), p (1), p (2), p (3)))
+        if (pair_batch.valid[j])
         {
+          p (0) = pair_batch.f1[j];
+          p (1) = pair_batch.f2[j];
+          p (2) = pair_batch.f3[j];
+          p (3) = pair_batch.f4[j];
+
           // Calculate alpha_m angle
-          Eigen::Vector3f model_reference_point = input_->points[i].getVector3fMap (),
-                          model_reference_normal = normals_->points[i].getNormalVector3fMap (),
-                          model_point = input_->points[j].getVector3fMap ();
-          Eigen::AngleAxisf rotation_mg (acosf (model_reference_normal.dot (Eigen::Vector3f::UnitX ())),
-                                         model_reference_normal.cross (Eigen::Vector3f::UnitX ()).normalized ());
-          Eigen::Affine3f transform_mg = Eigen::Translation3f ( rotation_mg * ((-1) * model_reference_point)) * rotation_mg;
-
-          Eigen::Vector3f model_point_transformed = transform_mg * model_point;
+          Eigen::Vector3f model_point_transformed = transform_mg * input_->points[j].getVector3fMap ();
           float angle = atan2f ( -model_point_transformed(2), model_point_transformed(1));
           if (sin (angle) * model_point_transformed(2) < 0.0f)
             angle *= (-1);
@@ -230,6 +230,41 @@ pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::normalizeHistog
     shot[j] /= static_cast<float> (acc_norm);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> void
+pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::buildAngleLookupTable ()
+{
+  // 1024 linear segments keep the interpolation error of atan below 1e-7 rad
+  const int nr_segments = 1024;
+  atan_lut_.resize (nr_segments + 1);
+  for (int i = 0; i <= nr_segments; ++i)
+    atan_lut_[i] = atan (static_cast<double> (i) / nr_segments);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> inline double
+pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::lookupAtan2 (double y, double x) const
+{
+  const double abs_x = fabs (x), abs_y = fabs (y);
+  if (abs_x == 0.0 && abs_y == 0.0)
+    return (0.0);
+
+  // Reduce to the first octant, where the ratio lies in [0, 1]
+  const bool steep = abs_y > abs_x;
+  const double ratio = steep ? abs_x / abs_y : abs_y / abs_x;
+
+  const int nr_segments = static_cast<int> (atan_lut_.size ()) - 1;
+  const double position = ratio * nr_segments;
+  const int segment = std::min (static_cast<int> (position), nr_segments - 1);
+  double angle = atan_lut_[segment] + (position - segment) * (atan_lut_[segment + 1] - atan_lut_[segment]);
+
+  if (steep)
+    angle = PST_RAD_90 - angle;
+  if (x < 0)
+    angle = PST_PI - angle;
+  return (y < 0 ? -angle : angle);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> void
 pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::interpolateSingleChannel (
@@ -330,13 +365,19 @@ pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::interpolateSing
     }
 
     //Interpolation on the inclination (adjacent vertical volumes)
-    double inclinationCos = zInFeatRef / distance;
-    if (inclinationCos < - 1.0)
-      inclinationCos = - 1.0;
-    if (inclinationCos > 1.0)
-      inclinationCos = 1.0;
+    double inclination;
+    if (use_angle_lut_)
+      inclination = lookupAtan2 (sqrt (xInFeatRef * xInFeatRef + yInFeatRef * yInFeatRef), zInFeatRef);
+    else
+    {
+      double inclinationCos = zInFeatRef / distance;
+      if (inclinationCos < - 1.0)
+        inclinationCos = - 1.0;
+      if (inclinationCos > 1.0)
+        inclinationCos = 1.0;
 
-    double inclination = acos (inclinationCos);
+      inclination = acos (inclinationCos);
+    }
 
     assert (inclination >= 0.0 && inclination <= PST_RAD_180);
 
@@ -368,7 +409,7 @@ pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::interpolateSing
     if (yInFeatRef != 0.0 || xInFeatRef != 0.0)
     {
       //Interpolation on the azimuth (adjacent horizontal volumes)
-      double azimuth = atan2 (yInFeatRef, xInFeatRef);
+      double azimuth = use_angle_lut_ ? lookupAtan2 (yInFeatRef, xInFeatRef) : atan2 (yInFeatRef, xInFeatRef);
 
       int sel = desc_index >> 2;
       double angularSectorSpan = PST_RAD_45;
@@ -526,13 +567,19 @@ pcl::SHOTColorEstimation<PointInT, PointNT, PointOutT, PointRFT>::interpolateDou
     }
 
     //Interpolation on the inclination (adjacent vertical volumes)
-    double inclinationCos = zInFeatRef / distance;
-    if (inclinationCos < - 1.0)
-      inclinationCos = - 1.0;
-    if (inclinationCos > 1.0)
-      inclinationCos = 1.0;
+    double inclination;
+    if (use_angle_lut_)
+      inclination = lookupAtan2 (sqrt (xInFeatRef * xInFeatRef + yInFeatRef * yInFeatRef), zInFeatRef);
+    else
+    {
+      double inclinationCos = zInFeatRef / distance;
+      if (inclinationCos < - 1.0)
+        inclinationCos = - 1.0;
+      if (inclinationCos > 1.0)
+        inclinationCos = 1.0;
 
-    double inclination = acos (inclinationCos);
+      inclination = acos (inclinationCos);
+    }
 
     assert (inclination >= 0.0 && inclination <= PST_RAD_180);
 
@@ -576,7 +623,7 @@ pcl::SHOTColorEstimation<PointInT, PointNT, PointOutT, PointRFT>::interpolateDou
     if (yInFeatRef != 0.0 || xInFeatRef != 0.0)
     {
       //Interpolation on the azimuth (adjacent horizontal volumes)
-      double azimuth = atan2 (yInFeatRef, xInFeatRef);
+      double azimuth = use_angle_lut_ ? lookupAtan2 (yInFeatRef, xInFeatRef) : atan2 (yInFeatRef, xInFeatRef);
 
       int sel = desc_index >> 2;
       double angularSectorSpan = PST_RAD_45;
@@ -41,6 +41,10 @@
 #include <pcl/common/time.h>
 #include <pcl/features/shot_lrf_omp.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 template<typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> bool
 pcl::SHOTEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::initCompute ()
 {
@@ -69,15 +73,54 @@ pcl::SHOTEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::initCompute ()
   if (!fake_surface_)
     lrf_estimator->setSearchSurface(surface_);
 
-  if (!FeatureWithLocalReferenceFrames<PointInT, PointRFT>::initLocalReferenceFrames (indices_->size (), lrf_estimator))
+  // If the frames have to be estimated, search the neighbors of all the input points once, for both the frames
+  // and the descriptors. The frames depend on the order of the neighbors, which must be sorted by distance.
+  const bool estimate_frames = frames_never_defined_ || !frames_ || frames_->points.size () != indices_->size ();
+  if (estimate_frames && !use_neighborhoods_ && indices_->size () == input_->points.size ())
+  {
+    pcl::search::Neighborhoods *neighborhoods = new pcl::search::Neighborhoods;
+    neighborhoods_.reset (neighborhoods);
+    const bool tree_sorted = tree_->getSortedResults ();
+    const unsigned int tree_threads = tree_->getNumberOfThreads ();
+    tree_->setSortedResults (true);
+    tree_->setNumberOfThreads (threads_);
+    tree_->radiusSearch (*input_, std::vector<int> (), search_radius_, *neighborhoods);
+    tree_->setNumberOfThreads (tree_threads);
+    tree_->setSortedResults (tree_sorted);
+    use_neighborhoods_ = true;
+    shared_neighborhoods_ = true;
+  }
+  // The frame estimator searches with the same tree, and changes it to return sorted results
+  const bool tree_sorted = tree_->getSortedResults ();
+  lrf_estimator->setSearchMethod (tree_);
+  if (use_neighborhoods_)
+    lrf_estimator->setSearchNeighborhoods (neighborhoods_);
+
+  const bool frames_ok = FeatureWithLocalReferenceFrames<PointInT, PointRFT>::initLocalReferenceFrames (indices_->size (), lrf_estimator);
+  tree_->setSortedResults (tree_sorted);
+  if (!frames_ok)
   {
     PCL_ERROR ("[pcl::%s::initCompute] Init failed.\n", getClassName ().c_str ());
+    deinitCompute ();
     return (false);
   }
 
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> bool
+pcl::SHOTEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::deinitCompute ()
+{
+  // Release the neighbors searched by initCompute, so that they are not mistaken for precomputed ones
+  if (shared_neighborhoods_)
+  {
+    neighborhoods_.reset ();
+    shared_neighborhoods_ = false;
+  }
+  return (Feature<PointInT, PointOutT>::deinitCompute ());
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> bool
 pcl::SHOTColorEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::initCompute ()
@@ -97,6 +140,13 @@ pcl::SHOTColorEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::initCompute
     return (false);
   }
 
+  // Fill the color conversion tables here, as they would otherwise be filled lazily by all the threads at once
+  if (this->sRGB_LUT[0] < 0)
+  {
+    float L, A, B;
+    this->RGB2CIELAB (0, 0, 0, L, A, B);
+  }
+
   // Default LRF estimation alg: SHOTLocalReferenceFrameEstimationOMP
   typename boost::shared_ptr<SHOTLocalReferenceFrameEstimationOMP<PointInT, PointRFT> > lrf_estimator(new SHOTLocalReferenceFrameEstimationOMP<PointInT, PointRFT>());
   lrf_estimator->setRadiusSearch (search_radius_);
@@ -107,15 +157,54 @@ pcl::SHOTColorEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::initCompute
   if (!fake_surface_)
     lrf_estimator->setSearchSurface(surface_);
 
-  if (!FeatureWithLocalReferenceFrames<PointInT, PointRFT>::initLocalReferenceFrames (indices_->size (), lrf_estimator))
+  // If the frames have to be estimated, search the neighbors of all the input points once, for both the frames
+  // and the descriptors. The frames depend on the order of the neighbors, which must be sorted by distance.
+  const bool estimate_frames = frames_never_defined_ || !frames_ || frames_->points.size () != indices_->size ();
+  if (estimate_frames && !use_neighborhoods_ && indices_->size () == input_->points.size ())
+  {
+    pcl::search::Neighborhoods *neighborhoods = new pcl::search::Neighborhoods;
+    neighborhoods_.reset (neighborhoods);
+    const bool tree_sorted = tree_->getSortedResults ();
+    const unsigned int tree_threads = tree_->getNumberOfThreads ();
+    tree_->setSortedResults (true);
+    tree_->setNumberOfThreads (threads_);
+    tree_->radiusSearch (*input_, std::vector<int> (), search_radius_, *neighborhoods);
+    tree_->setNumberOfThreads (tree_threads);
+    tree_->setSortedResults (tree_sorted);
+    use_neighborhoods_ = true;
+    shared_neighborhoods_ = true;
+  }
+  // The frame estimator searches with the same tree, and changes it to return sorted results
+  const bool tree_sorted = tree_->getSortedResults ();
+  lrf_estimator->setSearchMethod (tree_);
+  if (use_neighborhoods_)
+    lrf_estimator->setSearchNeighborhoods (neighborhoods_);
+
+  const bool frames_ok = FeatureWithLocalReferenceFrames<PointInT, PointRFT>::initLocalReferenceFrames (indices_->size (), lrf_estimator);
+  tree_->setSortedResults (tree_sorted);
+  if (!frames_ok)
   {
     PCL_ERROR ("[pcl::%s::initCompute] Init failed.\n", getClassName ().c_str ());
+    deinitCompute ();
     return (false);
   }
 
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> bool
+pcl::SHOTColorEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::deinitCompute ()
+{
+  // Release the neighbors searched by initCompute, so that they are not mistaken for precomputed ones
+  if (shared_neighborhoods_)
+  {
+    neighborhoods_.reset ();
+    shared_neighborhoods_ = false;
+  }
+  return (Feature<PointInT, PointOutT>::deinitCompute ());
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> void
 pcl::SHOTEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::computeFeature (PointCloudOut &output)
@@ -130,16 +219,22 @@ pcl::SHOTEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::computeFeature (
   assert(descLength_ == 352);
 
   int data_size = static_cast<int> (indices_->size ());
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
+  // Each thread reuses its own descriptor and neighbor buffers for all of its points
+  Eigen::VectorXf shot;
+  std::vector<int> nn_indices;
+  std::vector<float> nn_dists;
 
   output.is_dense = true;
   // Iterating over the entire index vector
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(threads_)
+#pragma omp parallel for private (shot, nn_indices, nn_dists) num_threads (nr_threads) schedule (dynamic, 64)
 #endif
   for (int idx = 0; idx < data_size; ++idx)
   {
-
-    Eigen::VectorXf shot;
     shot.setZero (descLength_);
 
     bool lrf_is_nan = false;
@@ -153,11 +248,6 @@ pcl::SHOTEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::computeFeature (
       lrf_is_nan = true;
     }
 
-    // Allocate enough space to hold the results
-    // \note This resize is irrelevant for a radiusSearch ().
-    std::vector<int> nn_indices (k_);
-    std::vector<float> nn_dists (k_);
-
     if (!isFinite ((*input_)[(*indices_)[idx]]) || lrf_is_nan || this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices,
                                                                                            nn_dists) == 0)
     {
@@ -204,22 +294,24 @@ pcl::SHOTColorEstimationOMP<PointInT, PointNT, PointOutT, PointRFT>::computeFeat
   radius1_2_ = search_radius_ / 2;
 
   int data_size = static_cast<int> (indices_->size ());
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
+  // Each thread reuses its own descriptor and neighbor buffers for all of its points
+  Eigen::VectorXf shot;
+  std::vector<int> nn_indices;
+  std::vector<float> nn_dists;
 
   output.is_dense = true;
   // Iterating over the entire index vector
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(threads_)
+#pragma omp parallel for private (shot, nn_indices, nn_dists) num_threads (nr_threads) schedule (dynamic, 64)
 #endif
   for (int idx = 0; idx < data_size; ++idx)
   {
-    Eigen::VectorXf shot;
     shot.setZero (descLength_);
 
-    // Allocate enough space to hold the results
-    // \note This resize is irrelevant for a radiusSearch ().
-    std::vector<int> nn_indices (k_);
-    std::vector<float> nn_dists (k_);
-
     bool lrf_is_nan = false;
     const PointRFT& current_frame = (*frames_)[idx];
     if (!pcl_isfinite (current_frame.x_axis[0]) ||
@@ -109,6 +109,8 @@ namespace pcl
       static const unsigned second_order_size = (Dimension * (Dimension + 1)) >> 1;
       typedef Eigen::Matrix<typename IntegralImageTypeTraits<DataType>::IntegralType, Dimension, 1> ElementType;
       typedef Eigen::Matrix<typename IntegralImageTypeTraits<DataType>::IntegralType, second_order_size, 1> SecondOrderType;
+      typedef Eigen::Matrix<float, Dimension, 1> SingleElementType;
+      typedef Eigen::Matrix<float, second_order_size, 1> SingleSecondOrderType;
 
       /** \brief Constructor for an Integral Image
         * \param[in] compute_second_order_integral_images set to true if we want to compute a second order image
@@ -117,9 +119,13 @@ namespace pcl
         first_order_integral_image_ (),
         second_order_integral_image_ (),
         finite_values_integral_image_ (),
+        first_order_integral_image_single_ (),
+        second_order_integral_image_single_ (),
         width_ (1), 
         height_ (1), 
-        compute_second_order_integral_images_ (compute_second_order_integral_images)
+        compute_second_order_integral_images_ (compute_second_order_integral_images),
+        single_precision_ (false),
+        threads_ (1)
       {
       }
 
@@ -133,6 +139,26 @@ namespace pcl
       void 
       setSecondOrderComputation (bool compute_second_order_integral_images);
 
+      /** \brief Store the integral images in single instead of double precision. This halves the memory (and
+        * memory bandwidth) used by the images, but the box sums are computed as differences of large values and
+        * lose precision accordingly. The sums returned by the getters are always of the integral type.
+        * Takes effect at the next call to setInput ().
+        * \param[in] single_precision set to true to store the integral images as floats
+        */
+      inline void
+      setSinglePrecision (bool single_precision) { single_precision_ = single_precision; }
+
+      /** \brief Returns whether the integral images are stored in single precision. */
+      inline bool
+      getSinglePrecision () const { return (single_precision_); }
+
+      /** \brief Set the number of threads used to compute the integral images, one by default. The result does
+        * not depend on the number of threads.
+        * \param[in] nr_threads the number of hardware threads to use (0 uses as many threads as OpenMP provides)
+        */
+      inline void
+      setNumberOfThreads (unsigned nr_threads = 0) { threads_ = nr_threads; }
+
       /** \brief Set the input data to compute the integral image for
         * \param[in] data the input data
         * \param[in] width the width of the data
@@ -201,17 +227,23 @@ namespace pcl
     private:
       typedef Eigen::Matrix<typename IntegralImageTypeTraits<DataType>::Type, Dimension, 1> InputType;
 
-      /** \brief Compute the actual integral image data
+      /** \brief Compute the actual integral image data: prefix sums along every row first, then down blocks of
+        * columns, both in parallel.
         * \param[in] data the input data
         * \param[in] element_stride the element stride of the data
         * \param[in] row_stride the row stride of the data
+        * \param[out] first_order the first order integral image to fill
+        * \param[out] second_order the second order integral image to fill, or NULL
         */
-      void
-      computeIntegralImages (const DataType * data, unsigned row_stride, unsigned element_stride);
+      template <typename FirstOrderT, typename SecondOrderT> void
+      computeIntegralImages (const DataType * data, unsigned row_stride, unsigned element_stride,
+                             FirstOrderT *first_order, SecondOrderT *second_order);
 
       std::vector<ElementType, Eigen::aligned_allocator<ElementType> > first_order_integral_image_;
       std::vector<SecondOrderType, Eigen::aligned_allocator<SecondOrderType> > second_order_integral_image_;
       std::vector<unsigned> finite_values_integral_image_;
+      std::vector<SingleElementType, Eigen::aligned_allocator<SingleElementType> > first_order_integral_image_single_;
+      std::vector<SingleSecondOrderType, Eigen::aligned_allocator<SingleSecondOrderType> > second_order_integral_image_single_;
 
       /** \brief The width of the 2d input data array */
       unsigned width_;
@@ -220,6 +252,12 @@ namespace pcl
 
       /** \brief Indicates whether second order integral images are available **/
       bool compute_second_order_integral_images_;
+
+      /** \brief Indicates whether the integral images are stored in single precision **/
+      bool single_precision_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned threads_;
    };
 
    /**
@@ -232,6 +270,8 @@ namespace pcl
       static const unsigned second_order_size = 1;
       typedef typename IntegralImageTypeTraits<DataType>::IntegralType ElementType;
       typedef typename IntegralImageTypeTraits<DataType>::IntegralType SecondOrderType;
+      typedef float SingleElementType;
+      typedef float SingleSecondOrderType;
 
       /** \brief Constructor for an Integral Image
         * \param[in] compute_second_order_integral_images set to true if we want to compute a second order image
@@ -240,8 +280,12 @@ namespace pcl
         first_order_integral_image_ (),
         second_order_integral_image_ (),
         finite_values_integral_image_ (),
+        first_order_integral_image_single_ (),
+        second_order_integral_image_single_ (),
         width_ (1), height_ (1), 
-        compute_second_order_integral_images_ (compute_second_order_integral_images)
+        compute_second_order_integral_images_ (compute_second_order_integral_images),
+        single_precision_ (false),
+        threads_ (1)
       {
       }
 
@@ -249,6 +293,35 @@ namespace pcl
       virtual
       ~IntegralImage2D () { }
 
+      /** \brief sets the computation for second order integral images on or off.
+        * \param compute_second_order_integral_images
+        */
+      inline void 
+      setSecondOrderComputation (bool compute_second_order_integral_images)
+      {
+        compute_second_order_integral_images_ = compute_second_order_integral_images;
+      }
+
+      /** \brief Store the integral images in single instead of double precision. This halves the memory (and
+        * memory bandwidth) used by the images, but the box sums are computed as differences of large values and
+        * lose precision accordingly. The sums returned by the getters are always of the integral type.
+        * Takes effect at the next call to setInput ().
+        * \param[in] single_precision set to true to store the integral images as floats
+        */
+      inline void
+      setSinglePrecision (bool single_precision) { single_precision_ = single_precision; }
+
+      /** \brief Returns whether the integral images are stored in single precision. */
+      inline bool
+      getSinglePrecision () const { return (single_precision_); }
+
+      /** \brief Set the number of threads used to compute the integral images, one by default. The result does
+        * not depend on the number of threads.
+        * \param[in] nr_threads the number of hardware threads to use (0 uses as many threads as OpenMP provides)
+        */
+      inline void
+      setNumberOfThreads (unsigned nr_threads = 0) { threads_ = nr_threads; }
+
       /** \brief Set the input data to compute the integral image for
         * \param[in] data the input data
         * \param[in] width the width of the data
@@ -317,17 +390,23 @@ namespace pcl
   private:
     //  typedef typename IntegralImageTypeTraits<DataType>::Type InputType;
 
-      /** \brief Compute the actual integral image data
+      /** \brief Compute the actual integral image data: prefix sums along every row first, then down blocks of
+        * columns, both in parallel.
         * \param[in] data the input data
         * \param[in] element_stride the element stride of the data
         * \param[in] row_stride the row stride of the data
+        * \param[out] first_order the first order integral image to fill
+        * \param[out] second_order the second order integral image to fill, or NULL
         */
-      void
-      computeIntegralImages (const DataType * data, unsigned row_stride, unsigned element_stride);
+      template <typename FirstOrderT, typename SecondOrderT> void
+      computeIntegralImages (const DataType * data, unsigned row_stride, unsigned element_stride,
+                             FirstOrderT *first_order, SecondOrderT *second_order);
 
       std::vector<ElementType, Eigen::aligned_allocator<ElementType> > first_order_integral_image_;
       std::vector<SecondOrderType, Eigen::aligned_allocator<SecondOrderType> > second_order_integral_image_;
       std::vector<unsigned> finite_values_integral_image_;
+      std::vector<SingleElementType, Eigen::aligned_allocator<SingleElementType> > first_order_integral_image_single_;
+      std::vector<SingleSecondOrderType, Eigen::aligned_allocator<SingleSecondOrderType> > second_order_integral_image_single_;
 
       /** \brief The width of the 2d input data array */
       unsigned width_;
@@ -336,6 +415,12 @@ namespace pcl
 
       /** \brief Indicates whether second order integral images are available **/
       bool compute_second_order_integral_images_;
+
+      /** \brief Indicates whether the integral images are stored in single precision **/
+      bool single_precision_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned threads_;
    };
  }
 
@@ -116,6 +116,8 @@ namespace pcl
         , vpy_ (0.0f)
         , vpz_ (0.0f)
         , use_sensor_origin_ (true)
+        , use_single_precision_ (false)
+        , threads_ (1)
       {
         feature_name_ = "IntegralImagesNormalEstimation";
         tree_.reset ();
@@ -203,6 +205,28 @@ namespace pcl
         normal_estimation_method_ = normal_estimation_method;
       }
 
+      /** \brief Set the number of threads used to build the integral images and to estimate the normals. The
+        * estimation runs on a single thread by default. The estimated normals do not depend on the number of threads.
+        * \param[in] nr_threads the number of hardware threads to use (0 uses as many threads as OpenMP provides)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
+      /** \brief Set whether the integral images are stored in single instead of double precision. This halves
+        * their memory footprint and bandwidth, at the cost of accuracy in the box sums. It is well suited for
+        * AVERAGE_3D_GRADIENT, whose integral images sum up small differences, but not recommended for
+        * COVARIANCE_MATRIX, where the second order sums cancel out. Takes effect at the next setInputCloud ().
+        * \param[in] use_single_precision set to true to use single precision integral images
+        */
+      inline void
+      setSinglePrecisionIntegralImages (bool use_single_precision)
+      {
+        use_single_precision_ = use_single_precision;
+      }
+
       /** \brief Set whether to use depth depending smoothing or not
         * \param[in] use_depth_dependent_smoothing decides whether the smoothing is depth dependent
         */
@@ -381,6 +405,12 @@ namespace pcl
 
       /** whether the sensor origin of the input cloud or a user given viewpoint should be used.*/
       bool use_sensor_origin_;
+
+      /** \brief Whether the integral images are stored in single precision. */
+      bool use_single_precision_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
       
       /** \brief This method should get called before starting the actual computation. */
       bool
@@ -402,6 +432,49 @@ namespace pcl
       void
       initSimple3DGradientMethod ();
 
+      /** \brief Initialize the data of the current normal estimation method if that has not been done yet. */
+      void
+      initCurrentMethod ();
+
+      /** \brief Returns true if the change between two neighboring depths marks a depth discontinuity.
+        * \param[in] depth the depth of the point the threshold is based on
+        * \param[in] neighbor_depth the depth of its neighbor
+        */
+      inline bool
+      isDepthChange (const float depth, const float neighbor_depth) const
+      {
+        const float depthDependendDepthChange = (max_depth_change_factor_ * (fabsf (depth) + 1.0f) * 2.0f);
+        return (fabs (depth - neighbor_depth) > depthDependendDepthChange
+                || !pcl_isfinite (depth) || !pcl_isfinite (neighbor_depth));
+      }
+
+      /** \brief Computes the normal at the specified position for a given region size. Does not touch any
+        * member and can therefore be called concurrently, once the current method has been initialized.
+        * \param[in] pos_x x position (pixel)
+        * \param[in] pos_y y position (pixel)
+        * \param[in] rect_width the width of the search rectangle
+        * \param[in] rect_height the height of the search rectangle
+        * \param[in] point_index the position index of the point
+        * \param[out] normal the output estimated normal
+        */
+      void
+      computePointNormal (const int pos_x, const int pos_y, const int rect_width, const int rect_height,
+                          const unsigned point_index, PointOutT &normal) const;
+
+      /** \brief Computes the normal at the specified position for a given region size, with mirroring for border
+        * handling. Does not touch any member and can therefore be called concurrently, once the current method
+        * has been initialized.
+        * \param[in] pos_x x position (pixel)
+        * \param[in] pos_y y position (pixel)
+        * \param[in] rect_width the width of the search rectangle
+        * \param[in] rect_height the height of the search rectangle
+        * \param[in] point_index the position index of the point
+        * \param[out] normal the output estimated normal
+        */
+      void
+      computePointNormalMirror (const int pos_x, const int pos_y, const int rect_width, const int rect_height,
+                                const unsigned point_index, PointOutT &normal) const;
+
     private:
       /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
         * \param[out] output the output point cloud
@@ -213,6 +213,7 @@ namespace pcl
       , covariance_matrix_ ()
       , xyz_centroid_ ()
       , use_sensor_origin_ (true)
+      , use_vectorized_covariance_ (false)
       {
         feature_name_ = "NormalEstimation";
       };
@@ -230,7 +231,7 @@ namespace pcl
       inline void
       computePointNormal (const pcl::PointCloud<PointInT> &cloud, const std::vector<int> &indices, Eigen::Vector4f &plane_parameters, float &curvature)
       {
-        if (computeMeanAndCovarianceMatrix (cloud, indices, covariance_matrix_, xyz_centroid_) == 0)
+        if (computeCovariance (cloud, indices, covariance_matrix_, xyz_centroid_) == 0)
         {
           plane_parameters.setConstant (std::numeric_limits<float>::quiet_NaN ());
           curvature = std::numeric_limits<float>::quiet_NaN ();
@@ -256,7 +257,7 @@ namespace pcl
       inline void
       computePointNormal (const pcl::PointCloud<PointInT> &cloud, const std::vector<int> &indices, float &nx, float &ny, float &nz, float &curvature)
       {
-        if (computeMeanAndCovarianceMatrix (cloud, indices, covariance_matrix_, xyz_centroid_) == 0)
+        if (computeCovariance (cloud, indices, covariance_matrix_, xyz_centroid_) == 0)
         {
           nx = ny = nz = curvature = std::numeric_limits<float>::quiet_NaN ();
           return;
@@ -266,6 +267,19 @@ namespace pcl
         solvePlaneParameters (covariance_matrix_, nx, ny, nz, curvature);
       }
 
+      /** \brief Set whether the covariance matrix of each neighborhood is computed in a single vectorized pass over
+        * the neighbors shifted by the first of them (see \ref computeMeanAndCovarianceMatrixVectorized), instead of
+        * the default scalar computation. The results match the default ones up to the floating point rounding, but
+        * stay accurate for clouds far away from the origin.
+        * \param[in] use_vectorized_covariance true to use the vectorized single pass, false for the default
+        */
+      inline void
+      setUseVectorizedCovariance (bool use_vectorized_covariance) { use_vectorized_covariance_ = use_vectorized_covariance; }
+
+      /** \brief Get whether the covariance matrices are computed in a single vectorized pass. */
+      inline bool
+      getUseVectorizedCovariance () const { return (use_vectorized_covariance_); }
+
       /** \brief Provide a pointer to the input dataset
         * \param cloud the const boost shared pointer to a PointCloud message
         */
@@ -342,6 +356,23 @@ namespace pcl
       void
       computeFeature (PointCloudOut &output);
 
+      /** \brief Compute the covariance matrix and the centroid of a neighborhood, using the computation selected with
+        * \ref setUseVectorizedCovariance.
+        * \param[in] cloud the input point cloud
+        * \param[in] indices the indices of the neighbors in \a cloud
+        * \param[out] covariance_matrix the resultant 3x3 covariance matrix
+        * \param[out] xyz_centroid the centroid of the neighbors
+        * \return the number of valid neighbors
+        */
+      inline unsigned int
+      computeCovariance (const pcl::PointCloud<PointInT> &cloud, const std::vector<int> &indices,
+                         Eigen::Matrix3f &covariance_matrix, Eigen::Vector4f &xyz_centroid) const
+      {
+        if (use_vectorized_covariance_)
+          return (computeMeanAndCovarianceMatrixVectorized (cloud, indices, covariance_matrix, xyz_centroid));
+        return (computeMeanAndCovarianceMatrix (cloud, indices, covariance_matrix, xyz_centroid));
+      }
+
       /** \brief Values describing the viewpoint ("pinhole" camera model assumed). For per point viewpoints, inherit
         * from NormalEstimation and provide your own computeFeature (). By default, the viewpoint is set to 0,0,0. */
       float vpx_, vpy_, vpz_;
@@ -355,6 +386,9 @@ namespace pcl
       /** whether the sensor origin of the input cloud or a user given viewpoint should be used.*/
       bool use_sensor_origin_;
 
+      /** \brief Whether the covariance matrices are computed in a single vectorized pass. */
+      bool use_vectorized_covariance_;
+
     private:
       /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
         * \param[out] output the output point cloud
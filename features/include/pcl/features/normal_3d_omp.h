@@ -61,6 +61,7 @@ namespace pcl
       using NormalEstimation<PointInT, PointOutT>::search_parameter_;
       using NormalEstimation<PointInT, PointOutT>::surface_;
       using NormalEstimation<PointInT, PointOutT>::getViewPoint;
+      using NormalEstimation<PointInT, PointOutT>::use_vectorized_covariance_;
 
       typedef typename NormalEstimation<PointInT, PointOutT>::PointCloudOut PointCloudOut;
 
@@ -114,6 +115,7 @@ namespace pcl
       using NormalEstimationOMP<PointInT, pcl::Normal>::surface_;
       using NormalEstimationOMP<PointInT, pcl::Normal>::getViewPoint;
       using NormalEstimationOMP<PointInT, pcl::Normal>::threads_;
+      using NormalEstimationOMP<PointInT, pcl::Normal>::use_vectorized_covariance_;
       using NormalEstimationOMP<PointInT, pcl::Normal>::compute;
 
       /** \brief Default constructor.
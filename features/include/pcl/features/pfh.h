@@ -67,6 +67,82 @@ namespace pcl
                        const Eigen::Vector4f &p2, const Eigen::Vector4f &n2, 
                        float &f1, float &f2, float &f3, float &f4);
 
+  /** \brief Compute the features of computePairFeatures for the pairs made of one source point and each of a
+    * batch of target points. The targets are given as separate coordinate arrays (structure of arrays), so that
+    * several pairs are processed at once with SSE instructions when available. The features are those of
+    * computePairFeatures, up to rounding; f1 uses the same atan2f.
+    * \param[in] p1 the source XYZ point
+    * \param[in] n1 the source surface normal
+    * \param[in] x the x coordinates of the target points
+    * \param[in] y the y coordinates of the target points
+    * \param[in] z the z coordinates of the target points
+    * \param[in] normal_x the x components of the target surface normals
+    * \param[in] normal_y the y components of the target surface normals
+    * \param[in] normal_z the z components of the target surface normals
+    * \param[in] nr_pairs the number of target points
+    * \param[out] f1 the first angular feature of each pair
+    * \param[out] f2 the second angular feature of each pair
+    * \param[out] f3 the third angular feature of each pair
+    * \param[out] f4 the distance feature of each pair
+    * \param[out] valid 1 for the pairs whose features could be computed, 0 for the others (whose features are
+    * all set to 0, as computePairFeatures does)
+    * \return the number of valid pairs
+    * \ingroup features
+    */
+  PCL_EXPORTS int
+  computePairFeatures (const Eigen::Vector4f &p1, const Eigen::Vector4f &n1,
+                       const float *x, const float *y, const float *z,
+                       const float *normal_x, const float *normal_y, const float *normal_z, int nr_pairs,
+                       float *f1, float *f2, float *f3, float *f4, unsigned char *valid);
+
+  /** \brief The target points of a batch of point pairs and their features, stored as separate arrays for the
+    * batch version of computePairFeatures. Reuse it from one source point to the next to avoid allocations.
+    * \ingroup features
+    */
+  struct PCL_EXPORTS PairFeatureBatch
+  {
+    /** \brief Remove all the target points, keeping the allocated memory. */
+    inline void
+    clear ()
+    {
+      x.clear (); y.clear (); z.clear ();
+      normal_x.clear (); normal_y.clear (); normal_z.clear ();
+    }
+
+    /** \brief Add a target point.
+      * \param[in] point the XYZ point
+      * \param[in] normal the surface normal at the point
+      */
+    template <typename PointT, typename PointNT> inline void
+    push_back (const PointT &point, const PointNT &normal)
+    {
+      x.push_back (point.x); y.push_back (point.y); z.push_back (point.z);
+      normal_x.push_back (normal.normal_x); normal_y.push_back (normal.normal_y); normal_z.push_back (normal.normal_z);
+    }
+
+    /** \brief Get the number of target points. */
+    inline size_t
+    size () const { return (x.size ()); }
+
+    /** \brief Compute the features of the pairs made of a source point and every target point, into f1, f2, f3,
+      * f4 and valid.
+      * \param[in] p1 the source XYZ point
+      * \param[in] n1 the source surface normal
+      * \return the number of valid pairs
+      */
+    int
+    compute (const Eigen::Vector4f &p1, const Eigen::Vector4f &n1);
+
+    /** \brief The coordinates of the target points. */
+    std::vector<float> x, y, z;
+    /** \brief The surface normals at the target points. */
+    std::vector<float> normal_x, normal_y, normal_z;
+    /** \brief The features of each pair, as computed by compute (). */
+    std::vector<float> f1, f2, f3, f4;
+    /** \brief Whether the features of each pair could be computed. */
+    std::vector<unsigned char> valid;
+  };
+
   /** \brief PFHEstimation estimates the Point Feature Histogram (PFH) descriptor for a given point cloud dataset
     * containing points and normals.
     *
@@ -121,6 +197,7 @@ namespace pcl
         pfh_histogram_ (),
         pfh_tuple_ (),
         d_pi_ (1.0f / (2.0f * static_cast<float> (M_PI))), 
+        pair_batch_ (),
         feature_map_ (),
         key_list_ (),
         // Default 1GB memory size. Need to set it to something more conservative.
@@ -224,6 +301,9 @@ namespace pcl
       /** \brief Float constant = 1.0 / (2.0 * M_PI) */
       float d_pi_; 
 
+      /** \brief Placeholder for the neighbors of a point and their pair features. */
+      PairFeatureBatch pair_batch_;
+
       /** \brief Internal hashmap, used to optimize efficiency of redundant computations. */
       std::map<std::pair<int, int>, Eigen::Vector4f, std::less<std::pair<int, int> >, Eigen::aligned_allocator<Eigen::Vector4f> > feature_map_;
 
@@ -92,12 +92,31 @@ namespace pcl
         sqradius_ (0), radius3_4_ (0), radius1_4_ (0), radius1_2_ (0),
         nr_grid_sector_ (32),
         maxAngularSectors_ (28),
-        descLength_ (0)
+        descLength_ (0),
+        use_angle_lut_ (false),
+        atan_lut_ ()
       {
         feature_name_ = "SHOTEstimation";
       };
 
     public:
+      /** \brief Set whether the inclination and azimuth of the neighbors are computed with a lookup table of the
+        * arctangent instead of calls to acos and atan2. The table is linearly interpolated, and the resulting
+        * angles are within 1e-7 rad of the exact ones, which is far below the resolution of the histogram bins.
+        * \param[in] use_lut true to use the lookup table, false (default) to compute the angles exactly
+        */
+      inline void
+      setUseAngleLookupTable (bool use_lut)
+      {
+        use_angle_lut_ = use_lut;
+        if (use_angle_lut_ && atan_lut_.empty ())
+          buildAngleLookupTable ();
+      }
+
+      /** \brief Get whether the angles are computed with a lookup table of the arctangent. */
+      inline bool
+      getUseAngleLookupTable () const { return (use_angle_lut_); }
+
        /** \brief Estimate the SHOT descriptor for a given point based on its spatial neighborhood of 3D points with normals
          * \param[in] index the index of the point in indices_
          * \param[in] indices the k-neighborhood point indices in surface_
@@ -151,6 +170,19 @@ namespace pcl
       createBinDistanceShape (int index, const std::vector<int> &indices,
                               std::vector<double> &bin_distance_shape);
 
+      /** \brief Fill \a atan_lut_ with the arctangent of evenly spaced values in [0, 1]. */
+      void
+      buildAngleLookupTable ();
+
+      /** \brief Approximate atan2 (y, x) using \a atan_lut_. The approximation keeps the quadrant of the exact
+        * value, so the sectors of the histogram are selected consistently with the signs of \a x and \a y.
+        * \param[in] y the ordinate
+        * \param[in] x the abscissa
+        * \return the angle in [-pi, pi]
+        */
+      inline double
+      lookupAtan2 (double y, double x) const;
+
       /** \brief The number of bins in each shape histogram. */
       int nr_shape_bins_;
 
@@ -178,6 +210,12 @@ namespace pcl
       /** \brief One SHOT length. */
       int descLength_;
 
+      /** \brief Whether the angles are computed with \a atan_lut_. */
+      bool use_angle_lut_;
+
+      /** \brief The arctangent of evenly spaced values in [0, 1], see \ref setUseAngleLookupTable. */
+      std::vector<double> atan_lut_;
+
       /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
         * \param[out] output the output point cloud
         */
@@ -227,6 +265,8 @@ namespace pcl
       using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::maxAngularSectors_;
       using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::interpolateSingleChannel;
       using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::shot_;
+      using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::use_angle_lut_;
+      using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::lookupAtan2;
       using FeatureWithLocalReferenceFrames<PointInT, PointRFT>::frames_;
 
       typedef typename Feature<PointInT, PointOutT>::PointCloudIn PointCloudIn;
@@ -389,6 +429,8 @@ namespace pcl
       using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::maxAngularSectors_;
       using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::interpolateSingleChannel;
       using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::shot_;
+      using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::use_angle_lut_;
+      using SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::lookupAtan2;
       using FeatureWithLocalReferenceFrames<PointInT, PointRFT>::frames_;
 
       typedef typename Feature<PointInT, PointOutT>::PointCloudIn PointCloudIn;
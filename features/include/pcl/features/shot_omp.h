@@ -76,8 +76,12 @@ namespace pcl
       using Feature<PointInT, PointOutT>::search_radius_;
       using Feature<PointInT, PointOutT>::surface_;
       using Feature<PointInT, PointOutT>::fake_surface_;
+      using Feature<PointInT, PointOutT>::tree_;
+      using Feature<PointInT, PointOutT>::neighborhoods_;
+      using Feature<PointInT, PointOutT>::use_neighborhoods_;
       using FeatureFromNormals<PointInT, PointNT, PointOutT>::normals_;
       using FeatureWithLocalReferenceFrames<PointInT, PointRFT>::frames_;
+      using FeatureWithLocalReferenceFrames<PointInT, PointRFT>::frames_never_defined_;
       using SHOTEstimation<PointInT, PointNT, PointOutT, PointRFT>::descLength_;
       using SHOTEstimation<PointInT, PointNT, PointOutT, PointRFT>::nr_grid_sector_;
       using SHOTEstimation<PointInT, PointNT, PointOutT, PointRFT>::nr_shape_bins_;
@@ -90,7 +94,8 @@ namespace pcl
       typedef typename Feature<PointInT, PointOutT>::PointCloudIn PointCloudIn;
 
       /** \brief Empty constructor. */
-      SHOTEstimationOMP (unsigned int nr_threads = 0) : SHOTEstimation<PointInT, PointNT, PointOutT, PointRFT> (), threads_ (nr_threads)
+      SHOTEstimationOMP (unsigned int nr_threads = 0) : SHOTEstimation<PointInT, PointNT, PointOutT, PointRFT> (), threads_ (nr_threads),
+        shared_neighborhoods_ (false)
       { };
       /** \brief Initialize the scheduler and set the number of threads to use.
         * \param nr_threads the number of hardware threads to use (0 sets the value back to automatic)
@@ -108,12 +113,24 @@ namespace pcl
       void
       computeFeature (PointCloudOut &output);
 
-      /** \brief This method should get called before starting the actual computation. */
+      /** \brief This method should get called before starting the actual computation. When the local reference
+        * frames have to be estimated for the whole input cloud, the neighbors of all the points are searched once
+        * and shared by the frame and the descriptor estimation.
+        */
       bool
       initCompute ();
 
+      /** \brief This method should get called after ending the actual computation. */
+      bool
+      deinitCompute ();
+
       /** \brief The number of threads the scheduler should use. */
       unsigned int threads_;
+
+      /** \brief Whether \a neighborhoods_ were searched by \ref initCompute, and have to be released after the
+        * computation.
+        */
+      bool shared_neighborhoods_;
   };
 
   /** \brief SHOTColorEstimationOMP estimates the Signature of Histograms of OrienTations (SHOT) descriptor for a given point cloud dataset
@@ -149,8 +166,12 @@ namespace pcl
       using Feature<PointInT, PointOutT>::search_radius_;
       using Feature<PointInT, PointOutT>::surface_;
       using Feature<PointInT, PointOutT>::fake_surface_;
+      using Feature<PointInT, PointOutT>::tree_;
+      using Feature<PointInT, PointOutT>::neighborhoods_;
+      using Feature<PointInT, PointOutT>::use_neighborhoods_;
       using FeatureFromNormals<PointInT, PointNT, PointOutT>::normals_;
       using FeatureWithLocalReferenceFrames<PointInT, PointRFT>::frames_;
+      using FeatureWithLocalReferenceFrames<PointInT, PointRFT>::frames_never_defined_;
       using SHOTColorEstimation<PointInT, PointNT, PointOutT, PointRFT>::descLength_;
       using SHOTColorEstimation<PointInT, PointNT, PointOutT, PointRFT>::nr_grid_sector_;
       using SHOTColorEstimation<PointInT, PointNT, PointOutT, PointRFT>::nr_shape_bins_;
@@ -169,7 +190,8 @@ namespace pcl
       SHOTColorEstimationOMP (bool describe_shape = true,
                               bool describe_color = true,
                               unsigned int nr_threads = 0)
-        : SHOTColorEstimation<PointInT, PointNT, PointOutT, PointRFT> (describe_shape, describe_color), threads_ (nr_threads)
+        : SHOTColorEstimation<PointInT, PointNT, PointOutT, PointRFT> (describe_shape, describe_color), threads_ (nr_threads),
+          shared_neighborhoods_ (false)
       {
       }
 
@@ -189,12 +211,24 @@ namespace pcl
       void
       computeFeature (PointCloudOut &output);
 
-      /** \brief This method should get called before starting the actual computation. */
+      /** \brief This method should get called before starting the actual computation. When the local reference
+        * frames have to be estimated for the whole input cloud, the neighbors of all the points are searched once
+        * and shared by the frame and the descriptor estimation.
+        */
       bool
       initCompute ();
 
+      /** \brief This method should get called after ending the actual computation. */
+      bool
+      deinitCompute ();
+
       /** \brief The number of threads the scheduler should use. */
       unsigned int threads_;
+
+      /** \brief Whether \a neighborhoods_ were searched by \ref initCompute, and have to be released after the
+        * computation.
+        */
+      bool shared_neighborhoods_;
   };
 
 }
@@ -41,6 +41,9 @@
 #include <pcl/impl/instantiate.hpp>
 #include <pcl/features/pfh.h>
 #include <pcl/features/impl/pfh.hpp>
+#if defined __SSE2__
+#include <emmintrin.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 bool
@@ -104,6 +107,161 @@ pcl::computePairFeatures (const Eigen::Vector4f &p1, const Eigen::Vector4f &n1,
   return (true);
 }
 
+namespace
+{
+  /* The batch kernel of computePairFeatures is written once, on top of the small functions below, for single
+   * floats and for SSE packets of four floats. The pairs that do not fill a packet thus go through exactly the
+   * same arithmetic as the others. */
+  inline float pfSet1 (float a) { return (a); }
+  inline float pfAdd (float a, float b) { return (a + b); }
+  inline float pfSub (float a, float b) { return (a - b); }
+  inline float pfMul (float a, float b) { return (a * b); }
+  inline float pfDiv (float a, float b) { return (a / b); }
+  inline float pfSqrt (float a) { return (sqrtf (a)); }
+  inline float pfAbs (float a) { return (fabsf (a)); }
+  inline bool pfLess (float a, float b) { return (a < b); }
+  inline bool pfEqual (float a, float b) { return (a == b); }
+  inline bool pfOr (bool a, bool b) { return (a || b); }
+  inline float pfSelect (bool mask, float a, float b) { return (mask ? a : b); }
+#if defined __SSE2__
+  inline __m128 pfSet1Packet (float a) { return (_mm_set1_ps (a)); }
+  inline __m128 pfAdd (__m128 a, __m128 b) { return (_mm_add_ps (a, b)); }
+  inline __m128 pfSub (__m128 a, __m128 b) { return (_mm_sub_ps (a, b)); }
+  inline __m128 pfMul (__m128 a, __m128 b) { return (_mm_mul_ps (a, b)); }
+  inline __m128 pfDiv (__m128 a, __m128 b) { return (_mm_div_ps (a, b)); }
+  inline __m128 pfSqrt (__m128 a) { return (_mm_sqrt_ps (a)); }
+  inline __m128 pfAbs (__m128 a) { return (_mm_andnot_ps (_mm_set1_ps (-0.0f), a)); }
+  inline __m128 pfLess (__m128 a, __m128 b) { return (_mm_cmplt_ps (a, b)); }
+  inline __m128 pfEqual (__m128 a, __m128 b) { return (_mm_cmpeq_ps (a, b)); }
+  inline __m128 pfOr (__m128 a, __m128 b) { return (_mm_or_ps (a, b)); }
+  inline __m128 pfSelect (__m128 mask, __m128 a, __m128 b) { return (_mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b))); }
+#endif
+
+  template <typename Packet> inline Packet pfConstant (float a);
+  template <> inline float pfConstant<float> (float a) { return (pfSet1 (a)); }
+#if defined __SSE2__
+  template <> inline __m128 pfConstant<__m128> (float a) { return (pfSet1Packet (a)); }
+#endif
+
+  /** \brief The pair features of computePairFeatures for a source point and a packet of target points. f1 is
+    * left to the caller, which gets the arguments of atan2 for it in f1_y and f1_x.
+    * \return a mask of the pairs whose features could not be computed, for which all features are set to 0
+    */
+  template <typename Packet, typename Mask> inline Mask
+  pfPairFeatures (const Packet p1[3], const Packet n1[3], const Packet p2[3], const Packet n2[3],
+                  Packet &f1_y, Packet &f1_x, Packet &f2, Packet &f3, Packet &f4)
+  {
+    const Packet zero = pfConstant<Packet> (0.0f);
+    Packet dp[3] = { pfSub (p2[0], p1[0]), pfSub (p2[1], p1[1]), pfSub (p2[2], p1[2]) };
+    f4 = pfSqrt (pfAdd (pfAdd (pfMul (dp[0], dp[0]), pfMul (dp[1], dp[1])), pfMul (dp[2], dp[2])));
+
+    const Packet angle1 = pfDiv (pfAdd (pfAdd (pfMul (n1[0], dp[0]), pfMul (n1[1], dp[1])), pfMul (n1[2], dp[2])), f4);
+    const Packet angle2 = pfDiv (pfAdd (pfAdd (pfMul (n2[0], dp[0]), pfMul (n2[1], dp[1])), pfMul (n2[2], dp[2])), f4);
+
+    // Make sure the same point is selected as 1 and 2 for each pair. acos is decreasing, so comparing
+    // acos (|angle1|) > acos (|angle2|) is the same as comparing |angle1| < |angle2|.
+    const Mask swap = pfLess (pfAbs (angle1), pfAbs (angle2));
+    Packet u[3], n[3];
+    for (int d = 0; d < 3; ++d)
+    {
+      u[d] = pfSelect (swap, n2[d], n1[d]);
+      n[d] = pfSelect (swap, n1[d], n2[d]);
+      dp[d] = pfSelect (swap, pfSub (zero, dp[d]), dp[d]);
+    }
+    f3 = pfSelect (swap, pfSub (zero, angle2), angle1);
+
+    // Create a Darboux frame coordinate system u-v-w
+    // u = n1; v = (p_idx - q_idx) x u / || (p_idx - q_idx) x u ||; w = u x v
+    Packet v[3] = { pfSub (pfMul (dp[1], u[2]), pfMul (dp[2], u[1])),
+                    pfSub (pfMul (dp[2], u[0]), pfMul (dp[0], u[2])),
+                    pfSub (pfMul (dp[0], u[1]), pfMul (dp[1], u[0])) };
+    const Packet v_norm = pfSqrt (pfAdd (pfAdd (pfMul (v[0], v[0]), pfMul (v[1], v[1])), pfMul (v[2], v[2])));
+    for (int d = 0; d < 3; ++d)
+      v[d] = pfDiv (v[d], v_norm);
+    const Packet w[3] = { pfSub (pfMul (u[1], v[2]), pfMul (u[2], v[1])),
+                          pfSub (pfMul (u[2], v[0]), pfMul (u[0], v[2])),
+                          pfSub (pfMul (u[0], v[1]), pfMul (u[1], v[0])) };
+
+    f2 = pfAdd (pfAdd (pfMul (v[0], n[0]), pfMul (v[1], n[1])), pfMul (v[2], n[2]));
+    // f1 = arctan (w * n2, u * n2) i.e. angle of n2 in the x=u, y=w coordinate system
+    f1_y = pfAdd (pfAdd (pfMul (w[0], n[0]), pfMul (w[1], n[1])), pfMul (w[2], n[2]));
+    f1_x = pfAdd (pfAdd (pfMul (u[0], n[0]), pfMul (u[1], n[1])), pfMul (u[2], n[2]));
+
+    const Mask invalid = pfOr (pfEqual (f4, zero), pfEqual (v_norm, zero));
+    // atan2f (0, 0) is 0
+    f1_y = pfSelect (invalid, zero, f1_y);
+    f1_x = pfSelect (invalid, zero, f1_x);
+    f2 = pfSelect (invalid, zero, f2);
+    f3 = pfSelect (invalid, zero, f3);
+    f4 = pfSelect (invalid, zero, f4);
+    return (invalid);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::computePairFeatures (const Eigen::Vector4f &p1, const Eigen::Vector4f &n1,
+                          const float *x, const float *y, const float *z,
+                          const float *normal_x, const float *normal_y, const float *normal_z, int nr_pairs,
+                          float *f1, float *f2, float *f3, float *f4, unsigned char *valid)
+{
+  int nr_valid = 0;
+  int i = 0;
+#if defined __SSE2__
+  const __m128 p1_packet[3] = { _mm_set1_ps (p1[0]), _mm_set1_ps (p1[1]), _mm_set1_ps (p1[2]) };
+  const __m128 n1_packet[3] = { _mm_set1_ps (n1[0]), _mm_set1_ps (n1[1]), _mm_set1_ps (n1[2]) };
+  for (; i + 4 <= nr_pairs; i += 4)
+  {
+    const __m128 p2[3] = { _mm_loadu_ps (x + i), _mm_loadu_ps (y + i), _mm_loadu_ps (z + i) };
+    const __m128 n2[3] = { _mm_loadu_ps (normal_x + i), _mm_loadu_ps (normal_y + i), _mm_loadu_ps (normal_z + i) };
+    __m128 r1_y, r1_x, r2, r3, r4;
+    const int invalid = _mm_movemask_ps (pfPairFeatures<__m128, __m128> (p1_packet, n1_packet, p2, n2,
+                                                                          r1_y, r1_x, r2, r3, r4));
+    float f1_x[4];
+    _mm_storeu_ps (f1 + i, r1_y);
+    _mm_storeu_ps (f1_x, r1_x);
+    _mm_storeu_ps (f2 + i, r2);
+    _mm_storeu_ps (f3 + i, r3);
+    _mm_storeu_ps (f4 + i, r4);
+    for (int j = 0; j < 4; ++j)
+    {
+      // The exact atan2f of computePairFeatures, so that the histograms built from f1 do not change
+      f1[i + j] = atan2f (f1[i + j], f1_x[j]);
+      valid[i + j] = static_cast<unsigned char> (((invalid >> j) & 1) ^ 1);
+      nr_valid += valid[i + j];
+    }
+  }
+#endif
+  const float p1_scalar[3] = { p1[0], p1[1], p1[2] };
+  const float n1_scalar[3] = { n1[0], n1[1], n1[2] };
+  for (; i < nr_pairs; ++i)
+  {
+    const float p2[3] = { x[i], y[i], z[i] };
+    const float n2[3] = { normal_x[i], normal_y[i], normal_z[i] };
+    float f1_x;
+    valid[i] = !pfPairFeatures<float, bool> (p1_scalar, n1_scalar, p2, n2, f1[i], f1_x, f2[i], f3[i], f4[i]);
+    f1[i] = atan2f (f1[i], f1_x);
+    nr_valid += valid[i];
+  }
+  return (nr_valid);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PairFeatureBatch::compute (const Eigen::Vector4f &p1, const Eigen::Vector4f &n1)
+{
+  const size_t nr_pairs = x.size ();
+  f1.resize (nr_pairs);
+  f2.resize (nr_pairs);
+  f3.resize (nr_pairs);
+  f4.resize (nr_pairs);
+  valid.resize (nr_pairs);
+  if (nr_pairs == 0)
+    return (0);
+  return (computePairFeatures (p1, n1, &x[0], &y[0], &z[0], &normal_x[0], &normal_y[0], &normal_z[0],
+                               static_cast<int> (nr_pairs), &f1[0], &f2[0], &f3[0], &f4[0], &valid[0]));
+}
+
 // Instantiations of specific point types
 #ifdef PCL_ONLY_CORE_POINT_TYPES
   PCL_INSTANTIATE_PRODUCT(PFHEstimation, ((pcl::PointXYZ)(pcl::PointXYZI)(pcl::PointXYZRGB)(pcl::PointXYZRGBA))((pcl::Normal))((pcl::PFHSignature125)))
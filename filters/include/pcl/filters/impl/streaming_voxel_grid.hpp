@@ -0,0 +1,209 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FILTERS_IMPL_STREAMING_VOXEL_GRID_H_
+#define PCL_FILTERS_IMPL_STREAMING_VOXEL_GRID_H_
+
+#include <pcl/common/io.h>
+#include <pcl/filters/streaming_voxel_grid.h>
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::StreamingVoxelGrid<PointT>::getRGBAOffset () const
+{
+  if (!downsample_all_data_)
+    return (-1);
+
+  PointCloud dummy;
+  std::vector<sensor_msgs::PointField> fields;
+  int rgba_index = pcl::getFieldIndex (dummy, "rgb", fields);
+  if (rgba_index == -1)
+    rgba_index = pcl::getFieldIndex (dummy, "rgba", fields);
+  if (rgba_index >= 0)
+    rgba_index = fields[rgba_index].offset;
+  return (rgba_index);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::addPoints (const PointCloud &cloud, PointCloud &output)
+{
+  int centroid_size = 4;
+  if (downsample_all_data_)
+    centroid_size = boost::mpl::size<FieldList>::value;
+
+  // ---[ RGB special case
+  int rgba_index = getRGBAOffset ();
+  if (rgba_index >= 0)
+    centroid_size += 3;
+
+  ++nr_batches_;
+  Eigen::VectorXf scratch = Eigen::VectorXf::Zero (centroid_size);
+
+  for (size_t cp = 0; cp < cloud.points.size (); ++cp)
+  {
+    if (!cloud.is_dense)
+      // Check if the point is invalid
+      if (!pcl_isfinite (cloud.points[cp].x) || 
+          !pcl_isfinite (cloud.points[cp].y) || 
+          !pcl_isfinite (cloud.points[cp].z))
+        continue;
+
+    VoxelKey key (static_cast<int> (floor (cloud.points[cp].x * inverse_leaf_size_[0])),
+                  static_cast<int> (floor (cloud.points[cp].y * inverse_leaf_size_[1])),
+                  static_cast<int> (floor (cloud.points[cp].z * inverse_leaf_size_[2])));
+
+    Leaf &leaf = leaves_[key];
+    if (leaf.count == 0)
+      leaf.centroid = Eigen::VectorXf::Zero (centroid_size);
+    ++leaf.count;
+    leaf.last_batch = nr_batches_;
+
+    if (!downsample_all_data_)
+    {
+      leaf.centroid[0] += cloud.points[cp].x;
+      leaf.centroid[1] += cloud.points[cp].y;
+      leaf.centroid[2] += cloud.points[cp].z;
+      continue;
+    }
+
+    // Unpack the point into scratch, then accumulate
+    // ---[ RGB special case
+    if (rgba_index >= 0)
+    {
+      // fill r/g/b data
+      pcl::RGB rgb;
+      memcpy (&rgb, reinterpret_cast<const char*> (&cloud.points[cp]) + rgba_index, sizeof (RGB));
+      scratch[centroid_size-3] = rgb.r;
+      scratch[centroid_size-2] = rgb.g;
+      scratch[centroid_size-1] = rgb.b;
+    }
+    pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (cloud.points[cp], scratch));
+    leaf.centroid += scratch;
+  }
+
+  if (leaves_.size () > max_voxels_)
+    evictLeaves (output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::evictLeaves (PointCloud &output)
+{
+  // Find the batch stamp below which (inclusive) enough voxels are finalized
+  size_t nr_evicted = leaves_.size () - max_voxels_;
+  std::vector<unsigned int> batches;
+  batches.reserve (leaves_.size ());
+  for (typename LeafMap::const_iterator it = leaves_.begin (); it != leaves_.end (); ++it)
+    batches.push_back (it->second.last_batch);
+  std::nth_element (batches.begin (), batches.begin () + (nr_evicted - 1), batches.end ());
+  unsigned int last_evicted_batch = batches[nr_evicted - 1];
+  std::vector<unsigned int> ().swap (batches);
+
+  int rgba_index = getRGBAOffset ();
+  output.points.reserve (output.points.size () + nr_evicted);
+
+  // Voxels last updated in the same batch are finalized together
+  typename LeafMap::iterator it = leaves_.begin ();
+  while (it != leaves_.end ())
+  {
+    if (it->second.last_batch <= last_evicted_batch)
+    {
+      emitLeaf (it->second, rgba_index, output);
+      it = leaves_.erase (it);
+    }
+    else
+      ++it;
+  }
+
+  output.width    = static_cast<uint32_t> (output.points.size ());
+  output.height   = 1;                    // downsampling breaks the organized structure
+  output.is_dense = true;                 // we filter out invalid points
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::flush (PointCloud &output)
+{
+  int rgba_index = getRGBAOffset ();
+  output.points.reserve (output.points.size () + leaves_.size ());
+  for (typename LeafMap::const_iterator it = leaves_.begin (); it != leaves_.end (); ++it)
+    emitLeaf (it->second, rgba_index, output);
+  reset ();
+
+  output.width    = static_cast<uint32_t> (output.points.size ());
+  output.height   = 1;                    // downsampling breaks the organized structure
+  output.is_dense = true;                 // we filter out invalid points
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::emitLeaf (const Leaf &leaf, int rgba_index, PointCloud &output) const
+{
+  Eigen::VectorXf centroid = leaf.centroid / static_cast<float> (leaf.count);
+  PointT point;
+
+  // Do we need to process all the fields?
+  if (!downsample_all_data_)
+  {
+    point.x = centroid[0];
+    point.y = centroid[1];
+    point.z = centroid[2];
+  }
+  else
+  {
+    pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor <PointT> (centroid, point));
+    // ---[ RGB special case
+    if (rgba_index >= 0)
+    {
+      // pack r/g/b into rgb
+      int centroid_size = static_cast<int> (centroid.size ());
+      float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
+      int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
+      memcpy (reinterpret_cast<char*> (&point) + rgba_index, &rgb, sizeof (float));
+    }
+  }
+  output.points.push_back (point);
+}
+
+#define PCL_INSTANTIATE_StreamingVoxelGrid(T) template class PCL_EXPORTS pcl::StreamingVoxelGrid<T>;
+
+#endif    // PCL_FILTERS_IMPL_STREAMING_VOXEL_GRID_H_
@@ -40,6 +40,10 @@
 
 #include <pcl/common/common.h>
 #include <pcl/filters/voxel_grid.h>
+#include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
@@ -121,13 +125,90 @@ pcl::getMinMax3D (const typename pcl::PointCloud<PointT>::ConstPtr &cloud,
 
 struct cloud_point_index_idx 
 {
-  unsigned int idx;
+  uint64_t idx;
   unsigned int cloud_point_index;
 
-  cloud_point_index_idx (unsigned int idx_, unsigned int cloud_point_index_) : idx (idx_), cloud_point_index (cloud_point_index_) {}
-  bool operator < (const cloud_point_index_idx &p) const { return (idx < p.idx); }
+  cloud_point_index_idx (uint64_t idx_, unsigned int cloud_point_index_) : idx (idx_), cloud_point_index (cloud_point_index_) {}
+  // Ties are broken on the point index, so that the order of the points inside a cell (and thus the
+  // floating point summation order of the centroid) does not depend on the sorting algorithm used
+  bool operator < (const cloud_point_index_idx &p) const { return (idx < p.idx || (idx == p.idx && cloud_point_index < p.cloud_point_index)); }
 };
 
+namespace pcl
+{
+  /** \brief Sort a vector of (voxel index, point index) pairs on the voxel index, using a parallel least
+    * significant digit radix sort. The sort is stable, which makes the result identical to an std::sort
+    * of an index_vector filled in increasing point index order.
+    * \param[in,out] index_vector the vector to sort
+    * \param[in] max_idx an upper bound for the voxel indices, used to skip the unnecessary digits
+    * \param[in] nr_threads the number of threads to use
+    */
+  inline void
+  radixSortVoxelIndices (std::vector<cloud_point_index_idx> &index_vector, uint64_t max_idx, int nr_threads)
+  {
+    const int radix_bits = 11;
+    const size_t radix_size = size_t (1) << radix_bits;
+    const uint64_t radix_mask = radix_size - 1;
+
+    const size_t nr_entries = index_vector.size ();
+    if (nr_entries < 2)
+      return;
+
+    std::vector<cloud_point_index_idx> buffer (nr_entries, cloud_point_index_idx (0, 0));
+    cloud_point_index_idx *src = &index_vector[0];
+    cloud_point_index_idx *dst = &buffer[0];
+
+    // One histogram per thread, each thread processes the same contiguous chunk in all passes
+    std::vector<size_t> histograms (nr_threads * radix_size);
+
+    for (int shift = 0; shift < 64 && (max_idx >> shift) > 0; shift += radix_bits)
+    {
+      std::fill (histograms.begin (), histograms.end (), 0);
+
+#pragma omp parallel for num_threads (nr_threads) schedule (static, 1)
+      for (int t = 0; t < nr_threads; ++t)
+      {
+        size_t *histogram = &histograms[t * radix_size];
+        const size_t end = nr_entries * (t + 1) / nr_threads;
+        for (size_t i = nr_entries * t / nr_threads; i < end; ++i)
+          ++histogram[(src[i].idx >> shift) & radix_mask];
+      }
+
+      // Exclusive prefix sum in (digit, thread) order, which keeps the sort stable
+      bool single_digit = false;
+      size_t offset = 0;
+      for (size_t d = 0; d < radix_size; ++d)
+      {
+        const size_t digit_start = offset;
+        for (int t = 0; t < nr_threads; ++t)
+        {
+          const size_t count = histograms[t * radix_size + d];
+          histograms[t * radix_size + d] = offset;
+          offset += count;
+        }
+        if (offset - digit_start == nr_entries)
+          single_digit = true;
+      }
+      // All the entries share the same digit, nothing to reorder
+      if (single_digit)
+        continue;
+
+#pragma omp parallel for num_threads (nr_threads) schedule (static, 1)
+      for (int t = 0; t < nr_threads; ++t)
+      {
+        size_t *histogram = &histograms[t * radix_size];
+        const size_t end = nr_entries * (t + 1) / nr_threads;
+        for (size_t i = nr_entries * t / nr_threads; i < end; ++i)
+          dst[histogram[(src[i].idx >> shift) & radix_mask]++] = src[i];
+      }
+      std::swap (src, dst);
+    }
+
+    if (src != &index_vector[0])
+      index_vector.swap (buffer);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
@@ -152,6 +233,22 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
   else
     getMinMax3D<PointT>(*input_, min_p, max_p);
 
+  // Check that the leaf size is not too small, given the size of the data. The voxel index is stored on 64 bits,
+  // so only the number of divisions along each axis has to fit into an integer, unless the leaf layout is saved:
+  // the layout and its accessors use integer indices
+  double dx = floor (max_p[0] * inverse_leaf_size_[0]) - floor (min_p[0] * inverse_leaf_size_[0]) + 1;
+  double dy = floor (max_p[1] * inverse_leaf_size_[1]) - floor (min_p[1] * inverse_leaf_size_[1]) + 1;
+  double dz = floor (max_p[2] * inverse_leaf_size_[2]) - floor (min_p[2] * inverse_leaf_size_[2]) + 1;
+  const double max_nr_voxels = save_leaf_layout_ ? static_cast<double> (std::numeric_limits<int>::max ())
+                                                 : static_cast<double> (std::numeric_limits<int64_t>::max ());
+  if (dx > std::numeric_limits<int>::max () || dy > std::numeric_limits<int>::max () || dz > std::numeric_limits<int>::max () ||
+      dx * dy * dz > max_nr_voxels)
+  {
+    PCL_WARN ("[pcl::%s::applyFilter] Leaf size is too small for the input dataset. Integer indices would overflow.\n", getClassName ().c_str ());
+    output = *input_;
+    return;
+  }
+
   // Compute the minimum and maximum bounding box values
   min_b_[0] = static_cast<int> (floor (min_p[0] * inverse_leaf_size_[0]));
   max_b_[0] = static_cast<int> (floor (max_p[0] * inverse_leaf_size_[0]));
@@ -164,8 +261,22 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
   div_b_ = max_b_ - min_b_ + Eigen::Vector4i::Ones ();
   div_b_[3] = 0;
 
-  // Set up the division multiplier
-  divb_mul_ = Eigen::Vector4i (1, div_b_[0], div_b_[0] * div_b_[1], 0);
+  // Set up the division multiplier. Its z component only fits into an integer if the grid has less than
+  // INT_MAX voxels, which is always the case when the leaf layout is saved
+  divb_mul_ = Eigen::Vector4i (1, div_b_[0], static_cast<int> (std::min (static_cast<int64_t> (div_b_[0]) * div_b_[1],
+                                                                        static_cast<int64_t> (std::numeric_limits<int>::max ()))), 0);
+
+  // The voxel index is computed on 64 bits, so that large extents with small leaf sizes do not overflow
+  const uint64_t divb_mul_y = static_cast<uint64_t> (div_b_[0]);
+  const uint64_t divb_mul_z = static_cast<uint64_t> (div_b_[0]) * static_cast<uint64_t> (div_b_[1]);
+
+  int nr_threads = static_cast<int> (threads_);
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    nr_threads = omp_get_max_threads ();
+#else
+  nr_threads = 1;
+#endif
 
   int centroid_size = 4;
   if (downsample_all_data_)
@@ -183,22 +294,33 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
     centroid_size += 3;
   }
 
-  std::vector<cloud_point_index_idx> index_vector;
-  index_vector.reserve(input_->points.size());
-
   // If we don't want to process the entire cloud, but rather filter points far away from the viewpoint first...
+  std::vector<sensor_msgs::PointField> distance_fields;
+  int distance_idx = -1;
   if (!filter_field_name_.empty ())
   {
     // Get the distance field index
-    std::vector<sensor_msgs::PointField> fields;
-    int distance_idx = pcl::getFieldIndex (*input_, filter_field_name_, fields);
+    distance_idx = pcl::getFieldIndex (*input_, filter_field_name_, distance_fields);
     if (distance_idx == -1)
       PCL_WARN ("[pcl::%s::applyFilter] Invalid filter field name. Index is %d.\n", getClassName ().c_str (), distance_idx);
+  }
+
+  // First pass: go over all points and insert them into the index_vector vector
+  // with calculated idx. Points with the same idx value will contribute to the
+  // same point of resulting CloudPoint. Every thread fills its own bucket with a
+  // contiguous chunk of the input, so that the concatenated buckets are ordered by point index
+  const unsigned int nr_points = static_cast<unsigned int> (input_->points.size ());
+  std::vector<std::vector<cloud_point_index_idx> > buckets (nr_threads);
+
+#pragma omp parallel for num_threads (nr_threads) schedule (static, 1)
+  for (int t = 0; t < nr_threads; ++t)
+  {
+    const unsigned int begin = static_cast<unsigned int> (static_cast<uint64_t> (nr_points) * t / nr_threads);
+    const unsigned int end = static_cast<unsigned int> (static_cast<uint64_t> (nr_points) * (t + 1) / nr_threads);
+    std::vector<cloud_point_index_idx> &bucket = buckets[t];
+    bucket.reserve (end - begin);
 
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    for (unsigned int cp = 0; cp < static_cast<unsigned int> (input_->points.size ()); ++cp)
+    for (unsigned int cp = begin; cp < end; ++cp)
     {
       if (!input_->is_dense)
         // Check if the point is invalid
@@ -207,74 +329,70 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
             !pcl_isfinite (input_->points[cp].z))
           continue;
 
-      // Get the distance value
-      const uint8_t* pt_data = reinterpret_cast<const uint8_t*> (&input_->points[cp]);
-      float distance_value = 0;
-      memcpy (&distance_value, pt_data + fields[distance_idx].offset, sizeof (float));
-
-      if (filter_limit_negative_)
-      {
-        // Use a threshold for cutting out points which inside the interval
-        if ((distance_value < filter_limit_max_) && (distance_value > filter_limit_min_))
-          continue;
-      }
-      else
+      if (distance_idx != -1)
       {
-        // Use a threshold for cutting out points which are too close/far away
-        if ((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_))
-          continue;
+        // Get the distance value
+        const uint8_t* pt_data = reinterpret_cast<const uint8_t*> (&input_->points[cp]);
+        float distance_value = 0;
+        memcpy (&distance_value, pt_data + distance_fields[distance_idx].offset, sizeof (float));
+
+        if (filter_limit_negative_)
+        {
+          // Use a threshold for cutting out points which inside the interval
+          if ((distance_value < filter_limit_max_) && (distance_value > filter_limit_min_))
+            continue;
+        }
+        else
+        {
+          // Use a threshold for cutting out points which are too close/far away
+          if ((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_))
+            continue;
+        }
       }
-      
+
       int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
       int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
       int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
 
       // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.push_back (cloud_point_index_idx (static_cast<unsigned int> (idx), cp));
+      uint64_t idx = static_cast<uint64_t> (ijk0) + static_cast<uint64_t> (ijk1) * divb_mul_y + static_cast<uint64_t> (ijk2) * divb_mul_z;
+      bucket.push_back (cloud_point_index_idx (idx, cp));
     }
   }
-  // No distance filtering, process all data
+
+  std::vector<cloud_point_index_idx> index_vector;
+  if (nr_threads == 1)
+    index_vector.swap (buckets[0]);
   else
   {
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    for (unsigned int cp = 0; cp < static_cast<unsigned int> (input_->points.size ()); ++cp)
-    {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) || 
-            !pcl_isfinite (input_->points[cp].y) || 
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
-
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
+    std::vector<size_t> bucket_offsets (nr_threads + 1, 0);
+    for (int t = 0; t < nr_threads; ++t)
+      bucket_offsets[t + 1] = bucket_offsets[t] + buckets[t].size ();
+    index_vector.resize (bucket_offsets[nr_threads], cloud_point_index_idx (0, 0));
 
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.push_back (cloud_point_index_idx (static_cast<unsigned int> (idx), cp));
+#pragma omp parallel for num_threads (nr_threads) schedule (static, 1)
+    for (int t = 0; t < nr_threads; ++t)
+    {
+      std::copy (buckets[t].begin (), buckets[t].end (), index_vector.begin () + bucket_offsets[t]);
+      std::vector<cloud_point_index_idx> ().swap (buckets[t]);
     }
   }
 
   // Second pass: sort the index_vector vector using value representing target cell as index
   // in effect all points belonging to the same output cell will be next to each other
-  std::sort (index_vector.begin (), index_vector.end (), std::less<cloud_point_index_idx> ());
+  if (nr_threads == 1)
+    std::sort (index_vector.begin (), index_vector.end (), std::less<cloud_point_index_idx> ());
+  else
+    radixSortVoxelIndices (index_vector, divb_mul_z * static_cast<uint64_t> (div_b_[2]), nr_threads);
 
-  // Third pass: count output cells
+  // Third pass: find the first entry of each output cell
   // we need to skip all the same, adjacenent idx values
-  unsigned int total = 0;
-  unsigned int index = 0;
-  while (index < index_vector.size ()) 
-  {
-    unsigned int i = index + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[index].idx) 
-      ++i;
-    ++total;
-    index = i;
-  }
+  std::vector<unsigned int> first_entries;
+  for (unsigned int i = 0; i < static_cast<unsigned int> (index_vector.size ()); ++i)
+    if (i == 0 || index_vector[i].idx != index_vector[i - 1].idx)
+      first_entries.push_back (i);
+  unsigned int total = static_cast<unsigned int> (first_entries.size ());
+  first_entries.push_back (static_cast<unsigned int> (index_vector.size ()));
 
   // Fourth pass: compute centroids, insert them into their final position
   output.points.resize (total);
@@ -304,42 +422,24 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
     }
   }
   
-  index = 0;
-  Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
-  Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
-
-  for (unsigned int cp = 0; cp < index_vector.size ();)
+  // Every output cell is reduced independently, in the point index order given by the sort
+#pragma omp parallel num_threads (nr_threads)
   {
-    // calculate centroid - sum values from all input points, that have the same idx value in index_vector array
-    if (!downsample_all_data_) 
-    {
-      centroid[0] = input_->points[index_vector[cp].cloud_point_index].x;
-      centroid[1] = input_->points[index_vector[cp].cloud_point_index].y;
-      centroid[2] = input_->points[index_vector[cp].cloud_point_index].z;
-    }
-    else 
-    {
-      // ---[ RGB special case
-      if (rgba_index >= 0)
-      {
-        // Fill r/g/b data, assuming that the order is BGRA
-        pcl::RGB rgb;
-        memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[cp].cloud_point_index]) + rgba_index, sizeof (RGB));
-        centroid[centroid_size-3] = rgb.r;
-        centroid[centroid_size-2] = rgb.g;
-        centroid[centroid_size-1] = rgb.b;
-      }
-      pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[cp].cloud_point_index], centroid));
-    }
+    Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
+    Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
 
-    unsigned int i = cp + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[cp].idx) 
+#pragma omp for schedule (static)
+    for (int index = 0; index < static_cast<int> (total); ++index)
     {
+      unsigned int cp = first_entries[index];
+      unsigned int last = first_entries[index + 1];
+
+      // calculate centroid - sum values from all input points, that have the same idx value in index_vector array
       if (!downsample_all_data_) 
       {
-        centroid[0] += input_->points[index_vector[i].cloud_point_index].x;
-        centroid[1] += input_->points[index_vector[i].cloud_point_index].y;
-        centroid[2] += input_->points[index_vector[i].cloud_point_index].z;
+        centroid[0] = input_->points[index_vector[cp].cloud_point_index].x;
+        centroid[1] = input_->points[index_vector[cp].cloud_point_index].y;
+        centroid[2] = input_->points[index_vector[cp].cloud_point_index].z;
       }
       else 
       {
@@ -348,45 +448,66 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
         {
           // Fill r/g/b data, assuming that the order is BGRA
           pcl::RGB rgb;
-          memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[i].cloud_point_index]) + rgba_index, sizeof (RGB));
-          temporary[centroid_size-3] = rgb.r;
-          temporary[centroid_size-2] = rgb.g;
-          temporary[centroid_size-1] = rgb.b;
+          memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[cp].cloud_point_index]) + rgba_index, sizeof (RGB));
+          centroid[centroid_size-3] = rgb.r;
+          centroid[centroid_size-2] = rgb.g;
+          centroid[centroid_size-1] = rgb.b;
+        }
+        pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[cp].cloud_point_index], centroid));
+      }
+
+      for (unsigned int i = cp + 1; i < last; ++i)
+      {
+        if (!downsample_all_data_) 
+        {
+          centroid[0] += input_->points[index_vector[i].cloud_point_index].x;
+          centroid[1] += input_->points[index_vector[i].cloud_point_index].y;
+          centroid[2] += input_->points[index_vector[i].cloud_point_index].z;
+        }
+        else 
+        {
+          // ---[ RGB special case
+          if (rgba_index >= 0)
+          {
+            // Fill r/g/b data, assuming that the order is BGRA
+            pcl::RGB rgb;
+            memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[i].cloud_point_index]) + rgba_index, sizeof (RGB));
+            temporary[centroid_size-3] = rgb.r;
+            temporary[centroid_size-2] = rgb.g;
+            temporary[centroid_size-1] = rgb.b;
+          }
+          pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[i].cloud_point_index], temporary));
+          centroid += temporary;
         }
-        pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[i].cloud_point_index], temporary));
-        centroid += temporary;
       }
-      ++i;
-    }
 
-    // index is centroid final position in resulting PointCloud
-    if (save_leaf_layout_)
-      leaf_layout_[index_vector[cp].idx] = index;
+      // index is centroid final position in resulting PointCloud
+      if (save_leaf_layout_)
+        leaf_layout_[index_vector[cp].idx] = index;
 
-    centroid /= static_cast<float> (i - cp);
+      centroid /= static_cast<float> (last - cp);
 
-    // store centroid
-    // Do we need to process all the fields?
-    if (!downsample_all_data_) 
-    {
-      output.points[index].x = centroid[0];
-      output.points[index].y = centroid[1];
-      output.points[index].z = centroid[2];
-    }
-    else 
-    {
-      pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor <PointT> (centroid, output.points[index]));
-      // ---[ RGB special case
-      if (rgba_index >= 0) 
+      // store centroid
+      // Do we need to process all the fields?
+      if (!downsample_all_data_) 
       {
-        // pack r/g/b into rgb
-        float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
-        int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
-        memcpy (reinterpret_cast<char*> (&output.points[index]) + rgba_index, &rgb, sizeof (float));
+        output.points[index].x = centroid[0];
+        output.points[index].y = centroid[1];
+        output.points[index].z = centroid[2];
+      }
+      else 
+      {
+        pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor <PointT> (centroid, output.points[index]));
+        // ---[ RGB special case
+        if (rgba_index >= 0) 
+        {
+          // pack r/g/b into rgb
+          float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
+          int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
+          memcpy (reinterpret_cast<char*> (&output.points[index]) + rgba_index, &rgb, sizeof (float));
+        }
       }
     }
-    cp = i;
-    ++index;
   }
   output.width = static_cast<uint32_t> (output.points.size ());
 }
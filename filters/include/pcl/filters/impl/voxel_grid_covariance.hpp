@@ -359,27 +359,35 @@ pcl::VoxelGridCovariance<PointT>::applyFilter (PointCloud &output)
 //////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> int
 pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors)
+{
+  // Slower than radius search because needs to check 26 indices
+  return (getNeighborhoodAtPoint (pcl::getAllNeighborCellIndices (), reference_point, neighbors));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const Eigen::MatrixXi &relative_coordinates,
+                                                          const PointT& reference_point,
+                                                          std::vector<LeafConstPtr> &neighbors) const
 {
   neighbors.clear ();
 
   // Find displacement coordinates
-  Eigen::MatrixXi relative_coordinates = pcl::getAllNeighborCellIndices ();
-  Eigen::Vector4i ijk (static_cast<int> (floor (reference_point.x / leaf_size_[0])), 
-                       static_cast<int> (floor (reference_point.y / leaf_size_[1])), 
-                       static_cast<int> (floor (reference_point.z / leaf_size_[2])), 0);
+  Eigen::Vector4i ijk (static_cast<int> (floor (reference_point.x * inverse_leaf_size_[0])),
+                       static_cast<int> (floor (reference_point.y * inverse_leaf_size_[1])),
+                       static_cast<int> (floor (reference_point.z * inverse_leaf_size_[2])), 0);
   Eigen::Array4i diff2min = min_b_ - ijk;
   Eigen::Array4i diff2max = max_b_ - ijk;
   neighbors.reserve (relative_coordinates.cols ());
 
   // Check each neighbor to see if it is occupied and contains sufficient points
-  // Slower than radius search because needs to check 26 indices
   for (int ni = 0; ni < relative_coordinates.cols (); ni++)
   {
     Eigen::Vector4i displacement = (Eigen::Vector4i () << relative_coordinates.col (ni), 0).finished ();
     // Checking if the specified cell is in the grid
     if ((diff2min <= displacement.array ()).all () && (diff2max >= displacement.array ()).all ())
     {
-      typename boost::unordered_map<size_t, Leaf>::iterator leaf_iter = leaves_.find (((ijk + displacement - min_b_).dot (divb_mul_)));
+      typename boost::unordered_map<size_t, Leaf>::const_iterator leaf_iter = leaves_.find (((ijk + displacement - min_b_).dot (divb_mul_)));
       if (leaf_iter != leaves_.end () && leaf_iter->second.nr_points >= min_points_per_voxel_)
       {
         LeafConstPtr leaf = &(leaf_iter->second);
@@ -0,0 +1,258 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FILTERS_STREAMING_VOXEL_GRID_H_
+#define PCL_FILTERS_STREAMING_VOXEL_GRID_H_
+
+#include <pcl/filters/boost.h>
+#include <pcl/point_cloud.h>
+
+namespace pcl
+{
+  /** \brief StreamingVoxelGrid downsamples a point cloud that is given in batches, without ever holding the
+    * complete input cloud in memory.
+    *
+    * Every batch passed to \ref addPoints is binned into a hash map of voxel accumulators, which store the
+    * running sums of the point fields. The number of accumulators is bounded by \ref setMaximumNumberOfVoxels:
+    * once a batch makes the map exceed this bound, the voxels that have not received any point for the
+    * longest time are finalized, i.e., their centroids are appended to the output cloud and their memory is
+    * released. A call to \ref flush finalizes all the remaining voxels.
+    *
+    * For spatially coherent streams (e.g., survey data read tile by tile, or consecutive scans of a moving
+    * sensor) this produces the same centroids as \ref VoxelGrid. If points of an already finalized voxel
+    * arrive later on, a second centroid is emitted for that voxel.
+    *
+    * \code
+    * pcl::StreamingVoxelGrid<pcl::PointXYZ> grid;
+    * grid.setLeafSize (0.1f, 0.1f, 0.1f);
+    * grid.setMaximumNumberOfVoxels (50000000);
+    * pcl::PointCloud<pcl::PointXYZ> output;
+    * while (readNextBatch (batch))
+    *   grid.addPoints (batch, output);
+    * grid.flush (output);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+  template <typename PointT>
+  class StreamingVoxelGrid
+  {
+    public:
+      typedef pcl::PointCloud<PointT> PointCloud;
+      typedef typename PointCloud::Ptr PointCloudPtr;
+      typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+      typedef boost::shared_ptr<StreamingVoxelGrid<PointT> > Ptr;
+      typedef boost::shared_ptr<const StreamingVoxelGrid<PointT> > ConstPtr;
+
+      /** \brief Empty constructor. */
+      StreamingVoxelGrid () :
+        leaf_size_ (Eigen::Vector3f::Ones ()),
+        inverse_leaf_size_ (Eigen::Array3f::Ones ()),
+        downsample_all_data_ (true),
+        max_voxels_ (10000000),
+        leaves_ (),
+        nr_batches_ (0)
+      {
+      }
+
+      /** \brief Destructor. */
+      virtual ~StreamingVoxelGrid ()
+      {
+      }
+
+      /** \brief Set the voxel grid leaf size.
+        * \param[in] leaf_size the voxel grid leaf size
+        */
+      inline void 
+      setLeafSize (const Eigen::Vector3f &leaf_size) 
+      { 
+        leaf_size_ = leaf_size; 
+        inverse_leaf_size_ = Eigen::Array3f::Ones () / leaf_size_.array ();
+      }
+
+      /** \brief Set the voxel grid leaf size.
+        * \param[in] lx the leaf size for X
+        * \param[in] ly the leaf size for Y
+        * \param[in] lz the leaf size for Z
+        */
+      inline void
+      setLeafSize (float lx, float ly, float lz)
+      {
+        setLeafSize (Eigen::Vector3f (lx, ly, lz));
+      }
+
+      /** \brief Get the voxel grid leaf size. */
+      inline Eigen::Vector3f 
+      getLeafSize () const { return (leaf_size_); }
+
+      /** \brief Set to true if all fields need to be downsampled, or false if just XYZ.
+        * \note This must not be changed while voxels are being accumulated, i.e., only before the first
+        * batch or after a call to \ref flush or \ref reset.
+        * \param[in] downsample the new value (true/false)
+        */
+      inline void 
+      setDownsampleAllData (bool downsample) { downsample_all_data_ = downsample; }
+
+      /** \brief Get the state of the internal downsampling parameter (true if
+        * all fields need to be downsampled, false if just XYZ). 
+        */
+      inline bool 
+      getDownsampleAllData () const { return (downsample_all_data_); }
+
+      /** \brief Set the maximum number of voxel accumulators kept in memory. The bound is enforced after
+        * every batch, so the peak number of voxels is this value plus the number of voxels of one batch.
+        * \param[in] max_voxels the maximum number of voxels
+        */
+      inline void
+      setMaximumNumberOfVoxels (size_t max_voxels) { max_voxels_ = max_voxels; }
+
+      /** \brief Get the maximum number of voxel accumulators kept in memory. */
+      inline size_t
+      getMaximumNumberOfVoxels () const { return (max_voxels_); }
+
+      /** \brief Get the number of voxels currently being accumulated (i.e., not finalized yet). */
+      inline size_t
+      getNumberOfVoxels () const { return (leaves_.size ()); }
+
+      /** \brief Add a batch of points to the voxel grid. Invalid (NaN/Inf) points are skipped.
+        * \param[in] cloud the batch of points
+        * \param[out] output the cloud the centroids of the finalized voxels are appended to
+        */
+      void
+      addPoints (const PointCloud &cloud, PointCloud &output);
+
+      /** \brief Finalize all the remaining voxels.
+        * \param[out] output the cloud the centroids of the finalized voxels are appended to
+        */
+      void
+      flush (PointCloud &output);
+
+      /** \brief Drop all the voxels being accumulated, without emitting their centroids. */
+      inline void
+      reset ()
+      {
+        leaves_.clear ();
+        nr_batches_ = 0;
+      }
+
+    protected:
+      /** \brief Integer (i, j, k) coordinates of a voxel, used as hash map key. */
+      struct VoxelKey
+      {
+        VoxelKey (int i_, int j_, int k_) : i (i_), j (j_), k (k_) {}
+
+        inline bool
+        operator == (const VoxelKey &key) const { return (i == key.i && j == key.j && k == key.k); }
+
+        int i, j, k;
+      };
+
+      /** \brief Hash functor for \ref VoxelKey. */
+      struct VoxelKeyHash
+      {
+        inline size_t
+        operator () (const VoxelKey &key) const
+        {
+          size_t seed = 0;
+          boost::hash_combine (seed, key.i);
+          boost::hash_combine (seed, key.j);
+          boost::hash_combine (seed, key.k);
+          return (seed);
+        }
+      };
+
+      /** \brief Running sums of the fields of all the points inside a voxel. */
+      struct Leaf
+      {
+        Leaf () : count (0), last_batch (0), centroid () {}
+
+        /** \brief The number of points accumulated in the voxel. */
+        unsigned int count;
+        /** \brief The batch which last added a point to the voxel, used to select the voxels to finalize. */
+        unsigned int last_batch;
+        /** \brief The sum of the point fields (plus r, g, b for RGB data). */
+        Eigen::VectorXf centroid;
+      };
+
+      typedef boost::unordered_map<VoxelKey, Leaf, VoxelKeyHash> LeafMap;
+
+      /** \brief The size of a leaf. */
+      Eigen::Vector3f leaf_size_;
+
+      /** \brief Compute 1/leaf_size_ to avoid division later */ 
+      Eigen::Array3f inverse_leaf_size_;
+
+      /** \brief Set to true if all fields need to be downsampled, or false if just XYZ. */
+      bool downsample_all_data_;
+
+      /** \brief The maximum number of voxel accumulators kept in memory. */
+      size_t max_voxels_;
+
+      /** \brief The voxel accumulators. */
+      LeafMap leaves_;
+
+      /** \brief The number of batches processed since the last reset. */
+      unsigned int nr_batches_;
+
+      typedef typename pcl::traits::fieldList<PointT>::type FieldList;
+
+      /** \brief Finalize the voxels that have not been updated for the longest time, until at most
+        * \a max_voxels_ voxels are left.
+        * \param[out] output the cloud the centroids of the finalized voxels are appended to
+        */
+      void
+      evictLeaves (PointCloud &output);
+
+      /** \brief Append the centroid of a voxel to the output cloud.
+        * \param[in] leaf the voxel to finalize
+        * \param[in] rgba_index the offset of the rgb/rgba field in PointT, or -1
+        * \param[out] output the output cloud
+        */
+      void
+      emitLeaf (const Leaf &leaf, int rgba_index, PointCloud &output) const;
+
+      /** \brief Get the offset of the rgb/rgba field in PointT, or -1 if there is none. */
+      int
+      getRGBAOffset () const;
+  };
+}
+
+#endif  // PCL_FILTERS_STREAMING_VOXEL_GRID_H_
@@ -184,7 +184,8 @@ namespace pcl
         filter_field_name_ (""), 
         filter_limit_min_ (-FLT_MAX), 
         filter_limit_max_ (FLT_MAX),
-        filter_limit_negative_ (false)
+        filter_limit_negative_ (false),
+        threads_ (1)
       {
         filter_name_ = "VoxelGrid";
       }
@@ -270,6 +271,7 @@ namespace pcl
 
       /** \brief Get the multipliers to be applied to the grid coordinates in
         * order to find the centroid index (after filtering is performed). 
+        * \note The z multiplier saturates at INT_MAX on grids that are too large to save their leaf layout.
         */
       inline Eigen::Vector3i 
       getDivisionMultiplier () { return (divb_mul_.head<3> ()); }
@@ -419,6 +421,18 @@ namespace pcl
         return (filter_limit_negative_);
       }
 
+      /** \brief Set the number of threads used to compute the voxel indices, sort them and reduce the centroids.
+        * A value of 1 (default) selects the serial implementation, while any other value switches to a parallel
+        * radix sort based implementation which produces exactly the same output.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+      /** \brief Get the number of threads used to downsample the data. */
+      inline unsigned int
+      getNumberOfThreads () { return (threads_); }
+
     protected:
       /** \brief The size of a leaf. */
       Eigen::Vector4f leaf_size_;
@@ -450,6 +464,9 @@ namespace pcl
       /** \brief Set to true if we want to return the data outside (\a filter_limit_min_;\a filter_limit_max_). Default: false. */
       bool filter_limit_negative_;
 
+      /** \brief The number of threads the scheduler should use (1 selects the serial implementation). */
+      unsigned int threads_;
+
       typedef typename pcl::traits::fieldList<PointT>::type FieldList;
 
       /** \brief Downsample a Point Cloud using a voxelized grid approach
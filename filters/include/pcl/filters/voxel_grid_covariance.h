@@ -371,6 +371,18 @@ namespace pcl
       int
       getNeighborhoodAtPoint (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors);
 
+      /** \brief Get the voxels at the given offsets from the voxel containing point p, by direct lookup of their
+       * indices (much cheaper than a radius search, and safe to call from several threads).
+       * \note Only voxels containing a sufficient number of points are used.
+       * \param[in] relative_coordinates the offsets of the voxels to check, one per column
+       * \param[in] reference_point the point to get the leaf structures around
+       * \param[out] neighbors the occupied voxels, in the order of \a relative_coordinates
+       * \return number of neighbors found
+       */
+      int
+      getNeighborhoodAtPoint (const Eigen::MatrixXi &relative_coordinates, const PointT& reference_point,
+                              std::vector<LeafConstPtr> &neighbors) const;
+
       /** \brief Get the leaf structure map
        * \return a map contataining all leaves
        */
@@ -426,7 +438,7 @@ namespace pcl
         k_leaves.reserve (k);
         for (std::vector<int>::iterator iter = k_indices.begin (); iter != k_indices.end (); iter++)
         {
-          k_leaves.push_back (&leaves_[voxel_centroids_leaf_indices_[*iter]]);
+          k_leaves.push_back (&leaves_.find (voxel_centroids_leaf_indices_[*iter])->second);
         }
         return k;
       }
@@ -478,7 +490,7 @@ namespace pcl
         k_leaves.reserve (k);
         for (std::vector<int>::iterator iter = k_indices.begin (); iter != k_indices.end (); iter++)
         {
-          k_leaves.push_back (&leaves_[voxel_centroids_leaf_indices_[*iter]]);
+          k_leaves.push_back (&leaves_.find (voxel_centroids_leaf_indices_[*iter])->second);
         }
         return k;
       }
@@ -41,11 +41,13 @@
 
 struct cloud_point_index_idx 
 {
-  unsigned int idx;
+  uint64_t idx;
   unsigned int cloud_point_index;
 
-  cloud_point_index_idx (unsigned int idx_, unsigned int cloud_point_index_) : idx (idx_), cloud_point_index (cloud_point_index_) {}
-  bool operator < (const cloud_point_index_idx &p) const { return (idx < p.idx); }
+  cloud_point_index_idx (uint64_t idx_, unsigned int cloud_point_index_) : idx (idx_), cloud_point_index (cloud_point_index_) {}
+  // Ties are broken on the point index, so that the order of the points inside a cell (and thus the
+  // floating point summation order of the centroid) does not depend on the sorting algorithm used
+  bool operator < (const cloud_point_index_idx &p) const { return (idx < p.idx || (idx == p.idx && cloud_point_index < p.cloud_point_index)); }
 };
 
 void
@@ -67,6 +67,8 @@
 #include <boost/tokenizer.hpp>
 #include <boost/foreach.hpp>
 #include <boost/shared_array.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/type_traits/alignment_of.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <boost/interprocess/permissions.hpp>
 
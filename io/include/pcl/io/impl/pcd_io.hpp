@@ -255,6 +255,124 @@ pcl::PCDWriter::writeBinary (const std::string &file_name,
   return (0);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::PCDWriter::writeBinaryMappable (const std::string &file_name, 
+                                     const pcl::PointCloud<PointT> &cloud)
+{
+  if (cloud.empty ())
+  {
+    throw pcl::IOException ("[pcl::PCDWriter::writeBinaryMappable] Input point cloud has no data!");
+    return (-1);
+  }
+  // The points are written as they are laid out in memory, padding included, and start on a 16 byte boundary,
+  // which allows PCDReader::readView to access them in place
+  sensor_msgs::PointCloud2 layout;
+  pcl::getFields (cloud, layout.fields);
+  layout.width = cloud.width;
+  layout.height = cloud.height;
+  layout.point_step = static_cast<uint32_t> (sizeof (PointT));
+
+  int data_idx = 0;
+  std::ostringstream oss;
+  oss.imbue (std::locale::classic ());
+  oss << generateHeaderBinary (layout, cloud.sensor_origin_, cloud.sensor_orientation_) << "DATA binary";
+  oss.flush ();
+  oss << std::string (static_cast<size_t> (15 - oss.tellp () % 16), ' ') << "\n";
+  oss.flush ();
+  data_idx = static_cast<int> (oss.tellp ());
+
+#if _WIN32
+  HANDLE h_native_file = CreateFileA (file_name.c_str (), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h_native_file == INVALID_HANDLE_VALUE)
+  {
+    throw pcl::IOException ("[pcl::PCDWriter::writeBinaryMappable] Error during CreateFile!");
+    return (-1);
+  }
+#else
+  int fd = pcl_open (file_name.c_str (), O_RDWR | O_CREAT | O_TRUNC, static_cast<mode_t> (0600));
+  if (fd < 0)
+  {
+    throw pcl::IOException ("[pcl::PCDWriter::writeBinaryMappable] Error during open!");
+    return (-1);
+  }
+#endif
+  // Mandatory lock file
+  boost::interprocess::file_lock file_lock;
+  setLockingPermissions (file_name, file_lock);
+
+  size_t data_size = cloud.points.size () * sizeof (PointT);
+
+  // Prepare the map
+#if _WIN32
+  HANDLE fm = CreateFileMappingA (h_native_file, NULL, PAGE_READWRITE, 0, (DWORD) (data_idx + data_size), NULL);
+  char *map = static_cast<char*>(MapViewOfFile (fm, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, data_idx + data_size));
+  CloseHandle (fm);
+
+#else
+  // Stretch the file size to the size of the data
+  int result = static_cast<int> (pcl_lseek (fd, getpagesize () + data_size - 1, SEEK_SET));
+  if (result < 0)
+  {
+    pcl_close (fd);
+    resetLockingPermissions (file_name, file_lock);
+    throw pcl::IOException ("[pcl::PCDWriter::writeBinaryMappable] Error during lseek ()!");
+    return (-1);
+  }
+  // Write a bogus entry so that the new file size comes in effect
+  result = static_cast<int> (::write (fd, "", 1));
+  if (result != 1)
+  {
+    pcl_close (fd);
+    resetLockingPermissions (file_name, file_lock);
+    throw pcl::IOException ("[pcl::PCDWriter::writeBinaryMappable] Error during write ()!");
+    return (-1);
+  }
+
+  char *map = static_cast<char*> (mmap (0, data_idx + data_size, PROT_WRITE, MAP_SHARED, fd, 0));
+  if (map == reinterpret_cast<char*> (-1)) //MAP_FAILED)
+  {
+    pcl_close (fd);
+    resetLockingPermissions (file_name, file_lock);
+    throw pcl::IOException ("[pcl::PCDWriter::writeBinaryMappable] Error during mmap ()!");
+    return (-1);
+  }
+#endif
+
+  // Copy the header
+  memcpy (&map[0], oss.str ().c_str (), data_idx);
+
+  // Copy the data
+  memcpy (&map[0] + data_idx, &cloud.points[0], data_size);
+
+  // If the user set the synchronization flag on, call msync
+#if !_WIN32
+  if (map_synchronization_)
+    msync (map, data_idx + data_size, MS_SYNC);
+#endif
+
+  // Unmap the pages of memory
+#if _WIN32
+    UnmapViewOfFile (map);
+#else
+  if (munmap (map, (data_idx + data_size)) == -1)
+  {
+    pcl_close (fd);
+    resetLockingPermissions (file_name, file_lock);
+    throw pcl::IOException ("[pcl::PCDWriter::writeBinaryMappable] Error during munmap ()!");
+    return (-1);
+  }
+#endif
+  // Close file
+#if _WIN32
+  CloseHandle (h_native_file);
+#else
+  pcl_close (fd);
+#endif
+  resetLockingPermissions (file_name, file_lock);
+  return (0);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
 pcl::PCDWriter::writeBinaryCompressed (const std::string &file_name, 
@@ -909,5 +1027,99 @@ pcl::PCDWriter::writeASCII (const std::string &file_name,
   return (0);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::PCDReader::isLayoutCompatible (const sensor_msgs::PointCloud2 &cloud, unsigned int data_idx)
+{
+  // The points are accessed in place, so the stride and the alignment must match
+  if (cloud.point_step != sizeof (PointT) || data_idx % boost::alignment_of<PointT>::value != 0)
+    return (false);
+
+  std::vector<sensor_msgs::PointField> fields;
+  pcl::getFields<PointT> (fields);
+
+  size_t nr_fields = 0;
+  for (size_t i = 0; i < cloud.fields.size (); ++i)
+  {
+    if (cloud.fields[i].name == "_")
+      continue;
+    ++nr_fields;
+
+    bool found = false;
+    for (size_t j = 0; j < fields.size (); ++j)
+    {
+      if (fields[j].name != cloud.fields[i].name)
+        continue;
+      found = fields[j].offset == cloud.fields[i].offset &&
+              fields[j].datatype == cloud.fields[i].datatype &&
+              std::max (fields[j].count, 1u) == std::max (cloud.fields[i].count, 1u);
+      break;
+    }
+    if (!found)
+      return (false);
+  }
+
+  // Every field of PointT must be present in the file
+  size_t nr_point_fields = 0;
+  for (size_t j = 0; j < fields.size (); ++j)
+    if (fields[j].name != "_")
+      ++nr_point_fields;
+  return (nr_fields == nr_point_fields);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::PCDReader::readView (const std::string &file_name, pcl::PCDCloudView<PointT> &cloud, const int offset)
+{
+  cloud.clear ();
+
+  sensor_msgs::PointCloud2 header;
+  int pcd_version, data_type;
+  unsigned int data_idx;
+  int res = parseHeader (file_name, header, cloud.sensor_origin_, cloud.sensor_orientation_,
+                         pcd_version, data_type, data_idx, offset);
+  if (res < 0)
+    return (res);
+
+  if (data_type == 1 && isLayoutCompatible<PointT> (header, data_idx))
+  {
+    size_t data_size = static_cast<size_t> (header.width) * header.height * header.point_step;
+    if (boost::filesystem::file_size (file_name) < data_idx + data_size)
+    {
+      PCL_ERROR ("[pcl::PCDReader::readView] File %s is smaller than advertised in its header!\n", file_name.c_str ());
+      return (-1);
+    }
+
+    PCDMappedFile::Ptr file (new PCDMappedFile);
+    if (!file->map (file_name, data_idx + data_size))
+    {
+      PCL_ERROR ("[pcl::PCDReader::readView] Error mapping file %s.\n", file_name.c_str ());
+      return (-1);
+    }
+
+    cloud.points_   = reinterpret_cast<const PointT*> (file->data () + data_idx);
+    cloud.file_     = file;
+    cloud.width     = header.width;
+    cloud.height    = header.height;
+    cloud.is_dense  = false;
+    return (0);
+  }
+
+  PCL_WARN ("[pcl::PCDReader::readView] Layout of %s does not match the point type (see PCDWriter::writeBinaryMappable), reading a copy.\n", file_name.c_str ());
+  boost::shared_ptr<pcl::PointCloud<PointT> > copy (new pcl::PointCloud<PointT>);
+  res = read (file_name, *copy, offset);
+  if (res < 0)
+    return (res);
+
+  cloud.points_   = copy->points.empty () ? NULL : &copy->points[0];
+  cloud.cloud_    = copy;
+  cloud.width     = copy->width;
+  cloud.height    = copy->height;
+  cloud.is_dense  = copy->is_dense;
+  cloud.sensor_origin_      = copy->sensor_origin_;
+  cloud.sensor_orientation_ = copy->sensor_orientation_;
+  return (0);
+}
+
 #endif  //#ifndef PCL_IO_PCD_IO_H_
 
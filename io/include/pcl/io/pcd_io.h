@@ -45,6 +45,219 @@
 
 namespace pcl
 {
+  /** \brief Read-only memory mapping of the beginning of a file. The mapping
+    * is released when the object is destroyed, so a PCDCloudView keeps a
+    * shared pointer to it for as long as its points are accessible.
+    * \ingroup io
+    */
+  class PCL_EXPORTS PCDMappedFile : boost::noncopyable
+  {
+    public:
+      typedef boost::shared_ptr<PCDMappedFile> Ptr;
+      typedef boost::shared_ptr<const PCDMappedFile> ConstPtr;
+
+      /** \brief Empty constructor. */
+      PCDMappedFile () : map_ (NULL), size_ (0), file_mapping_ (NULL) {}
+
+      /** \brief Destructor. Unmaps the file. */
+      ~PCDMappedFile () { unmap (); }
+
+      /** \brief Map the first \a size bytes of a file read-only. Pages are
+        * only loaded from disk when they are accessed for the first time.
+        * \param[in] file_name the name of the file to map
+        * \param[in] size the number of bytes to map
+        * \return true on success, false otherwise
+        */
+      bool
+      map (const std::string &file_name, size_t size);
+
+      /** \brief Release the mapping (if any). */
+      void
+      unmap ();
+
+      /** \brief Get a pointer to the first mapped byte (NULL if nothing is mapped). */
+      inline const char*
+      data () const { return (map_); }
+
+      /** \brief Get the number of mapped bytes. */
+      inline size_t
+      size () const { return (size_); }
+
+    private:
+      /** \brief The mapped region. */
+      char *map_;
+
+      /** \brief The size of the mapped region in bytes. */
+      size_t size_;
+
+      /** \brief The file mapping object handle (Windows only). */
+      void *file_mapping_;
+  };
+
+  /** \brief Read-only point cloud whose points are stored directly in a
+    * memory mapped binary PCD file, as returned by PCDReader::readView.
+    *
+    * Opening a view does not read nor copy any point data: pages are faulted
+    * in by the operating system as the points are accessed, which makes it
+    * possible to e.g. crop a small region out of a very large file without
+    * loading it. The mapping is shared by all copies of a view and stays
+    * valid until the last one is destroyed.
+    *
+    * \note Zero-copy access requires the data in the file to have exactly
+    * the memory layout of PointT (same fields, offsets and padding, as
+    * written by PCDWriter::writeBinaryMappable, or by PCDWriter::writeBinary
+    * for a sensor_msgs::PointCloud2 converted from a pcl::PointCloud<PointT>).
+    * For any other file, including the packed ones written by
+    * savePCDFileBinary, the points are read and converted once into memory
+    * owned by the view, and isMapped () returns false.
+    * \ingroup io
+    */
+  template <typename PointT>
+  class PCDCloudView
+  {
+    public:
+      typedef PointT PointType;
+      typedef const PointT* const_iterator;
+      typedef boost::shared_ptr<PCDCloudView<PointT> > Ptr;
+      typedef boost::shared_ptr<const PCDCloudView<PointT> > ConstPtr;
+
+      /** \brief Empty constructor. */
+      PCDCloudView () : width (0), height (0), is_dense (false),
+                        sensor_origin_ (Eigen::Vector4f::Zero ()),
+                        sensor_orientation_ (Eigen::Quaternionf::Identity ()),
+                        points_ (NULL), file_ (), cloud_ ()
+      {}
+
+      /** \brief Get the number of points in the view. */
+      inline size_t
+      size () const { return (static_cast<size_t> (width) * height); }
+
+      /** \brief Check whether the view contains no points. */
+      inline bool
+      empty () const { return (size () == 0); }
+
+      /** \brief Check whether the underlying data is organized (height > 1). */
+      inline bool
+      isOrganized () const { return (height > 1); }
+
+      /** \brief Check whether the points are read directly from the mapped
+        * file (true) or from a converted copy held in memory (false).
+        */
+      inline bool
+      isMapped () const { return (file_.get () != NULL); }
+
+      /** \brief Access a point without bounds checking. */
+      inline const PointT&
+      operator[] (size_t n) const { return (points_[n]); }
+
+      /** \brief Access a point with bounds checking.
+        * \param[in] n the index of the point
+        */
+      inline const PointT&
+      at (size_t n) const
+      {
+        if (n >= size ())
+          throw std::out_of_range ("[pcl::PCDCloudView::at] Index out of range");
+        return (points_[n]);
+      }
+
+      /** \brief Obtain the point given by the (column, row) coordinates. Only
+        * works on organized datasets (those that have height != 1).
+        * \param[in] column the column coordinate
+        * \param[in] row the row coordinate
+        */
+      inline const PointT&
+      at (int column, int row) const
+      {
+        if (height > 1)
+          return (at (static_cast<size_t> (row) * width + column));
+        else
+          throw IsNotDenseException ("Can't use 2D indexing with a unorganized point cloud");
+      }
+
+      /** \brief Get an iterator to the first point. */
+      inline const_iterator
+      begin () const { return (points_); }
+
+      /** \brief Get an iterator past the last point. */
+      inline const_iterator
+      end () const { return (points_ + size ()); }
+
+      /** \brief Copy all the points of the view into a point cloud.
+        * \param[out] cloud the resultant point cloud
+        */
+      void
+      copyTo (pcl::PointCloud<PointT> &cloud) const
+      {
+        cloud.points.assign (begin (), end ());
+        cloud.width    = width;
+        cloud.height   = height;
+        cloud.is_dense = is_dense;
+        cloud.sensor_origin_      = sensor_origin_;
+        cloud.sensor_orientation_ = sensor_orientation_;
+      }
+
+      /** \brief Copy a subset of the points of the view into a point cloud.
+        * Only the pages holding the selected points are read from disk.
+        * \param[in] indices the indices of the points to copy
+        * \param[out] cloud the resultant (unorganized) point cloud
+        */
+      void
+      copyTo (const std::vector<int> &indices, pcl::PointCloud<PointT> &cloud) const
+      {
+        cloud.points.resize (indices.size ());
+        for (size_t i = 0; i < indices.size (); ++i)
+          cloud.points[i] = points_[indices[i]];
+        cloud.width    = static_cast<uint32_t> (indices.size ());
+        cloud.height   = 1;
+        cloud.is_dense = is_dense;
+        cloud.sensor_origin_      = sensor_origin_;
+        cloud.sensor_orientation_ = sensor_orientation_;
+      }
+
+      /** \brief Release the points and reset the view to an empty state. */
+      void
+      clear ()
+      {
+        width = height = 0;
+        is_dense = false;
+        points_ = NULL;
+        file_.reset ();
+        cloud_.reset ();
+      }
+
+      /** \brief The point cloud width (if organized as an image-structure). */
+      uint32_t width;
+      /** \brief The point cloud height (if organized as an image-structure). */
+      uint32_t height;
+
+      /** \brief True if no points are invalid (e.g., have NaN or Inf values).
+        * A mapped view is conservatively marked as not dense, as checking it
+        * would require reading the whole file.
+        */
+      bool is_dense;
+
+      /** \brief Sensor acquisition pose (origin/translation). */
+      Eigen::Vector4f    sensor_origin_;
+      /** \brief Sensor acquisition pose (rotation). */
+      Eigen::Quaternionf sensor_orientation_;
+
+    private:
+      /** \brief Pointer to the first point, either in the mapping or in cloud_. */
+      const PointT *points_;
+
+      /** \brief The mapped file holding the points (if mapped). */
+      boost::shared_ptr<const PCDMappedFile> file_;
+
+      /** \brief The converted copy of the points (if not mapped). */
+      boost::shared_ptr<const pcl::PointCloud<PointT> > cloud_;
+
+      friend class PCDReader;
+
+    public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
   /** \brief Point Cloud Data (PCD) file format reader.
     * \author Radu Bogdan Rusu
     * \ingroup io
@@ -53,7 +266,7 @@ namespace pcl
   {
     public:
       /** Empty constructor */      
-      PCDReader () : FileReader () {}
+      PCDReader () : FileReader (), threads_ (0) {}
       /** Empty destructor */      
       ~PCDReader () {}
       /** \brief Various PCD file versions.
@@ -97,7 +310,7 @@ namespace pcl
         * \param[out] origin the sensor acquisition origin (only for > PCD_V7 - null if not present)
         * \param[out] orientation the sensor acquisition orientation (only for > PCD_V7 - identity if not present)
         * \param[out] pcd_version the PCD version of the file (i.e., PCD_V6, PCD_V7)
-        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed) 
+        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed, 3 = Binary chunked) 
         * \param[out] data_idx the offset of cloud data within the file
         * \param[in] offset the offset of where to expect the PCD Header in the
         * file (optional parameter). One usage example for setting the offset
@@ -153,7 +366,7 @@ namespace pcl
         * \param[in] file_name the name of the file to load
         * \param[out] cloud the resultant point cloud dataset (only the properties will be filled)
         * \param[out] pcd_version the PCD version of the file (either PCD_V6 or PCD_V7)
-        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed) 
+        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed, 3 = Binary chunked) 
         * \param[out] data_idx the offset of cloud data within the file
         * \param[in] offset the offset of where to expect the PCD Header in the
         * file (optional parameter). One usage example for setting the offset
@@ -243,6 +456,93 @@ namespace pcl
         return (res);
       }
 
+      /** \brief Set the number of threads used to decompress binary_chunked data.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+      /** \brief Get the number of threads used to decompress binary_chunked data. */
+      inline unsigned int
+      getNumberOfThreads () const { return (threads_); }
+
+      /** \brief Read a contiguous range of points from a PCD file and store it
+        * into a sensor_msgs/PointCloud2.
+        *
+        * For binary_chunked files only the chunks overlapping the range are
+        * decompressed, and binary files are read in place. Other formats are
+        * read completely and cropped.
+        *
+        * \param[in] file_name the name of the file containing the actual PointCloud data
+        * \param[out] cloud the resultant (unorganized) PointCloud message read from disk
+        * \param[out] origin the sensor acquisition origin (only for > PCD_V7 - null if not present)
+        * \param[out] orientation the sensor acquisition orientation (only for > PCD_V7 - identity if not present)
+        * \param[in] first the index of the first point to read
+        * \param[in] count the number of points to read (clamped to the number of points in the file, 0 gives an empty cloud)
+        * \param[in] offset the offset of where to expect the PCD Header in the file (optional parameter)
+        *
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      int
+      readRange (const std::string &file_name, sensor_msgs::PointCloud2 &cloud,
+                 Eigen::Vector4f &origin, Eigen::Quaternionf &orientation,
+                 unsigned int first, unsigned int count, const int offset = 0);
+
+      /** \brief Read a contiguous range of points from any PCD file, and convert it to the given template format.
+        * \param[in] file_name the name of the file containing the actual PointCloud data
+        * \param[out] cloud the resultant (unorganized) point cloud
+        * \param[in] first the index of the first point to read
+        * \param[in] count the number of points to read (clamped to the number of points in the file, 0 gives an empty cloud)
+        * \param[in] offset the offset of where to expect the PCD Header in the file (optional parameter)
+        *
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      template<typename PointT> int
+      readRange (const std::string &file_name, pcl::PointCloud<PointT> &cloud,
+                 unsigned int first, unsigned int count, const int offset = 0)
+      {
+        sensor_msgs::PointCloud2 blob;
+        int res = readRange (file_name, blob, cloud.sensor_origin_, cloud.sensor_orientation_,
+                             first, count, offset);
+
+        // If no error, convert the data
+        if (res == 0)
+          pcl::fromROSMsg (blob, cloud);
+        return (res);
+      }
+
+      /** \brief Open a binary PCD file as a read-only point cloud view
+        * backed directly by a memory mapping of the file.
+        *
+        * No point data is read or copied when opening the view: the header is
+        * parsed and the file is mapped, and the operating system loads the
+        * pages holding the points as they are accessed. This requires the
+        * file to be stored as DATA binary with a point layout identical to
+        * the memory layout of PointT, and the data block to be suitably
+        * aligned within the file. If any of these conditions does not hold,
+        * the file is read and converted with read () instead and the view
+        * owns the resulting points (see PCDCloudView::isMapped ()).
+        *
+        * \param[in] file_name the name of the file containing the actual PointCloud data
+        * \param[out] cloud the resultant point cloud view
+        * \param[in] offset the offset of where to expect the PCD Header in the
+        * file (optional parameter). One usage example for setting the offset
+        * parameter is for reading data from a TAR "archive containing multiple
+        * PCD files: TAR files always add a 512 byte header in front of the
+        * actual file, so set the offset to the next byte after the header
+        * (e.g., 513).
+        *
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      template<typename PointT> int
+      readView (const std::string &file_name, pcl::PCDCloudView<PointT> &cloud, const int offset = 0);
+
       /** \brief Read a point cloud data from any PCD file, and convert it to a pcl::PointCloud<Eigen::MatrixXf> format.
         * \attention The PCD data is \b always stored in ROW major format! The
         * read/write PCD methods will detect column major input and automatically convert it.
@@ -266,6 +566,52 @@ namespace pcl
     
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
+    private:
+      /** \brief Location of the independently compressed chunks of a binary_chunked PCD file. */
+      struct ChunkIndex
+      {
+        ChunkIndex () : points_per_chunk (0), offsets () {}
+
+        /** \brief The number of points stored in each chunk (except the last one). */
+        unsigned int points_per_chunk;
+        /** \brief Offset of each chunk relative to the start of the data, plus the total data size. */
+        std::vector<size_t> offsets;
+      };
+
+      /** \brief Parse the header of a PCD file, without allocating cloud.data.
+        * See readHeader () for a description of the parameters.
+        * \param[out] chunks if not NULL, receives the chunk index of binary_chunked files
+        */
+      int
+      parseHeader (const std::string &file_name, sensor_msgs::PointCloud2 &cloud, 
+                   Eigen::Vector4f &origin, Eigen::Quaternionf &orientation, int &pcd_version,
+                   int &data_type, unsigned int &data_idx, const int offset,
+                   ChunkIndex *chunks = NULL);
+
+      /** \brief Decompress the points [first, first + count) of binary_chunked
+        * data into cloud.data, in parallel over the chunks.
+        * \param[in] data pointer to the first chunk
+        * \param[in] chunks the chunk index of the file
+        * \param[in,out] cloud the header of the file, with cloud.data resized to count * point_step
+        * \param[in] nr_points the total number of points in the file
+        * \param[in] first the index of the first point to decompress
+        * \param[in] count the number of points to decompress
+        * \return true on success, false if a chunk is corrupted
+        */
+      bool
+      readChunks (const char *data, const ChunkIndex &chunks, sensor_msgs::PointCloud2 &cloud,
+                  size_t nr_points, size_t first, size_t count);
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief Check whether the binary data of a PCD file can be accessed
+        * in place as an array of PointT.
+        * \param[in] cloud the header of the file, as filled by parseHeader ()
+        * \param[in] data_idx the offset of the data within the file
+        */
+      template<typename PointT> static bool
+      isLayoutCompatible (const sensor_msgs::PointCloud2 &cloud, unsigned int data_idx);
   };
 
   /** \brief Point Cloud Data (PCD) file format writer.
@@ -275,7 +621,7 @@ namespace pcl
   class PCL_EXPORTS PCDWriter : public FileWriter
   {
     public:
-      PCDWriter() : FileWriter(), map_synchronization_(false) {}
+      PCDWriter() : FileWriter(), map_synchronization_(false), threads_ (0) {}
       ~PCDWriter() {}
 
       /** \brief Set whether mmap() synchornization via msync() is desired before munmap() calls. 
@@ -292,6 +638,16 @@ namespace pcl
         map_synchronization_ = sync;
       }
 
+      /** \brief Set the number of threads used to compress binary_chunked data.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+      /** \brief Get the number of threads used to compress binary_chunked data. */
+      inline unsigned int
+      getNumberOfThreads () const { return (threads_); }
+
       /** \brief Generate the header of a PCD file format
         * \param[in] cloud the point cloud data message
         * \param[in] origin the sensor acquisition origin
@@ -388,6 +744,28 @@ namespace pcl
                              const Eigen::Vector4f &origin = Eigen::Vector4f::Zero (), 
                              const Eigen::Quaternionf &orientation = Eigen::Quaternionf::Identity ());
 
+      /** \brief Save point cloud data to a PCD file containing n-D points, in BINARY_CHUNKED format.
+        *
+        * The points are split into chunks of \a chunk_size points, which are
+        * reordered field by field and LZF compressed independently of each
+        * other, in parallel. The size of every chunk is stored in the CHUNKS
+        * line of the header, so that readers can decompress the chunks in
+        * parallel too and read any range of points (see PCDReader::readRange)
+        * without decompressing the whole file. Chunks that do not compress
+        * are stored uncompressed.
+        *
+        * \param[in] file_name the output file name
+        * \param[in] cloud the point cloud data message
+        * \param[in] origin the sensor acquisition origin
+        * \param[in] orientation the sensor acquisition orientation
+        * \param[in] chunk_size the number of points per chunk
+        */
+      int 
+      writeBinaryChunked (const std::string &file_name, const sensor_msgs::PointCloud2 &cloud,
+                          const Eigen::Vector4f &origin = Eigen::Vector4f::Zero (), 
+                          const Eigen::Quaternionf &orientation = Eigen::Quaternionf::Identity (),
+                          const unsigned int chunk_size = 65536);
+
       /** \brief Save point cloud data to a PCD file containing n-D points
         * \param[in] file_name the output file name
         * \param[in] cloud the point cloud data message
@@ -449,6 +827,17 @@ namespace pcl
       writeBinary (const std::string &file_name, 
                    const pcl::PointCloud<PointT> &cloud);
 
+      /** \brief Save point cloud data to a PCD file in BINARY format, with the points stored exactly as they
+        * are laid out in memory, so that PCDReader::readView can access them in place without a copy.
+        * \note The padding of PointT is written as well (as "_" fields), which makes the file larger than the
+        * one written by writeBinary. Any PCD reader can still read it.
+        * \param[in] file_name the output file name
+        * \param[in] cloud the point cloud data
+        */
+      template <typename PointT> int 
+      writeBinaryMappable (const std::string &file_name, 
+                           const pcl::PointCloud<PointT> &cloud);
+
       /** \brief Save point cloud data to a PCD file containing n-D points, in BINARY format
         * \note This version is specialized for PointCloud<Eigen::MatrixXf> data types. 
         * \attention The PCD data is \b always stored in ROW major format! The
@@ -469,6 +858,21 @@ namespace pcl
       writeBinaryCompressed (const std::string &file_name, 
                              const pcl::PointCloud<PointT> &cloud);
 
+      /** \brief Save point cloud data to a binary chunked PCD file (see writeBinaryChunked above)
+        * \param[in] file_name the output file name
+        * \param[in] cloud the point cloud data message
+        * \param[in] chunk_size the number of points per chunk
+        */
+      template <typename PointT> int 
+      writeBinaryChunked (const std::string &file_name, 
+                          const pcl::PointCloud<PointT> &cloud,
+                          const unsigned int chunk_size = 65536)
+      {
+        sensor_msgs::PointCloud2 blob;
+        pcl::toROSMsg (cloud, blob);
+        return (writeBinaryChunked (file_name, blob, cloud.sensor_origin_, cloud.sensor_orientation_, chunk_size));
+      }
+
       /** \brief Save point cloud data to a binary comprssed PCD file.
         * \note This version is specialized for PointCloud<Eigen::MatrixXf> data types. 
         * \attention The PCD data is \b always stored in ROW major format! The
@@ -598,6 +1002,9 @@ namespace pcl
       /** \brief Set to true if msync() should be called before munmap(). Prevents data loss on NFS systems. */
       bool map_synchronization_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
       typedef std::pair<std::string, pcl::ChannelProperties> pair_channel_properties;
       /** \brief Internal structure used to sort the ChannelProperties in the
         * cloud.channels map based on their offset. 
@@ -49,6 +49,10 @@
 #include <cstring>
 #include <cerrno>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef _WIN32
 # include <io.h>
 # include <windows.h>
@@ -101,11 +105,85 @@ pcl::PCDWriter::resetLockingPermissions (const std::string &file_name,
 #endif
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PCDMappedFile::map (const std::string &file_name, size_t size)
+{
+  unmap ();
+
+  int fd = pcl_open (file_name.c_str (), O_RDONLY);
+  if (fd == -1)
+    return (false);
+
+#ifdef _WIN32
+  HANDLE fm = CreateFileMapping ((HANDLE) _get_osfhandle (fd), NULL, PAGE_READONLY, 0, 0, NULL);
+  if (fm == NULL)
+  {
+    pcl_close (fd);
+    return (false);
+  }
+  char *map = static_cast<char*> (MapViewOfFile (fm, FILE_MAP_READ, 0, 0, size));
+  if (map == NULL)
+  {
+    CloseHandle (fm);
+    pcl_close (fd);
+    return (false);
+  }
+  file_mapping_ = fm;
+#else
+  char *map = static_cast<char*> (mmap (0, size, PROT_READ, MAP_SHARED, fd, 0));
+  if (map == reinterpret_cast<char*> (-1))    // MAP_FAILED
+  {
+    pcl_close (fd);
+    return (false);
+  }
+#endif
+  // The mapping stays valid after the file descriptor is closed
+  pcl_close (fd);
+
+  map_ = map;
+  size_ = size;
+  return (true);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PCDMappedFile::unmap ()
+{
+  if (map_ == NULL)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile (map_);
+  CloseHandle (static_cast<HANDLE> (file_mapping_));
+  file_mapping_ = NULL;
+#else
+  munmap (map_, size_);
+#endif
+  map_ = NULL;
+  size_ = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 int
 pcl::PCDReader::readHeader (const std::string &file_name, sensor_msgs::PointCloud2 &cloud, 
                             Eigen::Vector4f &origin, Eigen::Quaternionf &orientation, 
                             int &pcd_version, int &data_type, unsigned int &data_idx, const int offset)
+{
+  int res = parseHeader (file_name, cloud, origin, orientation, pcd_version, data_type, data_idx, offset);
+  if (res < 0)
+    return (res);
+
+  // Need to allocate: N * point_step
+  cloud.data.resize (static_cast<size_t> (cloud.width) * cloud.height * cloud.point_step);
+  return (0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDReader::parseHeader (const std::string &file_name, sensor_msgs::PointCloud2 &cloud, 
+                             Eigen::Vector4f &origin, Eigen::Quaternionf &orientation, 
+                             int &pcd_version, int &data_type, unsigned int &data_idx, const int offset,
+                             ChunkIndex *chunks)
 {
   // Default values
   data_idx = 0;
@@ -125,6 +203,9 @@ pcl::PCDReader::readHeader (const std::string &file_name, sensor_msgs::PointClou
 
   int specified_channel_count = 0;
 
+  // points_per_chunk followed by the size of each chunk, for binary_chunked data
+  std::vector<size_t> chunk_sizes;
+
   if (file_name == "" || !boost::filesystem::exists (file_name))
   {
     PCL_ERROR ("[pcl::PCDReader::readHeader] Could not find file '%s'.\n", file_name.c_str ());
@@ -317,8 +398,22 @@ pcl::PCDReader::readHeader (const std::string &file_name, sensor_msgs::PointClou
       if (line_type.substr (0, 6) == "POINTS")
       {
         sstream >> nr_points;
-        // Need to allocate: N * point_step
-        cloud.data.resize (nr_points * cloud.point_step);
+        continue;
+      }
+
+      // Get the chunk index: CHUNKS points_per_chunk nr_chunks size_0 ... size_n-1
+      if (line_type.substr (0, 6) == "CHUNKS")
+      {
+        size_t nr_chunks = 0;
+        chunk_sizes.resize (1);
+        sstream >> chunk_sizes[0] >> nr_chunks;
+        if (sstream.fail () || st.size () != nr_chunks + 3)
+          throw "Invalid number of elements in <CHUNKS>!";
+        chunk_sizes.resize (nr_chunks + 1);
+        for (size_t i = 1; i <= nr_chunks; ++i)
+          sstream >> chunk_sizes[i];
+        if (sstream.fail ())
+          throw "Invalid chunk size in <CHUNKS>!";
         continue;
       }
 
@@ -328,6 +423,8 @@ pcl::PCDReader::readHeader (const std::string &file_name, sensor_msgs::PointClou
         data_idx = static_cast<int> (fs.tellg ());
         if (st.at (1).substr (0, 17) == "binary_compressed")
          data_type = 2;
+        else if (st.at (1).substr (0, 14) == "binary_chunked")
+          data_type = 3;
         else
           if (st.at (1).substr (0, 6) == "binary")
             data_type = 1;
@@ -350,6 +447,26 @@ pcl::PCDReader::readHeader (const std::string &file_name, sensor_msgs::PointClou
     fs.close ();
     return (-1);
   }
+
+  if (data_type == 3)
+  {
+    // Every chunk holds points_per_chunk points, except for the last one
+    if (chunk_sizes.empty () || chunk_sizes[0] == 0 ||
+        chunk_sizes.size () - 1 != (static_cast<size_t> (nr_points) + chunk_sizes[0] - 1) / chunk_sizes[0])
+    {
+      PCL_ERROR ("[pcl::PCDReader::readHeader] <CHUNKS> does not match the number of points (%d)!\n", nr_points);
+      fs.close ();
+      return (-1);
+    }
+    if (chunks)
+    {
+      chunks->points_per_chunk = static_cast<unsigned int> (chunk_sizes[0]);
+      chunks->offsets.resize (chunk_sizes.size ());
+      chunks->offsets[0] = 0;
+      for (size_t i = 1; i < chunk_sizes.size (); ++i)
+        chunks->offsets[i] = chunks->offsets[i - 1] + chunk_sizes[i];
+    }
+  }
   
   // Compatibility with older PCD file versions
   if (cloud.width == 0 && cloud.height == 0)
@@ -858,12 +975,18 @@ pcl::PCDReader::readHeaderEigen (const std::string &file_name, pcl::PointCloud<E
         continue;
       }
 
+      // The chunk index is only used by PCDReader::read
+      if (line_type.substr (0, 6) == "CHUNKS")
+        continue;
+
       // Read the header + comments line by line until we get to <DATA>
       if (line_type.substr (0, 4) == "DATA")
       {
         data_idx = static_cast<int> (fs.tellg ());
         if (st.at (1).substr (0, 17) == "binary_compressed")
          data_type = 2;
+        else if (st.at (1).substr (0, 14) == "binary_chunked")
+          data_type = 3;
         else
           if (st.at (1).substr (0, 6) == "binary")
             data_type = 1;
@@ -926,12 +1049,16 @@ pcl::PCDReader::read (const std::string &file_name, sensor_msgs::PointCloud2 &cl
 {
   int data_type;
   unsigned int data_idx;
+  ChunkIndex chunks;
 
-  int res = readHeader (file_name, cloud, origin, orientation, pcd_version, data_type, data_idx, offset);
+  int res = parseHeader (file_name, cloud, origin, orientation, pcd_version, data_type, data_idx, offset, &chunks);
 
   if (res < 0)
     return (res);
 
+  // Need to allocate: N * point_step
+  cloud.data.resize (static_cast<size_t> (cloud.width) * cloud.height * cloud.point_step);
+
   unsigned int idx = 0;
 
   // Get the number of points the cloud should have
@@ -1087,6 +1214,16 @@ pcl::PCDReader::read (const std::string &file_name, sensor_msgs::PointCloud2 &cl
     }
     
     size_t data_size = data_idx + cloud.data.size ();
+    if (data_type == 3)
+    {
+      data_size = data_idx + chunks.offsets.back ();
+      if (boost::filesystem::file_size (file_name) < data_size)
+      {
+        pcl_close (fd);
+        PCL_ERROR ("[pcl::PCDReader::read] File %s is smaller than advertised in its header!\n", file_name.c_str ());
+        return (-1);
+      }
+    }
     // Prepare the map
 #ifdef _WIN32
     // map te whole file
@@ -1113,8 +1250,24 @@ pcl::PCDReader::read (const std::string &file_name, sensor_msgs::PointCloud2 &cl
     }
 #endif
 
+    /// ---[ Binary chunked mode only
+    if (data_type == 3)
+    {
+      if (!readChunks (&map[data_idx], chunks, cloud, nr_points, 0, nr_points))
+      {
+#if _WIN32
+        UnmapViewOfFile (map);
+        CloseHandle (fm);
+#else
+        munmap (map, data_size);
+#endif
+        pcl_close (fd);
+        PCL_ERROR ("[pcl::PCDReader::read] Corrupted chunk in binary_chunked PCD file %s\n", file_name.c_str ());
+        return (-1);
+      }
+    }
     /// ---[ Binary compressed mode only
-    if (data_type == 2)
+    else if (data_type == 2)
     {
       // Uncompress the data first
       unsigned int compressed_size, uncompressed_size;
@@ -1421,6 +1574,8 @@ pcl::PCDReader::readEigen (const std::string &file_name, pcl::PointCloud<Eigen::
     /// ---[ Binary compressed mode only
     if (data_type == 2)
       throw pcl::IOException ("[pcl::PCDReader::readEigen] PCD binary_compressed mode not implemented for Eigen::MatrixXf!");
+    else if (data_type == 3)
+      throw pcl::IOException ("[pcl::PCDReader::readEigen] PCD binary_chunked mode not implemented for Eigen::MatrixXf!");
     else
     {
       // Is the given matrix row major?
@@ -1493,6 +1648,175 @@ pcl::PCDReader::read (const std::string &file_name, sensor_msgs::PointCloud2 &cl
   return (0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PCDReader::readChunks (const char *data, const ChunkIndex &chunks, sensor_msgs::PointCloud2 &cloud,
+                            size_t nr_points, size_t first, size_t count)
+{
+  // Get the fields sizes
+  std::vector<sensor_msgs::PointField> fields (cloud.fields.size ());
+  std::vector<size_t> fields_sizes (cloud.fields.size ());
+  size_t nri = 0, fsize = 0;
+  for (size_t i = 0; i < cloud.fields.size (); ++i)
+  {
+    if (cloud.fields[i].name == "_")
+      continue;
+    fields_sizes[nri] = cloud.fields[i].count * pcl::getFieldSize (cloud.fields[i].datatype);
+    fsize += fields_sizes[nri];
+    fields[nri] = cloud.fields[i];
+    ++nri;
+  }
+  fields.resize (nri);
+  fields_sizes.resize (nri);
+
+  if (count == 0)
+    return (true);
+
+  const size_t points_per_chunk = chunks.points_per_chunk;
+  const int first_chunk = static_cast<int> (first / points_per_chunk);
+  const int last_chunk  = static_cast<int> ((first + count - 1) / points_per_chunk);
+  std::vector<char> valid (last_chunk - first_chunk + 1, 1);
+
+#ifdef _OPENMP
+  int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#else
+  int nr_threads = 1;
+#endif
+
+#pragma omp parallel num_threads (nr_threads)
+  {
+    std::vector<char> buf (points_per_chunk * fsize);
+#pragma omp for schedule (dynamic)
+    for (int c = first_chunk; c <= last_chunk; ++c)
+    {
+      size_t begin = c * points_per_chunk;
+      size_t end = std::min (begin + points_per_chunk, nr_points);
+      size_t raw_size = (end - begin) * fsize;
+      size_t compressed_size = chunks.offsets[c + 1] - chunks.offsets[c];
+
+      // Chunks that did not compress are stored as is
+      const char *src = data + chunks.offsets[c];
+      if (compressed_size != raw_size)
+      {
+        if (compressed_size > raw_size ||
+            pcl::lzfDecompress (src, static_cast<unsigned int> (compressed_size),
+                                &buf[0], static_cast<unsigned int> (raw_size)) != raw_size)
+        {
+          valid[c - first_chunk] = 0;
+          continue;
+        }
+        src = &buf[0];
+      }
+
+      // Unpack the xxyyzz of the requested points to xyz
+      size_t from = std::max (begin, first), to = std::min (end, first + count);
+      for (size_t j = 0; j < fields.size (); ++j)
+      {
+        const char *pter = src + (from - begin) * fields_sizes[j];
+        for (size_t i = from; i < to; ++i, pter += fields_sizes[j])
+          memcpy (&cloud.data[(i - first) * cloud.point_step + fields[j].offset], pter, fields_sizes[j]);
+        src += (end - begin) * fields_sizes[j];
+      }
+    }
+  }
+
+  return (std::find (valid.begin (), valid.end (), 0) == valid.end ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDReader::readRange (const std::string &file_name, sensor_msgs::PointCloud2 &cloud,
+                           Eigen::Vector4f &origin, Eigen::Quaternionf &orientation,
+                           unsigned int first, unsigned int count, const int offset)
+{
+  int pcd_version, data_type;
+  unsigned int data_idx;
+  ChunkIndex chunks;
+
+  int res = parseHeader (file_name, cloud, origin, orientation, pcd_version, data_type, data_idx, offset, &chunks);
+  if (res < 0)
+    return (res);
+
+  // An empty range needs no data at all
+  if (count == 0)
+  {
+    cloud.data.clear ();
+    cloud.width = cloud.height = 0;
+    cloud.row_step = 0;
+    cloud.is_dense = true;
+    return (0);
+  }
+
+  size_t nr_points = static_cast<size_t> (cloud.width) * cloud.height;
+  if (first >= nr_points)
+  {
+    PCL_ERROR ("[pcl::PCDReader::readRange] First point (%u) out of range, file %s has %lu points.\n", first, file_name.c_str (), nr_points);
+    return (-1);
+  }
+  count = static_cast<unsigned int> (std::min (static_cast<size_t> (count), nr_points - first));
+
+  if (data_type == 1 || data_type == 3)
+  {
+    // Only map the part of the file up to the last requested point
+    size_t data_size = (data_type == 1) ? static_cast<size_t> (first + count) * cloud.point_step
+                                        : chunks.offsets[(first + count - 1) / chunks.points_per_chunk + 1];
+    if (boost::filesystem::file_size (file_name) < data_idx + data_size)
+    {
+      PCL_ERROR ("[pcl::PCDReader::readRange] File %s is smaller than advertised in its header!\n", file_name.c_str ());
+      return (-1);
+    }
+
+    PCDMappedFile file;
+    if (!file.map (file_name, data_idx + data_size))
+    {
+      PCL_ERROR ("[pcl::PCDReader::readRange] Error mapping file %s.\n", file_name.c_str ());
+      return (-1);
+    }
+
+    cloud.data.resize (static_cast<size_t> (count) * cloud.point_step);
+    if (data_type == 1)
+      memcpy (&cloud.data[0], file.data () + data_idx + static_cast<size_t> (first) * cloud.point_step, cloud.data.size ());
+    else if (!readChunks (file.data () + data_idx, chunks, cloud, nr_points, first, count))
+    {
+      PCL_ERROR ("[pcl::PCDReader::readRange] Corrupted chunk in binary_chunked PCD file %s\n", file_name.c_str ());
+      return (-1);
+    }
+  }
+  else
+  {
+    // ASCII and binary_compressed data can only be read as a whole
+    sensor_msgs::PointCloud2 full;
+    res = read (file_name, full, origin, orientation, pcd_version, offset);
+    if (res < 0)
+      return (res);
+    cloud.data.assign (full.data.begin () + static_cast<size_t> (first) * full.point_step,
+                       full.data.begin () + static_cast<size_t> (first + count) * full.point_step);
+  }
+
+  cloud.width    = count;
+  cloud.height   = 1;
+  cloud.row_step = cloud.point_step * cloud.width;
+
+  // Check the floating point fields for NaN/Inf values
+  cloud.is_dense = true;
+  for (uint32_t i = 0; i < count && cloud.is_dense; ++i)
+  {
+    for (unsigned int d = 0; d < static_cast<unsigned int> (cloud.fields.size ()); ++d)
+    {
+      for (uint32_t c = 0; c < cloud.fields[d].count; ++c)
+      {
+        if ((cloud.fields[d].datatype == sensor_msgs::PointField::FLOAT32 &&
+             !isValueFinite<pcl::traits::asType<sensor_msgs::PointField::FLOAT32>::type> (cloud, i, cloud.point_step, d, c)) ||
+            (cloud.fields[d].datatype == sensor_msgs::PointField::FLOAT64 &&
+             !isValueFinite<pcl::traits::asType<sensor_msgs::PointField::FLOAT64>::type> (cloud, i, cloud.point_step, d, c)))
+          cloud.is_dense = false;
+      }
+    }
+  }
+
+  return (0);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 std::string
 pcl::PCDWriter::generateHeaderASCII (const sensor_msgs::PointCloud2 &cloud, 
@@ -1633,7 +1957,7 @@ pcl::PCDWriter::generateHeaderBinary (const sensor_msgs::PointCloud2 &cloud,
         // Else, do cur_field.offset - prev_field.offset + sizeof (prev_field)
         (cloud.fields[i].offset - 
         (cloud.fields[i-1].offset + 
-         cloud.fields[i-1].count * getFieldSize (cloud.fields[i].datatype)));
+         cloud.fields[i-1].count * getFieldSize (cloud.fields[i-1].datatype)));
       
       toffset += fake_offset;
 
@@ -1853,7 +2177,11 @@ pcl::PCDWriter::writeBinary (const std::string &file_name, const sensor_msgs::Po
   std::ostringstream oss;
   oss.imbue (std::locale::classic ());
 
-  oss << generateHeaderBinary (cloud, origin, orientation) << "DATA binary\n";
+  oss << generateHeaderBinary (cloud, origin, orientation) << "DATA binary";
+  // Pad the DATA line so that the points start on a 16 byte boundary, which
+  // allows PCDReader::readView to access them in place
+  oss.flush();
+  oss << std::string (static_cast<size_t> (15 - oss.tellp () % 16), ' ') << "\n";
   oss.flush();
   data_idx = static_cast<unsigned int> (oss.tellp ());
 
@@ -2142,6 +2470,189 @@ pcl::PCDWriter::writeBinaryCompressed (const std::string &file_name, const senso
   return (0);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDWriter::writeBinaryChunked (const std::string &file_name, const sensor_msgs::PointCloud2 &cloud,
+                                    const Eigen::Vector4f &origin, const Eigen::Quaternionf &orientation,
+                                    const unsigned int chunk_size)
+{
+  if (cloud.data.empty ())
+  {
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryChunked] Input point cloud has no data!\n");
+    return (-1);
+  }
+
+  size_t fsize = 0;
+  size_t nri = 0;
+  std::vector<sensor_msgs::PointField> fields (cloud.fields.size ());
+  std::vector<size_t> fields_sizes (cloud.fields.size ());
+  // Compute the total size of the fields
+  for (size_t i = 0; i < cloud.fields.size (); ++i)
+  {
+    if (cloud.fields[i].name == "_")
+      continue;
+    
+    fields_sizes[nri] = cloud.fields[i].count * pcl::getFieldSize (cloud.fields[i].datatype);
+    fsize += fields_sizes[nri];
+    fields[nri] = cloud.fields[i];
+    ++nri;
+  }
+  fields_sizes.resize (nri);
+  fields.resize (nri);
+
+  // The chunk sizes are handed to lzf as unsigned int
+  if (chunk_size == 0 || static_cast<uint64_t> (chunk_size) * fsize > std::numeric_limits<unsigned int>::max ())
+  {
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryChunked] Invalid chunk size (%u)!\n", chunk_size);
+    return (-1);
+  }
+
+  const size_t nr_points = static_cast<size_t> (cloud.width) * cloud.height;
+  const int nr_chunks = static_cast<int> ((nr_points + chunk_size - 1) / chunk_size);
+  std::vector<std::vector<char> > chunks (nr_chunks);
+
+#ifdef _OPENMP
+  int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#else
+  int nr_threads = 1;
+#endif
+
+  // Convert each chunk from XYZRGBXYZRGB to XXYYZZRGBRGB and compress it
+#pragma omp parallel num_threads (nr_threads)
+  {
+    std::vector<char> only_valid_data (chunk_size * fsize);
+#pragma omp for schedule (dynamic)
+    for (int c = 0; c < nr_chunks; ++c)
+    {
+      size_t begin = static_cast<size_t> (c) * chunk_size;
+      size_t end = std::min (begin + chunk_size, nr_points);
+      size_t raw_size = (end - begin) * fsize;
+
+      char *pter = &only_valid_data[0];
+      for (size_t j = 0; j < fields.size (); ++j)
+      {
+        for (size_t i = begin; i < end; ++i, pter += fields_sizes[j])
+          memcpy (pter, &cloud.data[i * cloud.point_step + fields[j].offset], fields_sizes[j]);
+      }
+
+      // A chunk is stored uncompressed if compressing it does not save any space
+      chunks[c].resize (raw_size);
+      unsigned int compressed_size = 0;
+      if (raw_size > 1)
+        compressed_size = pcl::lzfCompress (&only_valid_data[0], static_cast<unsigned int> (raw_size),
+                                            &chunks[c][0], static_cast<unsigned int> (raw_size - 1));
+      if (compressed_size)
+        chunks[c].resize (compressed_size);
+      else
+        memcpy (&chunks[c][0], &only_valid_data[0], raw_size);
+    }
+  }
+
+  std::ostringstream oss;
+  oss.imbue (std::locale::classic ());
+  oss << generateHeaderBinaryCompressed (cloud, origin, orientation) << "CHUNKS " << chunk_size << " " << nr_chunks;
+  std::vector<size_t> chunk_offsets (nr_chunks + 1, 0);
+  for (int c = 0; c < nr_chunks; ++c)
+  {
+    oss << " " << chunks[c].size ();
+    chunk_offsets[c + 1] = chunk_offsets[c] + chunks[c].size ();
+  }
+  oss << "\nDATA binary_chunked\n";
+  oss.flush ();
+  size_t data_idx = static_cast<size_t> (oss.tellp ());
+  size_t file_size = data_idx + chunk_offsets.back ();
+
+#if _WIN32
+  HANDLE h_native_file = CreateFile (file_name.c_str (), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h_native_file == INVALID_HANDLE_VALUE)
+  {
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryChunked] Error during CreateFile (%s)!\n", file_name.c_str ());
+    return (-1);
+  }
+#else
+  int fd = pcl_open (file_name.c_str (), O_RDWR | O_CREAT | O_TRUNC, static_cast<mode_t> (0600));
+  if (fd < 0)
+  {
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryChunked] Error during open (%s)!\n", file_name.c_str());
+    return (-1);
+  }
+#endif
+  // Mandatory lock file
+  boost::interprocess::file_lock file_lock;
+  setLockingPermissions (file_name, file_lock);
+
+#if !_WIN32
+  // Stretch the file size to the size of the data
+  off_t result = pcl_lseek (fd, file_size - 1, SEEK_SET);
+  if (result < 0)
+  {
+    pcl_close (fd);
+    resetLockingPermissions (file_name, file_lock);
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryChunked] Error during lseek ()!\n");
+    return (-1);
+  }
+  // Write a bogus entry so that the new file size comes in effect
+  if (::write (fd, "", 1) != 1)
+  {
+    pcl_close (fd);
+    resetLockingPermissions (file_name, file_lock);
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryChunked] Error during write ()!\n");
+    return (-1);
+  }
+#endif
+
+  // Prepare the map
+#ifdef _WIN32
+  HANDLE fm = CreateFileMapping (h_native_file, NULL, PAGE_READWRITE, 0, (DWORD) file_size, NULL);
+  char *map = static_cast<char*> (MapViewOfFile (fm, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, file_size));
+  CloseHandle (fm);
+
+#else
+  char *map = static_cast<char*> (mmap (0, file_size, PROT_WRITE, MAP_SHARED, fd, 0));
+  if (map == reinterpret_cast<char*> (-1))    // MAP_FAILED
+  {
+    pcl_close (fd);
+    resetLockingPermissions (file_name, file_lock);
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryChunked] Error during mmap ()!\n");
+    return (-1);
+  }
+#endif
+
+  // copy header
+  memcpy (&map[0], oss.str ().c_str (), data_idx);
+  // Copy the compressed chunks
+#pragma omp parallel for num_threads (nr_threads) schedule (dynamic)
+  for (int c = 0; c < nr_chunks; ++c)
+    memcpy (&map[data_idx + chunk_offsets[c]], &chunks[c][0], chunks[c].size ());
+
+#if !_WIN32
+  // If the user set the synchronization flag on, call msync
+  if (map_synchronization_)
+    msync (map, file_size, MS_SYNC);
+#endif
+
+  // Unmap the pages of memory
+#if _WIN32
+    UnmapViewOfFile (map);
+#else
+  if (munmap (map, file_size) == -1)
+  {
+    pcl_close (fd);
+    resetLockingPermissions (file_name, file_lock);
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryChunked] Error during munmap ()!\n");
+    return (-1);
+  }
+#endif
+  // Close file
+#if _WIN32
+  CloseHandle (h_native_file);
+#else
+  pcl_close (fd);
+#endif
+  resetLockingPermissions (file_name, file_lock);
+  return (0);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 std::string
 pcl::PCDWriter::generateHeaderEigen (const pcl::PointCloud<Eigen::MatrixXf> &cloud, 
@@ -106,6 +106,8 @@ namespace pcl
           , target_ ()
           , target_indices_ ()
           , point_representation_ ()
+          , threads_ (0)
+          , force_no_recompute_ (false)
         {
         }
 
@@ -163,6 +165,24 @@ namespace pcl
         inline IndicesPtr const 
         getIndicesTarget () { return (target_indices_); }
 
+        /** \brief Provide a pointer to the search object used to find the nearest neighbors in the target
+          * cloud.
+          * \param[in] tree a pointer to the spatial search object
+          * \param[in] force_no_recompute if true, the target cloud and indices are not given to \a tree before
+          * each search, the caller keeps it up to date (e.g. a VoxelHashMap the map points are added to
+          * incrementally)
+          */
+        inline void
+        setSearchMethodTarget (const KdTreePtr &tree, bool force_no_recompute = false)
+        {
+          tree_ = tree;
+          force_no_recompute_ = force_no_recompute;
+        }
+
+        /** \brief Get a pointer to the search object used to find the nearest neighbors in the target cloud. */
+        inline KdTreePtr
+        getSearchMethodTarget () const { return (tree_); }
+
         /** \brief Determine the correspondences between input and target cloud.
           * \param[out] correspondences the found correspondences (index of query point, index of target point, distance)
           * \param[in] max_distance maximum allowed distance between correspondences
@@ -194,6 +214,18 @@ namespace pcl
           point_representation_ = point_representation;
         }
 
+        /** \brief Set the number of threads used to search for the correspondences. The source points are
+          * distributed over the threads and the correspondences are kept in the order of the source indices, so
+          * the result does not depend on the number of threads.
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+        /** \brief Get the number of threads to use (0 means automatic). */
+        inline unsigned int
+        getNumberOfThreads () const { return (threads_); }
+
       protected:
         /** \brief The correspondence estimation method name. */
         std::string corr_name_;
@@ -210,6 +242,18 @@ namespace pcl
         /** \brief The point representation used (internal). */
         PointRepresentationConstPtr point_representation_;
 
+        /** \brief The number of threads the scheduler should use. */
+        unsigned int threads_;
+
+        /** \brief If true, the target search object is not updated before the correspondences are searched. */
+        bool force_no_recompute_;
+
+        /** \brief Remove the correspondences whose index_match is -1, keeping the order of the others.
+          * \param[in,out] correspondences the correspondences to compact
+          */
+        static void
+        removeInvalidCorrespondences (pcl::Correspondences &correspondences);
+
         /** \brief Abstract class get name method. */
         inline const std::string& 
         getClassName () const { return (corr_name_); }
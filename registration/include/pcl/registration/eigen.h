@@ -48,5 +48,6 @@
 #include <Eigen/Geometry>
 #include <unsupported/Eigen/Polynomials>
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 
 #endif    // PCL_REGISTRATION_EIGEN_H_
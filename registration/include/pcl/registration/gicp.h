@@ -74,6 +74,7 @@ namespace pcl
       using IterativeClosestPoint<PointSource, PointTarget>::inlier_threshold_;
       using IterativeClosestPoint<PointSource, PointTarget>::min_number_correspondences_;
       using IterativeClosestPoint<PointSource, PointTarget>::update_visualizer_;
+      using IterativeClosestPoint<PointSource, PointTarget>::threads_;
 
       typedef pcl::PointCloud<PointSource> PointCloudSource;
       typedef typename PointCloudSource::Ptr PointCloudSourcePtr;
@@ -90,16 +91,31 @@ namespace pcl
       typedef typename pcl::KdTree<PointSource>::Ptr InputKdTreePtr;
 
       typedef Eigen::Matrix<double, 6, 1> Vector6d;
+      typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+      typedef std::vector<Eigen::Matrix3d> MatricesVector;
+      typedef boost::shared_ptr<MatricesVector> MatricesVectorPtr;
+
+      /** \brief The solvers for the transformation that minimizes the Mahalanobis distances of the
+        * correspondences, see setOptimizer. */
+      enum Optimizer
+      {
+        BFGS_OPTIMIZER, /**< BFGS with a line search on the gradient of the Mahalanobis distances (default) */
+        LM_OPTIMIZER    /**< Levenberg-Marquardt on the Gauss-Newton normal equations, with analytic Jacobians */
+      };
 
       /** \brief Empty constructor. */
       GeneralizedIterativeClosestPoint () 
         : k_correspondences_(20)
         , gicp_epsilon_(0.001)
         , rotation_epsilon_(2e-3)
-        , input_covariances_(0)
-        , target_covariances_(0)
+        , input_covariances_()
+        , target_covariances_()
+        , input_covariances_estimated_(false)
+        , target_covariances_estimated_(false)
         , mahalanobis_(0)
         , max_inner_iterations_(20)
+        , optimizer_(BFGS_OPTIMIZER)
       {
         min_number_correspondences_ = 4;
         reg_name_ = "GeneralizedIterativeClosestPoint";
@@ -130,7 +146,7 @@ namespace pcl
         
         input_ = input.makeShared ();
         input_tree_->setInputCloud (input_);
-        input_covariances_.reserve (input_->size ());
+        input_covariances_.reset ();
       }
 
       /** \brief Provide a pointer to the input target (e.g., the point cloud that we want to align the input source to)
@@ -140,9 +156,52 @@ namespace pcl
       setInputTarget (const PointCloudTargetConstPtr &target)
       {
         pcl::Registration<PointSource, PointTarget>::setInputTarget(target);
-        target_covariances_.reserve (target_->size ());
+        target_covariances_.reset ();
+      }
+
+      /** \brief Provide the covariance matrices of the input points, e.g. computed with
+        * computeCovariancesFromNormals, instead of estimating them from the k nearest neighbors. They are
+        * discarded by the next call to setInputCloud.
+        * \param[in] covariances one covariance matrix per point of the input cloud
+        */
+      inline void
+      setSourceCovariances (const MatricesVectorPtr &covariances)
+      {
+        input_covariances_ = covariances;
+        input_covariances_estimated_ = false;
+      }
+
+      /** \brief Get the covariance matrices of the input points, NULL until they are given or computed by
+        * align. */
+      inline MatricesVectorPtr
+      getSourceCovariances () const { return (input_covariances_); }
+
+      /** \brief Provide the covariance matrices of the target points instead of estimating them from the k
+        * nearest neighbors. They are discarded by the next call to setInputTarget.
+        * \param[in] covariances one covariance matrix per point of the target cloud
+        */
+      inline void
+      setTargetCovariances (const MatricesVectorPtr &covariances)
+      {
+        target_covariances_ = covariances;
+        target_covariances_estimated_ = false;
       }
 
+      /** \brief Get the covariance matrices of the target points, NULL until they are given or computed by
+        * align. The ones computed by align are kept for the following alignments to the same target.
+        */
+      inline MatricesVectorPtr
+      getTargetCovariances () const { return (target_covariances_); }
+
+      /** \brief Compute point covariance matrices from surface normals: each one has the variance gicp_epsilon
+        * along the normal and 1 in the tangent plane, which is what the k nearest neighbors estimate for points
+        * sampled from a plane. Points with an invalid normal get the identity.
+        * \param[in] normals the surface normals, one per point
+        * \param[out] covariances the covariance matrices, one per point
+        */
+      template <typename PointN> void
+      computeCovariancesFromNormals (const pcl::PointCloud<PointN> &normals, MatricesVector &covariances) const;
+
       /** \brief Estimate a rigid rotation transformation between a source and a target point cloud using an iterative
         * non-linear Levenberg-Marquardt approach.
         * \param[in] cloud_src the source point cloud dataset
@@ -158,6 +217,46 @@ namespace pcl
                                        const std::vector<int> &indices_tgt,
                                        Eigen::Matrix4f &transformation_matrix);
       
+      /** \brief Estimate a rigid rotation transformation between a source and a target point cloud with
+        * Levenberg-Marquardt iterations on the Gauss-Newton normal equations of the Mahalanobis distances. The
+        * normal equations are accumulated in parallel with the number of threads set by setNumberOfThreads, in
+        * fixed blocks of correspondences added in order, so the result does not depend on the number of
+        * threads. The iterations stop early once a step moves the rotation by less than the rotation epsilon
+        * and the translation by less than the transformation epsilon.
+        * \param[in] cloud_src the source point cloud dataset
+        * \param[in] indices_src the vector of indices describing the points of interest in \a cloud_src
+        * \param[in] cloud_tgt the target point cloud dataset
+        * \param[in] indices_tgt the vector of indices describing the correspondences of the interst points from \a indices_src
+        * \param[in,out] transformation_matrix the initial and the resultant transformation matrix
+        */
+      void
+      estimateRigidTransformationLM (const PointCloudSource &cloud_src,
+                                     const std::vector<int> &indices_src,
+                                     const PointCloudTarget &cloud_tgt,
+                                     const std::vector<int> &indices_tgt,
+                                     Eigen::Matrix4f &transformation_matrix);
+
+      /** \brief Set the solver used at the optimization step.
+        * \param[in] optimizer BFGS_OPTIMIZER (default) or LM_OPTIMIZER
+        */
+      inline void
+      setOptimizer (Optimizer optimizer)
+      {
+        optimizer_ = optimizer;
+        if (optimizer_ == LM_OPTIMIZER)
+          rigid_transformation_estimation_ = 
+            boost::bind (&GeneralizedIterativeClosestPoint<PointSource, PointTarget>::estimateRigidTransformationLM, 
+                         this, _1, _2, _3, _4, _5); 
+        else
+          rigid_transformation_estimation_ = 
+            boost::bind (&GeneralizedIterativeClosestPoint<PointSource, PointTarget>::estimateRigidTransformationBFGS, 
+                         this, _1, _2, _3, _4, _5); 
+      }
+
+      /** \brief Get the solver used at the optimization step. */
+      inline Optimizer
+      getOptimizer () const { return (optimizer_); }
+
       /** \brief \return Mahalanobis distance matrix for the given point index */
       inline const Eigen::Matrix3d& mahalanobis(size_t index) const
       {
@@ -175,6 +274,17 @@ namespace pcl
       void
       computeRDerivative(const Vector6d &x, const Eigen::Matrix3d &R, Vector6d &g) const;
 
+      /** \brief Computes the derivatives of the rotation matrix obtained from the rotation angles x[3], x[4]
+        * and x[5] with respect to each of them.
+        * \param[in] x array representing 3D transformation
+        * \param[out] dR_dPhi the derivative with respect to x[3]
+        * \param[out] dR_dTheta the derivative with respect to x[4]
+        * \param[out] dR_dPsi the derivative with respect to x[5]
+        */
+      void
+      computeRDerivatives (const Vector6d &x, Eigen::Matrix3d &dR_dPhi, Eigen::Matrix3d &dR_dTheta,
+                           Eigen::Matrix3d &dR_dPsi) const;
+
       /** \brief Set the rotation epsilon (maximum allowable difference between two 
         * consecutive rotations) in order for an optimization to be considered as having 
         * converged to the final solution.
@@ -192,11 +302,23 @@ namespace pcl
       /** \brief Set the number of neighbors used when selecting a point neighbourhood
         * to compute covariances. 
         * A higher value will bring more accurate covariance matrix but will make 
-        * covariances computation slower.
+        * covariances computation slower. Covariances estimated by a previous alignment are discarded, the ones
+        * given with setSourceCovariances or setTargetCovariances are kept.
         * \param k the number of neighbors to use when computing covariances
         */
       void
-      setCorrespondenceRandomness (int k) { k_correspondences_ = k; }
+      setCorrespondenceRandomness (int k)
+      {
+        // The covariances estimated from the previous neighborhoods are no longer valid
+        if (k != k_correspondences_)
+        {
+          if (input_covariances_estimated_)
+            input_covariances_.reset ();
+          if (target_covariances_estimated_)
+            target_covariances_.reset ();
+        }
+        k_correspondences_ = k;
+      }
 
       /** \brief Get the number of neighbors used when computing covariances as set by 
         * the user 
@@ -252,10 +374,16 @@ namespace pcl
       InputKdTreePtr input_tree_;
       
       /** \brief Input cloud points covariances. */
-      std::vector<Eigen::Matrix3d> input_covariances_;
+      MatricesVectorPtr input_covariances_;
+
+      /** \brief Target cloud points covariances, kept across alignments until the target changes. */
+      MatricesVectorPtr target_covariances_;
+
+      /** \brief Whether input_covariances_ were estimated from the k nearest neighbors rather than given. */
+      bool input_covariances_estimated_;
 
-      /** \brief Target cloud points covariances. */
-      std::vector<Eigen::Matrix3d> target_covariances_;
+      /** \brief Whether target_covariances_ were estimated from the k nearest neighbors rather than given. */
+      bool target_covariances_estimated_;
 
       /** \brief Mahalanobis matrices holder. */
       std::vector<Eigen::Matrix3d> mahalanobis_;
@@ -263,8 +391,12 @@ namespace pcl
       /** \brief maximum number of optimizations */
       int max_inner_iterations_;
 
+      /** \brief The solver used at the optimization step. */
+      Optimizer optimizer_;
+
       /** \brief compute points covariances matrices according to the K nearest 
         * neighbors. K is set via setCorrespondenceRandomness() methode.
+        * The points are processed in parallel with the number of threads set by setNumberOfThreads.
         * \param cloud pointer to point cloud
         * \param tree KD tree performer for nearest neighbors search
         * \return cloud_covariance covariances matrices for each point in the cloud
@@ -313,6 +445,22 @@ namespace pcl
 
       /// \brief compute transformation matrix from transformation matrix
       void applyState(Eigen::Matrix4f &t, const Vector6d& x) const;
+
+      /** \brief Compute the Gauss-Newton normal equations of the sum of the Mahalanobis distances of the
+        * correspondences, for the transformation \a x applied after \ref base_transformation_.
+        * \param[in] cloud_src the source point cloud dataset
+        * \param[in] indices_src the indices of the source points of the correspondences
+        * \param[in] cloud_tgt the target point cloud dataset
+        * \param[in] indices_tgt the indices of the target points of the correspondences
+        * \param[in] x the transformation vector
+        * \param[out] hessian the sum of J' M J over the correspondences
+        * \param[out] gradient the sum of J' M r over the correspondences
+        * \return the sum of r' M r over the correspondences
+        */
+      double
+      computeNormalEquations (const PointCloudSource &cloud_src, const std::vector<int> &indices_src,
+                              const PointCloudTarget &cloud_tgt, const std::vector<int> &indices_tgt,
+                              const Vector6d &x, Matrix6d &hessian, Vector6d &gradient) const;
       
       /// \brief optimization functor structure
       struct OptimizationFunctorWithIndices : public BFGSDummyFunctor<double,6>
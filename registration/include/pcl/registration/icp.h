@@ -128,6 +128,7 @@ namespace pcl
       using Registration<PointSource, PointTarget>::converged_;
       using Registration<PointSource, PointTarget>::corr_dist_threshold_;
       using Registration<PointSource, PointTarget>::inlier_threshold_;
+      using Registration<PointSource, PointTarget>::threads_;
       using Registration<PointSource, PointTarget>::min_number_correspondences_;
       using Registration<PointSource, PointTarget>::update_visualizer_;
       using Registration<PointSource, PointTarget>::correspondence_distances_;
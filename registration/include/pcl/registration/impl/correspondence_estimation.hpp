@@ -42,6 +42,9 @@
 #include <pcl/common/concatenate.h>
 #include <pcl/registration/correspondence_estimation.h>
 #include <pcl/common/io.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget> bool
@@ -53,11 +56,14 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget>::initCompu
     return (false);
   }
 
-  // If the target indices have been given via setIndicesTarget
-  if (target_indices_)
-    tree_->setInputCloud (target_, target_indices_);
-  else
-    tree_->setInputCloud (target_);
+  if (!force_no_recompute_)
+  {
+    // If the target indices have been given via setIndicesTarget
+    if (target_indices_)
+      tree_->setInputCloud (target_, target_indices_);
+    else
+      tree_->setInputCloud (target_);
+  }
 
   return (PCLBase<PointSource>::initCompute ());
 }
@@ -75,10 +81,22 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget>::setInputT
   target_ = cloud;
 
   // Set the internal point representation of choice
-  if (point_representation_)
+  if (point_representation_ && !force_no_recompute_)
     tree_->setPointRepresentation (point_representation_);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget> void
+pcl::registration::CorrespondenceEstimation<PointSource, PointTarget>::removeInvalidCorrespondences (
+    pcl::Correspondences &correspondences)
+{
+  size_t nr_valid_correspondences = 0;
+  for (size_t i = 0; i < correspondences.size (); ++i)
+    if (correspondences[i].index_match != -1)
+      correspondences[nr_valid_correspondences++] = correspondences[i];
+  correspondences.resize (nr_valid_correspondences);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget> void
 pcl::registration::CorrespondenceEstimation<PointSource, PointTarget>::determineCorrespondences (
@@ -94,49 +112,39 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget>::determine
 
   std::vector<int> index (1);
   std::vector<float> distance (1);
-  pcl::Correspondence corr;
-  unsigned int nr_valid_correspondences = 0;
-  
+  PointTarget pt;
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
+  // Every source index fills its own slot, with index_match = -1 if the correspondence is rejected, and the
+  // slots are compacted in order afterwards
   // Check if the template types are the same. If true, avoid a copy.
   // Both point types MUST be registered using the POINT_CLOUD_REGISTER_POINT_STRUCT macro!
-  if (isSamePointType<PointSource, PointTarget> ())
+  const bool same_point_type = isSamePointType<PointSource, PointTarget> ();
+#ifdef _OPENMP
+#pragma omp parallel for private (index, distance, pt) num_threads (nr_threads) schedule (dynamic, 256)
+#endif
+  for (int i = 0; i < static_cast<int> (indices_->size ()); ++i)
   {
-    // Iterate over the input set of source indices
-    for (std::vector<int>::const_iterator idx = indices_->begin (); idx != indices_->end (); ++idx)
-    {
-      tree_->nearestKSearch (input_->points[*idx], 1, index, distance);
-      if (distance[0] > max_dist_sqr)
-        continue;
-
-      corr.index_query = *idx;
-      corr.index_match = index[0];
-      corr.distance = distance[0];
-      correspondences[nr_valid_correspondences++] = corr;
-    }
-  }
-  else
-  {
-    PointTarget pt;
-    
-    // Iterate over the input set of source indices
-    for (std::vector<int>::const_iterator idx = indices_->begin (); idx != indices_->end (); ++idx)
+    const int idx = (*indices_)[i];
+    if (same_point_type)
+      tree_->nearestKSearch (input_->points[idx], 1, index, distance);
+    else
     {
       // Copy the source data to a target PointTarget format so we can search in the tree
       pcl::for_each_type <FieldListTarget> (pcl::NdConcatenateFunctor <PointSource, PointTarget> (
-            input_->points[*idx], 
+            input_->points[idx], 
             pt));
-
       tree_->nearestKSearch (pt, 1, index, distance);
-      if (distance[0] > max_dist_sqr)
-        continue;
-
-      corr.index_query = *idx;
-      corr.index_match = index[0];
-      corr.distance = distance[0];
-      correspondences[nr_valid_correspondences++] = corr;
     }
+
+    pcl::Correspondence &corr = correspondences[i];
+    corr.index_query = idx;
+    corr.index_match = distance[0] > max_dist_sqr ? -1 : index[0];
+    corr.distance = distance[0];
   }
-  correspondences.resize (nr_valid_correspondences);
+  removeInvalidCorrespondences (correspondences);
   deinitCompute ();
 }
 
@@ -167,68 +175,57 @@ pcl::registration::CorrespondenceEstimation<PointSource, PointTarget>::determine
   std::vector<float> distance (1);
   std::vector<int> index_reciprocal (1);
   std::vector<float> distance_reciprocal (1);
-  pcl::Correspondence corr;
-  unsigned int nr_valid_correspondences = 0;
-  int target_idx = 0;
+  PointTarget pt_src;
+  PointSource pt_tgt;
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
 
   // Check if the template types are the same. If true, avoid a copy.
   // Both point types MUST be registered using the POINT_CLOUD_REGISTER_POINT_STRUCT macro!
-  if (isSamePointType<PointSource, PointTarget> ())
-  {
-    // Iterate over the input set of source indices
-    for (std::vector<int>::const_iterator idx = indices_->begin (); idx != indices_->end (); ++idx)
-    {
-      tree_->nearestKSearch (input_->points[*idx], 1, index, distance);
-      if (distance[0] > max_dist_sqr)
-        continue;
-
-      target_idx = index[0];
-
-      tree_reciprocal.nearestKSearch (target_->points[target_idx], 1, index_reciprocal, distance_reciprocal);
-      if (distance_reciprocal[0] > max_dist_sqr || *idx != index_reciprocal[0])
-        continue;
-
-      corr.index_query = *idx;
-      corr.index_match = index[0];
-      corr.distance = distance[0];
-      correspondences[nr_valid_correspondences++] = corr;
-    }
-  }
-  else
+  const bool same_point_type = isSamePointType<PointSource, PointTarget> ();
+#ifdef _OPENMP
+#pragma omp parallel for private (index, distance, index_reciprocal, distance_reciprocal, pt_src, pt_tgt) num_threads (nr_threads) schedule (dynamic, 256)
+#endif
+  for (int i = 0; i < static_cast<int> (indices_->size ()); ++i)
   {
-    PointTarget pt_src;
-    PointSource pt_tgt;
-   
-    // Iterate over the input set of source indices
-    for (std::vector<int>::const_iterator idx = indices_->begin (); idx != indices_->end (); ++idx)
+    const int idx = (*indices_)[i];
+    pcl::Correspondence &corr = correspondences[i];
+    corr.index_query = idx;
+    corr.index_match = -1;
+
+    if (same_point_type)
+      tree_->nearestKSearch (input_->points[idx], 1, index, distance);
+    else
     {
       // Copy the source data to a target PointTarget format so we can search in the tree
       pcl::for_each_type <FieldList> (pcl::NdConcatenateFunctor <PointSource, PointTarget> (
-            input_->points[*idx], 
+            input_->points[idx], 
             pt_src));
-
       tree_->nearestKSearch (pt_src, 1, index, distance);
-      if (distance[0] > max_dist_sqr)
-        continue;
+    }
+    if (distance[0] > max_dist_sqr)
+      continue;
 
-      target_idx = index[0];
+    int target_idx = index[0];
 
+    if (same_point_type)
+      tree_reciprocal.nearestKSearch (target_->points[target_idx], 1, index_reciprocal, distance_reciprocal);
+    else
+    {
       // Copy the target data to a target PointSource format so we can search in the tree_reciprocal
       pcl::for_each_type<FieldList> (pcl::NdConcatenateFunctor <PointTarget, PointSource> (
             target_->points[target_idx],
             pt_tgt));
-
       tree_reciprocal.nearestKSearch (pt_tgt, 1, index_reciprocal, distance_reciprocal);
-      if (distance_reciprocal[0] > max_dist_sqr || *idx != index_reciprocal[0])
-        continue;
-
-      corr.index_query = *idx;
-      corr.index_match = index[0];
-      corr.distance = distance[0];
-      correspondences[nr_valid_correspondences++] = corr;
     }
+    if (distance_reciprocal[0] > max_dist_sqr || idx != index_reciprocal[0])
+      continue;
+
+    corr.index_match = index[0];
+    corr.distance = distance[0];
   }
-  correspondences.resize (nr_valid_correspondences);
+  removeInvalidCorrespondences (correspondences);
   deinitCompute ();
 }
 
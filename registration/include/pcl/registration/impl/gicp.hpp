@@ -37,6 +37,9 @@
 
 #include <pcl/registration/boost.h>
 #include <pcl/registration/exceptions.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget> 
@@ -51,72 +54,101 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeCovarian
     return;
   }
 
-  Eigen::Vector3d mean;
-  std::vector<int> nn_indecies; nn_indecies.reserve (k_correspondences_);
-  std::vector<float> nn_dist_sq; nn_dist_sq.reserve (k_correspondences_);
+  cloud_covariances.resize (cloud->size ());
 
-  // We should never get there but who knows
-  if(cloud_covariances.size () < cloud->size ())
-    cloud_covariances.resize (cloud->size ());
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
 
-  typename pcl::PointCloud<PointT>::const_iterator points_iterator = cloud->begin ();
-  std::vector<Eigen::Matrix3d>::iterator matrices_iterator = cloud_covariances.begin ();
-  for(;
-      points_iterator != cloud->end ();
-      ++points_iterator, ++matrices_iterator)
+  // Every point writes its own matrix, so the result does not depend on the number of threads
+#ifdef _OPENMP
+#pragma omp parallel num_threads (nr_threads)
+#endif
   {
-    const PointT &query_point = *points_iterator;
-    Eigen::Matrix3d &cov = *matrices_iterator;
-    // Zero out the cov and mean
-    cov.setZero ();
-    mean.setZero ();
-
-    // Search for the K nearest neighbours
-    kdtree->nearestKSearch(query_point, k_correspondences_, nn_indecies, nn_dist_sq);
-    
-    // Find the covariance matrix
-    for(int j = 0; j < k_correspondences_; j++) {
-      const PointT &pt = (*cloud)[nn_indecies[j]];
-      
-      mean[0] += pt.x;
-      mean[1] += pt.y;
-      mean[2] += pt.z;
-      
-      cov(0,0) += pt.x*pt.x;
-      
-      cov(1,0) += pt.y*pt.x;
-      cov(1,1) += pt.y*pt.y;
-      
-      cov(2,0) += pt.z*pt.x;
-      cov(2,1) += pt.z*pt.y;
-      cov(2,2) += pt.z*pt.z;    
-    }
-  
-    mean /= static_cast<double> (k_correspondences_);
-    // Get the actual covariance
-    for (int k = 0; k < 3; k++)
-      for (int l = 0; l <= k; l++) 
-      {
-        cov(k,l) /= static_cast<double> (k_correspondences_);
-        cov(k,l) -= mean[k]*mean[l];
-        cov(l,k) = cov(k,l);
+    Eigen::Vector3d mean;
+    std::vector<int> nn_indecies; nn_indecies.reserve (k_correspondences_);
+    std::vector<float> nn_dist_sq; nn_dist_sq.reserve (k_correspondences_);
+
+#ifdef _OPENMP
+#pragma omp for schedule (dynamic, 256)
+#endif
+    for (int i = 0; i < static_cast<int> (cloud->size ()); ++i)
+    {
+      const PointT &query_point = (*cloud)[i];
+      Eigen::Matrix3d &cov = cloud_covariances[i];
+      // Zero out the cov and mean
+      cov.setZero ();
+      mean.setZero ();
+
+      // Search for the K nearest neighbours
+      kdtree->nearestKSearch(query_point, k_correspondences_, nn_indecies, nn_dist_sq);
+
+      // Find the covariance matrix
+      for(int j = 0; j < k_correspondences_; j++) {
+        const PointT &pt = (*cloud)[nn_indecies[j]];
+
+        mean[0] += pt.x;
+        mean[1] += pt.y;
+        mean[2] += pt.z;
+
+        cov(0,0) += pt.x*pt.x;
+
+        cov(1,0) += pt.y*pt.x;
+        cov(1,1) += pt.y*pt.y;
+
+        cov(2,0) += pt.z*pt.x;
+        cov(2,1) += pt.z*pt.y;
+        cov(2,2) += pt.z*pt.z;
+      }
+
+      mean /= static_cast<double> (k_correspondences_);
+      // Get the actual covariance
+      for (int k = 0; k < 3; k++)
+        for (int l = 0; l <= k; l++)
+        {
+          cov(k,l) /= static_cast<double> (k_correspondences_);
+          cov(k,l) -= mean[k]*mean[l];
+          cov(l,k) = cov(k,l);
+        }
+
+      // Compute the SVD (covariance matrix is symmetric so U = V')
+      Eigen::JacobiSVD<Eigen::Matrix3d> svd(cov, Eigen::ComputeFullU);
+      cov.setZero ();
+      Eigen::Matrix3d U = svd.matrixU ();
+      // Reconstitute the covariance matrix with modified singular values using the column     // vectors in V.
+      for(int k = 0; k < 3; k++) {
+        Eigen::Vector3d col = U.col(k);
+        double v = 1.; // biggest 2 singular values replaced by 1
+        if(k == 2)   // smallest singular value replaced by gicp_epsilon
+          v = gicp_epsilon_;
+        cov+= v * col * col.transpose();
       }
-    
-    // Compute the SVD (covariance matrix is symmetric so U = V')
-    Eigen::JacobiSVD<Eigen::Matrix3d> svd(cov, Eigen::ComputeFullU);
-    cov.setZero ();
-    Eigen::Matrix3d U = svd.matrixU ();
-    // Reconstitute the covariance matrix with modified singular values using the column     // vectors in V.
-    for(int k = 0; k < 3; k++) {
-      Eigen::Vector3d col = U.col(k);
-      double v = 1.; // biggest 2 singular values replaced by 1
-      if(k == 2)   // smallest singular value replaced by gicp_epsilon
-        v = gicp_epsilon_;
-      cov+= v * col * col.transpose(); 
     }
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget>
+template <typename PointN> void
+pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeCovariancesFromNormals (const pcl::PointCloud<PointN> &normals,
+                                                                                               MatricesVector &covariances) const
+{
+  covariances.resize (normals.size ());
+  for (size_t i = 0; i < normals.size (); ++i)
+  {
+    Eigen::Vector3d n (normals[i].normal_x, normals[i].normal_y, normals[i].normal_z);
+    const double norm = n.norm ();
+    if (!pcl_isfinite (norm) || norm == 0)
+    {
+      covariances[i].setIdentity ();
+      continue;
+    }
+    n /= norm;
+    // U diag (1, 1, gicp_epsilon) U' with the normal as last column of U
+    covariances[i] = Eigen::Matrix3d::Identity () - (1.0 - gicp_epsilon_) * n * n.transpose ();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget> void
 pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeRDerivative(const Vector6d &x, const Eigen::Matrix3d &R, Vector6d& g) const
@@ -125,6 +157,20 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeRDerivat
   Eigen::Matrix3d dR_dTheta;
   Eigen::Matrix3d dR_dPsi;
 
+  computeRDerivatives (x, dR_dPhi, dR_dTheta, dR_dPsi);
+
+  g[3] = matricesInnerProd(dR_dPhi, R);
+  g[4] = matricesInnerProd(dR_dTheta, R);
+  g[5] = matricesInnerProd(dR_dPsi, R);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget> void
+pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeRDerivatives (const Vector6d &x,
+                                                                                      Eigen::Matrix3d &dR_dPhi,
+                                                                                      Eigen::Matrix3d &dR_dTheta,
+                                                                                      Eigen::Matrix3d &dR_dPsi) const
+{
   double phi = x[3], theta = x[4], psi = x[5];
   
   double cphi = cos(phi), sphi = sin(phi);
@@ -166,10 +212,6 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeRDerivat
   dR_dPsi(0,2) = cpsi*sphi - cphi*spsi*stheta;
   dR_dPsi(1,2) = sphi*spsi + cphi*cpsi*stheta;
   dR_dPsi(2,2) = 0.;
-      
-  g[3] = matricesInnerProd(dR_dPhi, R);
-  g[4] = matricesInnerProd(dR_dTheta, R);
-  g[5] = matricesInnerProd(dR_dPsi, R);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -236,6 +278,148 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::estimateRigidTr
                         "[pcl::" << getClassName () << "::TransformationEstimationBFGS::estimateRigidTransformation] BFGS solver didn't converge!");
 }
 
+////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget> void
+pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::estimateRigidTransformationLM (const PointCloudSource &cloud_src, 
+                                                                                                const std::vector<int> &indices_src, 
+                                                                                                const PointCloudTarget &cloud_tgt, 
+                                                                                                const std::vector<int> &indices_tgt, 
+                                                                                                Eigen::Matrix4f &transformation_matrix)
+{
+  if (indices_src.size () < 4)     // need at least 4 samples
+  {
+    PCL_THROW_EXCEPTION (NotEnoughPointsException, 
+                         "[pcl::GeneralizedIterativeClosestPoint::estimateRigidTransformationLM] Need at least 4 points to estimate a transform! Source and target have " << indices_src.size () << " points!");
+    return;
+  }
+  // Set the initial solution
+  Vector6d x = Vector6d::Zero ();
+  x[0] = transformation_matrix (0,3);
+  x[1] = transformation_matrix (1,3);
+  x[2] = transformation_matrix (2,3);
+  x[3] = atan2 (transformation_matrix (2,1), transformation_matrix (2,2));
+  x[4] = asin (-transformation_matrix (2,0));
+  x[5] = atan2 (transformation_matrix (1,0), transformation_matrix (0,0));
+
+  Matrix6d hessian, hessian_new;
+  Vector6d gradient, gradient_new;
+  double f = computeNormalEquations (cloud_src, indices_src, cloud_tgt, indices_tgt, x, hessian, gradient);
+
+  // Marquardt damping, scaled by the diagonal of the Gauss-Newton hessian
+  double lambda = 1e-3;
+  int inner_iterations = 0;
+  while (inner_iterations < max_inner_iterations_)
+  {
+    inner_iterations++;
+    Matrix6d damped (hessian);
+    damped.diagonal () *= 1.0 + lambda;
+    Vector6d delta = damped.ldlt ().solve (-gradient);
+    if (!pcl_isfinite (delta.sum ()))
+    {
+      PCL_DEBUG ("[pcl::%s::estimateRigidTransformationLM] Degenerate normal equations.\n", getClassName ().c_str ());
+      break;
+    }
+
+    Vector6d x_new = x + delta;
+    double f_new = computeNormalEquations (cloud_src, indices_src, cloud_tgt, indices_tgt, x_new, hessian_new, gradient_new);
+    if (f_new < f)
+    {
+      x = x_new;
+      f = f_new;
+      hessian = hessian_new;
+      gradient = gradient_new;
+      lambda = std::max (lambda * 0.1, 1e-10);
+    }
+    else
+      lambda *= 10.0;
+
+    // Stop once the step no longer moves the transformation, or the damping gave up on finding a decrease
+    if ((delta.head<3> ().cwiseAbs ().maxCoeff () < transformation_epsilon_ &&
+         delta.tail<3> ().cwiseAbs ().maxCoeff () < rotation_epsilon_) || lambda > 1e10)
+      break;
+  }
+  PCL_DEBUG ("[pcl::%s::estimateRigidTransformationLM] Finished after %d iterations with error %g.\n",
+             getClassName ().c_str (), inner_iterations, f / static_cast<double> (indices_src.size ()));
+  transformation_matrix.setIdentity ();
+  applyState (transformation_matrix, x);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget> double
+pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeNormalEquations (const PointCloudSource &cloud_src,
+                                                                                         const std::vector<int> &indices_src,
+                                                                                         const PointCloudTarget &cloud_tgt,
+                                                                                         const std::vector<int> &indices_tgt,
+                                                                                         const Vector6d &x,
+                                                                                         Matrix6d &hessian,
+                                                                                         Vector6d &gradient) const
+{
+  // The residual of a correspondence is r = R(x) * q + t_b + x_t - p_tgt, with q the source point rotated by the
+  // base transformation, so its Jacobian is [I | dR/dphi * q, dR/dtheta * q, dR/dpsi * q]
+  Eigen::Matrix3d rotation;
+  rotation = Eigen::AngleAxisd (x[5], Eigen::Vector3d::UnitZ ())
+           * Eigen::AngleAxisd (x[4], Eigen::Vector3d::UnitY ())
+           * Eigen::AngleAxisd (x[3], Eigen::Vector3d::UnitX ());
+  Eigen::Matrix3d dR_dPhi, dR_dTheta, dR_dPsi;
+  computeRDerivatives (x, dR_dPhi, dR_dTheta, dR_dPsi);
+  const Eigen::Matrix3d base_rotation = base_transformation_.topLeftCorner<3, 3> ().template cast<double> ();
+  const Eigen::Vector3d translation = base_transformation_.block<3, 1> (0, 3).template cast<double> () + x.head<3> ();
+
+  // The correspondences are processed in blocks of fixed size, whose partial sums are added in order afterwards,
+  // so that the result does not depend on the number of threads
+  const int block_size = 128;
+  const int nr_correspondences = static_cast<int> (indices_src.size ());
+  const int nr_blocks = (nr_correspondences + block_size - 1) / block_size;
+  std::vector<double> block_errors (nr_blocks, 0);
+  std::vector<Vector6d, Eigen::aligned_allocator<Vector6d> > block_gradients (nr_blocks, Vector6d::Zero ());
+  std::vector<Matrix6d, Eigen::aligned_allocator<Matrix6d> > block_hessians (nr_blocks, Matrix6d::Zero ());
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#pragma omp parallel num_threads (nr_threads)
+#endif
+  {
+    Eigen::Matrix<double, 3, 6> jacobian;
+    jacobian.leftCols<3> ().setIdentity ();
+    Eigen::Matrix<double, 6, 3> jacobian_t_mahalanobis;
+
+#ifdef _OPENMP
+#pragma omp for schedule (dynamic, 1)
+#endif
+    for (int block = 0; block < nr_blocks; ++block)
+    {
+      for (int idx = block * block_size; idx < std::min (nr_correspondences, (block + 1) * block_size); ++idx)
+      {
+        const PointSource &p_src = cloud_src.points[indices_src[idx]];
+        const PointTarget &p_tgt = cloud_tgt.points[indices_tgt[idx]];
+        const Eigen::Vector3d q (base_rotation * Eigen::Vector3d (p_src.x, p_src.y, p_src.z));
+        const Eigen::Vector3d res (rotation * q + translation - Eigen::Vector3d (p_tgt.x, p_tgt.y, p_tgt.z));
+        const Eigen::Matrix3d &M = mahalanobis_[indices_src[idx]];
+        const Eigen::Vector3d temp (M * res);
+
+        jacobian.col (3) = dR_dPhi * q;
+        jacobian.col (4) = dR_dTheta * q;
+        jacobian.col (5) = dR_dPsi * q;
+        jacobian_t_mahalanobis = jacobian.transpose () * M;
+
+        block_errors[block] += res.dot (temp);
+        block_gradients[block] += jacobian.transpose () * temp;
+        block_hessians[block] += jacobian_t_mahalanobis * jacobian;
+      }
+    }
+  }
+
+  double f = 0;
+  gradient.setZero ();
+  hessian.setZero ();
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    f += block_errors[block];
+    gradient += block_gradients[block];
+    hessian += block_hessians[block];
+  }
+  return (f);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget> inline double
 pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::OptimizationFunctorWithIndices::operator() (const Vector6d& x)
@@ -345,10 +529,28 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeTransfor
   const size_t N = indices_->size ();
   // Set the mahalanobis matrices to identity
   mahalanobis_.resize (N, Eigen::Matrix3d::Identity ());
-  // Compute target cloud covariance matrices
-  computeCovariances<PointTarget> (target_, tree_, target_covariances_);
+  // Compute target cloud covariance matrices, unless they were given or computed for a previous alignment
+  if (!target_covariances_)
+  {
+    target_covariances_.reset (new MatricesVector);
+    computeCovariances<PointTarget> (target_, tree_, *target_covariances_);
+    target_covariances_estimated_ = true;
+  }
   // Compute input cloud covariance matrices
-  computeCovariances<PointSource> (input_, input_tree_, input_covariances_);
+  if (!input_covariances_)
+  {
+    input_covariances_.reset (new MatricesVector);
+    computeCovariances<PointSource> (input_, input_tree_, *input_covariances_);
+    input_covariances_estimated_ = true;
+  }
+  if (input_covariances_->size () != input_->size () || target_covariances_->size () != target_->size ())
+  {
+    PCL_ERROR ("[pcl::%s::computeTransformation] The number of covariance matrices does not match the number of points!\n", getClassName ().c_str ());
+    return;
+  }
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
 
   base_transformation_ = guess;
   nr_iterations_ = 0;
@@ -372,23 +574,23 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeTransfor
 
     Eigen::Matrix3d R = transform_R.topLeftCorner<3,3> ();
 
-    for (size_t i = 0; i < N; i++)
+    // Every point writes its own slot (-1 if it has no neighbor closer than the threshold, or no neighbor at
+    // all), so that the correspondences can be compacted in order afterwards and the result does not depend on
+    // the number of threads
+#ifdef _OPENMP
+#pragma omp parallel for private (nn_indices, nn_dists) num_threads (nr_threads) schedule (dynamic, 256)
+#endif
+    for (int i = 0; i < static_cast<int> (N); i++)
     {
       PointSource query = output[i];
       query.getVector4fMap () = guess * query.getVector4fMap ();
       query.getVector4fMap () = transformation_ * query.getVector4fMap ();
 
-      if (!searchForNeighbors (query, nn_indices, nn_dists))
-      {
-        PCL_ERROR ("[pcl::%s::computeTransformation] Unable to find a nearest neighbor in the target dataset for point %d in the source!\n", getClassName ().c_str (), (*indices_)[i]);
-        return;
-      }
-      
-      // Check if the distance to the nearest neighbor is smaller than the user imposed threshold
-      if (nn_dists[0] < dist_threshold)
+      // Points without a neighbor are skipped, like the ones whose nearest neighbor is too far away
+      if (searchForNeighbors (query, nn_indices, nn_dists) && nn_dists[0] < dist_threshold)
       {
-        Eigen::Matrix3d &C1 = input_covariances_[i];
-        Eigen::Matrix3d &C2 = target_covariances_[nn_indices[0]];
+        Eigen::Matrix3d &C1 = (*input_covariances_)[i];
+        Eigen::Matrix3d &C2 = (*target_covariances_)[nn_indices[0]];
         Eigen::Matrix3d &M = mahalanobis_[i];
         // M = R*C1
         M = R * C1;
@@ -397,10 +599,19 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeTransfor
         temp+= C2;
         // M = temp^-1
         M = temp.inverse ();
-        source_indices[cnt] = static_cast<int> (i);
-        target_indices[cnt] = nn_indices[0];
-        cnt++;
+        target_indices[i] = nn_indices[0];
       }
+      else
+        target_indices[i] = -1;
+    }
+
+    for (size_t i = 0; i < N; i++)
+    {
+      if (target_indices[i] == -1)
+        continue;
+      source_indices[cnt] = static_cast<int> (i);
+      target_indices[cnt] = target_indices[i];
+      cnt++;
     }
     // Resize to the actual number of valid correspondences
     source_indices.resize(cnt); target_indices.resize(cnt);
@@ -39,6 +39,9 @@
  */
 
 #include <pcl/registration/boost.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget> void
@@ -47,6 +50,9 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
   // Allocate enough space to hold the results
   std::vector<int> nn_indices (1);
   std::vector<float> nn_dists (1);
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
 
   // Point cloud containing the correspondences of each point in <input, indices>
   PointCloudTarget input_corresp;
@@ -80,26 +86,37 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
     std::vector<int> source_indices (indices_->size ());
     std::vector<int> target_indices (indices_->size ());
 
-    // Iterating over the entire index vector and  find all correspondences
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+    // Iterating over the entire index vector and  find all correspondences. Every point writes its own slot
+    // (-1 if there is no neighbor closer than the threshold), so that the correspondences can be compacted in
+    // index order afterwards and the result does not depend on the number of threads. Approximate search
+    // methods (e.g. VoxelHashMap) may find no neighbor at all for points that are far from the target
+#ifdef _OPENMP
+#pragma omp parallel for private (nn_indices, nn_dists) num_threads (nr_threads) schedule (dynamic, 256)
+#endif
+    for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
     {
       if (!this->searchForNeighbors (output, (*indices_)[idx], nn_indices, nn_dists))
       {
-        PCL_ERROR ("[pcl::%s::computeTransformation] Unable to find a nearest neighbor in the target dataset for point %d in the source!\n", getClassName ().c_str (), (*indices_)[idx]);
-        return;
+        target_indices[idx] = -1;
+        correspondence_distances_[(*indices_)[idx]] = static_cast<float> (dist_threshold);
+        continue;
       }
 
       // Check if the distance to the nearest neighbor is smaller than the user imposed threshold
-      if (nn_dists[0] < dist_threshold)
-      {
-        source_indices[cnt] = (*indices_)[idx];
-        target_indices[cnt] = nn_indices[0];
-        cnt++;
-      }
+      target_indices[idx] = nn_dists[0] < dist_threshold ? nn_indices[0] : -1;
 
       // Save the nn_dists[0] to a global vector of distances
       correspondence_distances_[(*indices_)[idx]] = std::min (nn_dists[0], static_cast<float> (dist_threshold));
     }
+
+    for (size_t idx = 0; idx < indices_->size (); ++idx)
+    {
+      if (target_indices[idx] == -1)
+        continue;
+      source_indices[cnt] = (*indices_)[idx];
+      target_indices[cnt] = target_indices[idx];
+      cnt++;
+    }
     if (cnt < min_number_correspondences_)
     {
       PCL_ERROR ("[pcl::%s::computeTransformation] Not enough correspondences found. Relax your threshold parameters.\n", getClassName ().c_str ());
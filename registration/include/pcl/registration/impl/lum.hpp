@@ -41,6 +41,9 @@
 #define PCL_REGISTRATION_IMPL_LUM_HPP_
 
 #include <pcl/registration/lum.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> inline void
@@ -91,6 +94,20 @@ pcl::registration::LUM<PointT>::getConvergenceThreshold ()
   return (convergence_threshold_);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> inline void
+pcl::registration::LUM<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+  threads_ = nr_threads;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> inline unsigned int
+pcl::registration::LUM<PointT>::getNumberOfThreads () const
+{
+  return (threads_);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> typename pcl::registration::LUM<PointT>::Vertex
 pcl::registration::LUM<PointT>::addPointCloud (PointCloudPtr cloud, Eigen::Vector6f pose)
@@ -215,44 +232,101 @@ pcl::registration::LUM<PointT>::compute ()
     PCL_ERROR("[pcl::registration::LUM::compute] The slam graph needs at least 2 vertices.\n");
     return;
   }
+  // The edges are linearized in parallel, so they are gathered for random access first
+  std::vector<Edge> graph_edges;
+  graph_edges.reserve (num_edges (*slam_graph_));
+  typename SLAMGraph::edge_iterator e, e_end;
+  for (boost::tuples::tie (e, e_end) = edges (*slam_graph_); e != e_end; ++e)
+    graph_edges.push_back (*e);
+  const int nr_edges = static_cast<int> (graph_edges.size ());
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
   for (int i = 0; i < max_iterations_; ++i)
   {
     // Linearized computation of C^-1 and C^-1*D and convergence checking for all edges in the graph (results stored in slam_graph_)
-    typename SLAMGraph::edge_iterator e, e_end;
-    for (boost::tuples::tie (e, e_end) = edges (*slam_graph_); e != e_end; ++e)
-      computeEdge (*e);
-
-    // Declare matrices G and B
-    Eigen::MatrixXf G = Eigen::MatrixXf::Zero (6 * (n - 1), 6 * (n - 1));
-    Eigen::VectorXf B = Eigen::VectorXf::Zero (6 * (n - 1));
-
-    // Start at 1 because 0 is the reference pose
-    for (int vi = 1; vi != n; ++vi)
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (nr_threads) schedule (dynamic, 1)
+#endif
+    for (int ei = 0; ei < nr_edges; ++ei)
+      computeEdge (graph_edges[ei]);
+
+    // Find the vertices that are connected to the reference pose through edges with usable constraints
+    std::vector<std::vector<int> > neighbors (n);
+    for (int ei = 0; ei < nr_edges; ++ei)
+    {
+      if ((*slam_graph_)[graph_edges[ei]].cinv_ == Eigen::Matrix6f::Zero ())
+        continue;
+      const int vi = static_cast<int> (source (graph_edges[ei], *slam_graph_));
+      const int vj = static_cast<int> (target (graph_edges[ei], *slam_graph_));
+      neighbors[vi].push_back (vj);
+      neighbors[vj].push_back (vi);
+    }
+    std::vector<bool> connected (n, false);
+    std::vector<int> open_vertices (1, 0);
+    connected[0] = true;
+    while (!open_vertices.empty ())
     {
-      for (int vj = 0; vj != n; ++vj)
-      {
-        // Attempt to use the forward edge, otherwise use backward edge, otherwise there was no edge
-        Edge e;
-        bool present1, present2;
-        boost::tuples::tie (e, present1) = edge (vi, vj, *slam_graph_);
-        if (!present1)
+      const int vi = open_vertices.back ();
+      open_vertices.pop_back ();
+      for (size_t k = 0; k < neighbors[vi].size (); ++k)
+        if (!connected[neighbors[vi][k]])
         {
-          boost::tuples::tie (e, present2) = edge (vj, vi, *slam_graph_);
-          if (!present2)
-            continue;
+          connected[neighbors[vi][k]] = true;
+          open_vertices.push_back (neighbors[vi][k]);
         }
+    }
 
-        // Fill in elements of G and B
-        if (vj > 0)
-          G.block (6 * (vi - 1), 6 * (vj - 1), 6, 6) = -(*slam_graph_)[e].cinv_;
-        G.block (6 * (vi - 1), 6 * (vi - 1), 6, 6) += (*slam_graph_)[e].cinv_;
-        B.segment (6 * (vi - 1), 6) += (present1 ? 1 : -1) * (*slam_graph_)[e].cinvd_;
-      }
+    // Assemble the sparse matrix G and the vector B, with one 6x6 block of G per vertex and per edge
+    // Every edge contributes to the rows of both of its vertices, which keeps G symmetric
+    std::vector<Eigen::Triplet<double> > G_entries;
+    G_entries.reserve (144 * nr_edges + 6 * n);
+    Eigen::VectorXd B = Eigen::VectorXd::Zero (6 * (n - 1));
+    for (int ei = 0; ei < nr_edges; ++ei)
+    {
+      const int vi = static_cast<int> (source (graph_edges[ei], *slam_graph_));
+      const int vj = static_cast<int> (target (graph_edges[ei], *slam_graph_));
+      if (!connected[vi] || (*slam_graph_)[graph_edges[ei]].cinv_ == Eigen::Matrix6f::Zero ())
+        continue;
+      const Eigen::Matrix<double, 6, 6> cinv = (*slam_graph_)[graph_edges[ei]].cinv_.template cast<double> ();
+      const Eigen::Matrix<double, 6, 1> cinvd = (*slam_graph_)[graph_edges[ei]].cinvd_.template cast<double> ();
+
+      // Start at 1 because 0 is the reference pose
+      for (int r = 0; r < 6; ++r)
+        for (int c = 0; c < 6; ++c)
+        {
+          if (vi > 0)
+            G_entries.push_back (Eigen::Triplet<double> (6 * (vi - 1) + r, 6 * (vi - 1) + c, cinv (r, c)));
+          if (vj > 0)
+            G_entries.push_back (Eigen::Triplet<double> (6 * (vj - 1) + r, 6 * (vj - 1) + c, cinv (r, c)));
+          if (vi > 0 && vj > 0)
+          {
+            G_entries.push_back (Eigen::Triplet<double> (6 * (vi - 1) + r, 6 * (vj - 1) + c, -cinv (r, c)));
+            G_entries.push_back (Eigen::Triplet<double> (6 * (vj - 1) + r, 6 * (vi - 1) + c, -cinv (r, c)));
+          }
+        }
+      if (vi > 0)
+        B.segment<6> (6 * (vi - 1)) += cinvd;
+      if (vj > 0)
+        B.segment<6> (6 * (vj - 1)) -= cinvd;
     }
+    // Vertices that are not connected to the reference pose keep their pose
+    for (int vi = 1; vi != n; ++vi)
+      if (!connected[vi])
+        for (int r = 0; r < 6; ++r)
+          G_entries.push_back (Eigen::Triplet<double> (6 * (vi - 1) + r, 6 * (vi - 1) + r, 1.0));
+    Eigen::SparseMatrix<double> G (6 * (n - 1), 6 * (n - 1));
+    G.setFromTriplets (G_entries.begin (), G_entries.end ());
 
     // Computation of the linear equation system: GX = B
-    // TODO investigate accuracy vs. speed tradeoff and find the best solving method for our type of linear equation (sparse)
-    Eigen::VectorXf X = G.colPivHouseholderQr ().solve (B);
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > ldlt (G);
+    if (ldlt.info () != Eigen::Success)
+    {
+      PCL_ERROR("[pcl::registration::LUM::compute] The linear equation system could not be decomposed.\n");
+      return;
+    }
+    Eigen::VectorXf X = ldlt.solve (B).cast<float> ();
 
     // Update the poses
     float sum = 0.0;
@@ -303,6 +377,8 @@ pcl::registration::LUM<PointT>::computeEdge (Edge e)
   Eigen::Vector6f source_pose = (*slam_graph_)[source (e, *slam_graph_)].pose_;
   Eigen::Vector6f target_pose = (*slam_graph_)[target (e, *slam_graph_)].pose_;
   pcl::CorrespondencesPtr corrs = (*slam_graph_)[e].corrs_;
+  const Eigen::Affine3f source_transformation = pcl::getTransformation (source_pose (0), source_pose (1), source_pose (2), source_pose (3), source_pose (4), source_pose (5));
+  const Eigen::Affine3f target_transformation = pcl::getTransformation (target_pose (0), target_pose (1), target_pose (2), target_pose (3), target_pose (4), target_pose (5));
 
   // Build the average and difference vectors for all correspondences
   std::vector < Eigen::Vector3f > corrs_aver (corrs->size ());
@@ -311,8 +387,8 @@ pcl::registration::LUM<PointT>::computeEdge (Edge e)
   for (int ici = 0; ici != static_cast<int> (corrs->size ()); ++ici)  // ici = input correspondence iterator
   {
     // Compound the point pair onto the current pose
-    Eigen::Vector3f source_compounded = pcl::getTransformation (source_pose (0), source_pose (1), source_pose (2), source_pose (3), source_pose (4), source_pose (5)) * source_cloud->points[(*corrs)[ici].index_query].getVector3fMap ();
-    Eigen::Vector3f target_compounded = pcl::getTransformation (target_pose (0), target_pose (1), target_pose (2), target_pose (3), target_pose (4), target_pose (5)) * target_cloud->points[(*corrs)[ici].index_match].getVector3fMap ();
+    Eigen::Vector3f source_compounded = source_transformation * source_cloud->points[(*corrs)[ici].index_query].getVector3fMap ();
+    Eigen::Vector3f target_compounded = target_transformation * target_cloud->points[(*corrs)[ici].index_match].getVector3fMap ();
 
     // NaN points can not be passed to the remaining computational pipeline
     if (!pcl_isfinite (source_compounded (0)) || !pcl_isfinite (source_compounded (1)) || !pcl_isfinite (source_compounded (2)) || !pcl_isfinite (target_compounded (0)) || !pcl_isfinite (target_compounded (1)) || !pcl_isfinite (target_compounded (2)))
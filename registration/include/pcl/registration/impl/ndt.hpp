@@ -39,12 +39,17 @@
 #define PCL_REGISTRATION_NDT_IMPL_H_
 
 //#include <pcl/registration/ndt.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointSource, typename PointTarget>
 pcl::NormalDistributionsTransform<PointSource, PointTarget>::NormalDistributionsTransform () 
   : target_cells_ ()
+  , target_map_ ()
   , resolution_ (1.0f)
+  , search_method_ (KDTREE)
   , step_size_ (0.1)
   , outlier_ratio_ (0.55)
   , gauss_d1_ ()
@@ -170,6 +175,31 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::computeTransformati
   trans_probability_ = score / static_cast<double> (input_->points.size ());
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointSource, typename PointTarget> Eigen::MatrixXi
+pcl::NormalDistributionsTransform<PointSource, PointTarget>::getNeighborCellOffsets (NeighborSearchMethod method)
+{
+  Eigen::MatrixXi relative_coordinates;
+  switch (method)
+  {
+    case DIRECT26:
+      relative_coordinates.resize (3, 27);
+      relative_coordinates.col (0).setZero ();
+      relative_coordinates.rightCols<26> () = pcl::getAllNeighborCellIndices ();
+      break;
+    case DIRECT7:
+      relative_coordinates.resize (3, 7);
+      relative_coordinates << 0, 1, -1, 0,  0, 0,  0,
+                              0, 0,  0, 1, -1, 0,  0,
+                              0, 0,  0, 0,  0, 1, -1;
+      break;
+    default:
+      relative_coordinates.setZero (3, 1);
+      break;
+  }
+  return (relative_coordinates);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointSource, typename PointTarget> double
 pcl::NormalDistributionsTransform<PointSource, PointTarget>::computeDerivatives (Eigen::Matrix<double, 6, 1> &score_gradient,
@@ -178,15 +208,6 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::computeDerivatives
                                                                                  Eigen::Matrix<double, 6, 1> &p,
                                                                                  bool compute_hessian)
 {
-  // Original Point and Transformed Point
-  PointSource x_pt, x_trans_pt;
-  // Original Point and Transformed Point (for math)
-  Eigen::Vector3d x, x_trans;
-  // Occupied Voxel
-  TargetGridLeafConstPtr cell;
-  // Inverse Covariance of Occupied Voxel
-  Eigen::Matrix3d c_inv;
-
   score_gradient.setZero ();
   hessian.setZero ();
   double score = 0;
@@ -194,36 +215,67 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::computeDerivatives
   // Precompute Angular Derivatives (eq. 6.19 and 6.21)[Magnusson 2009]
   computeAngleDerivatives (p);
 
-  // Update gradient and hessian for each point, line 17 in Algorithm 2 [Magnusson 2009]
-  for (size_t idx = 0; idx < input_->points.size (); idx++)
+  const Eigen::MatrixXi relative_coordinates = getNeighborCellOffsets (search_method_);
+
+  // The points are processed in blocks of fixed size, whose partial sums are added in order afterwards, so that
+  // the result does not depend on the number of threads
+  const int block_size = 128;
+  const int nr_points = static_cast<int> (input_->points.size ());
+  const int nr_blocks = (nr_points + block_size - 1) / block_size;
+  std::vector<double> block_scores (nr_blocks, 0);
+  std::vector<Eigen::Matrix<double, 6, 1>, Eigen::aligned_allocator<Eigen::Matrix<double, 6, 1> > > block_gradients (nr_blocks, Eigen::Matrix<double, 6, 1>::Zero ());
+  std::vector<Eigen::Matrix<double, 6, 6>, Eigen::aligned_allocator<Eigen::Matrix<double, 6, 6> > > block_hessians (nr_blocks, Eigen::Matrix<double, 6, 6>::Zero ());
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#pragma omp parallel num_threads (nr_threads)
+#endif
   {
-    x_trans_pt = trans_cloud.points[idx];
-
-    // Find nieghbors (Radius search has been experimentally faster than direct neighbor checking.
+    // The translational entries of the point derivatives are constant
+    Eigen::Matrix<double, 3, 6> point_gradient = point_gradient_;
+    Eigen::Matrix<double, 18, 6> point_hessian = point_hessian_;
+    // Original Point and Transformed Point (for math)
+    Eigen::Vector3d x, x_trans;
+    // Occupied Voxels
     std::vector<TargetGridLeafConstPtr> neighborhood;
-    std::vector<float> distances;
-    target_cells_.radiusSearch (x_trans_pt, resolution_, neighborhood, distances);
 
-    for (typename std::vector<TargetGridLeafConstPtr>::iterator neighborhood_it = neighborhood.begin (); neighborhood_it != neighborhood.end (); neighborhood_it++)
+#ifdef _OPENMP
+#pragma omp for schedule (dynamic, 1)
+#endif
+    for (int block = 0; block < nr_blocks; ++block)
     {
-      cell = *neighborhood_it;
-      x_pt = input_->points[idx];
-      x = Eigen::Vector3d (x_pt.x, x_pt.y, x_pt.z);
-
-      x_trans = Eigen::Vector3d (x_trans_pt.x, x_trans_pt.y, x_trans_pt.z);
-
-      // Denorm point, x_k' in Equations 6.12 and 6.13 [Magnusson 2009]
-      x_trans -= cell->getMean ();
-      // Uses precomputed covariance for speed.
-      c_inv = cell->getInverseCov ();
-
-      // Compute derivative of transform function w.r.t. transform vector, J_E and H_E in Equations 6.18 and 6.20 [Magnusson 2009]
-      computePointDerivatives (x);
-      // Update score, gradient and hessian, lines 19-21 in Algorithm 2, according to Equations 6.10, 6.12 and 6.13, respectively [Magnusson 2009]
-      score += updateDerivatives (score_gradient, hessian, x_trans, c_inv, compute_hessian);
+      // Update gradient and hessian for each point, line 17 in Algorithm 2 [Magnusson 2009]
+      for (int idx = block * block_size; idx < std::min (nr_points, (block + 1) * block_size); ++idx)
+      {
+        const PointSource &x_trans_pt = trans_cloud.points[idx];
+        getNeighborhood (x_trans_pt, relative_coordinates, neighborhood);
+        if (neighborhood.empty ())
+          continue;
 
+        const PointSource &x_pt = input_->points[idx];
+        x = Eigen::Vector3d (x_pt.x, x_pt.y, x_pt.z);
+        // Compute derivative of transform function w.r.t. transform vector, J_E and H_E in Equations 6.18 and 6.20 [Magnusson 2009]
+        computePointDerivatives (x, point_gradient, point_hessian, compute_hessian);
+
+        for (size_t k = 0; k < neighborhood.size (); ++k)
+        {
+          // Denorm point, x_k' in Equations 6.12 and 6.13 [Magnusson 2009]
+          x_trans = Eigen::Vector3d (x_trans_pt.x, x_trans_pt.y, x_trans_pt.z) - neighborhood[k]->getMean ();
+          // Update score, gradient and hessian, lines 19-21 in Algorithm 2, according to Equations 6.10, 6.12 and 6.13, respectively [Magnusson 2009]
+          // Uses precomputed covariance for speed.
+          block_scores[block] += updateDerivatives (block_gradients[block], block_hessians[block], x_trans,
+                                                    neighborhood[k]->getInverseCov (), point_gradient, point_hessian,
+                                                    compute_hessian);
+        }
+      }
     }
   }
+
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    score += block_scores[block];
+    score_gradient += block_gradients[block];
+    hessian += block_hessians[block];
+  }
   return (score);
 }
 
@@ -306,18 +358,21 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::computeAngleDerivat
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointSource, typename PointTarget> void
-pcl::NormalDistributionsTransform<PointSource, PointTarget>::computePointDerivatives (Eigen::Vector3d &x, bool compute_hessian)
+pcl::NormalDistributionsTransform<PointSource, PointTarget>::computePointDerivatives (const Eigen::Vector3d &x,
+                                                                                      Eigen::Matrix<double, 3, 6> &point_gradient,
+                                                                                      Eigen::Matrix<double, 18, 6> &point_hessian,
+                                                                                      bool compute_hessian) const
 {
   // Calculate first derivative of Transformation Equation 6.17 w.r.t. transform vector p.
   // Derivative w.r.t. ith element of transform vector corresponds to column i, Equation 6.18 and 6.19 [Magnusson 2009]
-  point_gradient_ (1, 3) = x.dot (j_ang_a_);
-  point_gradient_ (2, 3) = x.dot (j_ang_b_);
-  point_gradient_ (0, 4) = x.dot (j_ang_c_);
-  point_gradient_ (1, 4) = x.dot (j_ang_d_);
-  point_gradient_ (2, 4) = x.dot (j_ang_e_);
-  point_gradient_ (0, 5) = x.dot (j_ang_f_);
-  point_gradient_ (1, 5) = x.dot (j_ang_g_);
-  point_gradient_ (2, 5) = x.dot (j_ang_h_);
+  point_gradient (1, 3) = x.dot (j_ang_a_);
+  point_gradient (2, 3) = x.dot (j_ang_b_);
+  point_gradient (0, 4) = x.dot (j_ang_c_);
+  point_gradient (1, 4) = x.dot (j_ang_d_);
+  point_gradient (2, 4) = x.dot (j_ang_e_);
+  point_gradient (0, 5) = x.dot (j_ang_f_);
+  point_gradient (1, 5) = x.dot (j_ang_g_);
+  point_gradient (2, 5) = x.dot (j_ang_h_);
 
   if (compute_hessian)
   {
@@ -333,15 +388,15 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::computePointDerivat
 
     // Calculate second derivative of Transformation Equation 6.17 w.r.t. transform vector p.
     // Derivative w.r.t. ith and jth elements of transform vector corresponds to the 3x1 block matrix starting at (3i,j), Equation 6.20 and 6.21 [Magnusson 2009]
-    point_hessian_.block<3, 1>(9, 3) = a;
-    point_hessian_.block<3, 1>(12, 3) = b;
-    point_hessian_.block<3, 1>(15, 3) = c;
-    point_hessian_.block<3, 1>(9, 4) = b;
-    point_hessian_.block<3, 1>(12, 4) = d;
-    point_hessian_.block<3, 1>(15, 4) = e;
-    point_hessian_.block<3, 1>(9, 5) = c;
-    point_hessian_.block<3, 1>(12, 5) = e;
-    point_hessian_.block<3, 1>(15, 5) = f;
+    point_hessian.block<3, 1>(9, 3) = a;
+    point_hessian.block<3, 1>(12, 3) = b;
+    point_hessian.block<3, 1>(15, 3) = c;
+    point_hessian.block<3, 1>(9, 4) = b;
+    point_hessian.block<3, 1>(12, 4) = d;
+    point_hessian.block<3, 1>(15, 4) = e;
+    point_hessian.block<3, 1>(9, 5) = c;
+    point_hessian.block<3, 1>(12, 5) = e;
+    point_hessian.block<3, 1>(15, 5) = f;
   }
 }
 
@@ -349,8 +404,10 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::computePointDerivat
 template<typename PointSource, typename PointTarget> double
 pcl::NormalDistributionsTransform<PointSource, PointTarget>::updateDerivatives (Eigen::Matrix<double, 6, 1> &score_gradient,
                                                                                 Eigen::Matrix<double, 6, 6> &hessian,
-                                                                                Eigen::Vector3d &x_trans, Eigen::Matrix3d &c_inv,
-                                                                                bool compute_hessian)
+                                                                                const Eigen::Vector3d &x_trans, const Eigen::Matrix3d &c_inv,
+                                                                                const Eigen::Matrix<double, 3, 6> &point_gradient,
+                                                                                const Eigen::Matrix<double, 18, 6> &point_hessian,
+                                                                                bool compute_hessian) const
 {
   Eigen::Vector3d cov_dxd_pi;
   // e^(-d_2/2 * (x_k - mu_k)^T Sigma_k^-1 (x_k - mu_k)) Equation 6.9 [Magnusson 2009]
@@ -371,7 +428,7 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::updateDerivatives (
   for (int i = 0; i < 6; i++)
   {
     // Sigma_k^-1 d(T(x,p))/dpi, Reusable portion of Equation 6.12 and 6.13 [Magnusson 2009]
-    cov_dxd_pi = c_inv * point_gradient_.col (i);
+    cov_dxd_pi = c_inv * point_gradient.col (i);
 
     // Update gradient, Equation 6.12 [Magnusson 2009]
     score_gradient (i) += x_trans.dot (cov_dxd_pi) * e_x_cov_x;
@@ -381,9 +438,9 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::updateDerivatives (
       for (int j = 0; j < hessian.cols (); j++)
       {
         // Update hessian, Equation 6.13 [Magnusson 2009]
-        hessian (i, j) += e_x_cov_x * (-gauss_d2_ * x_trans.dot (cov_dxd_pi) * x_trans.dot (c_inv * point_gradient_.col (j)) +
-                                    x_trans.dot (c_inv * point_hessian_.block<3, 1>(3 * i, j)) +
-                                    point_gradient_.col (j).dot (cov_dxd_pi) );
+        hessian (i, j) += e_x_cov_x * (-gauss_d2_ * x_trans.dot (cov_dxd_pi) * x_trans.dot (c_inv * point_gradient.col (j)) +
+                                    x_trans.dot (c_inv * point_hessian.block<3, 1>(3 * i, j)) +
+                                    point_gradient.col (j).dot (cov_dxd_pi) );
       }
     }
   }
@@ -396,56 +453,70 @@ template<typename PointSource, typename PointTarget> void
 pcl::NormalDistributionsTransform<PointSource, PointTarget>::computeHessian (Eigen::Matrix<double, 6, 6> &hessian,
                                                                              PointCloudSource &trans_cloud, Eigen::Matrix<double, 6, 1> &)
 {
-  // Original Point and Transformed Point
-  PointSource x_pt, x_trans_pt;
-  // Original Point and Transformed Point (for math)
-  Eigen::Vector3d x, x_trans;
-  // Occupied Voxel
-  TargetGridLeafConstPtr cell;
-  // Inverse Covariance of Occupied Voxel
-  Eigen::Matrix3d c_inv;
-
   hessian.setZero ();
 
   // Precompute Angular Derivatives unessisary because only used after regular derivative calculation
 
-  // Update hessian for each point, line 17 in Algorithm 2 [Magnusson 2009]
-  for (size_t idx = 0; idx < input_->points.size (); idx++)
+  const Eigen::MatrixXi relative_coordinates = getNeighborCellOffsets (search_method_);
+
+  // Blocks of fixed size, added in order afterwards, as in computeDerivatives
+  const int block_size = 128;
+  const int nr_points = static_cast<int> (input_->points.size ());
+  const int nr_blocks = (nr_points + block_size - 1) / block_size;
+  std::vector<Eigen::Matrix<double, 6, 6>, Eigen::aligned_allocator<Eigen::Matrix<double, 6, 6> > > block_hessians (nr_blocks, Eigen::Matrix<double, 6, 6>::Zero ());
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#pragma omp parallel num_threads (nr_threads)
+#endif
   {
-    x_trans_pt = trans_cloud.points[idx];
-
-    // Find nieghbors (Radius search has been experimentally faster than direct neighbor checking.
+    // The translational entries of the point derivatives are constant
+    Eigen::Matrix<double, 3, 6> point_gradient = point_gradient_;
+    Eigen::Matrix<double, 18, 6> point_hessian = point_hessian_;
+    // Original Point and Transformed Point (for math)
+    Eigen::Vector3d x, x_trans;
+    // Occupied Voxels
     std::vector<TargetGridLeafConstPtr> neighborhood;
-    std::vector<float> distances;
-    target_cells_.radiusSearch (x_trans_pt, resolution_, neighborhood, distances);
 
-    for (typename std::vector<TargetGridLeafConstPtr>::iterator neighborhood_it = neighborhood.begin (); neighborhood_it != neighborhood.end (); neighborhood_it++)
+#ifdef _OPENMP
+#pragma omp for schedule (dynamic, 1)
+#endif
+    for (int block = 0; block < nr_blocks; ++block)
     {
-      cell = *neighborhood_it;
-
+      // Update hessian for each point, line 17 in Algorithm 2 [Magnusson 2009]
+      for (int idx = block * block_size; idx < std::min (nr_points, (block + 1) * block_size); ++idx)
       {
-        x_pt = input_->points[idx];
-        x = Eigen::Vector3d (x_pt.x, x_pt.y, x_pt.z);
-
-        x_trans = Eigen::Vector3d (x_trans_pt.x, x_trans_pt.y, x_trans_pt.z);
-
-        // Denorm point, x_k' in Equations 6.12 and 6.13 [Magnusson 2009]
-        x_trans -= cell->getMean ();
-        // Uses precomputed covariance for speed.
-        c_inv = cell->getInverseCov ();
+        const PointSource &x_trans_pt = trans_cloud.points[idx];
+        getNeighborhood (x_trans_pt, relative_coordinates, neighborhood);
+        if (neighborhood.empty ())
+          continue;
 
+        const PointSource &x_pt = input_->points[idx];
+        x = Eigen::Vector3d (x_pt.x, x_pt.y, x_pt.z);
         // Compute derivative of transform function w.r.t. transform vector, J_E and H_E in Equations 6.18 and 6.20 [Magnusson 2009]
-        computePointDerivatives (x);
-        // Update hessian, lines 21 in Algorithm 2, according to Equations 6.10, 6.12 and 6.13, respectively [Magnusson 2009]
-        updateHessian (hessian, x_trans, c_inv);
+        computePointDerivatives (x, point_gradient, point_hessian);
+
+        for (size_t k = 0; k < neighborhood.size (); ++k)
+        {
+          // Denorm point, x_k' in Equations 6.12 and 6.13 [Magnusson 2009]
+          x_trans = Eigen::Vector3d (x_trans_pt.x, x_trans_pt.y, x_trans_pt.z) - neighborhood[k]->getMean ();
+          // Update hessian, lines 21 in Algorithm 2, according to Equations 6.10, 6.12 and 6.13, respectively [Magnusson 2009]
+          // Uses precomputed covariance for speed.
+          updateHessian (block_hessians[block], x_trans, neighborhood[k]->getInverseCov (), point_gradient, point_hessian);
+        }
       }
     }
   }
+
+  for (int block = 0; block < nr_blocks; ++block)
+    hessian += block_hessians[block];
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointSource, typename PointTarget> void
-pcl::NormalDistributionsTransform<PointSource, PointTarget>::updateHessian (Eigen::Matrix<double, 6, 6> &hessian, Eigen::Vector3d &x_trans, Eigen::Matrix3d &c_inv)
+pcl::NormalDistributionsTransform<PointSource, PointTarget>::updateHessian (Eigen::Matrix<double, 6, 6> &hessian,
+                                                                            const Eigen::Vector3d &x_trans, const Eigen::Matrix3d &c_inv,
+                                                                            const Eigen::Matrix<double, 3, 6> &point_gradient,
+                                                                            const Eigen::Matrix<double, 18, 6> &point_hessian) const
 {
   Eigen::Vector3d cov_dxd_pi;
   // e^(-d_2/2 * (x_k - mu_k)^T Sigma_k^-1 (x_k - mu_k)) Equation 6.9 [Magnusson 2009]
@@ -461,14 +532,14 @@ pcl::NormalDistributionsTransform<PointSource, PointTarget>::updateHessian (Eige
   for (int i = 0; i < 6; i++)
   {
     // Sigma_k^-1 d(T(x,p))/dpi, Reusable portion of Equation 6.12 and 6.13 [Magnusson 2009]
-    cov_dxd_pi = c_inv * point_gradient_.col (i);
+    cov_dxd_pi = c_inv * point_gradient.col (i);
 
     for (int j = 0; j < hessian.cols (); j++)
     {
       // Update hessian, Equation 6.13 [Magnusson 2009]
-      hessian (i, j) += e_x_cov_x * (-gauss_d2_ * x_trans.dot (cov_dxd_pi) * x_trans.dot (c_inv * point_gradient_.col (j)) +
-                                  x_trans.dot (c_inv * point_hessian_.block<3, 1>(3 * i, j)) +
-                                  point_gradient_.col (j).dot (cov_dxd_pi) );
+      hessian (i, j) += e_x_cov_x * (-gauss_d2_ * x_trans.dot (cov_dxd_pi) * x_trans.dot (c_inv * point_gradient.col (j)) +
+                                  x_trans.dot (c_inv * point_hessian.block<3, 1>(3 * i, j)) +
+                                  point_gradient.col (j).dot (cov_dxd_pi) );
     }
   }
 
@@ -0,0 +1,491 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+#ifndef PCL_REGISTRATION_IMPL_NDT_MAP_HPP_
+#define PCL_REGISTRATION_IMPL_NDT_MAP_HPP_
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace pcl
+{
+  namespace registration
+  {
+    namespace ndt_map
+    {
+      const char tile_magic[8] = { 'P', 'C', 'L', 'N', 'D', 'T', 'T', 'L' };
+      const uint32_t tile_version = 1;
+      const uint32_t tile_byte_order = 0x01020304;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::registration::NDTMap<PointT>::setMinPointPerVoxel (int min_points_per_voxel)
+{
+  if (min_points_per_voxel > 2)
+    min_points_per_voxel_ = min_points_per_voxel;
+  else
+  {
+    PCL_WARN ("[pcl::registration::NDTMap::setMinPointPerVoxel] Covariance calculation requires at least 3 points, setting Min Point per Voxel to 3\n");
+    min_points_per_voxel_ = 3;
+  }
+  for (typename VoxelMap::iterator it = voxels_.begin (); it != voxels_.end (); ++it)
+    computeLeaf (it->second);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::registration::NDTMap<PointT>::setCovEigValueInflationRatio (double min_covar_eigvalue_mult)
+{
+  min_covar_eigvalue_mult_ = min_covar_eigvalue_mult;
+  for (typename VoxelMap::iterator it = voxels_.begin (); it != voxels_.end (); ++it)
+    computeLeaf (it->second);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> size_t
+pcl::registration::NDTMap<PointT>::insert (const PointCloud &cloud)
+{
+  size_t nr_points = 0;
+  std::vector<Voxel*> touched;
+  touched.reserve (cloud.points.size ());
+
+  // Consecutive points usually fall into the same tile
+  Tile *tile = NULL;
+  Eigen::Vector3i tile_coordinates;
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    const PointT &p = cloud.points[i];
+    if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+      continue;
+
+    const Eigen::Vector3i ijk = getVoxelCoordinates (p.x, p.y, p.z);
+    const Eigen::Vector3i tile_ijk = getTileCoordinates (ijk);
+    if (!tile || tile_ijk != tile_coordinates)
+    {
+      tile = getTile (tile_ijk);
+      tile_coordinates = tile_ijk;
+      if (!tile)
+        continue;
+    }
+
+    const uint64_t key = getKey (ijk);
+    typename VoxelMap::iterator it = voxels_.find (key);
+    if (it == voxels_.end ())
+    {
+      it = voxels_.insert (std::make_pair (key, Voxel ())).first;
+      it->second.coordinates = ijk;
+      tile->voxels.push_back (key);
+    }
+    tile->dirty = true;
+
+    Voxel &voxel = it->second;
+    const Eigen::Vector3d d = Eigen::Vector3d (p.x, p.y, p.z) - ijk.cast<double> () * resolution_;
+    ++voxel.nr_points;
+    voxel.sum += d;
+    voxel.sum_sq += d * d.transpose ();
+    touched.push_back (&voxel);
+    ++nr_points;
+  }
+
+  // Voxels are nodes of the hash map, their addresses are stable
+  std::sort (touched.begin (), touched.end ());
+  typename std::vector<Voxel*>::iterator end = std::unique (touched.begin (), touched.end ());
+  for (typename std::vector<Voxel*>::iterator it = touched.begin (); it != end; ++it)
+    computeLeaf (**it);
+
+  return (nr_points);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::registration::NDTMap<PointT>::updateActiveTiles (const Eigen::Vector3f &position, float radius)
+{
+  if (map_directory_.empty ())
+  {
+    PCL_ERROR ("[pcl::registration::NDTMap::updateActiveTiles] No map directory was given!\n");
+    return (false);
+  }
+
+  const Eigen::Vector3i min_tile = getTileCoordinates (getVoxelCoordinates (position[0] - radius, position[1] - radius, position[2] - radius));
+  const Eigen::Vector3i max_tile = getTileCoordinates (getVoxelCoordinates (position[0] + radius, position[1] + radius, position[2] + radius));
+  bool success = true;
+
+  // Unload the tiles out of the region, a tile that can not be saved stays in memory
+  for (typename TileMap::iterator it = tiles_.begin (); it != tiles_.end (); )
+  {
+    const Tile &tile = it->second;
+    if ((tile.coordinates.array () >= min_tile.array ()).all () && (tile.coordinates.array () <= max_tile.array ()).all ())
+    {
+      ++it;
+      continue;
+    }
+    if (tile.dirty && !saveTile (tile))
+    {
+      success = false;
+      ++it;
+      continue;
+    }
+    for (size_t i = 0; i < tile.voxels.size (); ++i)
+      voxels_.erase (tile.voxels[i]);
+    it = tiles_.erase (it);
+  }
+
+  // Load the tiles of the region
+  for (int i = min_tile[0]; i <= max_tile[0]; ++i)
+    for (int j = min_tile[1]; j <= max_tile[1]; ++j)
+      for (int k = min_tile[2]; k <= max_tile[2]; ++k)
+      {
+        const Eigen::Vector3i coordinates (i, j, k);
+        if (tiles_.find (getKey (coordinates)) == tiles_.end () && !loadTile (coordinates))
+          success = false;
+      }
+
+  return (success);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::registration::NDTMap<PointT>::saveTiles ()
+{
+  bool success = true;
+  for (typename TileMap::iterator it = tiles_.begin (); it != tiles_.end (); ++it)
+  {
+    if (!it->second.dirty)
+      continue;
+    if (saveTile (it->second))
+      it->second.dirty = false;
+    else
+      success = false;
+  }
+  return (success);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> typename pcl::registration::NDTMap<PointT>::LeafConstPtr
+pcl::registration::NDTMap<PointT>::getLeaf (const PointT &point) const
+{
+  typename VoxelMap::const_iterator it = voxels_.find (getKey (getVoxelCoordinates (point.x, point.y, point.z)));
+  if (it == voxels_.end ())
+    return (NULL);
+  return (&(it->second.leaf));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::registration::NDTMap<PointT>::getNeighborhoodAtPoint (const Eigen::MatrixXi &relative_coordinates,
+                                                           const PointT &reference_point,
+                                                           std::vector<LeafConstPtr> &neighbors) const
+{
+  neighbors.clear ();
+  neighbors.reserve (relative_coordinates.cols ());
+
+  const Eigen::Vector3i ijk = getVoxelCoordinates (reference_point.x, reference_point.y, reference_point.z);
+  for (int ni = 0; ni < relative_coordinates.cols (); ++ni)
+  {
+    typename VoxelMap::const_iterator it = voxels_.find (getKey (ijk + relative_coordinates.col (ni)));
+    if (it != voxels_.end () && it->second.leaf.nr_points >= min_points_per_voxel_)
+      neighbors.push_back (&(it->second.leaf));
+  }
+  return (static_cast<int> (neighbors.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::registration::NDTMap<PointT>::radiusSearch (const PointT &point, double radius,
+                                                 std::vector<LeafConstPtr> &k_leaves,
+                                                 std::vector<float> &k_sqr_distances) const
+{
+  k_leaves.clear ();
+  k_sqr_distances.clear ();
+
+  // The mean of a voxel lies inside it, so only the voxels that intersect the search cube can match
+  const float r = static_cast<float> (radius);
+  const Eigen::Vector3i min_ijk = getVoxelCoordinates (point.x - r, point.y - r, point.z - r);
+  const Eigen::Vector3i max_ijk = getVoxelCoordinates (point.x + r, point.y + r, point.z + r);
+  const Eigen::Vector3d query (point.x, point.y, point.z);
+  const double sqr_radius = radius * radius;
+
+  std::vector<std::pair<double, LeafConstPtr> > found;
+  for (int i = min_ijk[0]; i <= max_ijk[0]; ++i)
+    for (int j = min_ijk[1]; j <= max_ijk[1]; ++j)
+      for (int k = min_ijk[2]; k <= max_ijk[2]; ++k)
+      {
+        typename VoxelMap::const_iterator it = voxels_.find (getKey (Eigen::Vector3i (i, j, k)));
+        if (it == voxels_.end () || it->second.leaf.nr_points < min_points_per_voxel_)
+          continue;
+        const double sqr_distance = (it->second.leaf.mean_ - query).squaredNorm ();
+        if (sqr_distance <= sqr_radius)
+          found.push_back (std::make_pair (sqr_distance, &(it->second.leaf)));
+      }
+
+  std::sort (found.begin (), found.end ());
+  k_leaves.resize (found.size ());
+  k_sqr_distances.resize (found.size ());
+  for (size_t i = 0; i < found.size (); ++i)
+  {
+    k_sqr_distances[i] = static_cast<float> (found[i].first);
+    k_leaves[i] = found[i].second;
+  }
+  return (static_cast<int> (found.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::registration::NDTMap<PointT>::getVoxelMeans (PointCloud &cloud) const
+{
+  cloud.points.clear ();
+  cloud.points.reserve (voxels_.size ());
+  for (typename VoxelMap::const_iterator it = voxels_.begin (); it != voxels_.end (); ++it)
+  {
+    const Leaf &leaf = it->second.leaf;
+    if (leaf.nr_points < min_points_per_voxel_)
+      continue;
+    cloud.points.push_back (PointT ());
+    cloud.points.back ().x = static_cast<float> (leaf.mean_[0]);
+    cloud.points.back ().y = static_cast<float> (leaf.mean_[1]);
+    cloud.points.back ().z = static_cast<float> (leaf.mean_[2]);
+  }
+  cloud.width = static_cast<uint32_t> (cloud.points.size ());
+  cloud.height = 1;
+  cloud.is_dense = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> std::string
+pcl::registration::NDTMap<PointT>::getTileFileName (const Eigen::Vector3i &tile) const
+{
+  std::ostringstream file_name;
+  file_name << map_directory_ << "/tile_" << tile[0] << "_" << tile[1] << "_" << tile[2] << ".ndt";
+  return (file_name.str ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> typename pcl::registration::NDTMap<PointT>::Tile*
+pcl::registration::NDTMap<PointT>::getTile (const Eigen::Vector3i &coordinates)
+{
+  const uint64_t key = getKey (coordinates);
+  typename TileMap::iterator it = tiles_.find (key);
+  if (it == tiles_.end ())
+  {
+    if (!loadTile (coordinates))
+      return (NULL);
+    it = tiles_.find (key);
+  }
+  return (&(it->second));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::registration::NDTMap<PointT>::loadTile (const Eigen::Vector3i &coordinates)
+{
+  Tile tile;
+  tile.coordinates = coordinates;
+
+  const std::string file_name = map_directory_.empty () ? std::string () : getTileFileName (coordinates);
+  std::ifstream file;
+  if (!file_name.empty ())
+    file.open (file_name.c_str (), std::ifstream::in | std::ifstream::binary);
+  if (!file.is_open ())
+  {
+    tiles_[getKey (coordinates)] = tile;
+    return (true);
+  }
+
+  TileHeader header;
+  file.read (reinterpret_cast<char*> (&header), sizeof (header));
+  if (!file || memcmp (header.magic, ndt_map::tile_magic, sizeof (header.magic)) != 0 ||
+      header.version != ndt_map::tile_version || header.byte_order != ndt_map::tile_byte_order)
+  {
+    PCL_ERROR ("[pcl::registration::NDTMap::loadTile] %s is not a supported NDT map tile file!\n", file_name.c_str ());
+    return (false);
+  }
+  if (header.resolution != resolution_ || header.tile_size != tile_size_ ||
+      header.nr_voxels > static_cast<uint64_t> (tile_size_) * tile_size_ * tile_size_ ||
+      header.coordinates[0] != coordinates[0] || header.coordinates[1] != coordinates[1] || header.coordinates[2] != coordinates[2])
+  {
+    PCL_ERROR ("[pcl::registration::NDTMap::loadTile] Inconsistent header in %s, or its resolution, tile size or coordinates do not match the map!\n", file_name.c_str ());
+    return (false);
+  }
+
+  std::vector<VoxelRecord> records (static_cast<size_t> (header.nr_voxels));
+  if (!records.empty ())
+    file.read (reinterpret_cast<char*> (&records[0]), records.size () * sizeof (VoxelRecord));
+  if (!file)
+  {
+    PCL_ERROR ("[pcl::registration::NDTMap::loadTile] Unexpected end of %s!\n", file_name.c_str ());
+    return (false);
+  }
+  for (size_t i = 0; i < records.size (); ++i)
+  {
+    const Eigen::Vector3i ijk (records[i].coordinates[0], records[i].coordinates[1], records[i].coordinates[2]);
+    if (getTileCoordinates (ijk) != coordinates || records[i].nr_points <= 0)
+    {
+      PCL_ERROR ("[pcl::registration::NDTMap::loadTile] Corrupted NDT map tile file %s!\n", file_name.c_str ());
+      return (false);
+    }
+  }
+
+  tile.voxels.reserve (records.size ());
+  for (size_t i = 0; i < records.size (); ++i)
+  {
+    const VoxelRecord &record = records[i];
+    const Eigen::Vector3i ijk (record.coordinates[0], record.coordinates[1], record.coordinates[2]);
+    const uint64_t key = getKey (ijk);
+    Voxel &voxel = voxels_[key];
+    voxel.coordinates = ijk;
+    voxel.nr_points = record.nr_points;
+    voxel.sum = Eigen::Vector3d (record.sum[0], record.sum[1], record.sum[2]);
+    voxel.sum_sq << record.sum_sq[0], record.sum_sq[1], record.sum_sq[2],
+                    record.sum_sq[1], record.sum_sq[3], record.sum_sq[4],
+                    record.sum_sq[2], record.sum_sq[4], record.sum_sq[5];
+    computeLeaf (voxel);
+    tile.voxels.push_back (key);
+  }
+  tiles_[getKey (coordinates)] = tile;
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::registration::NDTMap<PointT>::saveTile (const Tile &tile) const
+{
+  if (map_directory_.empty ())
+  {
+    PCL_ERROR ("[pcl::registration::NDTMap::saveTile] No map directory was given!\n");
+    return (false);
+  }
+
+  const std::string file_name = getTileFileName (tile.coordinates);
+  std::ofstream file (file_name.c_str (), std::ofstream::out | std::ofstream::binary);
+  if (!file.is_open ())
+  {
+    PCL_ERROR ("[pcl::registration::NDTMap::saveTile] Could not open %s for writing!\n", file_name.c_str ());
+    return (false);
+  }
+
+  TileHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, ndt_map::tile_magic, sizeof (header.magic));
+  header.version = ndt_map::tile_version;
+  header.byte_order = ndt_map::tile_byte_order;
+  for (int d = 0; d < 3; ++d)
+    header.coordinates[d] = tile.coordinates[d];
+  header.resolution = resolution_;
+  header.tile_size = tile_size_;
+  header.nr_voxels = tile.voxels.size ();
+
+  std::vector<VoxelRecord> records (tile.voxels.size ());
+  for (size_t i = 0; i < tile.voxels.size (); ++i)
+  {
+    const Voxel &voxel = voxels_.find (tile.voxels[i])->second;
+    VoxelRecord &record = records[i];
+    memset (&record, 0, sizeof (record));
+    for (int d = 0; d < 3; ++d)
+    {
+      record.coordinates[d] = voxel.coordinates[d];
+      record.sum[d] = voxel.sum[d];
+    }
+    record.nr_points = voxel.nr_points;
+    record.sum_sq[0] = voxel.sum_sq (0, 0);
+    record.sum_sq[1] = voxel.sum_sq (0, 1);
+    record.sum_sq[2] = voxel.sum_sq (0, 2);
+    record.sum_sq[3] = voxel.sum_sq (1, 1);
+    record.sum_sq[4] = voxel.sum_sq (1, 2);
+    record.sum_sq[5] = voxel.sum_sq (2, 2);
+  }
+
+  file.write (reinterpret_cast<const char*> (&header), sizeof (header));
+  if (!records.empty ())
+    file.write (reinterpret_cast<const char*> (&records[0]), records.size () * sizeof (VoxelRecord));
+  if (!file)
+  {
+    PCL_ERROR ("[pcl::registration::NDTMap::saveTile] Error writing %s!\n", file_name.c_str ());
+    return (false);
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::registration::NDTMap<PointT>::computeLeaf (Voxel &voxel) const
+{
+  Leaf &leaf = voxel.leaf;
+  const double n = voxel.nr_points;
+  const Eigen::Vector3d local_mean = voxel.sum / n;
+  leaf.nr_points = voxel.nr_points;
+  leaf.mean_ = voxel.coordinates.template cast<double> () * resolution_ + local_mean;
+  leaf.centroid = leaf.mean_.template cast<float> ();
+  // As in VoxelGridCovariance::Leaf, the sum of the outer products starts at the identity matrix
+  leaf.cov_ = ((voxel.sum_sq + Eigen::Matrix3d::Identity ()) / n - local_mean * local_mean.transpose ()) * ((n - 1.0) / n);
+
+  // Voxels with too few points can not be accurately approximated by a normal distribution
+  if (voxel.nr_points < min_points_per_voxel_)
+    return;
+
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver (leaf.cov_);
+  Eigen::Matrix3d eigen_val = eigensolver.eigenvalues ().asDiagonal ();
+  leaf.evecs_ = eigensolver.eigenvectors ();
+  if (eigen_val (0, 0) < 0 || eigen_val (1, 1) < 0 || eigen_val (2, 2) <= 0)
+  {
+    leaf.nr_points = -1;
+    return;
+  }
+
+  // Avoids matrices near singularities (eq 6.11)[Magnusson 2009]
+  const double min_covar_eigvalue = min_covar_eigvalue_mult_ * eigen_val (2, 2);
+  if (eigen_val (0, 0) < min_covar_eigvalue)
+  {
+    eigen_val (0, 0) = min_covar_eigvalue;
+    if (eigen_val (1, 1) < min_covar_eigvalue)
+      eigen_val (1, 1) = min_covar_eigvalue;
+    leaf.cov_ = leaf.evecs_ * eigen_val * leaf.evecs_.inverse ();
+  }
+  leaf.evals_ = eigen_val.diagonal ();
+
+  leaf.icov_ = leaf.cov_.inverse ();
+  if (leaf.icov_.maxCoeff () == std::numeric_limits<float>::infinity ()
+      || leaf.icov_.minCoeff () == -std::numeric_limits<float>::infinity ())
+    leaf.nr_points = -1;
+}
+
+#endif    // PCL_REGISTRATION_IMPL_NDT_MAP_HPP_
@@ -44,62 +44,9 @@
 #include <pcl/common/transforms.h>
 
 #include <pcl/features/pfh.h>
-//////////////////////////////////////////////////////////////////////////////////////////////
-void
-pcl::PPFHashMapSearch::setInputFeatureCloud (PointCloud<PPFSignature>::ConstPtr feature_cloud)
-{
-  // Discretize the feature cloud and insert it in the hash map
-  feature_hash_map_->clear ();
-  unsigned int n = static_cast<unsigned int> (sqrt (static_cast<float> (feature_cloud->points.size ())));
-  int d1, d2, d3, d4;
-  max_dist_ = -1.0;
-  alpha_m_.resize (n);
-  for (size_t i = 0; i < n; ++i)
-  {
-    std::vector <float> alpha_m_row (n);
-    for (size_t j = 0; j < n; ++j)
-    {
-      d1 = static_cast<int> (floor (feature_cloud->points[i*n+j].f1 / angle_discretization_step_));
-      d2 = static_cast<int> (floor (feature_cloud->points[i*n+j].f2 / angle_discretization_step_));
-      d3 = static_cast<int> (floor (feature_cloud->points[i*n+j].f3 / angle_discretization_step_));
-      d4 = static_cast<int> (floor (feature_cloud->points[i*n+j].f4 / distance_discretization_step_));
-      feature_hash_map_->insert (std::pair<HashKeyStruct, std::pair<size_t, size_t> > (HashKeyStruct (d1, d2, d3, d4), std::pair<size_t, size_t> (i, j)));
-      alpha_m_row [j] = feature_cloud->points[i*n + j].alpha_m;
-
-      if (max_dist_ < feature_cloud->points[i*n + j].f4)
-        max_dist_ = feature_cloud->points[i*n + j].f4;
-    }
-    alpha_m_[i] = alpha_m_row;
-  }
-
-  internals_initialized_ = true;
-}
-
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-void
-pcl::PPFHashMapSearch::nearestNeighborSearch (float &f1, float &f2, float &f3, float &f4,
-                                              std::vector<std::pair<size_t, size_t> > &indices)
-{
-  if (!internals_initialized_)
-  {
-    PCL_ERROR("[pcl::PPFRegistration::nearestNeighborSearch]: input feature cloud has not been set - skipping search!\n");
-    return;
-  }
-
-  int d1 = static_cast<int> (floor (f1 / angle_discretization_step_)),
-      d2 = static_cast<int> (floor (f2 / angle_discretization_step_)),
-      d3 = static_cast<int> (floor (f3 / angle_discretization_step_)),
-      d4 = static_cast<int> (floor (f4 / distance_discretization_step_));
-
-  indices.clear ();
-  HashKeyStruct key = HashKeyStruct (d1, d2, d3, d4);
-  std::pair <FeatureHashMapType::iterator, FeatureHashMapType::iterator> map_iterator_pair = feature_hash_map_->equal_range (key);
-  for (; map_iterator_pair.first != map_iterator_pair.second; ++ map_iterator_pair.first)
-    indices.push_back (std::pair<size_t, size_t> (map_iterator_pair.first->second.first,
-                                                  map_iterator_pair.first->second.second));
-}
-
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget> void
@@ -127,112 +74,129 @@ pcl::PPFRegistration<PointSource, PointTarget>::computeTransformation (PointClou
     PCL_ERROR("[pcl::PPFRegistration::computeTransformation] setting initial transform (guess) not implemented!\n");
   }
 
-  PoseWithVotesList voted_poses;
-  std::vector <std::vector <unsigned int> > accumulator_array;
-  accumulator_array.resize (input_->points.size ());
-
-  size_t aux_size = static_cast<size_t> (floor (2 * M_PI / search_method_->getAngleDiscretizationStep ()));
-  for (size_t i = 0; i < input_->points.size (); ++i)
-  {
-    std::vector<unsigned int> aux (aux_size);
-    accumulator_array[i] = aux;
-  }
-  PCL_INFO ("Accumulator array size: %u x %u.\n", accumulator_array.size (), accumulator_array.back ().size ());
+  const size_t aux_size = static_cast<size_t> (floor (2 * M_PI / search_method_->getAngleDiscretizationStep ()));
+  const size_t nr_model_points = input_->points.size ();
+  PCL_INFO ("Accumulator array size: %u x %u.\n", nr_model_points, aux_size);
 
   // Consider every <scene_reference_point_sampling_rate>-th point as the reference point => fix s_r
-  float f1, f2, f3, f4;
-  for (size_t scene_reference_index = 0; scene_reference_index < target_->points.size (); scene_reference_index += scene_reference_point_sampling_rate_)
+  const int nr_scene_reference_points = static_cast<int> (
+      (target_->points.size () + scene_reference_point_sampling_rate_ - 1) / scene_reference_point_sampling_rate_);
+  std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> > max_transforms (nr_scene_reference_points);
+  std::vector<unsigned int> max_votes_list (nr_scene_reference_points);
+
+#ifdef _OPENMP
+  // Every thread allocates an accumulator array, do not start more of them than there are reference points to vote
+  const int nr_threads = std::max (1, std::min (threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads (),
+                                                nr_scene_reference_points));
+#endif
+#ifdef _OPENMP
+#pragma omp parallel num_threads (nr_threads)
+#endif
   {
-    Eigen::Vector3f scene_reference_point = target_->points[scene_reference_index].getVector3fMap (),
-        scene_reference_normal = target_->points[scene_reference_index].getNormalVector3fMap ();
-
-    Eigen::AngleAxisf rotation_sg (acosf (scene_reference_normal.dot (Eigen::Vector3f::UnitX ())),
-                                   scene_reference_normal.cross (Eigen::Vector3f::UnitX ()). normalized());
-    Eigen::Affine3f transform_sg (Eigen::Translation3f (rotation_sg * ((-1) * scene_reference_point)) * rotation_sg);
-
-    // For every other point in the scene => now have pair (s_r, s_i) fixed
+    // Every thread votes in its own accumulator array, and only clears the cells it voted for
+    std::vector<unsigned int> accumulator_array (nr_model_points * aux_size, 0);
+    std::vector<size_t> voted_cells;
     std::vector<int> indices;
     std::vector<float> distances;
-    scene_search_tree_->radiusSearch (target_->points[scene_reference_index],
-                                     search_method_->getModelDiameter () /2,
-                                     indices,
-                                     distances);
-    for(size_t i = 0; i < indices.size (); ++i)
-//    for(size_t i = 0; i < target_->points.size (); ++i)
+    std::vector<std::pair<size_t, size_t> > nearest_indices;
+    PairFeatureBatch pair_batch;
+#ifdef _OPENMP
+#pragma omp for schedule (dynamic)
+#endif
+    for (int r = 0; r < nr_scene_reference_points; ++r)
     {
-      //size_t scene_point_index = i;
-      size_t scene_point_index = indices[i];
-      if (scene_reference_index != scene_point_index)
+      const size_t scene_reference_index = static_cast<size_t> (r) * scene_reference_point_sampling_rate_;
+      Eigen::Vector3f scene_reference_point = target_->points[scene_reference_index].getVector3fMap (),
+          scene_reference_normal = target_->points[scene_reference_index].getNormalVector3fMap ();
+
+      Eigen::AngleAxisf rotation_sg (acosf (scene_reference_normal.dot (Eigen::Vector3f::UnitX ())),
+                                     scene_reference_normal.cross (Eigen::Vector3f::UnitX ()). normalized());
+      Eigen::Affine3f transform_sg (Eigen::Translation3f (rotation_sg * ((-1) * scene_reference_point)) * rotation_sg);
+
+      // For every other point in the scene => now have pair (s_r, s_i) fixed
+      scene_search_tree_->radiusSearch (target_->points[scene_reference_index],
+                                        search_method_->getModelDiameter () /2,
+                                        indices,
+                                        distances);
+      pair_batch.clear ();
+      for (size_t i = 0; i < indices.size (); ++i)
+        pair_batch.push_back (target_->points[indices[i]], target_->points[indices[i]]);
+      pair_batch.compute (target_->points[scene_reference_index].getVector4fMap (),
+                          target_->points[scene_reference_index].getNormalVector4fMap ());
+
+      for (size_t i = 0; i < indices.size (); ++i)
       {
-        if (/*pcl::computePPFPairFeature*/pcl::computePairFeatures (target_->points[scene_reference_index].getVector4fMap (),
-                                        target_->points[scene_reference_index].getNormalVector4fMap (),
-                                        target_->points[scene_point_index].getVector4fMap (),
-                                        target_->points[scene_point_index].getNormalVector4fMap (),
-                                        f1, f2, f3, f4))
+        size_t scene_point_index = indices[i];
+        if (scene_reference_index == scene_point_index)
+          continue;
+        if (!pair_batch.valid[i])
+        {
+          PCL_ERROR ("[pcl::PPFRegistration::computeTransformation] Computing pair feature vector between points %zu and %zu went wrong.\n", scene_reference_index, scene_point_index);
+          continue;
+        }
+
+        search_method_->nearestNeighborSearch (pair_batch.f1[i], pair_batch.f2[i], pair_batch.f3[i], pair_batch.f4[i],
+                                               nearest_indices);
+
+        // Compute alpha_s angle
+        Eigen::Vector3f scene_point_transformed = transform_sg * target_->points[scene_point_index].getVector3fMap ();
+        float alpha_s = atan2f ( -scene_point_transformed(2), scene_point_transformed(1));
+        if ( alpha_s != alpha_s)
         {
-          std::vector<std::pair<size_t, size_t> > nearest_indices;
-          search_method_->nearestNeighborSearch (f1, f2, f3, f4, nearest_indices);
-
-          // Compute alpha_s angle
-          Eigen::Vector3f scene_point = target_->points[scene_point_index].getVector3fMap ();
-          Eigen::AngleAxisf rotation_sg (acosf (scene_reference_normal.dot (Eigen::Vector3f::UnitX ())),
-                                         scene_reference_normal.cross (Eigen::Vector3f::UnitX ()).normalized ());
-          Eigen::Affine3f transform_sg = Eigen::Translation3f ( rotation_sg * ((-1) * scene_reference_point)) * rotation_sg;
-//          float alpha_s = acos (Eigen::Vector3f::UnitY ().dot ((transform_sg * scene_point).normalized ()));
-
-          Eigen::Vector3f scene_point_transformed = transform_sg * scene_point;
-          float alpha_s = atan2f ( -scene_point_transformed(2), scene_point_transformed(1));
-          if ( alpha_s != alpha_s)
-          {
-            PCL_ERROR ("alpha_s is nan\n");
-            continue;
-          }
-          if (sin (alpha_s) * scene_point_transformed(2) < 0.0f)
-            alpha_s *= (-1);
+          PCL_ERROR ("alpha_s is nan\n");
+          continue;
+        }
+        if (sin (alpha_s) * scene_point_transformed(2) < 0.0f)
           alpha_s *= (-1);
+        alpha_s *= (-1);
 
-          // Go through point pairs in the model with the same discretized feature
-          for (std::vector<std::pair<size_t, size_t> >::iterator v_it = nearest_indices.begin (); v_it != nearest_indices.end (); ++ v_it)
-          {
-            size_t model_reference_index = v_it->first,
-                model_point_index = v_it->second;
-            // Calculate angle alpha = alpha_m - alpha_s
-            float alpha = search_method_->alpha_m_[model_reference_index][model_point_index] - alpha_s;
-            unsigned int alpha_discretized = static_cast<unsigned int> (floor (alpha) + floor (M_PI / search_method_->getAngleDiscretizationStep ()));
-            accumulator_array[model_reference_index][alpha_discretized] ++;
-          }
+        // Go through point pairs in the model with the same discretized feature
+        for (std::vector<std::pair<size_t, size_t> >::iterator v_it = nearest_indices.begin (); v_it != nearest_indices.end (); ++ v_it)
+        {
+          size_t model_reference_index = v_it->first,
+              model_point_index = v_it->second;
+          // Calculate angle alpha = alpha_m - alpha_s
+          float alpha = search_method_->alpha_m_[model_reference_index][model_point_index] - alpha_s;
+          unsigned int alpha_discretized = static_cast<unsigned int> (floor (alpha) + floor (M_PI / search_method_->getAngleDiscretizationStep ()));
+          size_t cell = model_reference_index * aux_size + alpha_discretized;
+          if (accumulator_array[cell]++ == 0)
+            voted_cells.push_back (cell);
         }
-        else PCL_ERROR ("[pcl::PPFRegistration::computeTransformation] Computing pair feature vector between points %zu and %zu went wrong.\n", scene_reference_index, scene_point_index);
       }
-    }
 
-    size_t max_votes_i = 0, max_votes_j = 0;
-    unsigned int max_votes = 0;
-
-    for (size_t i = 0; i < accumulator_array.size (); ++i)
-      for (size_t j = 0; j < accumulator_array.back ().size (); ++j)
+      // Find the cell with the most votes, the first one in row-major order on ties, and reset the accumulator
+      // array for the next scene reference point
+      size_t max_votes_cell = 0;
+      unsigned int max_votes = 0;
+      for (size_t c = 0; c < voted_cells.size (); ++c)
       {
-        if (accumulator_array[i][j] > max_votes)
+        size_t cell = voted_cells[c];
+        if (accumulator_array[cell] > max_votes || (accumulator_array[cell] == max_votes && cell < max_votes_cell))
         {
-          max_votes = accumulator_array[i][j];
-          max_votes_i = i;
-          max_votes_j = j;
+          max_votes = accumulator_array[cell];
+          max_votes_cell = cell;
         }
-        // Reset accumulator_array for the next set of iterations with a new scene reference point
-        accumulator_array[i][j] = 0;
+        accumulator_array[cell] = 0;
       }
-
-    Eigen::Vector3f model_reference_point = input_->points[max_votes_i].getVector3fMap (),
-        model_reference_normal = input_->points[max_votes_i].getNormalVector3fMap ();
-    Eigen::AngleAxisf rotation_mg (acosf (model_reference_normal.dot (Eigen::Vector3f::UnitX ())), model_reference_normal.cross (Eigen::Vector3f::UnitX ()).normalized ());
-    Eigen::Affine3f transform_mg = Eigen::Translation3f ( rotation_mg * ((-1) * model_reference_point)) * rotation_mg;
-    Eigen::Affine3f max_transform = 
-      transform_sg.inverse () * 
-      Eigen::AngleAxisf ((static_cast<float> (max_votes_j) - floorf (static_cast<float> (M_PI) / search_method_->getAngleDiscretizationStep ())) * search_method_->getAngleDiscretizationStep (), Eigen::Vector3f::UnitX ()) * 
-      transform_mg;
-
-    voted_poses.push_back (PoseWithVotes (max_transform, max_votes));
+      voted_cells.clear ();
+      size_t max_votes_i = max_votes_cell / aux_size, max_votes_j = max_votes_cell % aux_size;
+
+      Eigen::Vector3f model_reference_point = input_->points[max_votes_i].getVector3fMap (),
+          model_reference_normal = input_->points[max_votes_i].getNormalVector3fMap ();
+      Eigen::AngleAxisf rotation_mg (acosf (model_reference_normal.dot (Eigen::Vector3f::UnitX ())), model_reference_normal.cross (Eigen::Vector3f::UnitX ()).normalized ());
+      Eigen::Affine3f transform_mg = Eigen::Translation3f ( rotation_mg * ((-1) * model_reference_point)) * rotation_mg;
+      max_transforms[r] =
+        transform_sg.inverse () *
+        Eigen::AngleAxisf ((static_cast<float> (max_votes_j) - floorf (static_cast<float> (M_PI) / search_method_->getAngleDiscretizationStep ())) * search_method_->getAngleDiscretizationStep (), Eigen::Vector3f::UnitX ()) *
+        transform_mg;
+      max_votes_list[r] = max_votes;
+    }
   }
+
+  // Keep the poses in the order of the scene reference points
+  PoseWithVotesList voted_poses;
+  for (int r = 0; r < nr_scene_reference_points; ++r)
+    voted_poses.push_back (PoseWithVotes (max_transforms[r], max_votes_list[r]));
   PCL_DEBUG ("Done with the Hough Transform ...\n");
 
   // Cluster poses for filtering out outliers and obtaining more precise results
@@ -46,6 +46,13 @@ pcl::Registration<PointSource, PointTarget>::setInputTarget (const PointCloudTar
     PCL_ERROR ("[pcl::%s::setInputTarget] Invalid or empty point cloud dataset given!\n", getClassName ().c_str ());
     return;
   }
+  // A target search object that the caller keeps up to date indexes this very cloud, so it is shared instead
+  // of copied, and points the caller adds to it later remain valid search results
+  if (force_no_recompute_)
+  {
+    target_ = cloud;
+    return;
+  }
   PointCloudTarget target = *cloud;
   // Set all the point.data[3] values to 1 to aid the rigid transformation
   for (size_t i = 0; i < target.points.size (); ++i)
@@ -53,7 +60,8 @@ pcl::Registration<PointSource, PointTarget>::setInputTarget (const PointCloudTar
 
   //target_ = cloud;
   target_ = target.makeShared ();
-  tree_->setInputCloud (target_);
+  if (!force_no_recompute_)
+    tree_->setInputCloud (target_);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -150,7 +158,7 @@ pcl::Registration<PointSource, PointTarget>::align (PointCloudSource &output, co
     output.points[i] = input_->points[(*indices_)[i]];
 
   // Set the internal point representation of choice
-  if (point_representation_)
+  if (point_representation_ && !force_no_recompute_)
     tree_->setPointRepresentation (point_representation_);
 
   // Perform the actual transformation computation
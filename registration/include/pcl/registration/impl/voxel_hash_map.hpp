@@ -0,0 +1,259 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_VOXEL_HASH_MAP_HPP_
+#define PCL_REGISTRATION_IMPL_VOXEL_HASH_MAP_HPP_
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::registration::VoxelHashMap<PointT>::setLeafSize (float leaf_size)
+{
+  leaf_size_ = leaf_size;
+  inverse_leaf_size_ = 1.0f / leaf_size;
+
+  // Re-index the points that are in the voxels, keeping the map cloud as it is
+  std::vector<int> map_indices;
+  map_indices.reserve (map_->points.size ());
+  for (typename VoxelMap::const_iterator it = voxels_.begin (); it != voxels_.end (); ++it)
+    map_indices.insert (map_indices.end (), it->second.begin (), it->second.end ());
+  std::sort (map_indices.begin (), map_indices.end ());
+
+  voxels_.clear ();
+  for (size_t i = 0; i < map_indices.size (); ++i)
+    insertPoint (map_indices[i]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::registration::VoxelHashMap<PointT>::setInputCloud (const PointCloudConstPtr &cloud,
+                                                        const IndicesConstPtr &indices)
+{
+  // KdTree::setPointRepresentation gives the map its own cloud back
+  if (cloud != map_)
+  {
+    map_.reset (new PointCloud (*cloud));
+    // Set all the point.data[3] values to 1 to aid the rigid transformation, as Registration does for its target
+    for (size_t i = 0; i < map_->points.size (); ++i)
+      map_->points[i].data[3] = 1.0f;
+  }
+  input_ = map_;
+  indices_ = indices;
+
+  voxels_.clear ();
+  if (indices)
+  {
+    for (size_t i = 0; i < indices->size (); ++i)
+      insertPoint ((*indices)[i]);
+  }
+  else
+  {
+    for (size_t i = 0; i < map_->points.size (); ++i)
+      insertPoint (static_cast<int> (i));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> size_t
+pcl::registration::VoxelHashMap<PointT>::addPoints (const PointCloud &cloud)
+{
+  size_t nr_points = 0;
+  map_->points.reserve (map_->points.size () + cloud.points.size ());
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    map_->points.push_back (cloud.points[i]);
+    map_->points.back ().data[3] = 1.0f;
+    if (insertPoint (static_cast<int> (map_->points.size ()) - 1))
+      ++nr_points;
+    else
+      map_->points.pop_back ();
+  }
+  map_->width = static_cast<uint32_t> (map_->points.size ());
+  map_->height = 1;
+  map_->is_dense = false;
+  return (nr_points);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::registration::VoxelHashMap<PointT>::clear ()
+{
+  map_.reset (new PointCloud);
+  input_ = map_;
+  indices_.reset ();
+  voxels_.clear ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::registration::VoxelHashMap<PointT>::insertPoint (int index)
+{
+  const PointT &p = map_->points[index];
+  if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+    return (false);
+
+  const Eigen::Vector3i ijk = getVoxelCoordinates (p);
+  std::vector<int> &voxel = voxels_[getVoxelKey (ijk[0], ijk[1], ijk[2])];
+  if (max_points_per_voxel_ != 0 && voxel.size () >= max_points_per_voxel_)
+    return (false);
+  voxel.push_back (index);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::registration::VoxelHashMap<PointT>::nearestKSearch (const PointT &p_q, int k,
+                                                         std::vector<int> &k_indices,
+                                                         std::vector<float> &k_sqr_distances) const
+{
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (k <= 0 || !pcl_isfinite (p_q.x) || !pcl_isfinite (p_q.y) || !pcl_isfinite (p_q.z))
+    return (0);
+
+  const Eigen::Vector3i ijk = getVoxelCoordinates (p_q);
+  const Eigen::Vector3f q = p_q.getVector3fMap ();
+
+  // The common case of ICP: keep the closest point only, without collecting the candidates
+  if (k == 1)
+  {
+    int nn_index = -1;
+    float nn_sqr_distance = std::numeric_limits<float>::max ();
+    for (int i = ijk[0] - 1; i <= ijk[0] + 1; ++i)
+      for (int j = ijk[1] - 1; j <= ijk[1] + 1; ++j)
+        for (int l = ijk[2] - 1; l <= ijk[2] + 1; ++l)
+        {
+          typename VoxelMap::const_iterator it = voxels_.find (getVoxelKey (i, j, l));
+          if (it == voxels_.end ())
+            continue;
+          for (size_t m = 0; m < it->second.size (); ++m)
+          {
+            const int index = it->second[m];
+            const float sqr_distance = (map_->points[index].getVector3fMap () - q).squaredNorm ();
+            if (sqr_distance < nn_sqr_distance || (sqr_distance == nn_sqr_distance && index < nn_index))
+            {
+              nn_index = index;
+              nn_sqr_distance = sqr_distance;
+            }
+          }
+        }
+    if (nn_index == -1)
+      return (0);
+    k_indices.push_back (nn_index);
+    k_sqr_distances.push_back (nn_sqr_distance);
+    return (1);
+  }
+
+  std::vector<std::pair<float, int> > candidates;
+  for (int i = ijk[0] - 1; i <= ijk[0] + 1; ++i)
+    for (int j = ijk[1] - 1; j <= ijk[1] + 1; ++j)
+      for (int l = ijk[2] - 1; l <= ijk[2] + 1; ++l)
+      {
+        typename VoxelMap::const_iterator it = voxels_.find (getVoxelKey (i, j, l));
+        if (it == voxels_.end ())
+          continue;
+        for (size_t m = 0; m < it->second.size (); ++m)
+          candidates.push_back (std::make_pair ((map_->points[it->second[m]].getVector3fMap () - q).squaredNorm (),
+                                                it->second[m]));
+      }
+
+  const size_t nr_neighbors = std::min (candidates.size (), static_cast<size_t> (k));
+  std::partial_sort (candidates.begin (), candidates.begin () + nr_neighbors, candidates.end ());
+  k_indices.resize (nr_neighbors);
+  k_sqr_distances.resize (nr_neighbors);
+  for (size_t m = 0; m < nr_neighbors; ++m)
+  {
+    k_sqr_distances[m] = candidates[m].first;
+    k_indices[m] = candidates[m].second;
+  }
+  return (static_cast<int> (nr_neighbors));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::registration::VoxelHashMap<PointT>::radiusSearch (const PointT &p_q, double radius,
+                                                       std::vector<int> &k_indices,
+                                                       std::vector<float> &k_sqr_distances,
+                                                       unsigned int max_nn) const
+{
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (!pcl_isfinite (p_q.x) || !pcl_isfinite (p_q.y) || !pcl_isfinite (p_q.z))
+    return (0);
+
+  // Visit all the voxels that intersect the bounding box of the sphere
+  const Eigen::Vector3f q = p_q.getVector3fMap ();
+  const float r = static_cast<float> (radius);
+  const float sqr_radius = static_cast<float> (radius * radius);
+  std::vector<std::pair<float, int> > candidates;
+  for (int i = static_cast<int> (floor ((q[0] - r) * inverse_leaf_size_)); i <= static_cast<int> (floor ((q[0] + r) * inverse_leaf_size_)); ++i)
+    for (int j = static_cast<int> (floor ((q[1] - r) * inverse_leaf_size_)); j <= static_cast<int> (floor ((q[1] + r) * inverse_leaf_size_)); ++j)
+      for (int l = static_cast<int> (floor ((q[2] - r) * inverse_leaf_size_)); l <= static_cast<int> (floor ((q[2] + r) * inverse_leaf_size_)); ++l)
+      {
+        typename VoxelMap::const_iterator it = voxels_.find (getVoxelKey (i, j, l));
+        if (it == voxels_.end ())
+          continue;
+        for (size_t m = 0; m < it->second.size (); ++m)
+        {
+          const float sqr_distance = (map_->points[it->second[m]].getVector3fMap () - q).squaredNorm ();
+          if (sqr_distance <= sqr_radius)
+            candidates.push_back (std::make_pair (sqr_distance, it->second[m]));
+        }
+      }
+
+  if (max_nn != 0 && candidates.size () > max_nn)
+  {
+    std::partial_sort (candidates.begin (), candidates.begin () + max_nn, candidates.end ());
+    candidates.resize (max_nn);
+  }
+  else if (sorted_)
+    std::sort (candidates.begin (), candidates.end ());
+
+  k_indices.resize (candidates.size ());
+  k_sqr_distances.resize (candidates.size ());
+  for (size_t m = 0; m < candidates.size (); ++m)
+  {
+    k_sqr_distances[m] = candidates[m].first;
+    k_indices[m] = candidates[m].second;
+  }
+  return (static_cast<int> (candidates.size ()));
+}
+
+#endif    // PCL_REGISTRATION_IMPL_VOXEL_HASH_MAP_HPP_
@@ -136,7 +136,7 @@ namespace pcl
         /** \brief Empty constructor.
           */
         LUM () :
-            slam_graph_ (new SLAMGraph), max_iterations_ (5), convergence_threshold_ (0.0)
+            slam_graph_ (new SLAMGraph), max_iterations_ (5), convergence_threshold_ (0.0), threads_ (0)
         {
         }
 
@@ -194,6 +194,19 @@ namespace pcl
         inline float
         getConvergenceThreshold ();
 
+        /** \brief Set the number of threads used to linearize the edges in the compute() method.
+          * \details The results do not depend on the number of threads.
+          * \param[in] nr_threads The number of hardware threads to use (0 sets the value back to automatic).
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0);
+
+        /** \brief Get the number of threads used to linearize the edges in the compute() method.
+          * \return The number of threads to use (0 means automatic).
+          */
+        inline unsigned int
+        getNumberOfThreads () const;
+
         /** \brief Add a new point cloud to the SLAM graph.
           * \details This method will add a new vertex to the SLAM graph and attach a point cloud to that vertex.
           * Optionally you can specify a pose estimate for this point cloud.
@@ -292,6 +305,9 @@ namespace pcl
           * </ul>
           * Computation will change the pose estimates for the vertices of the SLAM graph, not the point clouds attached to them.
           * The results can be retrieved with getPose(), getTransformation(), getTransformedCloud() or getConcatenatedCloud().
+          * <br>
+          * The edges are linearized in parallel (see setNumberOfThreads()) and the resulting linear equation system, which has one 6x6 block per vertex and per edge, is solved with a sparse Cholesky decomposition.
+          * Its cost therefore grows with the number of edges rather than with the square of the number of vertices.
           */
         void
         compute ();
@@ -328,6 +344,9 @@ namespace pcl
 
         /** \brief The convergence threshold for the summed vector lengths of all poses. */
         float convergence_threshold_;
+
+        /** \brief The number of threads used to linearize the edges. */
+        unsigned int threads_;
     };
   }
 }
@@ -40,6 +40,7 @@
 
 #include <pcl/registration/registration.h>
 #include <pcl/filters/voxel_grid_covariance.h>
+#include <pcl/registration/ndt_map.h>
 
 #include <unsupported/Eigen/NonLinearOptimization>
 
@@ -81,8 +82,22 @@ namespace pcl
       /** \brief Typename of const pointer to searchable voxel grid leaf. */
       typedef typename TargetGrid::LeafConstPtr TargetGridLeafConstPtr;
 
+      /** \brief Typename of the persistent target map. */
+      typedef registration::NDTMap<PointTarget> TargetMap;
+      /** \brief Typename of const pointer to the persistent target map. */
+      typedef typename TargetMap::ConstPtr TargetMapConstPtr;
+
 
     public:
+      /** \brief The ways to find the target voxels a transformed source point is scored against. */
+      enum NeighborSearchMethod
+      {
+        KDTREE,   /**< the voxels with a centroid closer than the resolution, found with a radius search (default) */
+        DIRECT26, /**< the voxel containing the point and its 26 neighbors, looked up by index */
+        DIRECT7,  /**< the voxel containing the point and its 6 face neighbors, looked up by index */
+        DIRECT1   /**< only the voxel containing the point */
+      };
+
       /** \brief Constructor.
         * Sets \ref outlier_ratio_ to 0.35, \ref step_size_ to 0.05 and \ref resolution_ to 1.0
         */
@@ -95,7 +110,39 @@ namespace pcl
       setInputTarget (const PointCloudTargetConstPtr &cloud)
       {
         Registration<PointSource, PointTarget>::setInputTarget (cloud);
-        init ();
+        if (!target_map_)
+          init ();
+      }
+
+      /** \brief Score the source against a persistent NDT map instead of the voxels of the target cloud, so
+        * that the target does not have to be voxelized again. The resolution is the one of the map, and the
+        * target cloud is replaced by the means of its usable voxels, which are given to the target search method
+        * unless setSearchMethodTarget was called with \a force_no_recompute. The voxels are looked up in the map
+        * as it is at the time of the alignment, so it can be updated between alignments without calling this
+        * again.
+        * \param[in] map the target map, or a NULL pointer to go back to the target cloud
+        */
+      inline void
+      setTargetMap (const TargetMapConstPtr &map)
+      {
+        target_map_ = map;
+        if (!target_map_)
+        {
+          if (target_)
+            init ();
+          return;
+        }
+        resolution_ = target_map_->getResolution ();
+        PointCloudTargetPtr means (new PointCloudTarget);
+        target_map_->getVoxelMeans (*means);
+        Registration<PointSource, PointTarget>::setInputTarget (means);
+      }
+
+      /** \brief Get the persistent target map, NULL if the voxels of the target cloud are used. */
+      inline TargetMapConstPtr
+      getTargetMap () const
+      {
+        return (target_map_);
       }
 
       /** \brief Set/change the voxel grid resolution.
@@ -104,6 +151,11 @@ namespace pcl
       inline void
       setResolution (float resolution)
       {
+        if (target_map_)
+        {
+          PCL_WARN ("[pcl::%s::setResolution] The resolution of the target map is used!\n", getClassName ().c_str ());
+          return;
+        }
         // Prevents unnessary voxel initiations
         if (resolution_ != resolution)
         {
@@ -122,6 +174,24 @@ namespace pcl
         return (resolution_);
       }
 
+      /** \brief Set the way the target voxels are found for each transformed source point. The DIRECT methods
+        * look the voxels up by their index instead of searching the voxel centroids, which is several times
+        * cheaper per iteration, at the price of a slightly smaller basin of convergence for DIRECT7 and DIRECT1.
+        * \param[in] method the neighbor search method
+        */
+      inline void
+      setNeighborSearchMethod (NeighborSearchMethod method)
+      {
+        search_method_ = method;
+      }
+
+      /** \brief Get the way the target voxels are found for each transformed source point. */
+      inline NeighborSearchMethod
+      getNeighborSearchMethod () const
+      {
+        return (search_method_);
+      }
+
       /** \brief Get the newton line search maximum step length.
         * \return maximum step length
         */
@@ -219,6 +289,7 @@ namespace pcl
       using Registration<PointSource, PointTarget>::inlier_threshold_;
 
       using Registration<PointSource, PointTarget>::update_visualizer_;
+      using Registration<PointSource, PointTarget>::threads_;
 
       /** \brief Estimate the transformation and returns the transformed source (input) as output.
         * \param[out] output the resultant input transfomed point cloud dataset
@@ -248,6 +319,8 @@ namespace pcl
 
       /** \brief Compute derivatives of probability function w.r.t. the transformation vector.
         * \note Equation 6.10, 6.12 and 6.13 [Magnusson 2009].
+        * \note The points are processed in parallel with the number of threads set by setNumberOfThreads. Partial
+        * sums over fixed blocks of points are added in order, so the result does not depend on the number of threads.
         * \param[out] score_gradient the gradient vector of the probability function w.r.t. the transformation vector
         * \param[out] hessian the hessian matrix of the probability function w.r.t. the transformation vector
         * \param[in] trans_cloud transformed point cloud
@@ -273,7 +346,30 @@ namespace pcl
       updateDerivatives (Eigen::Matrix<double, 6, 1> &score_gradient,
                          Eigen::Matrix<double, 6, 6> &hessian,
                          Eigen::Vector3d &x_trans, Eigen::Matrix3d &c_inv,
-                         bool compute_hessian = true);
+                         bool compute_hessian = true)
+      {
+        return (updateDerivatives (score_gradient, hessian, x_trans, c_inv, point_gradient_, point_hessian_,
+                                   compute_hessian));
+      }
+
+      /** \brief Compute individual point contirbutions to derivatives of probability function w.r.t. the
+        * transformation vector, using the given point derivatives.
+        * \note Equation 6.10, 6.12 and 6.13 [Magnusson 2009].
+        * \param[in,out] score_gradient the gradient vector of the probability function w.r.t. the transformation vector
+        * \param[in,out] hessian the hessian matrix of the probability function w.r.t. the transformation vector
+        * \param[in] x_trans transformed point minus mean of occupied covariance voxel
+        * \param[in] c_inv covariance of occupied covariance voxel
+        * \param[in] point_gradient the first order derivative of the transformation of the point
+        * \param[in] point_hessian the second order derivative of the transformation of the point
+        * \param[in] compute_hessian flag to calculate hessian, unnessissary for step calculation.
+        */
+      double
+      updateDerivatives (Eigen::Matrix<double, 6, 1> &score_gradient,
+                         Eigen::Matrix<double, 6, 6> &hessian,
+                         const Eigen::Vector3d &x_trans, const Eigen::Matrix3d &c_inv,
+                         const Eigen::Matrix<double, 3, 6> &point_gradient,
+                         const Eigen::Matrix<double, 18, 6> &point_hessian,
+                         bool compute_hessian = true) const;
 
       /** \brief Precompute anglular components of derivatives.
         * \note Equation 6.19 and 6.21 [Magnusson 2009].
@@ -289,7 +385,26 @@ namespace pcl
         * \param[in] compute_hessian flag to calculate hessian, unnessissary for step calculation.
         */
       void
-      computePointDerivatives (Eigen::Vector3d &x, bool compute_hessian = true);
+      computePointDerivatives (Eigen::Vector3d &x, bool compute_hessian = true)
+      {
+        computePointDerivatives (x, point_gradient_, point_hessian_, compute_hessian);
+      }
+
+      /** \brief Compute point derivatives into the given matrices, so that several points can be processed at
+        * the same time.
+        * \note Equation 6.18-21 [Magnusson 2009].
+        * \param[in] x point from the input cloud
+        * \param[in,out] point_gradient the first order derivative of the transformation of \a x, only the
+        * rotational entries are written
+        * \param[in,out] point_hessian the second order derivative of the transformation of \a x, only the
+        * rotational entries are written
+        * \param[in] compute_hessian flag to calculate hessian, unnessissary for step calculation.
+        */
+      void
+      computePointDerivatives (const Eigen::Vector3d &x,
+                               Eigen::Matrix<double, 3, 6> &point_gradient,
+                               Eigen::Matrix<double, 18, 6> &point_hessian,
+                               bool compute_hessian = true) const;
 
       /** \brief Compute hessian of probability function w.r.t. the transformation vector.
         * \note Equation 6.13 [Magnusson 2009].
@@ -310,7 +425,55 @@ namespace pcl
         */
       void
       updateHessian (Eigen::Matrix<double, 6, 6> &hessian,
-                     Eigen::Vector3d &x_trans, Eigen::Matrix3d &c_inv);
+                     Eigen::Vector3d &x_trans, Eigen::Matrix3d &c_inv)
+      {
+        updateHessian (hessian, x_trans, c_inv, point_gradient_, point_hessian_);
+      }
+
+      /** \brief Compute individual point contirbutions to hessian of probability function w.r.t. the
+        * transformation vector, using the given point derivatives.
+        * \note Equation 6.13 [Magnusson 2009].
+        * \param[in,out] hessian the hessian matrix of the probability function w.r.t. the transformation vector
+        * \param[in] x_trans transformed point minus mean of occupied covariance voxel
+        * \param[in] c_inv covariance of occupied covariance voxel
+        * \param[in] point_gradient the first order derivative of the transformation of the point
+        * \param[in] point_hessian the second order derivative of the transformation of the point
+        */
+      void
+      updateHessian (Eigen::Matrix<double, 6, 6> &hessian,
+                     const Eigen::Vector3d &x_trans, const Eigen::Matrix3d &c_inv,
+                     const Eigen::Matrix<double, 3, 6> &point_gradient,
+                     const Eigen::Matrix<double, 18, 6> &point_hessian) const;
+
+      /** \brief Find the target voxels a transformed source point is scored against, with the current
+        * \ref search_method_.
+        * \param[in] x_trans_pt the transformed source point
+        * \param[in] relative_coordinates the voxel offsets for the DIRECT methods
+        * \param[out] neighborhood the target voxels
+        */
+      inline void
+      getNeighborhood (const PointSource &x_trans_pt, const Eigen::MatrixXi &relative_coordinates,
+                       std::vector<TargetGridLeafConstPtr> &neighborhood)
+      {
+        if (search_method_ == KDTREE)
+        {
+          std::vector<float> distances;
+          if (target_map_)
+            target_map_->radiusSearch (x_trans_pt, resolution_, neighborhood, distances);
+          else
+            target_cells_.radiusSearch (x_trans_pt, resolution_, neighborhood, distances);
+        }
+        else if (target_map_)
+          target_map_->getNeighborhoodAtPoint (relative_coordinates, x_trans_pt, neighborhood);
+        else
+          target_cells_.getNeighborhoodAtPoint (relative_coordinates, x_trans_pt, neighborhood);
+      }
+
+      /** \brief Get the voxel offsets checked by a DIRECT neighbor search method, the voxel of the point first.
+        * \param[in] method the neighbor search method
+        */
+      static Eigen::MatrixXi
+      getNeighborCellOffsets (NeighborSearchMethod method);
 
       /** \brief Compute line search step length and update transform and probability derivatives using More-Thuente method.
         * \note Search Algorithm [More, Thuente 1994]
@@ -406,11 +569,17 @@ namespace pcl
       /** \brief The voxel grid generated from target cloud containing point means and covariances. */
       TargetGrid target_cells_;
 
+      /** \brief The persistent target map used instead of \ref target_cells_, if given. */
+      TargetMapConstPtr target_map_;
+
       //double fitness_epsilon_;
 
       /** \brief The side length of voxels. */
       float resolution_;
 
+      /** \brief The way the target voxels are found for each transformed source point. */
+      NeighborSearchMethod search_method_;
+
       /** \brief The maximum step length. */
       double step_size_;
 
@@ -0,0 +1,362 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+#ifndef PCL_REGISTRATION_NDT_MAP_H_
+#define PCL_REGISTRATION_NDT_MAP_H_
+
+#include <pcl/filters/voxel_grid_covariance.h>
+#include <pcl/registration/boost.h>
+
+namespace pcl
+{
+  namespace registration
+  {
+    /** \brief NDTMap is a persistent target for NormalDistributionsTransform, for localization in maps that are
+      * too large to be voxelized again every time the registration starts.
+      *
+      * The map keeps, for every voxel, the number of points and the running sums of their coordinates and of
+      * their outer products, so that new scans can be inserted at any time and only the mean and covariance
+      * of the voxels they touch are recomputed. The voxels are grouped into cubic tiles of \ref getTileSize
+      * voxels per side, which are written to and read from a map directory, one file per tile, and can be
+      * loaded and unloaded around the current position with \ref updateActiveTiles:
+      *
+      * \code
+      * pcl::registration::NDTMap<pcl::PointXYZ>::Ptr map (new pcl::registration::NDTMap<pcl::PointXYZ> (1.0f));
+      * map->setMapDirectory ("/data/city_map");
+      * map->updateActiveTiles (position, 100.0f);
+      * pcl::NormalDistributionsTransform<pcl::PointXYZ, pcl::PointXYZ> ndt;
+      * ndt.setTargetMap (map);
+      * ndt.setInputCloud (scan);
+      * ndt.align (aligned_scan, guess);
+      * \endcode
+      *
+      * The voxels are aligned with the origin, like the ones of VoxelGridCovariance, and their mean and
+      * covariance are computed the same way. The sums are taken relative to the corner of each voxel, which
+      * keeps the covariances accurate far away from the origin.
+      * \note The voxel coordinates are stored on 21 bits per axis.
+      * \ingroup registration
+      */
+    template <typename PointT>
+    class NDTMap
+    {
+      public:
+        typedef pcl::PointCloud<PointT> PointCloud;
+
+        /** \brief The voxel type, shared with VoxelGridCovariance. */
+        typedef typename pcl::VoxelGridCovariance<PointT>::Leaf Leaf;
+        typedef const Leaf* LeafConstPtr;
+
+        typedef boost::shared_ptr<NDTMap<PointT> > Ptr;
+        typedef boost::shared_ptr<const NDTMap<PointT> > ConstPtr;
+
+        /** \brief Constructor.
+          * \param[in] resolution the edge length of the voxels
+          * \param[in] tile_size the number of voxels along each edge of a tile
+          */
+        NDTMap (float resolution = 1.0f, int tile_size = 64)
+          : voxels_ ()
+          , tiles_ ()
+          , resolution_ (resolution)
+          , inverse_resolution_ (1.0f / resolution)
+          , tile_size_ (tile_size)
+          , min_points_per_voxel_ (6)
+          , min_covar_eigvalue_mult_ (0.01)
+          , map_directory_ ()
+        {
+        }
+
+        /** \brief Get the edge length of the voxels. */
+        inline float
+        getResolution () const { return (resolution_); }
+
+        /** \brief Get the number of voxels along each edge of a tile. */
+        inline int
+        getTileSize () const { return (tile_size_); }
+
+        /** \brief Set the minimum number of points required for a voxel to be used, see
+          * VoxelGridCovariance::setMinPointPerVoxel. The loaded voxels are updated.
+          * \param[in] min_points_per_voxel the minimum number of points per voxel (at least 3, 6 by default)
+          */
+        void
+        setMinPointPerVoxel (int min_points_per_voxel);
+
+        /** \brief Get the minimum number of points required for a voxel to be used. */
+        inline int
+        getMinPointPerVoxel () const { return (min_points_per_voxel_); }
+
+        /** \brief Set the minimum allowable ratio between the eigenvalues of the voxel covariances, see
+          * VoxelGridCovariance::setCovEigValueInflationRatio. The loaded voxels are updated.
+          * \param[in] min_covar_eigvalue_mult the minimum ratio (0.01 by default)
+          */
+        void
+        setCovEigValueInflationRatio (double min_covar_eigvalue_mult);
+
+        /** \brief Get the minimum allowable ratio between the eigenvalues of the voxel covariances. */
+        inline double
+        getCovEigValueInflationRatio () const { return (min_covar_eigvalue_mult_); }
+
+        /** \brief Set the directory the tiles are written to and read from. The directory must exist.
+          * \param[in] directory the map directory
+          */
+        inline void
+        setMapDirectory (const std::string &directory) { map_directory_ = directory; }
+
+        /** \brief Get the directory the tiles are written to and read from. */
+        inline std::string
+        getMapDirectory () const { return (map_directory_); }
+
+        /** \brief Insert the finite points of a cloud into the map. The tiles the points fall into are read
+          * from the map directory first if they are saved there and not loaded yet, so that inserting never
+          * hides the saved voxels.
+          * \param[in] cloud the points to insert, in the map frame
+          * \return the number of points inserted
+          */
+        size_t
+        insert (const PointCloud &cloud);
+
+        /** \brief Load the saved tiles that intersect the cube of half side \a radius around \a position, and
+          * unload the other ones, saving them first if they were modified.
+          * \param[in] position the center of the region to keep in memory
+          * \param[in] radius the half side of the region to keep in memory
+          * \return true if all the tiles were read and written successfully
+          */
+        bool
+        updateActiveTiles (const Eigen::Vector3f &position, float radius);
+
+        /** \brief Write the loaded tiles that were modified since they were last saved to the map directory.
+          * \return true if all the tiles were written successfully
+          */
+        bool
+        saveTiles ();
+
+        /** \brief Remove all the voxels from memory, without saving them. */
+        inline void
+        clear ()
+        {
+          voxels_.clear ();
+          tiles_.clear ();
+        }
+
+        /** \brief Get the number of loaded voxels, including the ones with too few points to be used. */
+        inline size_t
+        getNumberOfVoxels () const { return (voxels_.size ()); }
+
+        /** \brief Get the number of loaded tiles. */
+        inline size_t
+        getNumberOfTiles () const { return (tiles_.size ()); }
+
+        /** \brief Get the voxel containing a point.
+          * \param[in] point the point
+          * \return the voxel, or NULL if it is empty or not loaded
+          */
+        LeafConstPtr
+        getLeaf (const PointT &point) const;
+
+        /** \brief Get the usable voxels at the given offsets from the voxel of a point, see
+          * VoxelGridCovariance::getNeighborhoodAtPoint.
+          * \param[in] relative_coordinates the offsets of the voxels to check, one per column
+          * \param[in] reference_point the point
+          * \param[out] neighbors the usable voxels
+          * \return the number of usable voxels found
+          */
+        int
+        getNeighborhoodAtPoint (const Eigen::MatrixXi &relative_coordinates, const PointT &reference_point,
+                                std::vector<LeafConstPtr> &neighbors) const;
+
+        /** \brief Search for the usable voxels whose mean is within a radius of a point, like
+          * VoxelGridCovariance::radiusSearch.
+          * \param[in] point the query point
+          * \param[in] radius the search radius
+          * \param[out] k_leaves the voxels found, sorted by distance
+          * \param[out] k_sqr_distances the squared distances from the point to their means
+          * \return the number of voxels found
+          */
+        int
+        radiusSearch (const PointT &point, double radius, std::vector<LeafConstPtr> &k_leaves,
+                      std::vector<float> &k_sqr_distances) const;
+
+        /** \brief Get the means of the usable loaded voxels.
+          * \param[out] cloud a cloud with one point per usable voxel
+          */
+        void
+        getVoxelMeans (PointCloud &cloud) const;
+
+      protected:
+        /** \brief A voxel of the map, with the sums its mean and covariance are computed from. */
+        struct Voxel
+        {
+          Voxel () : coordinates (), nr_points (0), sum (Eigen::Vector3d::Zero ()),
+                     sum_sq (Eigen::Matrix3d::Zero ()), leaf () {}
+
+          /** \brief The integer coordinates of the voxel. */
+          Eigen::Vector3i coordinates;
+          /** \brief The number of points inserted into the voxel. */
+          int nr_points;
+          /** \brief The sum of the points, relative to the corner of the voxel. */
+          Eigen::Vector3d sum;
+          /** \brief The sum of the outer products of the points, relative to the corner of the voxel. */
+          Eigen::Matrix3d sum_sq;
+          /** \brief The mean and covariance computed from the sums. */
+          Leaf leaf;
+        };
+
+        /** \brief A loaded tile, with the keys of its voxels. */
+        struct Tile
+        {
+          Tile () : coordinates (), voxels (), dirty (false) {}
+
+          /** \brief The integer coordinates of the tile. */
+          Eigen::Vector3i coordinates;
+          /** \brief The keys of the voxels of the tile in \ref voxels_. */
+          std::vector<uint64_t> voxels;
+          /** \brief True if the tile was modified since it was last saved. */
+          bool dirty;
+        };
+
+        /** \brief Header of the tile files. */
+        struct TileHeader
+        {
+          char magic[8];
+          uint32_t version;
+          uint32_t byte_order;
+          int32_t coordinates[3];
+          float resolution;
+          int32_t tile_size;
+          uint32_t reserved;
+          uint64_t nr_voxels;
+        };
+
+        /** \brief A voxel in the tile files, the upper triangle of \a sum_sq is stored row by row. */
+        struct VoxelRecord
+        {
+          int32_t coordinates[3];
+          int32_t nr_points;
+          double sum[3];
+          double sum_sq[6];
+        };
+
+        typedef boost::unordered_map<uint64_t, Voxel> VoxelMap;
+        typedef boost::unordered_map<uint64_t, Tile> TileMap;
+
+        /** \brief Get the integer coordinates of the voxel containing a point. */
+        inline Eigen::Vector3i
+        getVoxelCoordinates (float x, float y, float z) const
+        {
+          return (Eigen::Vector3i (static_cast<int> (floor (x * inverse_resolution_)),
+                                   static_cast<int> (floor (y * inverse_resolution_)),
+                                   static_cast<int> (floor (z * inverse_resolution_))));
+        }
+
+        /** \brief Get the integer coordinates of the tile containing a voxel. */
+        inline Eigen::Vector3i
+        getTileCoordinates (const Eigen::Vector3i &voxel) const
+        {
+          Eigen::Vector3i tile;
+          for (int d = 0; d < 3; ++d)
+            tile[d] = voxel[d] >= 0 ? voxel[d] / tile_size_ : -((-voxel[d] - 1) / tile_size_) - 1;
+          return (tile);
+        }
+
+        /** \brief Pack integer coordinates into a hash key, 21 bits per axis. */
+        static inline uint64_t
+        getKey (const Eigen::Vector3i &coordinates)
+        {
+          return (((static_cast<uint64_t> (coordinates[0]) & 0x1FFFFF) << 42) |
+                  ((static_cast<uint64_t> (coordinates[1]) & 0x1FFFFF) << 21) |
+                   (static_cast<uint64_t> (coordinates[2]) & 0x1FFFFF));
+        }
+
+        /** \brief Get the name of the file of a tile in the map directory. */
+        std::string
+        getTileFileName (const Eigen::Vector3i &tile) const;
+
+        /** \brief Get a loaded tile, reading it from the map directory first if needed.
+          * \return the tile, or NULL if its file could not be read
+          */
+        Tile*
+        getTile (const Eigen::Vector3i &coordinates);
+
+        /** \brief Read a tile from the map directory and insert its voxels. A tile without a file is loaded
+          * empty.
+          * \return false if the tile file exists but could not be read, the map is then left untouched
+          */
+        bool
+        loadTile (const Eigen::Vector3i &coordinates);
+
+        /** \brief Write a tile to the map directory.
+          * \return true if the file was written successfully
+          */
+        bool
+        saveTile (const Tile &tile) const;
+
+        /** \brief Compute the mean, covariance and inverse covariance of a voxel from its sums, the way
+          * VoxelGridCovariance::applyFilter does.
+          */
+        void
+        computeLeaf (Voxel &voxel) const;
+
+        /** \brief The loaded voxels, by packed voxel coordinates. */
+        VoxelMap voxels_;
+
+        /** \brief The loaded tiles, by packed tile coordinates. */
+        TileMap tiles_;
+
+        /** \brief The edge length of the voxels. */
+        float resolution_;
+
+        /** \brief The inverse of the edge length of the voxels. */
+        float inverse_resolution_;
+
+        /** \brief The number of voxels along each edge of a tile. */
+        int tile_size_;
+
+        /** \brief The minimum number of points required for a voxel to be used. */
+        int min_points_per_voxel_;
+
+        /** \brief The minimum allowable ratio between the eigenvalues of the voxel covariances. */
+        double min_covar_eigvalue_mult_;
+
+        /** \brief The directory the tiles are written to and read from. */
+        std::string map_directory_;
+    };
+  }
+}
+
+#include <pcl/registration/impl/ndt_map.hpp>
+
+#endif    // PCL_REGISTRATION_NDT_MAP_H_
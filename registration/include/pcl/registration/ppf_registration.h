@@ -45,13 +45,16 @@
 
 namespace pcl
 {
+  /** \brief Hash map search structure for the discretized point pair features of a model, used by PPFRegistration.
+    * The features are stored in a single array, grouped by hash bucket and sorted by key inside each bucket, so
+    * that the features of a bin are contiguous. The discretization and the sorting of the buckets are done in
+    * parallel.
+    */
   class PCL_EXPORTS PPFHashMapSearch
   {
     public:
       /** \brief Data structure to hold the information for the key in the feature hash map of the
         * PPFHashMapSearch class
-        * \note It uses multiple pair levels in order to enable the usage of the boost::hash function
-        * which has the std::pair implementation (i.e., does not require a custom hash function)
         */
       struct HashKeyStruct : public std::pair <int, std::pair <int, std::pair <int, int> > >
       {
@@ -63,7 +66,10 @@ namespace pcl
           this->second.second.second = d;
         }
       };
+      /** \deprecated The features are no longer stored in a boost::unordered_multimap, the typedef is only kept for
+        * existing code that refers to it. */
       typedef boost::unordered_multimap<HashKeyStruct, std::pair<size_t, size_t> > FeatureHashMapType;
+      /** \deprecated See FeatureHashMapType. */
       typedef boost::shared_ptr<FeatureHashMapType> FeatureHashMapTypePtr;
       typedef boost::shared_ptr<PPFHashMapSearch> Ptr;
 
@@ -75,14 +81,22 @@ namespace pcl
       PPFHashMapSearch (float angle_discretization_step = 12.0f / 180.0f * static_cast<float> (M_PI),
                         float distance_discretization_step = 0.01f)
         : alpha_m_ ()
-        , feature_hash_map_ (new FeatureHashMapType)
+        , entries_ ()
+        , bucket_offsets_ ()
         , internals_initialized_ (false)
         , angle_discretization_step_ (angle_discretization_step)
         , distance_discretization_step_ (distance_discretization_step)
         , max_dist_ (-1.0f)
+        , threads_ (0)
       {
       }
 
+      /** \brief Set the number of threads used to build the hash map.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
       /** \brief Method that sets the feature cloud to be inserted in the hash map
        * \param feature_cloud a const smart pointer to the PPFSignature feature cloud
        */
@@ -101,6 +115,39 @@ namespace pcl
       nearestNeighborSearch (float &f1, float &f2, float &f3, float &f4,
                              std::vector<std::pair<size_t, size_t> > &indices);
 
+      /** \brief Save the hash map, the alpha_m angles, the model diameter and the discretization steps to a binary
+        * file, so that the search structure can be restored with loadBinary () instead of recomputing the model
+        * features and calling setInputFeatureCloud (). The arrays are stored as they are laid out in memory.
+        * \param[in] file_name the name of the file to write
+        * \return true if the file was written successfully
+        */
+      bool
+      saveBinary (const std::string &file_name) const;
+
+      /** \brief Write the search structure to an output stream, see saveBinary (const std::string &).
+        * \param[out] file the binary output stream
+        * \return true if the data was written successfully
+        */
+      bool
+      saveBinary (std::ostream &file) const;
+
+      /** \brief Load the search structure saved by saveBinary (). The discretization steps given to the constructor
+        * are replaced by the ones stored in the file.
+        * \param[in] file_name the name of the file to read
+        * \return true if the file was read successfully, false (leaving the search structure untouched) otherwise
+        */
+      bool
+      loadBinary (const std::string &file_name);
+
+      /** \brief Load the search structure from an input stream, see loadBinary (const std::string &).
+        * The stream must be seekable: the sizes declared in the header are checked against the length of the
+        * remaining data before anything is allocated.
+        * \param[in] file the binary input stream
+        * \return true if the data was read successfully, false (leaving the search structure untouched) otherwise
+        */
+      bool
+      loadBinary (std::istream &file);
+
       /** \brief Convenience method for returning a copy of the class instance as a boost::shared_ptr */
       Ptr
       makeShared() { return Ptr (new PPFHashMapSearch (*this)); }
@@ -119,11 +166,59 @@ namespace pcl
 
       std::vector <std::vector <float> > alpha_m_;
     private:
-      FeatureHashMapTypePtr feature_hash_map_;
+      /** \brief A discretized feature and the indices of the model point pair it was computed for. */
+      struct HashEntry
+      {
+        int d1, d2, d3, d4;
+        unsigned int model_reference_index, model_point_index;
+      };
+
+      /** \brief Header of the files written by saveBinary (). */
+      struct BinaryHeader
+      {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t nr_model_points;
+        uint64_t nr_buckets;
+        uint64_t nr_entries;
+        float angle_discretization_step;
+        float distance_discretization_step;
+        float max_dist;
+        uint32_t reserved;
+      };
+
+      /** \brief Lexicographic order of the entries, by key and then by point pair. */
+      static bool
+      hashEntryCompareFunction (const HashEntry &a, const HashEntry &b);
+
+      /** \brief Get the bucket of a discretized feature. */
+      inline size_t
+      getBucket (int d1, int d2, int d3, int d4) const
+      {
+        unsigned int h = (static_cast<unsigned int> (d1) * 73856093u) ^ (static_cast<unsigned int> (d2) * 19349663u) ^
+                         (static_cast<unsigned int> (d3) * 83492791u) ^ (static_cast<unsigned int> (d4) * 50331653u);
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        // The number of buckets is bucket_offsets_.size () - 1
+        return (static_cast<size_t> (h) & (bucket_offsets_.size () - 2));
+      }
+
+      /** \brief All the entries, grouped by bucket. */
+      std::vector<HashEntry> entries_;
+
+      /** \brief The entries of bucket b are in [bucket_offsets_[b], bucket_offsets_[b + 1]). The number of
+        * buckets is a power of two. */
+      std::vector<size_t> bucket_offsets_;
+
       bool internals_initialized_;
 
       float angle_discretization_step_, distance_discretization_step_;
       float max_dist_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
   };
 
   /** \brief Class that registers two point clouds based on their sets of PPFSignatures.
@@ -134,6 +229,8 @@ namespace pcl
    *    13-18 June 2010, San Francisco, CA
    *
    * \note This class works in tandem with the PPFEstimation class
+   * \note The scene reference points vote in parallel, each thread in its own accumulator array, see
+   * setNumberOfThreads (); the result does not depend on the number of threads.
    *
    * \author Alexandru-Eugen Ichim
    */
@@ -164,6 +261,7 @@ namespace pcl
       using Registration<PointSource, PointTarget>::converged_;
       using Registration<PointSource, PointTarget>::final_transformation_;
       using Registration<PointSource, PointTarget>::transformation_;
+      using Registration<PointSource, PointTarget>::threads_;
 
       typedef pcl::PointCloud<PointSource> PointCloudSource;
       typedef typename PointCloudSource::Ptr PointCloudSourcePtr;
@@ -180,9 +278,18 @@ namespace pcl
          search_method_ (),
          scene_reference_point_sampling_rate_ (5),
          clustering_position_diff_threshold_ (0.01f),
-         clustering_rotation_diff_threshold_ (20.0f / 180.0f * static_cast<float> (M_PI))
+         clustering_rotation_diff_threshold_ (20.0f / 180.0f * static_cast<float> (M_PI)),
+         scene_search_tree_ ()
       {}
 
+      /** \brief Set the number of threads voting for the poses. Every thread allocates its own accumulator array
+        * of number of model points x (2 pi / angle discretization step) votes, so the memory used by the voting
+        * grows linearly with the number of threads. No more threads than scene reference points are started.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
       /** \brief Method for setting the position difference clustering parameter
        * \param clustering_position_diff_threshold distance threshold below which two poses are
        * considered close enough to be in the same cluster (for the clustering phase of the algorithm)
@@ -103,6 +103,8 @@ namespace pcl
                         correspondence_distances_ (),
                         transformation_estimation_ (),
                         update_visualizer_ (NULL),
+                        threads_ (0),
+                        force_no_recompute_ (false),
                         point_representation_ ()
       {
       }
@@ -126,6 +128,25 @@ namespace pcl
       inline PointCloudTargetConstPtr const 
       getInputTarget () { return (target_ ); }
 
+      /** \brief Provide a pointer to the search object used to find the nearest neighbors in the target cloud.
+        * \param[in] tree a pointer to the spatial search object
+        * \param[in] force_no_recompute if true, \ref setInputTarget does not give the target cloud to \a tree,
+        * which the caller then keeps up to date (e.g. a VoxelHashMap the map points are added to incrementally).
+        * The target cloud is then shared with the caller instead of copied, and should be the cloud \a tree indexes.
+        */
+      inline void
+      setSearchMethodTarget (const KdTreePtr &tree, bool force_no_recompute = false)
+      {
+        tree_ = tree;
+        force_no_recompute_ = force_no_recompute;
+        if (target_ && !force_no_recompute_)
+          tree_->setInputCloud (target_);
+      }
+
+      /** \brief Get a pointer to the search object used to find the nearest neighbors in the target cloud. */
+      inline KdTreePtr
+      getSearchMethodTarget () const { return (tree_); }
+
       /** \brief Get the final transformation matrix estimated by the registration method. */
       inline Eigen::Matrix4f 
       getFinalTransformation () { return (final_transformation_); }
@@ -277,6 +298,17 @@ namespace pcl
       inline const std::string&
       getClassName () const { return (reg_name_); }
 
+      /** \brief Set the number of threads used by the registration methods that support it, e.g. for the
+        * correspondence search in IterativeClosestPoint. The results do not depend on the number of threads.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+      /** \brief Get the number of threads to use (0 means automatic). */
+      inline unsigned int
+      getNumberOfThreads () const { return (threads_); }
+
     protected:
       /** \brief The registration method name. */
       std::string reg_name_;
@@ -353,6 +385,12 @@ namespace pcl
                            const pcl::PointCloud<PointTarget> &cloud_tgt,
                            const std::vector<int> &indices_tgt)> update_visualizer_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief If true, the target search object is not updated when a new target is set. */
+      bool force_no_recompute_;
+
       /** \brief Search for the closest nearest neighbor of a given point.
         * \param cloud the point cloud dataset to use for nearest neighbor search
         * \param index the index of the query point
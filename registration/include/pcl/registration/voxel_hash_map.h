@@ -0,0 +1,239 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_REGISTRATION_VOXEL_HASH_MAP_H_
+#define PCL_REGISTRATION_VOXEL_HASH_MAP_H_
+
+#include <pcl/kdtree/kdtree.h>
+#include <pcl/registration/boost.h>
+
+namespace pcl
+{
+  namespace registration
+  {
+    /** \brief VoxelHashMap is a spatial locator for scan-to-map registration. The points are stored in a hash
+      * map of cubic voxels, so that new points can be added in time proportional to their number, without
+      * rebuilding the search structure, and a nearest neighbor lookup only visits a constant number of voxels.
+      *
+      * It implements the pcl::KdTree interface, so it can be given as the target search method of
+      * Registration and CorrespondenceEstimation. The returned indices refer to \ref getInputCloud, which
+      * grows with every call to \ref addPoints. Since \ref setInputCloud (which the registration methods call
+      * when a new target is set) would re-index the whole cloud, pass \a force_no_recompute to
+      * setSearchMethodTarget and give the map cloud itself as target. The registration then shares the map
+      * cloud instead of copying it, so it sees the points added afterwards, and the target only needs to be
+      * set again after \ref setInputCloud or \ref clear replaced the map cloud:
+      *
+      * \code
+      * pcl::registration::VoxelHashMap<pcl::PointXYZ>::Ptr map (new pcl::registration::VoxelHashMap<pcl::PointXYZ> (0.5f));
+      * pcl::IterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ> icp;
+      * map->addPoints (first_scan);
+      * icp.setSearchMethodTarget (map, true);
+      * icp.setMaxCorrespondenceDistance (0.5);
+      * icp.setInputTarget (map->getInputCloud ());
+      * for (...)
+      * {
+      *   icp.setInputCloud (scan);
+      *   icp.align (aligned_scan, guess);
+      *   map->addPoints (aligned_scan);
+      * }
+      * \endcode
+      *
+      * \note The search is approximate: nearestKSearch only looks at the voxel of the query point and its 26
+      * neighbors, so it is exact for neighbors closer than the leaf size and finds no neighbor at all if these
+      * voxels are empty. The leaf size should therefore be at least the maximum correspondence distance.
+      * radiusSearch visits all the voxels that intersect the search sphere and is exact.
+      * \note Only the x, y and z fields are used, the point representation is ignored.
+      * \ingroup registration
+      */
+    template <typename PointT>
+    class VoxelHashMap : public pcl::KdTree<PointT>
+    {
+      public:
+        using pcl::KdTree<PointT>::input_;
+        using pcl::KdTree<PointT>::indices_;
+        using pcl::KdTree<PointT>::sorted_;
+        using pcl::KdTree<PointT>::nearestKSearch;
+        using pcl::KdTree<PointT>::radiusSearch;
+
+        typedef typename pcl::KdTree<PointT>::PointCloud PointCloud;
+        typedef typename pcl::KdTree<PointT>::PointCloudPtr PointCloudPtr;
+        typedef typename pcl::KdTree<PointT>::PointCloudConstPtr PointCloudConstPtr;
+        typedef typename pcl::KdTree<PointT>::IndicesConstPtr IndicesConstPtr;
+
+        typedef boost::shared_ptr<VoxelHashMap<PointT> > Ptr;
+        typedef boost::shared_ptr<const VoxelHashMap<PointT> > ConstPtr;
+
+        /** \brief Constructor.
+          * \param[in] leaf_size the edge length of the voxels
+          * \param[in] sorted set to true if the neighbors should be returned sorted by distance (default)
+          */
+        VoxelHashMap (float leaf_size = 1.0f, bool sorted = true)
+          : pcl::KdTree<PointT> (sorted)
+          , map_ (new PointCloud)
+          , voxels_ ()
+          , leaf_size_ (leaf_size)
+          , inverse_leaf_size_ (1.0f / leaf_size)
+          , max_points_per_voxel_ (0)
+        {
+          input_ = map_;
+        }
+
+        /** \brief Set the edge length of the voxels. The points already in the map are re-indexed.
+          * \param[in] leaf_size the edge length of the voxels
+          */
+        void
+        setLeafSize (float leaf_size);
+
+        /** \brief Get the edge length of the voxels. */
+        inline float
+        getLeafSize () const { return (leaf_size_); }
+
+        /** \brief Set the maximum number of points a voxel keeps. Points that fall into a full voxel are not
+          * added to the map, which bounds its density. The points already in the map are not affected.
+          * \param[in] nr_points the maximum number of points per voxel (0 means unlimited, the default)
+          */
+        inline void
+        setMaxPointsPerVoxel (unsigned int nr_points) { max_points_per_voxel_ = nr_points; }
+
+        /** \brief Get the maximum number of points per voxel (0 means unlimited). */
+        inline unsigned int
+        getMaxPointsPerVoxel () const { return (max_points_per_voxel_); }
+
+        /** \brief Replace the map with a copy of the given cloud. The indices returned by the searches refer
+          * to the points of \a cloud.
+          * \param[in] cloud the input point cloud
+          * \param[in] indices the points of \a cloud to insert into the voxels (all if NULL)
+          */
+        void
+        setInputCloud (const PointCloudConstPtr &cloud, const IndicesConstPtr &indices = IndicesConstPtr ());
+
+        /** \brief Append points to the map. The finite points that do not fall into a full voxel are added to
+          * the end of \ref getInputCloud, the others are dropped.
+          * \param[in] cloud the points to add
+          * \return the number of points added
+          */
+        size_t
+        addPoints (const PointCloud &cloud);
+
+        /** \brief Remove all the points from the map. */
+        void
+        clear ();
+
+        /** \brief Get the number of occupied voxels. */
+        inline size_t
+        getNumberOfVoxels () const { return (voxels_.size ()); }
+
+        /** \brief Search for the k nearest neighbors of the given query point among the points of its voxel
+          * and of the 26 neighboring voxels.
+          * \param[in] p_q the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (const PointT &p_q, int k,
+                        std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const;
+
+        /** \brief Search for all the neighbors of the query point in a given radius.
+          * \param[in] p_q the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value (the closest ones are
+          * kept)
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (const PointT &p_q, double radius, std::vector<int> &k_indices,
+                      std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const;
+
+      protected:
+        /** \brief The voxels, as a map from the packed voxel coordinates to the indices of their points. */
+        typedef boost::unordered_map<uint64_t, std::vector<int> > VoxelMap;
+
+        /** \brief Class getName method. */
+        virtual std::string
+        getName () const { return ("VoxelHashMap"); }
+
+        /** \brief Get the integer coordinates of the voxel containing a point. */
+        inline Eigen::Vector3i
+        getVoxelCoordinates (const PointT &p) const
+        {
+          return (Eigen::Vector3i (static_cast<int> (floor (p.x * inverse_leaf_size_)),
+                                   static_cast<int> (floor (p.y * inverse_leaf_size_)),
+                                   static_cast<int> (floor (p.z * inverse_leaf_size_))));
+        }
+
+        /** \brief Pack the integer coordinates of a voxel into a hash key, 21 bits per axis. */
+        static inline uint64_t
+        getVoxelKey (int i, int j, int k)
+        {
+          return (((static_cast<uint64_t> (i) & 0x1FFFFF) << 42) |
+                  ((static_cast<uint64_t> (j) & 0x1FFFFF) << 21) |
+                   (static_cast<uint64_t> (k) & 0x1FFFFF));
+        }
+
+        /** \brief Insert the point at the given index of \ref map_ into its voxel.
+          * \return false if the point is not finite or its voxel is full
+          */
+        bool
+        insertPoint (int index);
+
+        /** \brief The points of the map. */
+        PointCloudPtr map_;
+
+        /** \brief The occupied voxels. */
+        VoxelMap voxels_;
+
+        /** \brief The edge length of the voxels. */
+        float leaf_size_;
+
+        /** \brief The inverse of the edge length of the voxels. */
+        float inverse_leaf_size_;
+
+        /** \brief The maximum number of points per voxel (0 means unlimited). */
+        unsigned int max_points_per_voxel_;
+    };
+  }
+}
+
+#include <pcl/registration/impl/voxel_hash_map.hpp>
+
+#endif    // PCL_REGISTRATION_VOXEL_HASH_MAP_H_
@@ -43,3 +43,289 @@
 //
 //PCL_INSTANTIATE_PRODUCT(PPFRegistration, (PCL_XYZ_POINT_TYPES)(PCL_NORMAL_POINT_TYPES));
 //
+
+#include <pcl/registration/ppf_registration.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PPFHashMapSearch::hashEntryCompareFunction (const HashEntry &a, const HashEntry &b)
+{
+  if (a.d1 != b.d1) return (a.d1 < b.d1);
+  if (a.d2 != b.d2) return (a.d2 < b.d2);
+  if (a.d3 != b.d3) return (a.d3 < b.d3);
+  if (a.d4 != b.d4) return (a.d4 < b.d4);
+  if (a.model_reference_index != b.model_reference_index) return (a.model_reference_index < b.model_reference_index);
+  return (a.model_point_index < b.model_point_index);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PPFHashMapSearch::setInputFeatureCloud (PointCloud<PPFSignature>::ConstPtr feature_cloud)
+{
+  unsigned int n = static_cast<unsigned int> (sqrt (static_cast<float> (feature_cloud->points.size ())));
+  size_t nr_entries = static_cast<size_t> (n) * n;
+
+  // Use about four entries per bucket
+  size_t nr_buckets = 1;
+  while (nr_buckets * 4 < nr_entries)
+    nr_buckets *= 2;
+  bucket_offsets_.assign (nr_buckets + 1, 0);
+
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#endif
+
+  // Discretize the feature cloud and find the bucket of every feature
+  std::vector<HashEntry> entries (nr_entries);
+  std::vector<size_t> entry_buckets (nr_entries);
+  std::vector<float> max_dist_row (n, -1.0f);
+  alpha_m_.resize (n);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+#endif
+  for (int i = 0; i < static_cast<int> (n); ++i)
+  {
+    std::vector <float> &alpha_m_row = alpha_m_[i];
+    alpha_m_row.resize (n);
+    for (size_t j = 0; j < n; ++j)
+    {
+      const size_t k = i * static_cast<size_t> (n) + j;
+      const PPFSignature &feature = feature_cloud->points[k];
+      HashEntry &entry = entries[k];
+      entry.d1 = static_cast<int> (floor (feature.f1 / angle_discretization_step_));
+      entry.d2 = static_cast<int> (floor (feature.f2 / angle_discretization_step_));
+      entry.d3 = static_cast<int> (floor (feature.f3 / angle_discretization_step_));
+      entry.d4 = static_cast<int> (floor (feature.f4 / distance_discretization_step_));
+      entry.model_reference_index = static_cast<unsigned int> (i);
+      entry.model_point_index = static_cast<unsigned int> (j);
+      entry_buckets[k] = getBucket (entry.d1, entry.d2, entry.d3, entry.d4);
+      alpha_m_row[j] = feature.alpha_m;
+
+      if (max_dist_row[i] < feature.f4)
+        max_dist_row[i] = feature.f4;
+    }
+  }
+
+  max_dist_ = -1.0f;
+  for (size_t i = 0; i < n; ++i)
+    if (max_dist_ < max_dist_row[i])
+      max_dist_ = max_dist_row[i];
+
+  // Group the entries by bucket, a single pass over the bucket counts
+  for (size_t k = 0; k < nr_entries; ++k)
+    ++bucket_offsets_[entry_buckets[k] + 1];
+  for (size_t b = 0; b < nr_buckets; ++b)
+    bucket_offsets_[b + 1] += bucket_offsets_[b];
+  std::vector<size_t> insert_position (bucket_offsets_.begin (), bucket_offsets_.end () - 1);
+  entries_.resize (nr_entries);
+  for (size_t k = 0; k < nr_entries; ++k)
+    entries_[insert_position[entry_buckets[k]]++] = entries[k];
+
+  // Sort every bucket so that the entries of a key are contiguous, and in the same order regardless of the
+  // number of threads
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (nr_threads) schedule (dynamic, 1024)
+#endif
+  for (int b = 0; b < static_cast<int> (nr_buckets); ++b)
+    std::sort (entries_.begin () + bucket_offsets_[b], entries_.begin () + bucket_offsets_[b + 1], hashEntryCompareFunction);
+
+  internals_initialized_ = true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PPFHashMapSearch::nearestNeighborSearch (float &f1, float &f2, float &f3, float &f4,
+                                              std::vector<std::pair<size_t, size_t> > &indices)
+{
+  if (!internals_initialized_)
+  {
+    PCL_ERROR("[pcl::PPFRegistration::nearestNeighborSearch]: input feature cloud has not been set - skipping search!\n");
+    return;
+  }
+
+  int d1 = static_cast<int> (floor (f1 / angle_discretization_step_)),
+      d2 = static_cast<int> (floor (f2 / angle_discretization_step_)),
+      d3 = static_cast<int> (floor (f3 / angle_discretization_step_)),
+      d4 = static_cast<int> (floor (f4 / distance_discretization_step_));
+
+  indices.clear ();
+  size_t b = getBucket (d1, d2, d3, d4);
+  for (size_t k = bucket_offsets_[b]; k < bucket_offsets_[b + 1]; ++k)
+  {
+    const HashEntry &entry = entries_[k];
+    if (entry.d1 == d1 && entry.d2 == d2 && entry.d3 == d3 && entry.d4 == d4)
+      indices.push_back (std::pair<size_t, size_t> (entry.model_reference_index, entry.model_point_index));
+    // The entries of a key are contiguous
+    else if (!indices.empty ())
+      break;
+  }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+  const char ppf_hash_map_magic[8] = { 'P', 'C', 'L', 'P', 'P', 'F', 'H', 'M' };
+  const pcl::uint32_t ppf_hash_map_version = 1;
+  const pcl::uint32_t ppf_hash_map_byte_order = 0x01020304;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PPFHashMapSearch::saveBinary (std::ostream &file) const
+{
+  if (!internals_initialized_)
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::saveBinary] Input feature cloud has not been set - nothing to save!\n");
+    return (false);
+  }
+
+  const size_t n = alpha_m_.size ();
+  BinaryHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, ppf_hash_map_magic, sizeof (header.magic));
+  header.version = ppf_hash_map_version;
+  header.byte_order = ppf_hash_map_byte_order;
+  header.nr_model_points = n;
+  header.nr_buckets = bucket_offsets_.size () - 1;
+  header.nr_entries = entries_.size ();
+  header.angle_discretization_step = angle_discretization_step_;
+  header.distance_discretization_step = distance_discretization_step_;
+  header.max_dist = max_dist_;
+  file.write (reinterpret_cast<const char*> (&header), sizeof (header));
+
+  // Sections: the bucket offsets, the entries and the alpha_m angles, row after row
+  std::vector<uint64_t> bucket_offsets (bucket_offsets_.begin (), bucket_offsets_.end ());
+  file.write (reinterpret_cast<const char*> (&bucket_offsets[0]), bucket_offsets.size () * sizeof (uint64_t));
+  if (!entries_.empty ())
+    file.write (reinterpret_cast<const char*> (&entries_[0]), entries_.size () * sizeof (HashEntry));
+  for (size_t i = 0; i < n; ++i)
+    file.write (reinterpret_cast<const char*> (&alpha_m_[i][0]), n * sizeof (float));
+
+  if (!file)
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::saveBinary] Error writing the hash map!\n");
+    return (false);
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PPFHashMapSearch::saveBinary (const std::string &file_name) const
+{
+  std::ofstream file (file_name.c_str (), std::ofstream::out | std::ofstream::binary);
+  if (!file.is_open ())
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::saveBinary] Could not open %s for writing!\n", file_name.c_str ());
+    return (false);
+  }
+  return (saveBinary (file));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PPFHashMapSearch::loadBinary (std::istream &file)
+{
+  BinaryHeader header;
+  file.read (reinterpret_cast<char*> (&header), sizeof (header));
+  if (!file || memcmp (header.magic, ppf_hash_map_magic, sizeof (header.magic)) != 0)
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::loadBinary] Not a PPF hash map file!\n");
+    return (false);
+  }
+  if (header.version != ppf_hash_map_version || header.byte_order != ppf_hash_map_byte_order)
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::loadBinary] Unsupported version (%u) or byte order of the PPF hash map file!\n", header.version);
+    return (false);
+  }
+  // n * n must not overflow: n is at most sqrt (UINT64_MAX)
+  const uint64_t n = header.nr_model_points;
+  if (n > std::numeric_limits<uint32_t>::max () || header.nr_entries != n * n ||
+      header.nr_buckets == 0 || (header.nr_buckets & (header.nr_buckets - 1)) != 0 ||
+      !(header.angle_discretization_step > 0.0f) || !(header.distance_discretization_step > 0.0f))
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::loadBinary] Inconsistent PPF hash map file header!\n");
+    return (false);
+  }
+
+  // Check that the stream holds all the sections the header announces before allocating them
+  const std::istream::pos_type data_begin = file.tellg ();
+  file.seekg (0, std::ios::end);
+  const std::istream::pos_type data_end = file.tellg ();
+  file.seekg (data_begin);
+  if (data_begin == std::istream::pos_type (-1) || data_end == std::istream::pos_type (-1) || !file)
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::loadBinary] The PPF hash map stream is not seekable!\n");
+    return (false);
+  }
+  uint64_t remaining = static_cast<uint64_t> (data_end - data_begin);
+  bool complete = header.nr_buckets < remaining / sizeof (uint64_t);
+  if (complete)
+  {
+    remaining -= (header.nr_buckets + 1) * sizeof (uint64_t);
+    complete = header.nr_entries <= remaining / (sizeof (HashEntry) + sizeof (float)) &&
+               header.nr_entries <= std::numeric_limits<size_t>::max () / sizeof (HashEntry);
+  }
+  if (!complete)
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::loadBinary] Unexpected end of the PPF hash map file!\n");
+    return (false);
+  }
+
+  std::vector<uint64_t> bucket_offsets (static_cast<size_t> (header.nr_buckets + 1));
+  file.read (reinterpret_cast<char*> (&bucket_offsets[0]), bucket_offsets.size () * sizeof (uint64_t));
+  std::vector<HashEntry> entries (static_cast<size_t> (header.nr_entries));
+  if (!entries.empty ())
+    file.read (reinterpret_cast<char*> (&entries[0]), entries.size () * sizeof (HashEntry));
+  std::vector <std::vector <float> > alpha_m (static_cast<size_t> (n), std::vector<float> (static_cast<size_t> (n)));
+  for (size_t i = 0; i < alpha_m.size (); ++i)
+    file.read (reinterpret_cast<char*> (&alpha_m[i][0]), alpha_m[i].size () * sizeof (float));
+  if (!file)
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::loadBinary] Unexpected end of the PPF hash map file!\n");
+    return (false);
+  }
+
+  // The lookups trust the offsets and the point pair indices, so check them once here
+  bool valid = bucket_offsets.front () == 0 && bucket_offsets.back () == header.nr_entries;
+  for (size_t b = 0; valid && b + 1 < bucket_offsets.size (); ++b)
+    valid = bucket_offsets[b] <= bucket_offsets[b + 1];
+  for (size_t k = 0; valid && k < entries.size (); ++k)
+    valid = entries[k].model_reference_index < n && entries[k].model_point_index < n;
+  if (!valid)
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::loadBinary] Corrupted PPF hash map file!\n");
+    return (false);
+  }
+
+  bucket_offsets_.assign (bucket_offsets.begin (), bucket_offsets.end ());
+  entries_.swap (entries);
+  alpha_m_.swap (alpha_m);
+  angle_discretization_step_ = header.angle_discretization_step;
+  distance_discretization_step_ = header.distance_discretization_step;
+  max_dist_ = header.max_dist;
+  internals_initialized_ = true;
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PPFHashMapSearch::loadBinary (const std::string &file_name)
+{
+  std::ifstream file (file_name.c_str (), std::ifstream::in | std::ifstream::binary);
+  if (!file.is_open ())
+  {
+    PCL_ERROR ("[pcl::PPFHashMapSearch::loadBinary] Could not open %s for reading!\n", file_name.c_str ());
+    return (false);
+  }
+  return (loadBinary (file));
+}
@@ -40,6 +40,10 @@
 
 #include <pcl/sample_consensus/lmeds.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> bool
 pcl::LeastMedianSquares<PointT>::computeModel (int debug_verbosity_level)
@@ -51,6 +55,9 @@ pcl::LeastMedianSquares<PointT>::computeModel (int debug_verbosity_level)
     return (false);
   }
 
+  if (threads_ != 1)
+    return (computeModelParallel (debug_verbosity_level));
+
   iterations_ = 0;
   double d_best_penalty = std::numeric_limits<double>::max();
 
@@ -172,6 +179,145 @@ pcl::LeastMedianSquares<PointT>::computeModel (int debug_verbosity_level)
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::LeastMedianSquares<PointT>::computeModelParallel (int debug_verbosity_level)
+{
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#else
+  const int nr_threads = 1;
+#endif
+
+  iterations_ = 0;
+  double d_best_penalty = std::numeric_limits<double>::max();
+
+  unsigned skipped_count = 0;
+  // supress infinite loops by just allowing 10 x maximum allowed iterations for invalid model parameters!
+  const unsigned max_skip = max_iterations_ * 10;
+  bool no_samples = false;
+
+  const size_t nr_indices = sac_model_->getIndices ()->size ();
+  const size_t mid = nr_indices / 2;
+  std::vector<boost::uint32_t> seeds;
+  this->getThreadSeeds (nr_threads, seeds);
+
+#pragma omp parallel num_threads (nr_threads)
+  {
+#ifdef _OPENMP
+    boost::mt19937 rng (seeds[omp_get_thread_num ()]);
+#else
+    boost::mt19937 rng (seeds[0]);
+#endif
+    std::vector<int> selection;
+    Eigen::VectorXf model_coefficients;
+    std::vector<double> distances;
+
+    while (true)
+    {
+      // Reserve one trial, with the same stopping criteria as the serial loop
+      bool run;
+#pragma omp critical (pcl_lmeds_best)
+      {
+        run = !no_samples && iterations_ < max_iterations_ && skipped_count < max_skip;
+        if (run)
+          ++iterations_;
+      }
+      if (!run)
+        break;
+
+      // Get X samples which satisfy the model criteria
+      sac_model_->getSamples (rng, selection);
+      if (selection.empty ())
+      {
+#pragma omp critical (pcl_lmeds_best)
+        no_samples = true;
+        break;
+      }
+
+      // Search for inliers in the point cloud for the current plane model M, and calculate
+      // the distances from the 3d points to it. No distances? The model must not respect
+      // the user given constraints
+      bool valid = sac_model_->computeModelCoefficients (selection, model_coefficients);
+      if (valid)
+      {
+        sac_model_->getDistancesToModel (model_coefficients, distances);
+        valid = mid < distances.size ();
+      }
+      if (!valid)
+      {
+#pragma omp critical (pcl_lmeds_best)
+        {
+          --iterations_;
+          ++skipped_count;
+        }
+        continue;
+      }
+
+      // d_cur_penalty = median (distances), found by partial sorting
+      std::nth_element (distances.begin (), distances.begin () + mid, distances.end ());
+      double d_cur_penalty;
+      // Do we have a "middle" point or should we "estimate" one ?
+      if (nr_indices % 2 == 0)
+        d_cur_penalty = (sqrt (*std::max_element (distances.begin (), distances.begin () + mid)) + sqrt (distances[mid])) / 2;
+      else
+        d_cur_penalty = sqrt (distances[mid]);
+
+#pragma omp critical (pcl_lmeds_best)
+      {
+        // Better match ?
+        if (d_cur_penalty < d_best_penalty)
+        {
+          d_best_penalty = d_cur_penalty;
+
+          // Save the current model/coefficients selection as being the best so far
+          model_              = selection;
+          model_coefficients_ = model_coefficients;
+        }
+        if (debug_verbosity_level > 1)
+          PCL_DEBUG ("[pcl::LeastMedianSquares::computeModel] Trial %d out of %d. Best penalty is %f.\n", iterations_, max_iterations_, d_best_penalty);
+      }
+    }
+  }
+
+  if (model_.empty ())
+  {
+    if (debug_verbosity_level > 0)
+      PCL_DEBUG ("[pcl::LeastMedianSquares::computeModel] Unable to find a solution!\n");
+    return (false);
+  }
+
+  // Iterate through the 3d points and calculate the distances from them to the model again
+  std::vector<double> distances;
+  sac_model_->getDistancesToModel (model_coefficients_, distances);
+  // No distances? The model must not respect the user given constraints
+  if (distances.empty ())
+  {
+    PCL_ERROR ("[pcl::LeastMedianSquares::computeModel] The model found failed to verify against the given constraints!\n");
+    return (false);
+  }
+
+  std::vector<int> &indices = *sac_model_->getIndices ();
+  if (distances.size () != indices.size ())
+  {
+    PCL_ERROR ("[pcl::LeastMedianSquares::computeModel] Estimated distances (%zu) differs than the normal of indices (%zu).\n", distances.size (), indices.size ());
+    return (false);
+  }
+
+  // Get the inliers for the best model found
+  inliers_.resize (distances.size ());
+  int n_inliers_count = 0;
+  for (size_t i = 0; i < distances.size (); ++i)
+    if (distances[i] <= threshold_)
+      inliers_[n_inliers_count++] = indices[i];
+  inliers_.resize (n_inliers_count);
+
+  if (debug_verbosity_level > 0)
+    PCL_DEBUG ("[pcl::LeastMedianSquares::computeModel] Model: %zu size, %d inliers.\n", model_.size (), n_inliers_count);
+
+  return (true);
+}
+
 #define PCL_INSTANTIATE_LeastMedianSquares(T) template class PCL_EXPORTS pcl::LeastMedianSquares<T>;
 
 #endif    // PCL_SAMPLE_CONSENSUS_IMPL_LMEDS_H_
@@ -40,6 +40,10 @@
 
 #include <pcl/sample_consensus/ransac.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> bool
 pcl::RandomSampleConsensus<PointT>::computeModel (int debug_verbosity_level)
@@ -51,6 +55,9 @@ pcl::RandomSampleConsensus<PointT>::computeModel (int debug_verbosity_level)
     return (false);
   }
 
+  if (threads_ != 1)
+    return (computeModelParallel (debug_verbosity_level));
+
   iterations_ = 0;
   int n_best_inliers_count = -INT_MAX;
   double k = 1.0;
@@ -132,6 +139,116 @@ pcl::RandomSampleConsensus<PointT>::computeModel (int debug_verbosity_level)
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::RandomSampleConsensus<PointT>::computeModelParallel (int debug_verbosity_level)
+{
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#else
+  const int nr_threads = 1;
+#endif
+
+  iterations_ = 0;
+  int n_best_inliers_count = -INT_MAX;
+  double k = 1.0;
+
+  unsigned skipped_count = 0;
+  // supress infinite loops by just allowing 10 x maximum allowed iterations for invalid model parameters!
+  const unsigned max_skip = max_iterations_ * 10;
+  bool no_samples = false;
+
+  const double nr_indices = static_cast<double> (sac_model_->getIndices ()->size ());
+  std::vector<boost::uint32_t> seeds;
+  this->getThreadSeeds (nr_threads, seeds);
+
+#pragma omp parallel num_threads (nr_threads)
+  {
+#ifdef _OPENMP
+    boost::mt19937 rng (seeds[omp_get_thread_num ()]);
+#else
+    boost::mt19937 rng (seeds[0]);
+#endif
+    std::vector<int> selection;
+    Eigen::VectorXf model_coefficients;
+
+    while (true)
+    {
+      // Reserve one trial, with the same stopping criteria as the serial loop
+      bool run;
+#pragma omp critical (pcl_ransac_best)
+      {
+        run = !no_samples && iterations_ < k && skipped_count < max_skip && iterations_ <= max_iterations_;
+        if (run)
+          ++iterations_;
+      }
+      if (!run)
+        break;
+
+      // Get X samples which satisfy the model criteria
+      sac_model_->getSamples (rng, selection);
+      if (selection.empty ())
+      {
+#pragma omp critical (pcl_ransac_best)
+        no_samples = true;
+        break;
+      }
+
+      // Search for inliers in the point cloud for the current plane model M
+      if (!sac_model_->computeModelCoefficients (selection, model_coefficients))
+      {
+#pragma omp critical (pcl_ransac_best)
+        {
+          --iterations_;
+          ++skipped_count;
+        }
+        continue;
+      }
+
+      int n_inliers_count = sac_model_->countWithinDistance (model_coefficients, threshold_);
+
+#pragma omp critical (pcl_ransac_best)
+      {
+        // Better match ?
+        if (n_inliers_count > n_best_inliers_count)
+        {
+          n_best_inliers_count = n_inliers_count;
+
+          // Save the current model/inlier/coefficients selection as being the best so far
+          model_              = selection;
+          model_coefficients_ = model_coefficients;
+
+          // Compute the k parameter (k=log(z)/log(1-w^n))
+          double w = static_cast<double> (n_best_inliers_count) / nr_indices;
+          double p_no_outliers = 1.0 - pow (w, static_cast<double> (selection.size ()));
+          p_no_outliers = (std::max) (std::numeric_limits<double>::epsilon (), p_no_outliers);       // Avoid division by -Inf
+          p_no_outliers = (std::min) (1.0 - std::numeric_limits<double>::epsilon (), p_no_outliers);   // Avoid division by 0.
+          k = log (1.0 - probability_) / log (p_no_outliers);
+        }
+        if (debug_verbosity_level > 1)
+          PCL_DEBUG ("[pcl::RandomSampleConsensus::computeModel] Trial %d out of %f: %d inliers (best is: %d so far).\n", iterations_, k, n_inliers_count, n_best_inliers_count);
+      }
+    }
+  }
+
+  if (no_samples)
+    PCL_ERROR ("[pcl::RandomSampleConsensus::computeModel] No samples could be selected!\n");
+  if (iterations_ > max_iterations_ && debug_verbosity_level > 0)
+    PCL_DEBUG ("[pcl::RandomSampleConsensus::computeModel] RANSAC reached the maximum number of trials.\n");
+  if (debug_verbosity_level > 0)
+    PCL_DEBUG ("[pcl::RandomSampleConsensus::computeModel] Model: %zu size, %d inliers.\n", model_.size (), n_best_inliers_count);
+
+  if (model_.empty ())
+  {
+    inliers_.clear ();
+    return (false);
+  }
+
+  // Get the set of inliers that correspond to the best model found so far
+  sac_model_->selectWithinDistance (model_coefficients_, threshold_, inliers_);
+  return (true);
+}
+
 #define PCL_INSTANTIATE_RandomSampleConsensus(T) template class PCL_EXPORTS pcl::RandomSampleConsensus<T>;
 
 #endif    // PCL_SAMPLE_CONSENSUS_IMPL_RANSAC_H_
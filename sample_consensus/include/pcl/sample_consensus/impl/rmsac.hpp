@@ -40,6 +40,10 @@
 
 #include <pcl/sample_consensus/rmsac.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> bool
 pcl::RandomizedMEstimatorSampleConsensus<PointT>::computeModel (int debug_verbosity_level)
@@ -51,6 +55,9 @@ pcl::RandomizedMEstimatorSampleConsensus<PointT>::computeModel (int debug_verbos
     return (false);
   }
 
+  if (threads_ != 1)
+    return (computeModelParallel (debug_verbosity_level));
+
   iterations_ = 0;
   double d_best_penalty = std::numeric_limits<double>::max();
   double k = 1.0;
@@ -175,6 +182,170 @@ pcl::RandomizedMEstimatorSampleConsensus<PointT>::computeModel (int debug_verbos
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::RandomizedMEstimatorSampleConsensus<PointT>::computeModelParallel (int debug_verbosity_level)
+{
+#ifdef _OPENMP
+  const int nr_threads = threads_ != 0 ? static_cast<int> (threads_) : omp_get_max_threads ();
+#else
+  const int nr_threads = 1;
+#endif
+
+  iterations_ = 0;
+  double d_best_penalty = std::numeric_limits<double>::max();
+  double k = 1.0;
+
+  unsigned skipped_count = 0;
+  // supress infinite loops by just allowing 10 x maximum allowed iterations for invalid model parameters!
+  const unsigned max_skip = max_iterations_ * 10;
+  bool no_samples = false;
+
+  const double nr_indices = static_cast<double> (sac_model_->getIndices ()->size ());
+
+  // Number of samples to try randomly
+  size_t fraction_nr_points = pcl_lrint (nr_indices * fraction_nr_pretest_ / 100.0);
+  std::vector<boost::uint32_t> seeds;
+  this->getThreadSeeds (nr_threads, seeds);
+
+#pragma omp parallel num_threads (nr_threads)
+  {
+#ifdef _OPENMP
+    boost::mt19937 rng (seeds[omp_get_thread_num ()]);
+#else
+    boost::mt19937 rng (seeds[0]);
+#endif
+    std::vector<int> selection;
+    Eigen::VectorXf model_coefficients;
+    std::vector<double> distances;
+    std::set<int> indices_subset;
+
+    while (true)
+    {
+      // Reserve one trial, with the same stopping criteria as the serial loop
+      bool run;
+      double current_k = 1.0;
+#pragma omp critical (pcl_rmsac_best)
+      {
+        run = !no_samples && iterations_ < k && skipped_count < max_skip && iterations_ <= max_iterations_;
+        if (run)
+        {
+          ++iterations_;
+          current_k = k;
+        }
+      }
+      if (!run)
+        break;
+
+      // Get X samples which satisfy the model criteria
+      sac_model_->getSamples (rng, selection);
+      if (selection.empty ())
+      {
+#pragma omp critical (pcl_rmsac_best)
+        no_samples = true;
+        break;
+      }
+
+      // Search for inliers in the point cloud for the current plane model M
+      if (!sac_model_->computeModelCoefficients (selection, model_coefficients))
+      {
+#pragma omp critical (pcl_rmsac_best)
+        {
+          --iterations_;
+          ++skipped_count;
+        }
+        continue;
+      }
+
+      // RMSAC addon: verify a random fraction of the data
+      // Get X random samples which satisfy the model criterion
+      this->getRandomSamples (sac_model_->getIndices (), fraction_nr_points, indices_subset, rng);
+
+      // As in the serial loop, a rejected model still counts as a trial once k has been set
+      if (!sac_model_->doSamplesVerifyModel (indices_subset, model_coefficients, threshold_) && current_k != 1.0)
+        continue;
+
+      // Iterate through the 3d points and calculate the distances from them to the model
+      sac_model_->getDistancesToModel (model_coefficients, distances);
+
+      // An invalid model yields no distances: count it as skipped rather than as a perfect match
+      if (distances.empty ())
+      {
+#pragma omp critical (pcl_rmsac_best)
+        {
+          --iterations_;
+          ++skipped_count;
+        }
+        continue;
+      }
+
+      // Accumulate the penalty and the number of inliers in a single pass, outside of the lock
+      double d_cur_penalty = 0;
+      int n_inliers_count = 0;
+      for (size_t i = 0; i < distances.size (); ++i)
+      {
+        d_cur_penalty += (std::min) (distances[i], threshold_);
+        if (distances[i] <= threshold_)
+          ++n_inliers_count;
+      }
+
+#pragma omp critical (pcl_rmsac_best)
+      {
+        // Better match ?
+        if (d_cur_penalty < d_best_penalty)
+        {
+          d_best_penalty = d_cur_penalty;
+
+          // Save the current model/coefficients selection as being the best so far
+          model_              = selection;
+          model_coefficients_ = model_coefficients;
+
+          // Compute the k parameter (k=log(z)/log(1-w^n))
+          double w = static_cast<double> (n_inliers_count) / nr_indices;
+          double p_no_outliers = 1.0 - pow (w, static_cast<double> (selection.size ()));
+          p_no_outliers = (std::max) (std::numeric_limits<double>::epsilon (), p_no_outliers);       // Avoid division by -Inf
+          p_no_outliers = (std::min) (1.0 - std::numeric_limits<double>::epsilon (), p_no_outliers);   // Avoid division by 0.
+          k = log (1.0 - probability_) / log (p_no_outliers);
+        }
+        if (debug_verbosity_level > 1)
+          PCL_DEBUG ("[pcl::RandomizedMEstimatorSampleConsensus::computeModel] Trial %d out of %d. Best penalty is %f.\n", iterations_, static_cast<int> (ceil (k)), d_best_penalty);
+      }
+    }
+  }
+
+  if (iterations_ > max_iterations_ && debug_verbosity_level > 0)
+    PCL_DEBUG ("[pcl::RandomizedMEstimatorSampleConsensus::computeModel] MSAC reached the maximum number of trials.\n");
+
+  if (model_.empty ())
+  {
+    if (debug_verbosity_level > 0)
+      PCL_DEBUG ("[pcl::RandomizedMEstimatorSampleConsensus::computeModel] Unable to find a solution!\n");
+    return (false);
+  }
+
+  // Get the inliers for the best model found
+  std::vector<double> distances;
+  sac_model_->getDistancesToModel (model_coefficients_, distances);
+  std::vector<int> &indices = *sac_model_->getIndices ();
+  if (distances.size () != indices.size ())
+  {
+    PCL_ERROR ("[pcl::RandomizedMEstimatorSampleConsensus::computeModel] Estimated distances (%zu) differs than the normal of indices (%zu).\n", distances.size (), indices.size ());
+    return (false);
+  }
+
+  inliers_.resize (distances.size ());
+  int n_inliers_count = 0;
+  for (size_t i = 0; i < distances.size (); ++i)
+    if (distances[i] <= threshold_)
+      inliers_[n_inliers_count++] = indices[i];
+  inliers_.resize (n_inliers_count);
+
+  if (debug_verbosity_level > 0)
+    PCL_DEBUG ("[pcl::RandomizedMEstimatorSampleConsensus::computeModel] Model: %zu size, %d inliers.\n", model_.size (), n_inliers_count);
+
+  return (true);
+}
+
 #define PCL_INSTANTIATE_RandomizedMEstimatorSampleConsensus(T) template class PCL_EXPORTS pcl::RandomizedMEstimatorSampleConsensus<T>;
 
 #endif    // PCL_SAMPLE_CONSENSUS_IMPL_RMSAC_H_
@@ -41,6 +41,121 @@
 #include <pcl/sample_consensus/eigen.h>
 #include <pcl/sample_consensus/sac_model_cylinder.h>
 #include <pcl/common/concatenate.h>
+#include <pcl/sample_consensus/sac_model_simd.h>
+#include <limits>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Distance kernel of SampleConsensusModelCylinder: the weighted sum of the angle between the
+      * point normal and the cylinder normal at the point, and of |dist (point, axis) - radius|.
+      *
+      * The Euclidean part is vectorized. The angle needs an acos, which is only evaluated for the points
+      * whose weighted Euclidean distance alone is smaller than \a max_distance; the others get that lower
+      * bound as distance.
+      */
+    template <typename PointT, typename PointNT>
+    class SACCylinderDistance
+    {
+      public:
+        SACCylinderDistance (const PointCloud<PointT> &cloud, const PointCloud<PointNT> &normals,
+                             const Eigen::VectorXf &model_coefficients, double normal_distance_weight,
+                             float max_distance = std::numeric_limits<float>::max ())
+          : points_ (cloud.points), normals_ (normals.points)
+          , px_ (model_coefficients[0]), py_ (model_coefficients[1]), pz_ (model_coefficients[2])
+          , dx_ (model_coefficients[3]), dy_ (model_coefficients[4]), dz_ (model_coefficients[5])
+          , r_ (model_coefficients[6])
+          , normal_weight_ (static_cast<float> (normal_distance_weight))
+          , euclidean_weight_ (static_cast<float> (1 - normal_distance_weight))
+          , max_distance_ (max_distance)
+        {
+          ptdotdir_ = px_ * dx_ + py_ * dy_ + pz_ * dz_;
+          dirdotdir_ = 1.0f / (dx_ * dx_ + dy_ * dy_ + dz_ * dz_);
+        }
+
+        inline float
+        operator () (int index) const
+        {
+          const PointT &p = points_[index];
+          const PointNT &n = normals_[index];
+
+          // Distance from the point to the cylinder axis, minus the radius
+          float vx = px_ - p.x, vy = py_ - p.y, vz = pz_ - p.z;
+          float cx = dy_ * vz - dz_ * vy, cy = dz_ * vx - dx_ * vz, cz = dx_ * vy - dy_ * vx;
+          float d_euclid = euclidean_weight_ * std::fabs (sqrtf ((cx * cx + cy * cy + cz * cz) * dirdotdir_) - r_);
+          if (d_euclid >= max_distance_)
+            return (d_euclid);
+
+          // Direction from the point's projection on the cylinder axis to the point
+          float k = (p.x * dx_ + p.y * dy_ + p.z * dz_ - ptdotdir_) * dirdotdir_;
+          float ux = p.x - (px_ + k * dx_), uy = p.y - (py_ + k * dy_), uz = p.z - (pz_ + k * dz_);
+          float cosine = (n.normal_x * ux + n.normal_y * uy + n.normal_z * uz) /
+                         sqrtf ((n.normal_x * n.normal_x + n.normal_y * n.normal_y + n.normal_z * n.normal_z) *
+                                (ux * ux + uy * uy + uz * uz));
+          return (combine (d_euclid, cosine));
+        }
+
+#ifdef __SSE2__
+        inline SACPacket
+        operator () (const int *indices) const
+        {
+          const float *p[SAC_PACKET_SIZE], *pn[SAC_PACKET_SIZE];
+          for (int j = 0; j < SAC_PACKET_SIZE; ++j)
+          {
+            p[j] = &points_[indices[j]].x;
+            pn[j] = &normals_[indices[j]].normal_x;
+          }
+          SACPacket x, y, z, nx, ny, nz;
+          sacLoadXYZ (p, x, y, z);
+          sacLoadXYZ (pn, nx, ny, nz);
+
+          SACPacket dx = sacSet1 (dx_), dy = sacSet1 (dy_), dz = sacSet1 (dz_);
+          SACPacket vx = sacSub (sacSet1 (px_), x), vy = sacSub (sacSet1 (py_), y), vz = sacSub (sacSet1 (pz_), z);
+          SACPacket cx = sacSub (sacMul (dy, vz), sacMul (dz, vy));
+          SACPacket cy = sacSub (sacMul (dz, vx), sacMul (dx, vz));
+          SACPacket cz = sacSub (sacMul (dx, vy), sacMul (dy, vx));
+          SACPacket sqr_norm = sacMul (sacAdd (sacAdd (sacMul (cx, cx), sacMul (cy, cy)), sacMul (cz, cz)), sacSet1 (dirdotdir_));
+          SACPacket d_euclid = sacMul (sacSet1 (euclidean_weight_), sacAbs (sacSub (sacSqrt (sqr_norm), sacSet1 (r_))));
+
+          SACPacket k = sacMul (sacSub (sacAdd (sacAdd (sacMul (x, dx), sacMul (y, dy)), sacMul (z, dz)), sacSet1 (ptdotdir_)), sacSet1 (dirdotdir_));
+          SACPacket ux = sacSub (x, sacAdd (sacSet1 (px_), sacMul (k, dx)));
+          SACPacket uy = sacSub (y, sacAdd (sacSet1 (py_), sacMul (k, dy)));
+          SACPacket uz = sacSub (z, sacAdd (sacSet1 (pz_), sacMul (k, dz)));
+          SACPacket n_dot_u = sacAdd (sacAdd (sacMul (nx, ux), sacMul (ny, uy)), sacMul (nz, uz));
+          SACPacket n_sqr_norm = sacAdd (sacAdd (sacMul (nx, nx), sacMul (ny, ny)), sacMul (nz, nz));
+          SACPacket u_sqr_norm = sacAdd (sacAdd (sacMul (ux, ux), sacMul (uy, uy)), sacMul (uz, uz));
+          SACPacket cosine = sacDiv (n_dot_u, sacSqrt (sacMul (n_sqr_norm, u_sqr_norm)));
+
+          float d_euclids[SAC_PACKET_SIZE], cosines[SAC_PACKET_SIZE];
+          sacStore (d_euclids, d_euclid);
+          sacStore (cosines, cosine);
+          for (int j = 0; j < SAC_PACKET_SIZE; ++j)
+            if (!(d_euclids[j] >= max_distance_))
+              d_euclids[j] = combine (d_euclids[j], cosines[j]);
+          return (sacLoad (d_euclids));
+        }
+#endif
+
+      private:
+        /** \brief Add the weighted angle between the normal and the cylinder normal, given its cosine. */
+        inline float
+        combine (float d_euclid, float cosine) const
+        {
+          // The sign of the normal does not matter, so this is min (angle, pi - angle)
+          float d_normal = acosf ((std::min) (std::fabs (cosine), 1.0f));
+          return (std::fabs (normal_weight_ * d_normal + d_euclid));
+        }
+
+        const typename PointCloud<PointT>::VectorType &points_;
+        const typename PointCloud<PointNT>::VectorType &normals_;
+        float px_, py_, pz_, dx_, dy_, dz_, r_;
+        float ptdotdir_, dirdotdir_;
+        float normal_weight_, euclidean_weight_;
+        float max_distance_;
+    };
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename PointNT> bool
@@ -128,37 +243,15 @@ pcl::SampleConsensusModelCylinder<PointT, PointNT>::getDistancesToModel (
     return;
   }
 
-  distances.resize (indices_->size ());
-
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
-  Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  float ptdotdir = line_pt.dot (line_dir);
-  float dirdotdir = 1.0f / line_dir.dot (line_dir);
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Aproximate the distance from the point to the cylinder as the difference between
-    // dist(point,cylinder_axis) and cylinder radius
-    // @note need to revise this.
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n  (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-
-    double d_euclid = fabs (pointToLineDistance (pt, model_coefficients) - model_coefficients[6]);
-
-    // Calculate the point's projection on the cylinder axis
-    float k = (pt.dot (line_dir) - ptdotdir) * dirdotdir;
-    Eigen::Vector4f pt_proj = line_pt + k * line_dir;
-    Eigen::Vector4f dir = pt - pt_proj;
-    dir.normalize ();
-
-    // Calculate the angular distance between the point normal and the (dir=pt_proj->pt) vector
-    double d_normal = fabs (getAngle3D (n, dir));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
-
-    distances[i] = fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid);
-  }
+  // Aproximate the distance from each point to the cylinder as the difference between
+  // dist(point,cylinder_axis) and cylinder radius, combined with the angular distance
+  // between the point normal and the (dir=pt_proj->pt) vector
+  // @note need to revise this.
+  detail::sacGetDistances (*indices_, detail::SACCylinderDistance<PointT, PointNT> (
+                             *input_, *normals_, model_coefficients, normal_distance_weight_), distances);
 }
 
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename PointNT> void
 pcl::SampleConsensusModelCylinder<PointT, PointNT>::selectWithinDistance (
@@ -171,42 +264,13 @@ pcl::SampleConsensusModelCylinder<PointT, PointNT>::selectWithinDistance (
     return;
   }
 
-  int nr_p = 0;
-  inliers.resize (indices_->size ());
-
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
-  Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  float ptdotdir = line_pt.dot (line_dir);
-  float dirdotdir = 1.0f / line_dir.dot (line_dir);
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Aproximate the distance from the point to the cylinder as the difference between
-    // dist(point,cylinder_axis) and cylinder radius
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n  (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-    double d_euclid = fabs (pointToLineDistance (pt, model_coefficients) - model_coefficients[6]);
-
-    // Calculate the point's projection on the cylinder axis
-    float k = (pt.dot (line_dir) - ptdotdir) * dirdotdir;
-    Eigen::Vector4f pt_proj = line_pt + k * line_dir;
-    Eigen::Vector4f dir = pt - pt_proj;
-    dir.normalize ();
-
-    // Calculate the angular distance between the point normal and the (dir=pt_proj->pt) vector
-    double d_normal = fabs (getAngle3D (n, dir));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
-
-    if (fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid) < threshold)
-    {
-      // Returns the indices of the points whose distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
-    }
-  }
-  inliers.resize (nr_p);
+  // Returns the indices of the points whose distances to the cylinder are smaller than the threshold
+  detail::sacSelectWithinDistance (*indices_, detail::SACCylinderDistance<PointT, PointNT> (
+                                     *input_, *normals_, model_coefficients, normal_distance_weight_, static_cast<float> (threshold)),
+                                   static_cast<float> (threshold), inliers);
 }
 
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename PointNT> int
 pcl::SampleConsensusModelCylinder<PointT, PointNT>::countWithinDistance (
@@ -216,37 +280,12 @@ pcl::SampleConsensusModelCylinder<PointT, PointNT>::countWithinDistance (
   if (!isModelValid (model_coefficients))
     return (0);
 
-  int nr_p = 0;
-
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
-  Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  float ptdotdir = line_pt.dot (line_dir);
-  float dirdotdir = 1.0f / line_dir.dot (line_dir);
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Aproximate the distance from the point to the cylinder as the difference between
-    // dist(point,cylinder_axis) and cylinder radius
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n  (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-    double d_euclid = fabs (pointToLineDistance (pt, model_coefficients) - model_coefficients[6]);
-
-    // Calculate the point's projection on the cylinder axis
-    float k = (pt.dot (line_dir) - ptdotdir) * dirdotdir;
-    Eigen::Vector4f pt_proj = line_pt + k * line_dir;
-    Eigen::Vector4f dir = pt - pt_proj;
-    dir.normalize ();
-
-    // Calculate the angular distance between the point normal and the (dir=pt_proj->pt) vector
-    double d_normal = fabs (getAngle3D (n, dir));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
-
-    if (fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid) < threshold)
-      nr_p++;
-  }
-  return (nr_p);
+  return (detail::sacCountWithinDistance (*indices_, detail::SACCylinderDistance<PointT, PointNT> (
+                                            *input_, *normals_, model_coefficients, normal_distance_weight_, static_cast<float> (threshold)),
+                                          static_cast<float> (threshold)));
 }
 
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename PointNT> void
 pcl::SampleConsensusModelCylinder<PointT, PointNT>::optimizeModelCoefficients (
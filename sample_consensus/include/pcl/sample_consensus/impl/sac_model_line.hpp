@@ -41,6 +41,59 @@
 #include <pcl/sample_consensus/sac_model_line.h>
 #include <pcl/common/centroid.h>
 #include <pcl/common/concatenate.h>
+#include <pcl/sample_consensus/sac_model_simd.h>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Distance kernel of SampleConsensusModelLine: ||(line_pt - point) x line_dir|| with a unit line_dir. */
+    template <typename PointT>
+    class SACLineDistance
+    {
+      public:
+        SACLineDistance (const PointCloud<PointT> &cloud, const Eigen::VectorXf &model_coefficients)
+          : points_ (cloud.points)
+          , px_ (model_coefficients[0]), py_ (model_coefficients[1]), pz_ (model_coefficients[2])
+        {
+          Eigen::Vector3f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5]);
+          line_dir.normalize ();
+          dx_ = line_dir[0]; dy_ = line_dir[1]; dz_ = line_dir[2];
+        }
+
+        inline float
+        operator () (int index) const
+        {
+          const PointT &p = points_[index];
+          float vx = px_ - p.x, vy = py_ - p.y, vz = pz_ - p.z;
+          float cx = vy * dz_ - vz * dy_, cy = vz * dx_ - vx * dz_, cz = vx * dy_ - vy * dx_;
+          return (sqrtf (cx * cx + cy * cy + cz * cz));
+        }
+
+#ifdef __SSE2__
+        inline SACPacket
+        operator () (const int *indices) const
+        {
+          const float *p[SAC_PACKET_SIZE];
+          for (int j = 0; j < SAC_PACKET_SIZE; ++j)
+            p[j] = &points_[indices[j]].x;
+          SACPacket x, y, z;
+          sacLoadXYZ (p, x, y, z);
+          SACPacket vx = sacSub (sacSet1 (px_), x), vy = sacSub (sacSet1 (py_), y), vz = sacSub (sacSet1 (pz_), z);
+          SACPacket dx = sacSet1 (dx_), dy = sacSet1 (dy_), dz = sacSet1 (dz_);
+          SACPacket cx = sacSub (sacMul (vy, dz), sacMul (vz, dy));
+          SACPacket cy = sacSub (sacMul (vz, dx), sacMul (vx, dz));
+          SACPacket cz = sacSub (sacMul (vx, dy), sacMul (vy, dx));
+          return (sacSqrt (sacAdd (sacAdd (sacMul (cx, cx), sacMul (cy, cy)), sacMul (cz, cz))));
+        }
+#endif
+
+      private:
+        const typename PointCloud<PointT>::VectorType &points_;
+        float px_, py_, pz_, dx_, dy_, dz_;
+    };
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> bool
@@ -91,23 +144,13 @@ pcl::SampleConsensusModelLine<PointT>::getDistancesToModel (
   if (!isModelValid (model_coefficients))
     return;
 
-  distances.resize (indices_->size ());
-
-  // Obtain the line point and direction
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
-  Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  line_dir.normalize ();
-
-  // Iterate through the 3d points and calculate the distances from them to the line
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the line
-    // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
-    // Need to estimate sqrt here to keep MSAC and friends general
-    distances[i] = sqrt ((line_pt - input_->points[(*indices_)[i]].getVector4fMap ()).cross3 (line_dir).squaredNorm ());
-  }
+  // Calculate the distance from each point to the line
+  // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
+  // Need to estimate sqrt here to keep MSAC and friends general
+  detail::sacGetDistances (*indices_, detail::SACLineDistance<PointT> (*input_, model_coefficients), distances);
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SampleConsensusModelLine<PointT>::selectWithinDistance (
@@ -117,33 +160,12 @@ pcl::SampleConsensusModelLine<PointT>::selectWithinDistance (
   if (!isModelValid (model_coefficients))
     return;
 
-  double sqr_threshold = threshold * threshold;
-
-  int nr_p = 0;
-  inliers.resize (indices_->size ());
-
-  // Obtain the line point and direction
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
-  Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  line_dir.normalize ();
-
-  // Iterate through the 3d points and calculate the distances from them to the line
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the line
-    // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
-    double sqr_distance = (line_pt - input_->points[(*indices_)[i]].getVector4fMap ()).cross3 (line_dir).squaredNorm ();
-
-    if (sqr_distance < sqr_threshold)
-    {
-      // Returns the indices of the points whose squared distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
-    }
-  }
-  inliers.resize (nr_p);
+  // Returns the indices of the points whose distances to the line are smaller than the threshold
+  detail::sacSelectWithinDistance (*indices_, detail::SACLineDistance<PointT> (*input_, model_coefficients),
+                                   static_cast<float> (threshold), inliers);
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
 pcl::SampleConsensusModelLine<PointT>::countWithinDistance (
@@ -153,28 +175,11 @@ pcl::SampleConsensusModelLine<PointT>::countWithinDistance (
   if (!isModelValid (model_coefficients))
     return (0);
 
-  double sqr_threshold = threshold * threshold;
-
-  int nr_p = 0;
-
-  // Obtain the line point and direction
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
-  Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  line_dir.normalize ();
-
-  // Iterate through the 3d points and calculate the distances from them to the line
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the line
-    // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
-    double sqr_distance = (line_pt - input_->points[(*indices_)[i]].getVector4fMap ()).cross3 (line_dir).squaredNorm ();
-
-    if (sqr_distance < sqr_threshold)
-      nr_p++;
-  }
-  return (nr_p);
+  return (detail::sacCountWithinDistance (*indices_, detail::SACLineDistance<PointT> (*input_, model_coefficients),
+                                          static_cast<float> (threshold)));
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SampleConsensusModelLine<PointT>::optimizeModelCoefficients (
@@ -42,6 +42,50 @@
 #include <pcl/common/centroid.h>
 #include <pcl/common/eigen.h>
 #include <pcl/common/concatenate.h>
+#include <pcl/sample_consensus/sac_model_simd.h>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Distance kernel of SampleConsensusModelPlane: |a*x + b*y + c*z + d|. */
+    template <typename PointT>
+    class SACPlaneDistance
+    {
+      public:
+        SACPlaneDistance (const PointCloud<PointT> &cloud, const Eigen::VectorXf &model_coefficients)
+          : points_ (cloud.points)
+          , a_ (model_coefficients[0]), b_ (model_coefficients[1])
+          , c_ (model_coefficients[2]), d_ (model_coefficients[3])
+        {}
+
+        inline float
+        operator () (int index) const
+        {
+          const PointT &p = points_[index];
+          return (std::fabs ((a_ * p.x + b_ * p.y) + (c_ * p.z + d_)));
+        }
+
+#ifdef __SSE2__
+        inline SACPacket
+        operator () (const int *indices) const
+        {
+          const float *p[SAC_PACKET_SIZE];
+          for (int j = 0; j < SAC_PACKET_SIZE; ++j)
+            p[j] = &points_[indices[j]].x;
+          SACPacket x, y, z;
+          sacLoadXYZ (p, x, y, z);
+          return (sacAbs (sacAdd (sacAdd (sacMul (sacSet1 (a_), x), sacMul (sacSet1 (b_), y)),
+                                  sacAdd (sacMul (sacSet1 (c_), z), sacSet1 (d_)))));
+        }
+#endif
+
+      private:
+        const typename PointCloud<PointT>::VectorType &points_;
+        float a_, b_, c_, d_;
+    };
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> bool
@@ -115,25 +159,12 @@ pcl::SampleConsensusModelPlane<PointT>::getDistancesToModel (
     return;
   }
 
-  distances.resize (indices_->size ());
-
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    /*distances[i] = fabs (model_coefficients[0] * input_->points[(*indices_)[i]].x +
-                         model_coefficients[1] * input_->points[(*indices_)[i]].y +
-                         model_coefficients[2] * input_->points[(*indices_)[i]].z +
-                         model_coefficients[3]);*/
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x,
-                        input_->points[(*indices_)[i]].y,
-                        input_->points[(*indices_)[i]].z,
-                        1);
-    distances[i] = fabs (model_coefficients.dot (pt));
-  }
+  // Calculate the distance from each point to the plane normal as the dot product
+  // D = (P-A).N/|N|, several points at a time when SIMD instructions are available
+  detail::sacGetDistances (*indices_, detail::SACPlaneDistance<PointT> (*input_, model_coefficients), distances);
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SampleConsensusModelPlane<PointT>::selectWithinDistance (
@@ -146,28 +177,12 @@ pcl::SampleConsensusModelPlane<PointT>::selectWithinDistance (
     return;
   }
 
-  int nr_p = 0;
-  inliers.resize (indices_->size ());
-
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x,
-                        input_->points[(*indices_)[i]].y,
-                        input_->points[(*indices_)[i]].z,
-                        1);
-    if (fabs (model_coefficients.dot (pt)) < threshold)
-    {
-      // Returns the indices of the points whose distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
-    }
-  }
-  inliers.resize (nr_p);
+  // Returns the indices of the points whose distances to the plane are smaller than the threshold
+  detail::sacSelectWithinDistance (*indices_, detail::SACPlaneDistance<PointT> (*input_, model_coefficients),
+                                   static_cast<float> (threshold), inliers);
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
 pcl::SampleConsensusModelPlane<PointT>::countWithinDistance (
@@ -180,23 +195,11 @@ pcl::SampleConsensusModelPlane<PointT>::countWithinDistance (
     return (0);
   }
 
-  int nr_p = 0;
-
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x,
-                        input_->points[(*indices_)[i]].y,
-                        input_->points[(*indices_)[i]].z,
-                        1);
-    if (fabs (model_coefficients.dot (pt)) < threshold)
-      nr_p++;
-  }
-  return (nr_p);
+  return (detail::sacCountWithinDistance (*indices_, detail::SACPlaneDistance<PointT> (*input_, model_coefficients),
+                                          static_cast<float> (threshold)));
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SampleConsensusModelPlane<PointT>::optimizeModelCoefficients (
@@ -40,6 +40,52 @@
 
 #include <pcl/sample_consensus/eigen.h>
 #include <pcl/sample_consensus/sac_model_sphere.h>
+#include <pcl/sample_consensus/sac_model_simd.h>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Distance kernel of SampleConsensusModelSphere: |dist (point, center) - radius|. */
+    template <typename PointT>
+    class SACSphereDistance
+    {
+      public:
+        SACSphereDistance (const PointCloud<PointT> &cloud, const Eigen::VectorXf &model_coefficients)
+          : points_ (cloud.points)
+          , cx_ (model_coefficients[0]), cy_ (model_coefficients[1])
+          , cz_ (model_coefficients[2]), r_ (model_coefficients[3])
+        {}
+
+        inline float
+        operator () (int index) const
+        {
+          const PointT &p = points_[index];
+          float dx = p.x - cx_, dy = p.y - cy_, dz = p.z - cz_;
+          return (std::fabs (sqrtf (dx * dx + dy * dy + dz * dz) - r_));
+        }
+
+#ifdef __SSE2__
+        inline SACPacket
+        operator () (const int *indices) const
+        {
+          const float *p[SAC_PACKET_SIZE];
+          for (int j = 0; j < SAC_PACKET_SIZE; ++j)
+            p[j] = &points_[indices[j]].x;
+          SACPacket x, y, z;
+          sacLoadXYZ (p, x, y, z);
+          SACPacket dx = sacSub (x, sacSet1 (cx_)), dy = sacSub (y, sacSet1 (cy_)), dz = sacSub (z, sacSet1 (cz_));
+          SACPacket sqr_norm = sacAdd (sacAdd (sacMul (dx, dx), sacMul (dy, dy)), sacMul (dz, dz));
+          return (sacAbs (sacSub (sacSqrt (sqr_norm), sacSet1 (r_))));
+        }
+#endif
+
+      private:
+        const typename PointCloud<PointT>::VectorType &points_;
+        float cx_, cy_, cz_, r_;
+    };
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> bool
@@ -126,24 +172,14 @@ pcl::SampleConsensusModelSphere<PointT>::getDistancesToModel (
     distances.clear ();
     return;
   }
-  distances.resize (indices_->size ());
 
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
-    // Calculate the distance from the point to the sphere as the difference between
-    //dist(point,sphere_origin) and sphere_radius
-    distances[i] = fabs (sqrtf (
-                               ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) *
-                               ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) +
-
-                               ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) *
-                               ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) +
-
-                               ( input_->points[(*indices_)[i]].z - model_coefficients[2] ) *
-                               ( input_->points[(*indices_)[i]].z - model_coefficients[2] )
-                               ) - model_coefficients[3]);
+  // Calculate the distance from each point to the sphere as the difference between
+  // dist(point,sphere_origin) and sphere_radius, several points at a time when SIMD
+  // instructions are available
+  detail::sacGetDistances (*indices_, detail::SACSphereDistance<PointT> (*input_, model_coefficients), distances);
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SampleConsensusModelSphere<PointT>::selectWithinDistance (
@@ -156,33 +192,12 @@ pcl::SampleConsensusModelSphere<PointT>::selectWithinDistance (
     return;
   }
 
-  int nr_p = 0;
-  inliers.resize (indices_->size ());
-
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the sphere as the difference between
-    // dist(point,sphere_origin) and sphere_radius
-    if (fabs (sqrtf (
-                    ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) *
-                    ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) +
-
-                    ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) *
-                    ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) +
-
-                    ( input_->points[(*indices_)[i]].z - model_coefficients[2] ) *
-                    ( input_->points[(*indices_)[i]].z - model_coefficients[2] )
-                    ) - model_coefficients[3]) < threshold)
-    {
-      // Returns the indices of the points whose distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
-    }
-  }
-  inliers.resize (nr_p);
+  // Returns the indices of the points whose distances to the sphere are smaller than the threshold
+  detail::sacSelectWithinDistance (*indices_, detail::SACSphereDistance<PointT> (*input_, model_coefficients),
+                                   static_cast<float> (threshold), inliers);
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
 pcl::SampleConsensusModelSphere<PointT>::countWithinDistance (
@@ -192,28 +207,11 @@ pcl::SampleConsensusModelSphere<PointT>::countWithinDistance (
   if (!isModelValid (model_coefficients))
     return (0);
 
-  int nr_p = 0;
-
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the sphere as the difference between
-    // dist(point,sphere_origin) and sphere_radius
-    if (fabs (sqrtf (
-                    ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) *
-                    ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) +
-
-                    ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) *
-                    ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) +
-
-                    ( input_->points[(*indices_)[i]].z - model_coefficients[2] ) *
-                    ( input_->points[(*indices_)[i]].z - model_coefficients[2] )
-                    ) - model_coefficients[3]) < threshold)
-      nr_p++;
-  }
-  return (nr_p);
+  return (detail::sacCountWithinDistance (*indices_, detail::SACSphereDistance<PointT> (*input_, model_coefficients),
+                                          static_cast<float> (threshold)));
 }
 
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SampleConsensusModelSphere<PointT>::optimizeModelCoefficients (
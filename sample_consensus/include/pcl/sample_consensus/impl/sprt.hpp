@@ -0,0 +1,223 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_SAMPLE_CONSENSUS_IMPL_SPRT_H_
+#define PCL_SAMPLE_CONSENSUS_IMPL_SPRT_H_
+
+#include <pcl/sample_consensus/sprt.h>
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> double
+pcl::SPRTSampleConsensus<PointT>::designTest (double epsilon, double delta) const
+{
+  // A bad model has to be less likely to explain a point than a good one
+  if (delta >= epsilon)
+    return (std::numeric_limits<double>::max ());
+
+  // C = (1 - delta) log ((1 - delta) / (1 - epsilon)) + delta log (delta / epsilon)
+  const double c = (1.0 - delta) * log ((1.0 - delta) / (1.0 - epsilon)) + delta * log (delta / epsilon);
+
+  // A is the fixed point of A = t_M * C / m_S + 1 + log (A), with m_S = 1 model per sample
+  const double k = model_estimation_cost_ * c + 1.0;
+  double a = k;
+  for (int i = 0; i < 10; ++i)
+  {
+    double a_next = k + log (a);
+    if (fabs (a_next - a) < 1e-6)
+      break;
+    a = a_next;
+  }
+  return (log (a));
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> double
+pcl::SPRTSampleConsensus<PointT>::computeIterationBound (double epsilon, size_t sample_size, double log_a) const
+{
+  // A good model survives the test with probability 1 - 1/A
+  double p_good = pow (epsilon, static_cast<double> (sample_size));
+  if (log_a < std::numeric_limits<double>::max ())
+    p_good *= 1.0 - exp (-log_a);
+
+  // Compute the k parameter (k=log(z)/log(1-p_good))
+  double p_no_outliers = 1.0 - p_good;
+  p_no_outliers = (std::max) (std::numeric_limits<double>::epsilon (), p_no_outliers);       // Avoid division by -Inf
+  p_no_outliers = (std::min) (1.0 - std::numeric_limits<double>::epsilon (), p_no_outliers);   // Avoid division by 0.
+  return (log (1.0 - probability_) / log (p_no_outliers));
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::SPRTSampleConsensus<PointT>::computeModel (int debug_verbosity_level)
+{
+  // Warn and exit if no threshold was set
+  if (threshold_ == std::numeric_limits<double>::max())
+  {
+    PCL_ERROR ("[pcl::SPRTSampleConsensus::computeModel] No threshold set!\n");
+    return (false);
+  }
+
+  iterations_ = 0;
+  int n_best_inliers_count = -INT_MAX;
+  double k = 1.0;
+
+  std::vector<int> selection;
+  Eigen::VectorXf model_coefficients;
+
+  unsigned skipped_count = 0;
+  // supress infinite loops by just allowing 10 x maximum allowed iterations for invalid model parameters!
+  const unsigned max_skip = max_iterations_ * 10;
+
+  // Split the indices in blocks, in a random order shared by all hypotheses
+  const std::vector<int> &indices = *sac_model_->getIndices ();
+  const size_t block_size = (std::max) (block_size_, 1u);
+  std::vector<int> shuffled_indices (indices);
+  for (size_t i = shuffled_indices.size (); i > 1; --i)
+    std::swap (shuffled_indices[i - 1], shuffled_indices[static_cast<size_t> (static_cast<double> (i) * this->rnd ())]);
+  std::vector<boost::shared_ptr<std::vector<int> > > blocks;
+  for (size_t i = 0; i < shuffled_indices.size (); i += block_size)
+    blocks.push_back (boost::shared_ptr<std::vector<int> > (new std::vector<int> (
+          shuffled_indices.begin () + i, shuffled_indices.begin () + (std::min) (i + block_size, shuffled_indices.size ()))));
+  const double nr_indices = static_cast<double> (indices.size ());
+
+  // Keep delta away from 0, where a single inlier would accept any model
+  const double min_delta = 1.0 / (nr_indices + 1.0);
+  double epsilon = (std::min) (initial_inlier_ratio_, 1.0 - min_delta);
+  double delta = (std::max) (initial_bad_model_inlier_ratio_, min_delta);
+  double log_a = designTest (epsilon, delta);
+  // Until a model is accepted, the number of trials follows from the initial epsilon
+  k = computeIterationBound (epsilon, sac_model_->getSampleSize (), log_a);
+  double delta_sum = 0;
+  int n_rejected = 0;
+  size_t n_verified = 0;
+
+  // Iterate
+  while (iterations_ < k && skipped_count < max_skip)
+  {
+    // Get X samples which satisfy the model criteria
+    sac_model_->getSamples (iterations_, selection);
+
+    if (selection.empty ()) 
+    {
+      PCL_ERROR ("[pcl::SPRTSampleConsensus::computeModel] No samples could be selected!\n");
+      break;
+    }
+
+    // Search for inliers in the point cloud for the current plane model M
+    if (!sac_model_->computeModelCoefficients (selection, model_coefficients))
+    {
+      ++skipped_count;
+      continue;
+    }
+
+    // Verify the hypothesis block by block, accumulating the log likelihood ratio
+    const double log_inlier = log (delta / epsilon);
+    const double log_outlier = log ((1.0 - delta) / (1.0 - epsilon));
+    double log_lambda = 0;
+    int n_inliers_count = 0;
+    size_t n_tested = 0;
+    bool rejected = false;
+    for (size_t b = 0; b < blocks.size () && !rejected; ++b)
+    {
+      int n_block_inliers = sac_model_->countIndicesWithinDistance (model_coefficients, threshold_, blocks[b]);
+      n_inliers_count += n_block_inliers;
+      n_tested += blocks[b]->size ();
+      log_lambda += n_block_inliers * log_inlier + static_cast<double> (blocks[b]->size () - n_block_inliers) * log_outlier;
+      rejected = log_lambda > log_a;
+    }
+    n_verified += n_tested;
+
+    if (rejected)
+    {
+      // The fraction of points consistent with the rejected models estimates delta
+      delta_sum += static_cast<double> (n_inliers_count) / static_cast<double> (n_tested);
+      ++n_rejected;
+      double delta_estimate = (std::max) (delta_sum / n_rejected, min_delta);
+      if (fabs (delta_estimate - delta) > 0.05 * delta)
+      {
+        delta = delta_estimate;
+        log_a = designTest (epsilon, delta);
+        k = computeIterationBound (epsilon, selection.size (), log_a);
+      }
+    }
+    // Better match ?
+    else if (n_inliers_count > n_best_inliers_count)
+    {
+      n_best_inliers_count = n_inliers_count;
+
+      // Save the current model/inlier/coefficients selection as being the best so far
+      model_              = selection;
+      model_coefficients_ = model_coefficients;
+
+      // The best model so far gives the new estimate of epsilon
+      epsilon = (std::min) (static_cast<double> (n_best_inliers_count) / nr_indices, 1.0 - min_delta);
+      log_a = designTest (epsilon, delta);
+      k = computeIterationBound (epsilon, selection.size (), log_a);
+    }
+
+    ++iterations_;
+    if (debug_verbosity_level > 1)
+      PCL_DEBUG ("[pcl::SPRTSampleConsensus::computeModel] Trial %d out of %f: %s after %zu points (best is: %d so far).\n", iterations_, k, rejected ? "rejected" : "accepted", n_tested, n_best_inliers_count);
+    if (iterations_ > max_iterations_)
+    {
+      if (debug_verbosity_level > 0)
+        PCL_DEBUG ("[pcl::SPRTSampleConsensus::computeModel] SPRT reached the maximum number of trials.\n");
+      break;
+    }
+  }
+
+  if (debug_verbosity_level > 0)
+    PCL_DEBUG ("[pcl::SPRTSampleConsensus::computeModel] Model: %zu size, %d inliers, %g points verified per trial (epsilon %f, delta %f).\n",
+               model_.size (), n_best_inliers_count, iterations_ > 0 ? static_cast<double> (n_verified) / iterations_ : 0.0, epsilon, delta);
+
+  if (model_.empty ())
+  {
+    inliers_.clear ();
+    return (false);
+  }
+
+  // Get the set of inliers that correspond to the best model found so far
+  sac_model_->selectWithinDistance (model_coefficients_, threshold_, inliers_);
+  return (true);
+}
+
+#define PCL_INSTANTIATE_SPRTSampleConsensus(T) template class PCL_EXPORTS pcl::SPRTSampleConsensus<T>;
+
+#endif    // PCL_SAMPLE_CONSENSUS_IMPL_SPRT_H_
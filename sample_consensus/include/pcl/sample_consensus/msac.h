@@ -62,6 +62,7 @@ namespace pcl
     using SampleConsensus<PointT>::model_coefficients_;
     using SampleConsensus<PointT>::inliers_;
     using SampleConsensus<PointT>::probability_;
+    using SampleConsensus<PointT>::threads_;
 
     typedef typename SampleConsensusModel<PointT>::Ptr SampleConsensusModelPtr;
 
@@ -89,6 +90,13 @@ namespace pcl
         * \param debug_verbosity_level enable/disable on-screen debug information and set the verbosity level
         */
       bool computeModel (int debug_verbosity_level = 0);
+
+    protected:
+      /** \brief Compute the model with several threads drawing and scoring hypotheses
+        * concurrently. See \ref setNumberOfThreads.
+        * \param debug_verbosity_level enable/disable on-screen debug information and set the verbosity level
+        */
+      bool computeModelParallel (int debug_verbosity_level);
   };
 }
 
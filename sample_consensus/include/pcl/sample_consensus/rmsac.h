@@ -63,6 +63,7 @@ namespace pcl
     using SampleConsensus<PointT>::model_coefficients_;
     using SampleConsensus<PointT>::inliers_;
     using SampleConsensus<PointT>::probability_;
+    using SampleConsensus<PointT>::threads_;
 
     typedef typename SampleConsensusModel<PointT>::Ptr SampleConsensusModelPtr;
 
@@ -101,6 +102,13 @@ namespace pcl
       /** \brief Get the percentage of points to pre-test. */
       inline double getFractionNrPretest () { return (fraction_nr_pretest_); }
 
+    protected:
+      /** \brief Compute the model with several threads drawing and scoring hypotheses
+        * concurrently. See \ref setNumberOfThreads.
+        * \param debug_verbosity_level enable/disable on-screen debug information and set the verbosity level
+        */
+      bool computeModelParallel (int debug_verbosity_level);
+
     private:
       /** \brief Number of samples to randomly pre-test, in percents. */
       double fraction_nr_pretest_;
@@ -77,6 +77,7 @@ namespace pcl
         iterations_ (0), 
         threshold_ (std::numeric_limits<double>::max()),
         max_iterations_ (1000), 
+        threads_ (1), 
         rng_alg_ (), 
         rng_ (new boost::uniform_01<boost::mt19937> (rng_alg_))
       {
@@ -101,6 +102,7 @@ namespace pcl
         iterations_ (0), 
         threshold_ (threshold), 
         max_iterations_ (1000), 
+        threads_ (1), 
         rng_alg_ (), 
         rng_ (new boost::uniform_01<boost::mt19937> (rng_alg_))
       {
@@ -145,6 +147,24 @@ namespace pcl
       inline double 
       getProbability () { return (probability_); }
 
+      /** \brief Set the number of threads that draw and score model hypotheses concurrently.
+        * Honoured by RANSAC, MSAC, RMSAC and LMedS; the other methods always run serially.
+        *
+        * With more than one thread, every thread draws its own samples from a private
+        * random number generator and the best model found so far, together with the
+        * adaptive iteration bound, is shared between them. The underlying model must
+        * then support concurrent calls to computeModelCoefficients, countWithinDistance
+        * and getDistancesToModel, which is the case for all models in PCL. Results are
+        * only repeatable when a single thread is used.
+        * \param[in] nr_threads the number of threads to use (0 automatic, 1 the original serial search)
+        */
+      inline void 
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+      /** \brief Get the number of threads that evaluate model hypotheses, as set by the user. */
+      inline unsigned int 
+      getNumberOfThreads () const { return (threads_); }
+
       /** \brief Compute the actual model. Pure virtual. */
       virtual bool 
       computeModel (int debug_verbosity_level = 0) = 0;
@@ -165,6 +185,24 @@ namespace pcl
           indices_subset.insert ((*indices)[static_cast<int> (static_cast<double>(indices->size ()) * rnd ())]);
       }
 
+      /** \brief Get a set of randomly selected indices, drawing from an external random
+        * number generator so that several threads can sample concurrently.
+        * \param[in] indices the input indices vector
+        * \param[in] nr_samples the desired number of point indices to randomly select
+        * \param[out] indices_subset the resultant output set of randomly selected indices
+        * \param[in,out] rng the random number generator to draw from
+        */
+      inline void
+      getRandomSamples (const boost::shared_ptr <std::vector<int> > &indices, 
+                        size_t nr_samples, 
+                        std::set<int> &indices_subset,
+                        boost::mt19937 &rng) const
+      {
+        indices_subset.clear ();
+        while (indices_subset.size () < nr_samples)
+          indices_subset.insert ((*indices)[rng () % indices->size ()]);
+      }
+
       /** \brief Return the best model found so far. 
         * \param[out] model the resultant model
         */
@@ -208,6 +246,22 @@ namespace pcl
       /** \brief Maximum number of iterations before giving up. */
       int max_iterations_;
 
+      /** \brief The number of threads that evaluate model hypotheses concurrently. */
+      unsigned int threads_;
+
+      /** \brief Draw one seed per thread from the random number generator, for the
+        * private generators of the parallel hypothesis search.
+        * \param[in] nr_threads the number of threads
+        * \param[out] seeds the resultant seeds
+        */
+      inline void
+      getThreadSeeds (int nr_threads, std::vector<boost::uint32_t> &seeds)
+      {
+        seeds.resize (nr_threads);
+        for (int t = 0; t < nr_threads; ++t)
+          seeds[t] = static_cast<boost::uint32_t> (rng_->base () ());
+      }
+
       /** \brief Boost-based random number generator algorithm. */
       boost::mt19937 rng_alg_;
 
@@ -197,6 +197,40 @@ namespace pcl
         samples.clear ();
       }
 
+      /** \brief Get a set of random data samples and return them as point
+        * indices, drawing from an external random number generator.
+        *
+        * Unlike \ref getSamples (int &, std::vector<int> &), this neither modifies the
+        * internal shuffled indices nor the internal generator, so several threads may
+        * call it concurrently, each with its own \a rng.
+        * \param[in,out] rng the random number generator to draw from
+        * \param[out] samples the resultant model samples (empty if no good sample could be drawn)
+        */
+      void
+      getSamples (boost::mt19937 &rng, std::vector<int> &samples) const
+      {
+        if (indices_->size () < getSampleSize ())
+        {
+          samples.clear ();
+          return;
+        }
+
+        samples.resize (getSampleSize ());
+        for (unsigned int iter = 0; iter < max_sample_checks_; ++iter)
+        {
+          // Choose the random indices
+          if (samples_radius_ < std::numeric_limits<double>::epsilon ())
+            drawIndexSample (rng, samples);
+          else
+            drawIndexSampleRadius (rng, samples);
+
+          // If it's a good sample, stop here
+          if (isSampleGood (samples))
+            return;
+        }
+        samples.clear ();
+      }
+
       /** \brief Check whether the given index samples can form a valid model,
         * compute the model coefficients from these samples and store them
         * in model_coefficients. Pure virtual.
@@ -258,6 +292,32 @@ namespace pcl
       countWithinDistance (const Eigen::VectorXf &model_coefficients, 
                            const double threshold) = 0;
 
+      /** \brief Count all the points which respect the given model coefficients
+        * as inliers, considering only a subset of the indices.
+        *
+        * Used by estimators that verify a hypothesis incrementally. The default
+        * implementation temporarily swaps \a indices in for indices_ and calls
+        * \ref countWithinDistance, so every model supports it with its own distance
+        * function, but it must not be called concurrently on the same model.
+        * \param[in] model_coefficients the coefficients of a model that we need to
+        * compute distances to
+        * \param[in] threshold a maximum admissible distance threshold for
+        * determining the inliers from the outliers
+        * \param[in] indices the subset of point indices to test, each also present in indices_
+        * \return the resultant number of inliers
+        */
+      virtual int
+      countIndicesWithinDistance (const Eigen::VectorXf &model_coefficients, 
+                                  const double threshold,
+                                  const boost::shared_ptr<std::vector<int> > &indices)
+      {
+        boost::shared_ptr<std::vector<int> > all_indices = indices_;
+        indices_ = indices;
+        int nr_p = countWithinDistance (model_coefficients, threshold);
+        indices_ = all_indices;
+        return (nr_p);
+      }
+
       /** \brief Create a new point cloud with inliers projected onto the model. Pure virtual.
         * \param[in] inliers the data inliers that we want to project on the model
         * \param[in] model_coefficients the coefficients of a model
@@ -447,6 +507,67 @@ namespace pcl
         std::copy (shuffled_indices_.begin (), shuffled_indices_.begin () + sample_size, sample.begin ());
       }
 
+      /** \brief Fills a sample array with distinct random samples from the indices_ vector,
+        * drawing from \a rng instead of the internal generator.
+        * \param[in,out] rng the random number generator to draw from
+        * \param[out] sample the set of indices of target_ to analyze
+        */
+      inline void
+      drawIndexSample (boost::mt19937 &rng, std::vector<int> &sample) const
+      {
+        size_t sample_size = sample.size ();
+        size_t index_size = indices_->size ();
+        // Draw distinct positions first: rejection sampling is cheaper than shuffling
+        // a private copy of indices_ for the handful of points a model needs
+        for (size_t i = 0; i < sample_size; ++i)
+        {
+          bool unique;
+          do
+          {
+            sample[i] = static_cast<int> (rng () % index_size);
+            unique = true;
+            for (size_t j = 0; j < i && unique; ++j)
+              unique = sample[j] != sample[i];
+          }
+          while (!unique);
+        }
+        for (size_t i = 0; i < sample_size; ++i)
+          sample[i] = (*indices_)[sample[i]];
+      }
+
+      /** \brief Fills a sample array with one random sample from the indices_ vector
+        * and other random samples that are closer than samples_radius_, drawing from
+        * \a rng instead of the internal generator.
+        * \param[in,out] rng the random number generator to draw from
+        * \param[out] sample the set of indices of target_ to analyze
+        */
+      inline void
+      drawIndexSampleRadius (boost::mt19937 &rng, std::vector<int> &sample) const
+      {
+        size_t sample_size = sample.size ();
+        sample[0] = (*indices_)[rng () % indices_->size ()];
+
+        std::vector<int> indices;
+        std::vector<float> sqr_dists;
+
+        samples_radius_search_->radiusSearch (sample[0], samples_radius_,
+                                              indices, sqr_dists );
+
+        if (indices.size () < sample_size - 1)
+        {
+          // radius search failed, make an invalid model
+          for (unsigned int i = 1; i < sample_size; ++i)
+            sample[i] = sample[0];
+        }
+        else
+        {
+          for (unsigned int i = 0; i < sample_size-1; ++i)
+            std::swap (indices[i], indices[i + (rng () % (indices.size () - i))]);
+          for (unsigned int i = 1; i < sample_size; ++i)
+            sample[i] = indices[i-1];
+        }
+      }
+
       /** \brief Check whether a model is valid given the user constraints.
         * \param[in] model_coefficients the set of model coefficients
         */
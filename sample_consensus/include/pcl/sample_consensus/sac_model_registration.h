@@ -172,6 +172,30 @@ namespace pcl
       countWithinDistance (const Eigen::VectorXf &model_coefficients,
                            const double threshold);
 
+      /** \brief Count all the points which respect the given model coefficients as inliers,
+        * considering only a subset of the source indices and their correspondences.
+        * \param[in] model_coefficients the coefficients of a model that we need to compute distances to
+        * \param[in] threshold maximum admissible distance threshold for determining the inliers from the outliers
+        * \param[in] indices the subset of source point indices to test
+        * \return the resultant number of inliers
+        */
+      virtual int
+      countIndicesWithinDistance (const Eigen::VectorXf &model_coefficients,
+                                  const double threshold,
+                                  const boost::shared_ptr<std::vector<int> > &indices)
+      {
+        // The target indices run in parallel to the source ones: subset them as well
+        boost::shared_ptr<std::vector<int> > indices_tgt (new std::vector<int> (indices->size ()));
+        for (size_t i = 0; i < indices->size (); ++i)
+          (*indices_tgt)[i] = correspondences_[(*indices)[i]];
+
+        boost::shared_ptr<std::vector<int> > all_indices_tgt = indices_tgt_;
+        indices_tgt_ = indices_tgt;
+        int nr_p = SampleConsensusModel<PointT>::countIndicesWithinDistance (model_coefficients, threshold, indices);
+        indices_tgt_ = all_indices_tgt;
+        return (nr_p);
+      }
+
       /** \brief Recompute the 4x4 transformation using the given inlier set
         * \param[in] inliers the data inliers found as supporting the model
         * \param[in] model_coefficients the initial guess for the optimization
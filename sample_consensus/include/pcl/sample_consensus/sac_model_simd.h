@@ -0,0 +1,216 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_SAMPLE_CONSENSUS_SAC_MODEL_SIMD_H_
+#define PCL_SAMPLE_CONSENSUS_SAC_MODEL_SIMD_H_
+
+#include <vector>
+#include <cmath>
+#if defined __AVX__
+#include <immintrin.h>
+#elif defined __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace pcl
+{
+  namespace detail
+  {
+    /* Small wrappers around the SSE and AVX intrinsics, so that the distance kernels of the sample
+     * consensus models are written once for packets of 4 (SSE2) or 8 (AVX) points. When neither is
+     * available, only the scalar versions of the kernels are used. */
+#if defined __AVX__
+    typedef __m256 SACPacket;
+    enum { SAC_PACKET_SIZE = 8 };
+
+    inline SACPacket sacSet1 (float a) { return (_mm256_set1_ps (a)); }
+    inline SACPacket sacAdd (SACPacket a, SACPacket b) { return (_mm256_add_ps (a, b)); }
+    inline SACPacket sacSub (SACPacket a, SACPacket b) { return (_mm256_sub_ps (a, b)); }
+    inline SACPacket sacMul (SACPacket a, SACPacket b) { return (_mm256_mul_ps (a, b)); }
+    inline SACPacket sacDiv (SACPacket a, SACPacket b) { return (_mm256_div_ps (a, b)); }
+    inline SACPacket sacSqrt (SACPacket a) { return (_mm256_sqrt_ps (a)); }
+    inline SACPacket sacAbs (SACPacket a) { return (_mm256_andnot_ps (_mm256_set1_ps (-0.0f), a)); }
+    inline void sacStore (float *dst, SACPacket a) { _mm256_storeu_ps (dst, a); }
+    inline SACPacket sacLoad (const float *src) { return (_mm256_loadu_ps (src)); }
+    /** \brief Bit i of the result is set if a[i] < b[i] (false for NaN). */
+    inline int sacLessThan (SACPacket a, SACPacket b) { return (_mm256_movemask_ps (_mm256_cmp_ps (a, b, _CMP_LT_OQ))); }
+
+    /** \brief Load the first three floats pointed to by p[0..7] and transpose them into x, y and z packets.
+      * Each pointer must be followed by a fourth float, as in the points declared with PCL_ADD_POINT4D.
+      */
+    inline void
+    sacLoadXYZ (const float *const *p, SACPacket &x, SACPacket &y, SACPacket &z)
+    {
+      // Lane l of rows r0..r3 holds points l * 4 + 0..3, so the usual 4x4 transpose works per lane
+      __m256 r0 = _mm256_insertf128_ps (_mm256_castps128_ps256 (_mm_loadu_ps (p[0])), _mm_loadu_ps (p[4]), 1);
+      __m256 r1 = _mm256_insertf128_ps (_mm256_castps128_ps256 (_mm_loadu_ps (p[1])), _mm_loadu_ps (p[5]), 1);
+      __m256 r2 = _mm256_insertf128_ps (_mm256_castps128_ps256 (_mm_loadu_ps (p[2])), _mm_loadu_ps (p[6]), 1);
+      __m256 r3 = _mm256_insertf128_ps (_mm256_castps128_ps256 (_mm_loadu_ps (p[3])), _mm_loadu_ps (p[7]), 1);
+      __m256 t0 = _mm256_unpacklo_ps (r0, r1);
+      __m256 t1 = _mm256_unpackhi_ps (r0, r1);
+      __m256 t2 = _mm256_unpacklo_ps (r2, r3);
+      __m256 t3 = _mm256_unpackhi_ps (r2, r3);
+      x = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE (1, 0, 1, 0));
+      y = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE (3, 2, 3, 2));
+      z = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE (1, 0, 1, 0));
+    }
+#elif defined __SSE2__
+    typedef __m128 SACPacket;
+    enum { SAC_PACKET_SIZE = 4 };
+
+    inline SACPacket sacSet1 (float a) { return (_mm_set1_ps (a)); }
+    inline SACPacket sacAdd (SACPacket a, SACPacket b) { return (_mm_add_ps (a, b)); }
+    inline SACPacket sacSub (SACPacket a, SACPacket b) { return (_mm_sub_ps (a, b)); }
+    inline SACPacket sacMul (SACPacket a, SACPacket b) { return (_mm_mul_ps (a, b)); }
+    inline SACPacket sacDiv (SACPacket a, SACPacket b) { return (_mm_div_ps (a, b)); }
+    inline SACPacket sacSqrt (SACPacket a) { return (_mm_sqrt_ps (a)); }
+    inline SACPacket sacAbs (SACPacket a) { return (_mm_andnot_ps (_mm_set1_ps (-0.0f), a)); }
+    inline void sacStore (float *dst, SACPacket a) { _mm_storeu_ps (dst, a); }
+    inline SACPacket sacLoad (const float *src) { return (_mm_loadu_ps (src)); }
+    /** \brief Bit i of the result is set if a[i] < b[i] (false for NaN). */
+    inline int sacLessThan (SACPacket a, SACPacket b) { return (_mm_movemask_ps (_mm_cmplt_ps (a, b))); }
+
+    /** \brief Load the first three floats pointed to by p[0..3] and transpose them into x, y and z packets.
+      * Each pointer must be followed by a fourth float, as in the points declared with PCL_ADD_POINT4D.
+      */
+    inline void
+    sacLoadXYZ (const float *const *p, SACPacket &x, SACPacket &y, SACPacket &z)
+    {
+      __m128 r0 = _mm_loadu_ps (p[0]);
+      __m128 r1 = _mm_loadu_ps (p[1]);
+      __m128 r2 = _mm_loadu_ps (p[2]);
+      __m128 r3 = _mm_loadu_ps (p[3]);
+      _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+      x = r0;
+      y = r1;
+      z = r2;
+    }
+#endif
+
+#ifdef __SSE2__
+    /** \brief Number of bits set in a mask returned by sacLessThan, without branches. */
+    inline int
+    sacCountBits (int mask)
+    {
+      static const int nibble_bits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+      return (nibble_bits[mask & 15] + nibble_bits[(mask >> 4) & 15]);
+    }
+#endif
+
+    /** \brief Count the points whose distance to a model is smaller than a threshold.
+      * \param[in] indices the indices of the points to test
+      * \param[in] distance the distance kernel of the model, called on packets of points when SIMD
+      * instructions are available and on the remaining points one by one
+      * \param[in] threshold the maximum distance
+      */
+    template <typename Distance> inline int
+    sacCountWithinDistance (const std::vector<int> &indices, const Distance &distance, float threshold)
+    {
+      int nr_p = 0;
+      size_t i = 0;
+#ifdef __SSE2__
+      const SACPacket threshold_packet = sacSet1 (threshold);
+      for (; i + SAC_PACKET_SIZE <= indices.size (); i += SAC_PACKET_SIZE)
+        nr_p += sacCountBits (sacLessThan (distance (&indices[i]), threshold_packet));
+#endif
+      for (; i < indices.size (); ++i)
+        if (distance (indices[i]) < threshold)
+          ++nr_p;
+      return (nr_p);
+    }
+
+    /** \brief Select the points whose distance to a model is smaller than a threshold.
+      * \param[in] indices the indices of the points to test
+      * \param[in] distance the distance kernel of the model
+      * \param[in] threshold the maximum distance
+      * \param[out] inliers the indices of the selected points, in the order of \a indices
+      */
+    template <typename Distance> inline void
+    sacSelectWithinDistance (const std::vector<int> &indices, const Distance &distance, float threshold,
+                             std::vector<int> &inliers)
+    {
+      int nr_p = 0;
+      inliers.resize (indices.size ());
+      size_t i = 0;
+#ifdef __SSE2__
+      const SACPacket threshold_packet = sacSet1 (threshold);
+      for (; i + SAC_PACKET_SIZE <= indices.size (); i += SAC_PACKET_SIZE)
+      {
+        // Write every index and only advance past the inliers, which avoids unpredictable branches
+        int mask = sacLessThan (distance (&indices[i]), threshold_packet);
+        for (int j = 0; j < SAC_PACKET_SIZE; ++j)
+        {
+          inliers[nr_p] = indices[i + j];
+          nr_p += (mask >> j) & 1;
+        }
+      }
+#endif
+      for (; i < indices.size (); ++i)
+        if (distance (indices[i]) < threshold)
+          inliers[nr_p++] = indices[i];
+      inliers.resize (nr_p);
+    }
+
+    /** \brief Compute the distances from the points to a model.
+      * \param[in] indices the indices of the points
+      * \param[in] distance the distance kernel of the model
+      * \param[out] distances the resultant distances, in the order of \a indices
+      */
+    template <typename Distance> inline void
+    sacGetDistances (const std::vector<int> &indices, const Distance &distance, std::vector<double> &distances)
+    {
+      distances.resize (indices.size ());
+      size_t i = 0;
+#ifdef __SSE2__
+      float packet_distances[SAC_PACKET_SIZE];
+      for (; i + SAC_PACKET_SIZE <= indices.size (); i += SAC_PACKET_SIZE)
+      {
+        sacStore (packet_distances, distance (&indices[i]));
+        for (int j = 0; j < SAC_PACKET_SIZE; ++j)
+          distances[i + j] = packet_distances[j];
+      }
+#endif
+      for (; i < indices.size (); ++i)
+        distances[i] = distance (indices[i]);
+    }
+  }
+}
+
+#endif  // PCL_SAMPLE_CONSENSUS_SAC_MODEL_SIMD_H_
@@ -0,0 +1,177 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_SAMPLE_CONSENSUS_SPRT_H_
+#define PCL_SAMPLE_CONSENSUS_SPRT_H_
+
+#include <pcl/sample_consensus/sac.h>
+#include <pcl/sample_consensus/sac_model.h>
+
+namespace pcl
+{
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief @b SPRTSampleConsensus represents an implementation of RANSAC with a Sequential Probability Ratio Test
+    * for hypothesis verification, as described in "Optimal Randomized RANSAC", O. Chum and J. Matas, IEEE Trans. on
+    * Pattern Analysis and Machine Intelligence, vol. 30, no. 8, pp. 1472-1482, 2008.
+    *
+    * Instead of counting the inliers of every hypothesis over the whole cloud, the points are verified in blocks, in
+    * a fixed random order, while the likelihood ratio between the "bad model" and the "good model" hypotheses is
+    * accumulated. A hypothesis is abandoned as soon as the ratio exceeds a decision threshold, which is redesigned
+    * whenever the estimates of the inlier ratio (from the best model so far) and of the fraction of points that
+    * are consistent with a bad model (from the rejected hypotheses) change. Only the hypotheses that pass the test
+    * are verified against all points, so most of the cost of verifying bad models is avoided on large clouds.
+    *
+    * \note The models are verified through SampleConsensusModel::countIndicesWithinDistance.
+    * \ingroup sample_consensus
+    */
+  template <typename PointT>
+  class SPRTSampleConsensus : public SampleConsensus<PointT>
+  {
+    using SampleConsensus<PointT>::max_iterations_;
+    using SampleConsensus<PointT>::threshold_;
+    using SampleConsensus<PointT>::iterations_;
+    using SampleConsensus<PointT>::sac_model_;
+    using SampleConsensus<PointT>::model_;
+    using SampleConsensus<PointT>::model_coefficients_;
+    using SampleConsensus<PointT>::inliers_;
+    using SampleConsensus<PointT>::probability_;
+
+    typedef typename SampleConsensusModel<PointT>::Ptr SampleConsensusModelPtr;
+
+    public:
+      /** \brief SPRT RANSAC main constructor
+        * \param model a Sample Consensus model
+        */
+      SPRTSampleConsensus (const SampleConsensusModelPtr &model) : SampleConsensus<PointT> (model),
+                                                                   initial_inlier_ratio_ (0.1),
+                                                                   initial_bad_model_inlier_ratio_ (0.01),
+                                                                   model_estimation_cost_ (200.0),
+                                                                   block_size_ (64)
+      {
+        // Maximum number of trials before we give up.
+        max_iterations_ = 10000;
+      }
+
+      /** \brief SPRT RANSAC main constructor
+        * \param model a Sample Consensus model
+        * \param threshold distance to model threshold
+        */
+      SPRTSampleConsensus (const SampleConsensusModelPtr &model, double threshold) : SampleConsensus<PointT> (model, threshold),
+                                                                                     initial_inlier_ratio_ (0.1),
+                                                                                     initial_bad_model_inlier_ratio_ (0.01),
+                                                                                     model_estimation_cost_ (200.0),
+                                                                                     block_size_ (64)
+      {
+        // Maximum number of trials before we give up.
+        max_iterations_ = 10000;
+      }
+
+      /** \brief Compute the actual model and find the inliers
+        * \param debug_verbosity_level enable/disable on-screen debug information and set the verbosity level
+        */
+      bool computeModel (int debug_verbosity_level = 0);
+
+      /** \brief Set the initial estimate of the fraction of inliers in the data (epsilon). A low value
+        * gives a conservative test until a good model has been found.
+        * \param ratio the initial inlier ratio (default: 0.1)
+        */
+      inline void setInitialInlierRatio (double ratio) { initial_inlier_ratio_ = ratio; }
+
+      /** \brief Get the initial estimate of the fraction of inliers in the data. */
+      inline double getInitialInlierRatio () const { return (initial_inlier_ratio_); }
+
+      /** \brief Set the initial estimate of the fraction of points that are consistent with a bad model (delta).
+        * \param ratio the initial bad model inlier ratio (default: 0.01)
+        */
+      inline void setInitialBadModelInlierRatio (double ratio) { initial_bad_model_inlier_ratio_ = ratio; }
+
+      /** \brief Get the initial estimate of the fraction of points that are consistent with a bad model. */
+      inline double getInitialBadModelInlierRatio () const { return (initial_bad_model_inlier_ratio_); }
+
+      /** \brief Set the cost of computing the model coefficients from a sample, in units of the cost of
+        * verifying a single point against a model.
+        * \param cost the model estimation cost (default: 200)
+        */
+      inline void setModelEstimationCost (double cost) { model_estimation_cost_ = cost; }
+
+      /** \brief Get the cost of computing the model coefficients from a sample. */
+      inline double getModelEstimationCost () const { return (model_estimation_cost_); }
+
+      /** \brief Set the number of points verified between two evaluations of the likelihood ratio.
+        * \param block_size the number of points per block (default: 64)
+        */
+      inline void setBlockSize (unsigned int block_size) { block_size_ = block_size; }
+
+      /** \brief Get the number of points verified between two evaluations of the likelihood ratio. */
+      inline unsigned int getBlockSize () const { return (block_size_); }
+
+    protected:
+      /** \brief Compute the logarithm of the SPRT decision threshold A for the given estimates.
+        * \param[in] epsilon the fraction of inliers in the data
+        * \param[in] delta the fraction of points consistent with a bad model
+        * \return log (A), or std::numeric_limits<double>::max () if the test cannot tell the two apart
+        */
+      double
+      designTest (double epsilon, double delta) const;
+
+      /** \brief Compute the number of trials needed to find a good model with the desired probability.
+        * \param[in] epsilon the fraction of inliers of the best model so far
+        * \param[in] sample_size the number of points needed to compute a model
+        * \param[in] log_a the logarithm of the current SPRT decision threshold
+        */
+      double
+      computeIterationBound (double epsilon, size_t sample_size, double log_a) const;
+
+    private:
+      /** \brief Initial estimate of the fraction of inliers in the data. */
+      double initial_inlier_ratio_;
+
+      /** \brief Initial estimate of the fraction of points consistent with a bad model. */
+      double initial_bad_model_inlier_ratio_;
+
+      /** \brief Cost of computing a model, in point verifications. */
+      double model_estimation_cost_;
+
+      /** \brief Number of points verified between two evaluations of the likelihood ratio. */
+      unsigned int block_size_;
+  };
+}
+
+#endif  //#ifndef PCL_SAMPLE_CONSENSUS_SPRT_H_
@@ -168,6 +168,37 @@ namespace pcl
           return (tree_->radiusSearch (point, radius, k_indices, k_sqr_distances, max_nn));
         }
 
+        /** \brief Search for the k-nearest neighbors of a batch of query points, in parallel. The queries are
+          * bound statically to this search method (see pcl::search::Search::nearestKSearch).
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices of the query points in \a cloud. If empty, all the points are queried.
+          * \param[in] k the number of neighbors to search for
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \param[in] nr_threads if given, the number of threads to use instead of the one set with setNumberOfThreads
+          */
+        virtual void
+        nearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k, Neighborhoods &neighbors,
+                        unsigned int nr_threads = 0) const
+        {
+          this->batchSearch (cloud, indices, typename Search<PointT>::template NearestKQuery<KdTree<PointT> > (*this, k), neighbors, nr_threads);
+        }
+
+        /** \brief Search for all the nearest neighbors of a batch of query points in a given radius, in parallel.
+          * The queries are bound statically to this search method (see pcl::search::Search::radiusSearch).
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices of the query points in \a cloud. If empty, all the points are queried.
+          * \param[in] radius the radius of the sphere bounding all of the neighbors
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \param[in] nr_threads if given, the number of threads to use instead of the one set with setNumberOfThreads
+          */
+        virtual void
+        radiusSearch (const PointCloud &cloud, const std::vector<int> &indices, double radius,
+                      Neighborhoods &neighbors, unsigned int max_nn = 0, unsigned int nr_threads = 0) const
+        {
+          this->batchSearch (cloud, indices, typename Search<PointT>::template RadiusQuery<KdTree<PointT> > (*this, radius, max_nn), neighbors, nr_threads);
+        }
+
       protected:
         /** \brief A pointer to the internal KdTreeFLANN object. */
         KdTreeFLANNPtr tree_;
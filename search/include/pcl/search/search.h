@@ -42,11 +42,52 @@
 
 #include <pcl/point_cloud.h>
 #include <pcl/common/io.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace pcl
 {
   namespace search
   {
+    /** \brief Neighbors of a batch of query points, stored in compressed sparse row (CSR) form.
+      *
+      * The neighbors of the i-th query point are indices[offsets[i]] ... indices[offsets[i+1] - 1], and their
+      * squared distances are stored at the same positions in \a sqr_distances. \a offsets thus holds one more
+      * element than there are query points.
+      * \ingroup search
+      */
+    struct Neighborhoods
+    {
+      Neighborhoods () : offsets (), indices (), sqr_distances () {}
+
+      /** \brief Get the number of query points. */
+      inline size_t
+      size () const { return (offsets.empty () ? 0 : offsets.size () - 1); }
+
+      /** \brief Get the number of neighbors found for a query point.
+        * \param[in] query the position of the query point in the batch
+        */
+      inline int
+      getNumberOfNeighbors (size_t query) const { return (static_cast<int> (offsets[query + 1] - offsets[query])); }
+
+      /** \brief Release all the neighbor lists. */
+      inline void
+      clear ()
+      {
+        offsets.clear ();
+        indices.clear ();
+        sqr_distances.clear ();
+      }
+
+      /** \brief The start of the neighbor list of each query point, plus the total number of neighbors. */
+      std::vector<size_t> offsets;
+      /** \brief The concatenated indices of the neighbors of all query points. */
+      std::vector<int> indices;
+      /** \brief The concatenated squared distances of the neighbors of all query points. */
+      std::vector<float> sqr_distances;
+    };
+
     /** \brief Generic search class. All search wrappers must inherit from this.
       *
       * Each search method must implement 2 different types of search:
@@ -89,6 +130,7 @@ namespace pcl
           , indices_ ()
           , sorted_results_ (sorted)
           , name_ (name)
+          , threads_ (0)
         {
         }
 
@@ -115,7 +157,11 @@ namespace pcl
         {
           sorted_results_ = sorted;
         }
-        
+
+        /** \brief Get whether the results are sorted (ascending in the distance) or not. */
+        inline bool
+        getSortedResults () const { return (sorted_results_); }
+
         /** \brief Pass the input dataset that the search will be performed on.
           * \param[in] cloud a const pointer to the PointCloud data
           * \param[in] indices the point indices subset that is to be used from the cloud
@@ -141,6 +187,16 @@ namespace pcl
           return (indices_);
         }
 
+        /** \brief Set the number of threads used by the batch searches (see \ref Neighborhoods).
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+        /** \brief Get the number of threads used by the batch searches (0 for automatic). */
+        inline unsigned int
+        getNumberOfThreads () const { return (threads_); }
+
         /** \brief Search for the k-nearest neighbors for the given query point.
           * \param[in] point the given query point
           * \param[in] k the number of neighbors to search for
@@ -475,12 +531,138 @@ namespace pcl
           }
         }
 
+        /** \brief Search for the k-nearest neighbors of a batch of query points, using \ref setNumberOfThreads
+          * threads. The results of all the queries are stored in flat buffers, so no memory is allocated per query.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices of the query points in \a cloud. If empty, all the points are queried.
+          * \param[in] k the number of neighbors to search for
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices. Invalid
+          * (i.e., non finite) query points have no neighbors.
+          * \param[in] nr_threads if given, the number of threads to use for this search instead of the one set with
+          * \ref setNumberOfThreads, which is left untouched
+          */
+        virtual void
+        nearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k, Neighborhoods &neighbors,
+                        unsigned int nr_threads = 0) const
+        {
+          batchSearch (cloud, indices, VirtualNearestKQuery (*this, k), neighbors, nr_threads);
+        }
+
+        /** \brief Search for all the nearest neighbors of a batch of query points in a given radius, using
+          * \ref setNumberOfThreads threads. The results of all the queries are stored in flat buffers, so no memory
+          * is allocated per query.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices of the query points in \a cloud. If empty, all the points are queried.
+          * \param[in] radius the radius of the sphere bounding all of the neighbors
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices. Invalid
+          * (i.e., non finite) query points have no neighbors.
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value. If \a max_nn is set to
+          * 0 or to a number higher than the number of points in the input cloud, all neighbors in \a radius will be
+          * returned.
+          * \param[in] nr_threads if given, the number of threads to use for this search instead of the one set with
+          * \ref setNumberOfThreads, which is left untouched
+          */
+        virtual void
+        radiusSearch (const PointCloud &cloud, const std::vector<int> &indices, double radius,
+                      Neighborhoods &neighbors, unsigned int max_nn = 0, unsigned int nr_threads = 0) const
+        {
+          batchSearch (cloud, indices, VirtualRadiusQuery (*this, radius, max_nn), neighbors, nr_threads);
+        }
+
       protected:
+        /** \brief Functor performing a single k-nearest neighbor query for \ref batchSearch. Derived classes
+          * instantiate it with their own type, so that the query is bound statically instead of going through
+          * the virtual \ref nearestKSearch for every point.
+          */
+        template <typename SearchT>
+        struct NearestKQuery
+        {
+          NearestKQuery (const SearchT &search, int k) : search_ (search), k_ (k) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+          {
+            return (search_.SearchT::nearestKSearch (point, k_, k_indices, k_sqr_distances));
+          }
+
+          const SearchT &search_;
+          int k_;
+        };
+
+        /** \brief Functor performing a single radius query for \ref batchSearch, see \ref NearestKQuery. */
+        template <typename SearchT>
+        struct RadiusQuery
+        {
+          RadiusQuery (const SearchT &search, double radius, unsigned int max_nn)
+            : search_ (search), radius_ (radius), max_nn_ (max_nn) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+          {
+            return (search_.SearchT::radiusSearch (point, radius_, k_indices, k_sqr_distances, max_nn_));
+          }
+
+          const SearchT &search_;
+          double radius_;
+          unsigned int max_nn_;
+        };
+
+        /** \brief Functor performing a single k-nearest neighbor query through the virtual \ref nearestKSearch,
+          * used by the generic batch search.
+          */
+        struct VirtualNearestKQuery
+        {
+          VirtualNearestKQuery (const Search<PointT> &search, int k) : search_ (search), k_ (k) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+          {
+            return (search_.nearestKSearch (point, k_, k_indices, k_sqr_distances));
+          }
+
+          const Search<PointT> &search_;
+          int k_;
+        };
+
+        /** \brief Functor performing a single radius query through the virtual \ref radiusSearch, used by the
+          * generic batch search.
+          */
+        struct VirtualRadiusQuery
+        {
+          VirtualRadiusQuery (const Search<PointT> &search, double radius, unsigned int max_nn)
+            : search_ (search), radius_ (radius), max_nn_ (max_nn) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+          {
+            return (search_.radiusSearch (point, radius_, k_indices, k_sqr_distances, max_nn_));
+          }
+
+          const Search<PointT> &search_;
+          double radius_;
+          unsigned int max_nn_;
+        };
+
+        /** \brief Run a query for every point of a batch in parallel and gather the results in CSR form.
+          * Every thread processes a contiguous range of query points into its own flat buffers, reusing the
+          * same scratch vectors for all of its queries; the buffers are then concatenated in query order.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices of the query points in \a cloud. If empty, all the points are queried.
+          * \param[in] query the functor performing a single query
+          * \param[out] neighbors the neighbors of the query points
+          * \param[in] nr_threads the number of threads to use, 0 for the one set with \ref setNumberOfThreads
+          */
+        template <typename QueryT> void
+        batchSearch (const PointCloud &cloud, const std::vector<int> &indices, const QueryT &query,
+                     Neighborhoods &neighbors, unsigned int nr_threads) const;
+
         void sortResults (std::vector<int>& indices, std::vector<float>& distances) const;
         PointCloudConstPtr input_;
         IndicesConstPtr indices_;
         bool sorted_results_;
         std::string name_;
+        /** \brief The number of threads used by the batch searches (0 for automatic). */
+        unsigned int threads_;
         
       private:
         struct Compare
@@ -500,6 +682,63 @@ namespace pcl
     }; // class Search
     
     // implementation
+    template<typename PointT> template <typename QueryT> void
+    Search<PointT>::batchSearch (const PointCloud &cloud, const std::vector<int> &indices, const QueryT &query,
+                                 Neighborhoods &neighbors, unsigned int threads) const
+    {
+      const size_t nr_queries = indices.empty () ? cloud.points.size () : indices.size ();
+      neighbors.offsets.assign (nr_queries + 1, 0);
+
+      int nr_threads = static_cast<int> (threads != 0 ? threads : threads_);
+#ifdef _OPENMP
+      if (nr_threads == 0)
+        nr_threads = omp_get_max_threads ();
+#else
+      nr_threads = 1;
+#endif
+
+      std::vector<std::vector<int> > thread_indices (nr_threads);
+      std::vector<std::vector<float> > thread_sqr_distances (nr_threads);
+
+#pragma omp parallel for num_threads (nr_threads) schedule (static, 1)
+      for (int t = 0; t < nr_threads; ++t)
+      {
+        const size_t begin = nr_queries * t / nr_threads;
+        const size_t end = nr_queries * (t + 1) / nr_threads;
+        std::vector<int> nn_indices;
+        std::vector<float> nn_sqr_distances;
+
+        for (size_t q = begin; q < end; ++q)
+        {
+          const PointT &point = cloud.points[indices.empty () ? q : indices[q]];
+          if (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
+            continue;
+
+          int nr_neighbors = query (point, nn_indices, nn_sqr_distances);
+          size_t nr_found = std::min (static_cast<size_t> (std::max (nr_neighbors, 0)), nn_indices.size ());
+          // Store the counts for now, they are turned into offsets below
+          neighbors.offsets[q + 1] = nr_found;
+          thread_indices[t].insert (thread_indices[t].end (), nn_indices.begin (), nn_indices.begin () + nr_found);
+          thread_sqr_distances[t].insert (thread_sqr_distances[t].end (), nn_sqr_distances.begin (), nn_sqr_distances.begin () + nr_found);
+        }
+      }
+
+      for (size_t q = 0; q < nr_queries; ++q)
+        neighbors.offsets[q + 1] += neighbors.offsets[q];
+      neighbors.indices.resize (neighbors.offsets[nr_queries]);
+      neighbors.sqr_distances.resize (neighbors.offsets[nr_queries]);
+
+#pragma omp parallel for num_threads (nr_threads) schedule (static, 1)
+      for (int t = 0; t < nr_threads; ++t)
+      {
+        const size_t offset = neighbors.offsets[nr_queries * t / nr_threads];
+        std::copy (thread_indices[t].begin (), thread_indices[t].end (), neighbors.indices.begin () + offset);
+        std::copy (thread_sqr_distances[t].begin (), thread_sqr_distances[t].end (), neighbors.sqr_distances.begin () + offset);
+        std::vector<int> ().swap (thread_indices[t]);
+        std::vector<float> ().swap (thread_sqr_distances[t]);
+      }
+    }
+
     template<typename PointT> void
     Search<PointT>::sortResults (std::vector<int>& indices, std::vector<float>& distances) const
     {
@@ -0,0 +1,157 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_SEGMENTATION_CONCURRENT_UNION_FIND_H_
+#define PCL_SEGMENTATION_CONCURRENT_UNION_FIND_H_
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#if defined _MSC_VER
+# include <intrin.h>
+#endif
+
+namespace pcl
+{
+  /** \brief Lock-free disjoint-set forest (union-find) over the integers [0, size).
+    *
+    * find () and unite () can be called concurrently from any number of
+    * threads. Roots are always linked below the smaller one, so that once all
+    * the unions are done the representative of each set is its smallest
+    * element, independently of the order in which the unions were performed.
+    * Paths are compressed with the path halving scheme of Anderson and Woll.
+    *
+    * \ingroup segmentation
+    */
+  class ConcurrentUnionFind
+  {
+    public:
+      /** \brief Constructor.
+        * \param[in] size the number of elements, each one initially in its own set
+        */
+      ConcurrentUnionFind (size_t size = 0) : parent_ ()
+      {
+        reset (size);
+      }
+
+      /** \brief Put each of \a size elements back into its own set.
+        * \param[in] size the number of elements
+        */
+      void
+      reset (size_t size)
+      {
+        parent_.resize (size);
+        for (size_t i = 0; i < size; ++i)
+          parent_[i] = static_cast<int> (i);
+      }
+
+      /** \brief Get the number of elements. */
+      inline size_t
+      size () const
+      {
+        return (parent_.size ());
+      }
+
+      /** \brief Get the representative of the set containing \a x, halving the path to it.
+        * \param[in] x the element
+        */
+      inline int
+      find (int x)
+      {
+        while (true)
+        {
+          int parent = load (x);
+          if (parent == x)
+            return (x);
+          int grand_parent = load (parent);
+          // If another thread changed parent_[x] meanwhile it still points to an ancestor
+          if (grand_parent != parent)
+            compareAndSwap (&parent_[x], parent, grand_parent);
+          x = grand_parent;
+        }
+      }
+
+      /** \brief Merge the sets containing \a a and \a b.
+        * \param[in] a the first element
+        * \param[in] b the second element
+        * \return true if the two elements were in different sets
+        */
+      inline bool
+      unite (int a, int b)
+      {
+        while (true)
+        {
+          a = find (a);
+          b = find (b);
+          if (a == b)
+            return (false);
+          if (a < b)
+            std::swap (a, b);
+          // Only succeeds if a is still a root
+          if (compareAndSwap (&parent_[a], a, b))
+            return (true);
+        }
+      }
+
+    private:
+      /** \brief Read the parent of \a x, bypassing any value cached by the compiler. */
+      inline int
+      load (int x) const
+      {
+        return (*static_cast<const volatile int*> (&parent_[x]));
+      }
+
+      /** \brief Atomically replace *ptr by \a desired if it equals \a expected. */
+      static inline bool
+      compareAndSwap (int *ptr, int expected, int desired)
+      {
+#if defined _MSC_VER
+        return (_InterlockedCompareExchange (reinterpret_cast<volatile long*> (ptr), desired, expected) == expected);
+#else
+        return (__sync_bool_compare_and_swap (ptr, expected, desired));
+#endif
+      }
+
+      /** \brief The parent of each element (roots are their own parent). */
+      std::vector<int> parent_;
+  };
+}
+
+#endif  // PCL_SEGMENTATION_CONCURRENT_UNION_FIND_H_
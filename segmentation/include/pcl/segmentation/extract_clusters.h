@@ -81,6 +81,34 @@ namespace pcl
       const boost::shared_ptr<search::Search<PointT> > &tree, float tolerance, std::vector<PointIndices> &clusters, 
       unsigned int min_pts_per_cluster = 1, unsigned int max_pts_per_cluster = (std::numeric_limits<int>::max) ());
 
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief Decompose a region of space into clusters based on the Euclidean distance between points, using
+    * several threads.
+    *
+    * The radius searches are distributed over the threads, and the neighbors found are merged into connected
+    * components with a lock-free union-find structure instead of growing one cluster at a time. The resultant
+    * clusters are identical to the ones of the serial extractEuclideanClusters, in the same order, as long as
+    * the search method returns sorted results (the serial version assumes the first neighbor is the query).
+    *
+    * \param cloud the point cloud message
+    * \param indices a list of point indices to use from \a cloud
+    * \param tree the spatial locator (e.g., kd-tree) used for nearest neighbors searching
+    * \note the tree has to be created as a spatial locator on \a cloud and \a indices, and has to support
+    * concurrent searches
+    * \param tolerance the spatial cluster tolerance as a measure in L2 Euclidean space
+    * \param clusters the resultant clusters containing point indices (as a vector of PointIndices)
+    * \param min_pts_per_cluster minimum number of points that a cluster may contain (default: 1)
+    * \param max_pts_per_cluster maximum number of points that a cluster may contain (default: max int)
+    * \param nr_threads the number of threads to use (default: 0, all available cores)
+    * \ingroup segmentation
+    */
+  template <typename PointT> void 
+  extractEuclideanClustersParallel (
+      const PointCloud<PointT> &cloud, const std::vector<int> &indices, 
+      const boost::shared_ptr<search::Search<PointT> > &tree, float tolerance, std::vector<PointIndices> &clusters, 
+      unsigned int min_pts_per_cluster = 1, unsigned int max_pts_per_cluster = (std::numeric_limits<int>::max) (),
+      unsigned int nr_threads = 0);
+
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   /** \brief Decompose a region of space into clusters based on the euclidean distance between points, and the normal
     * angular deviation
@@ -312,7 +340,8 @@ namespace pcl
       EuclideanClusterExtraction () : tree_ (), 
                                       cluster_tolerance_ (0),
                                       min_pts_per_cluster_ (1), 
-                                      max_pts_per_cluster_ (std::numeric_limits<int>::max ())
+                                      max_pts_per_cluster_ (std::numeric_limits<int>::max ()),
+                                      threads_ (1)
       {};
 
       /** \brief Provide a pointer to the search object.
@@ -381,6 +410,24 @@ namespace pcl
         return (max_pts_per_cluster_); 
       }
 
+      /** \brief Set the number of threads to use. With more than one thread the clusters are extracted with
+        * extractEuclideanClustersParallel, which gives the same result when the search method returns sorted
+        * results. The search method has to support concurrent searches.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
+      /** \brief Get the number of threads to use (default: 1). */
+      inline unsigned int
+      getNumberOfThreads () const
+      {
+        return (threads_);
+      }
+
       /** \brief Cluster extraction in a PointCloud given by <setInputCloud (), setIndices ()>
         * \param[out] clusters the resultant point clusters
         */
@@ -406,6 +453,9 @@ namespace pcl
       /** \brief The maximum number of points that a cluster needs to contain in order to be considered valid (default = MAXINT). */
       int max_pts_per_cluster_;
 
+      /** \brief The number of threads the scheduler should use (default = 1). */
+      unsigned int threads_;
+
       /** \brief Class getName method. */
       virtual std::string getClassName () const { return ("EuclideanClusterExtraction"); }
 
@@ -0,0 +1,182 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_SEGMENTATION_EXTRACT_VOXEL_CLUSTERS_H_
+#define PCL_SEGMENTATION_EXTRACT_VOXEL_CLUSTERS_H_
+
+#include <pcl/pcl_base.h>
+#include <pcl/segmentation/extract_clusters.h>
+
+namespace pcl
+{
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief @b VoxelEuclideanClusterExtraction is a fast alternative to EuclideanClusterExtraction for large,
+    * sparse clouds such as lidar scans.
+    *
+    * Instead of a radius search per point, the points are binned in a hashed voxel grid whose leaf size is the
+    * cluster tolerance, so that two points closer than the tolerance always lie in the same or in adjacent voxels.
+    * The clusters are then the connected components of the occupied voxels, where two adjacent voxels are
+    * connected as soon as one pair of their points is within the tolerance. The memory used is linear in the
+    * number of points.
+    *
+    * In approximate mode (the default), all the points that share a voxel are put in the same cluster without
+    * checking their distance, which can merge points up to sqrt(3) times the tolerance apart. With
+    * setApproximate (false) the points of a voxel are connected pairwise as well, and the result is the same as
+    * the one of EuclideanClusterExtraction.
+    *
+    * \ingroup segmentation
+    */
+  template <typename PointT>
+  class VoxelEuclideanClusterExtraction: public PCLBase<PointT>
+  {
+    typedef PCLBase<PointT> BasePCLBase;
+
+    public:
+      typedef pcl::PointCloud<PointT> PointCloud;
+      typedef typename PointCloud::Ptr PointCloudPtr;
+      typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+      typedef PointIndices::Ptr PointIndicesPtr;
+      typedef PointIndices::ConstPtr PointIndicesConstPtr;
+
+      /** \brief Empty constructor. */
+      VoxelEuclideanClusterExtraction () : cluster_tolerance_ (0),
+                                           min_pts_per_cluster_ (1),
+                                           max_pts_per_cluster_ (std::numeric_limits<int>::max ()),
+                                           approximate_ (true)
+      {};
+
+      /** \brief Set the spatial cluster tolerance as a measure in the L2 Euclidean space. This is also the
+        * leaf size of the voxel grid.
+        * \param[in] tolerance the spatial cluster tolerance as a measure in the L2 Euclidean space
+        */
+      inline void 
+      setClusterTolerance (double tolerance) 
+      { 
+        cluster_tolerance_ = tolerance; 
+      }
+
+      /** \brief Get the spatial cluster tolerance as a measure in the L2 Euclidean space. */
+      inline double 
+      getClusterTolerance () const 
+      { 
+        return (cluster_tolerance_); 
+      }
+
+      /** \brief Set the minimum number of points that a cluster needs to contain in order to be considered valid.
+        * \param[in] min_cluster_size the minimum cluster size
+        */
+      inline void 
+      setMinClusterSize (int min_cluster_size) 
+      { 
+        min_pts_per_cluster_ = min_cluster_size; 
+      }
+
+      /** \brief Get the minimum number of points that a cluster needs to contain in order to be considered valid. */
+      inline int 
+      getMinClusterSize () const 
+      { 
+        return (min_pts_per_cluster_); 
+      }
+
+      /** \brief Set the maximum number of points that a cluster needs to contain in order to be considered valid.
+        * \param[in] max_cluster_size the maximum cluster size
+        */
+      inline void 
+      setMaxClusterSize (int max_cluster_size) 
+      { 
+        max_pts_per_cluster_ = max_cluster_size; 
+      }
+
+      /** \brief Get the maximum number of points that a cluster needs to contain in order to be considered valid. */
+      inline int 
+      getMaxClusterSize () const 
+      { 
+        return (max_pts_per_cluster_); 
+      }
+
+      /** \brief Set whether the points that share a voxel are clustered together without checking their distance.
+        * \param[in] approximate false to also check the distances inside a voxel, which gives exact Euclidean
+        * clusters (default: true)
+        */
+      inline void
+      setApproximate (bool approximate)
+      {
+        approximate_ = approximate;
+      }
+
+      /** \brief Get whether the points that share a voxel are clustered together without checking their distance. */
+      inline bool
+      getApproximate () const
+      {
+        return (approximate_);
+      }
+
+      /** \brief Cluster extraction in a PointCloud given by <setInputCloud (), setIndices ()>
+        * \param[out] clusters the resultant point clusters, sorted by decreasing size
+        */
+      void 
+      extract (std::vector<PointIndices> &clusters);
+
+    protected:
+      // Members derived from the base class
+      using BasePCLBase::input_;
+      using BasePCLBase::indices_;
+      using BasePCLBase::initCompute;
+      using BasePCLBase::deinitCompute;
+
+      /** \brief The spatial cluster tolerance as a measure in the L2 Euclidean space. */
+      double cluster_tolerance_;
+
+      /** \brief The minimum number of points that a cluster needs to contain in order to be considered valid (default = 1). */
+      int min_pts_per_cluster_;
+
+      /** \brief The maximum number of points that a cluster needs to contain in order to be considered valid (default = MAXINT). */
+      int max_pts_per_cluster_;
+
+      /** \brief Whether the points that share a voxel are clustered without checking their distance (default = true). */
+      bool approximate_;
+
+      /** \brief Class getName method. */
+      virtual std::string getClassName () const { return ("VoxelEuclideanClusterExtraction"); }
+  };
+}
+
+#endif  //#ifndef PCL_SEGMENTATION_EXTRACT_VOXEL_CLUSTERS_H_
@@ -39,6 +39,11 @@
 #define PCL_SEGMENTATION_IMPL_EXTRACT_CLUSTERS_H_
 
 #include <pcl/segmentation/extract_clusters.h>
+#include <pcl/segmentation/concurrent_union_find.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
@@ -198,6 +203,81 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::extractEuclideanClustersParallel (const PointCloud<PointT> &cloud, 
+                                       const std::vector<int> &indices,
+                                       const boost::shared_ptr<search::Search<PointT> > &tree,
+                                       float tolerance, std::vector<PointIndices> &clusters,
+                                       unsigned int min_pts_per_cluster, 
+                                       unsigned int max_pts_per_cluster,
+                                       unsigned int nr_threads)
+{
+  if (tree->getInputCloud ()->points.size () != cloud.points.size ())
+  {
+    PCL_ERROR ("[pcl::extractEuclideanClustersParallel] Tree built for a different point cloud dataset (%zu) than the input cloud (%zu)!\n", tree->getInputCloud ()->points.size (), cloud.points.size ());
+    return;
+  }
+  if (tree->getIndices () && tree->getIndices ()->size () != indices.size ())
+  {
+    PCL_ERROR ("[pcl::extractEuclideanClustersParallel] Tree built for a different set of indices (%zu) than the input set (%zu)!\n", tree->getIndices ()->size (), indices.size ());
+    return;
+  }
+
+#ifdef _OPENMP
+  int threads = nr_threads != 0 ? static_cast<int> (nr_threads) : omp_get_max_threads ();
+#else
+  int threads = 1;
+  (void)nr_threads;
+#endif
+
+  // Connect every point to its neighbors. The order in which the threads merge the
+  // components does not matter, the root of each one ends up being its smallest index
+  ConcurrentUnionFind components (cloud.points.size ());
+#pragma omp parallel num_threads (threads)
+  {
+    std::vector<int> nn_indices;
+    std::vector<float> nn_distances;
+#pragma omp for schedule (dynamic, 256)
+    for (int i = 0; i < static_cast<int> (indices.size ()); ++i)
+    {
+      if (tree->radiusSearch (cloud.points[indices[i]], tolerance, nn_indices, nn_distances) <= 0)
+        continue;
+
+      for (size_t j = 0; j < nn_indices.size (); ++j)
+        if (nn_indices[j] != -1 && nn_indices[j] != indices[i])
+          components.unite (indices[i], nn_indices[j]);
+    }
+  }
+
+  // Number the components in the order in which the serial region growing would find their seed
+  std::vector<int> cluster_of_root (cloud.points.size (), -1);
+  std::vector<PointIndices> components_indices;
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    int root = components.find (indices[i]);
+    if (cluster_of_root[root] == -1)
+    {
+      cluster_of_root[root] = static_cast<int> (components_indices.size ());
+      components_indices.push_back (PointIndices ());
+    }
+    components_indices[cluster_of_root[root]].indices.push_back (indices[i]);
+  }
+
+  // If the clusters are satisfactory, add them to the output
+  for (size_t c = 0; c < components_indices.size (); ++c)
+  {
+    std::vector<int> &r = components_indices[c].indices;
+    std::sort (r.begin (), r.end ());
+    r.erase (std::unique (r.begin (), r.end ()), r.end ());
+    if (r.size () < min_pts_per_cluster || r.size () > max_pts_per_cluster)
+      continue;
+
+    components_indices[c].header = cloud.header;
+    clusters.push_back (components_indices[c]);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -224,7 +304,10 @@ pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clu
 
   // Send the input dataset to the spatial locator
   tree_->setInputCloud (input_, indices_);
-  extractEuclideanClusters (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_);
+  if (threads_ == 1)
+    extractEuclideanClusters (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_);
+  else
+    extractEuclideanClustersParallel (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_, threads_);
 
   //tree_->setInputCloud (input_);
   //extractEuclideanClusters (*input_, tree_, cluster_tolerance_, clusters, min_pts_per_cluster_, max_pts_per_cluster_);
@@ -237,6 +320,7 @@ pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clu
 
 #define PCL_INSTANTIATE_EuclideanClusterExtraction(T) template class PCL_EXPORTS pcl::EuclideanClusterExtraction<T>;
 #define PCL_INSTANTIATE_extractEuclideanClusters(T) template void PCL_EXPORTS pcl::extractEuclideanClusters<T>(const pcl::PointCloud<T> &, const boost::shared_ptr<pcl::search::Search<T> > &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int);
+#define PCL_INSTANTIATE_extractEuclideanClustersParallel(T) template void PCL_EXPORTS pcl::extractEuclideanClustersParallel<T>(const pcl::PointCloud<T> &, const std::vector<int> &, const boost::shared_ptr<pcl::search::Search<T> > &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int, unsigned int);
 #define PCL_INSTANTIATE_extractEuclideanClusters_indices(T) template void PCL_EXPORTS pcl::extractEuclideanClusters<T>(const pcl::PointCloud<T> &, const std::vector<int> &, const boost::shared_ptr<pcl::search::Search<T> > &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int);
 
 #endif        // PCL_EXTRACT_CLUSTERS_IMPL_H_
@@ -0,0 +1,232 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_SEGMENTATION_IMPL_EXTRACT_VOXEL_CLUSTERS_H_
+#define PCL_SEGMENTATION_IMPL_EXTRACT_VOXEL_CLUSTERS_H_
+
+#include <pcl/segmentation/extract_voxel_clusters.h>
+#include <pcl/segmentation/concurrent_union_find.h>
+#include <pcl/segmentation/boost.h>
+#include <pcl/common/common.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void 
+pcl::VoxelEuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clusters)
+{
+  clusters.clear ();
+  if (!initCompute () || 
+      (input_ != 0   && input_->points.empty ()) ||
+      (indices_ != 0 && indices_->empty ()))
+    return;
+
+  if (cluster_tolerance_ <= 0)
+  {
+    PCL_ERROR ("[pcl::%s::extract] Invalid cluster tolerance (%f)!\n", getClassName ().c_str (), cluster_tolerance_);
+    deinitCompute ();
+    return;
+  }
+
+  const std::vector<int> &indices = *indices_;
+  const int nr_points = static_cast<int> (indices.size ());
+
+  // Get the bounding box of the finite points, which gives the dimensions of the grid
+  Eigen::Vector4f min_p, max_p;
+  getMinMax3D<PointT> (*input_, indices, min_p, max_p);
+  if (min_p[0] > max_p[0])
+  {
+    deinitCompute ();
+    return;
+  }
+
+  const double inverse_tolerance = 1.0 / cluster_tolerance_;
+  const uint64_t div_x = static_cast<uint64_t> (std::floor ((max_p[0] - min_p[0]) * inverse_tolerance)) + 1;
+  const uint64_t div_y = static_cast<uint64_t> (std::floor ((max_p[1] - min_p[1]) * inverse_tolerance)) + 1;
+  const uint64_t div_z = static_cast<uint64_t> (std::floor ((max_p[2] - min_p[2]) * inverse_tolerance)) + 1;
+  if (static_cast<double> (div_x) * static_cast<double> (div_y) * static_cast<double> (div_z) >
+      static_cast<double> (std::numeric_limits<uint64_t>::max ()))
+  {
+    PCL_WARN ("[pcl::%s::extract] Cluster tolerance is too small for the input dataset. Integer indices would overflow.\n", getClassName ().c_str ());
+    deinitCompute ();
+    return;
+  }
+  const uint64_t div_xy = div_x * div_y;
+
+  // Hash the occupied voxels, numbering them in order of first appearance
+  boost::unordered_map<uint64_t, int> voxel_map;
+  std::vector<uint64_t> voxel_keys;
+  std::vector<int> point_voxel (nr_points, -1);
+  for (int i = 0; i < nr_points; ++i)
+  {
+    const PointT &p = input_->points[indices[i]];
+    if (!input_->is_dense && (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z)))
+      continue;
+
+    uint64_t x = std::min (static_cast<uint64_t> ((p.x - min_p[0]) * inverse_tolerance), div_x - 1);
+    uint64_t y = std::min (static_cast<uint64_t> ((p.y - min_p[1]) * inverse_tolerance), div_y - 1);
+    uint64_t z = std::min (static_cast<uint64_t> ((p.z - min_p[2]) * inverse_tolerance), div_z - 1);
+    uint64_t key = x + y * div_x + z * div_xy;
+
+    std::pair<boost::unordered_map<uint64_t, int>::iterator, bool> voxel = 
+      voxel_map.insert (std::make_pair (key, static_cast<int> (voxel_keys.size ())));
+    if (voxel.second)
+      voxel_keys.push_back (key);
+    point_voxel[i] = voxel.first->second;
+  }
+
+  // Group the points of each voxel contiguously (counting sort), keeping their order in indices
+  const int nr_voxels = static_cast<int> (voxel_keys.size ());
+  std::vector<int> voxel_begin (nr_voxels + 1, 0);
+  for (int i = 0; i < nr_points; ++i)
+    if (point_voxel[i] != -1)
+      ++voxel_begin[point_voxel[i] + 1];
+  for (int v = 0; v < nr_voxels; ++v)
+    voxel_begin[v + 1] += voxel_begin[v];
+  std::vector<int> voxel_points (voxel_begin.back ());
+  std::vector<int> voxel_fill (voxel_begin.begin (), voxel_begin.end () - 1);
+  for (int i = 0; i < nr_points; ++i)
+    if (point_voxel[i] != -1)
+      voxel_points[voxel_fill[point_voxel[i]]++] = i;
+
+  const float sqr_tolerance = static_cast<float> (cluster_tolerance_ * cluster_tolerance_);
+  ConcurrentUnionFind components (nr_points);
+  for (int v = 0; v < nr_voxels; ++v)
+  {
+    const int begin = voxel_begin[v], end = voxel_begin[v + 1];
+
+    // Connect the points inside the voxel
+    if (approximate_)
+    {
+      for (int a = begin + 1; a < end; ++a)
+        components.unite (voxel_points[begin], voxel_points[a]);
+    }
+    else
+    {
+      for (int a = begin; a < end; ++a)
+      {
+        const PointT &pa = input_->points[indices[voxel_points[a]]];
+        for (int b = a + 1; b < end; ++b)
+          if ((pa.getVector3fMap () - input_->points[indices[voxel_points[b]]].getVector3fMap ()).squaredNorm () <= sqr_tolerance)
+            components.unite (voxel_points[a], voxel_points[b]);
+      }
+    }
+
+    // Connect the voxel to the 13 neighbors that come after it, the 13 others do the same with it
+    const int64_t x = static_cast<int64_t> (voxel_keys[v] % div_x);
+    const int64_t y = static_cast<int64_t> ((voxel_keys[v] / div_x) % div_y);
+    const int64_t z = static_cast<int64_t> (voxel_keys[v] / div_xy);
+    for (int dz = 0; dz <= 1; ++dz)
+    {
+      for (int dy = (dz == 0 ? 0 : -1); dy <= 1; ++dy)
+      {
+        for (int dx = (dz == 0 && dy == 0 ? 1 : -1); dx <= 1; ++dx)
+        {
+          if (x + dx < 0 || x + dx >= static_cast<int64_t> (div_x) ||
+              y + dy < 0 || y + dy >= static_cast<int64_t> (div_y) ||
+              z + dz >= static_cast<int64_t> (div_z))
+            continue;
+
+          uint64_t key = static_cast<uint64_t> (x + dx) + static_cast<uint64_t> (y + dy) * div_x + static_cast<uint64_t> (z + dz) * div_xy;
+          boost::unordered_map<uint64_t, int>::const_iterator neighbor = voxel_map.find (key);
+          if (neighbor == voxel_map.end ())
+            continue;
+          const int n_begin = voxel_begin[neighbor->second], n_end = voxel_begin[neighbor->second + 1];
+
+          // In approximate mode, a single pair within the tolerance merges the two voxels
+          if (approximate_ && components.find (voxel_points[begin]) == components.find (voxel_points[n_begin]))
+            continue;
+          bool connected = false;
+          for (int a = begin; a < end && !connected; ++a)
+          {
+            const PointT &pa = input_->points[indices[voxel_points[a]]];
+            for (int b = n_begin; b < n_end; ++b)
+            {
+              if ((pa.getVector3fMap () - input_->points[indices[voxel_points[b]]].getVector3fMap ()).squaredNorm () > sqr_tolerance)
+                continue;
+              components.unite (voxel_points[a], voxel_points[b]);
+              if (approximate_)
+              {
+                connected = true;
+                break;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Number the clusters in order of first appearance in indices
+  std::vector<int> cluster_of_root (nr_points, -1);
+  std::vector<PointIndices> components_indices;
+  for (int i = 0; i < nr_points; ++i)
+  {
+    if (point_voxel[i] == -1)
+      continue;
+    int root = components.find (i);
+    if (cluster_of_root[root] == -1)
+    {
+      cluster_of_root[root] = static_cast<int> (components_indices.size ());
+      components_indices.push_back (PointIndices ());
+    }
+    components_indices[cluster_of_root[root]].indices.push_back (indices[i]);
+  }
+
+  // If the clusters are satisfactory, add them to the output
+  for (size_t c = 0; c < components_indices.size (); ++c)
+  {
+    std::vector<int> &r = components_indices[c].indices;
+    std::sort (r.begin (), r.end ());
+    r.erase (std::unique (r.begin (), r.end ()), r.end ());
+    if (static_cast<int> (r.size ()) < min_pts_per_cluster_ || static_cast<int> (r.size ()) > max_pts_per_cluster_)
+      continue;
+
+    components_indices[c].header = input_->header;
+    clusters.push_back (components_indices[c]);
+  }
+
+  // Sort the clusters based on their size (largest one first)
+  std::sort (clusters.rbegin (), clusters.rend (), comparePointClusters);
+
+  deinitCompute ();
+}
+
+#define PCL_INSTANTIATE_VoxelEuclideanClusterExtraction(T) template class PCL_EXPORTS pcl::VoxelEuclideanClusterExtraction<T>;
+
+#endif        // PCL_SEGMENTATION_IMPL_EXTRACT_VOXEL_CLUSTERS_H_
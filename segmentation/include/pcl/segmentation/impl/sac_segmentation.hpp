@@ -49,6 +49,7 @@
 #include <pcl/sample_consensus/rmsac.h>
 #include <pcl/sample_consensus/rransac.h>
 #include <pcl/sample_consensus/prosac.h>
+#include <pcl/sample_consensus/sprt.h>
 
 // Sample Consensus models
 #include <pcl/sample_consensus/sac_model.h>
@@ -307,6 +308,12 @@ pcl::SACSegmentation<PointT>::initSAC (const int method_type)
       sac_.reset (new ProgressiveSampleConsensus<PointT> (model_, threshold_));
       break;
     }
+    case SAC_SPRT:
+    {
+      PCL_DEBUG ("[pcl::%s::initSAC] Using a method of type: SAC_SPRT with a model threshold of %f\n", getClassName ().c_str (), threshold_);
+      sac_.reset (new SPRTSampleConsensus<PointT> (model_, threshold_));
+      break;
+    }
   }
   // Set the Sample Consensus parameters if they are given/changed
   if (sac_->getProbability () != probability_)
@@ -319,6 +326,11 @@ pcl::SACSegmentation<PointT>::initSAC (const int method_type)
     PCL_DEBUG ("[pcl::%s::initSAC] Setting the maximum number of iterations to %d\n", getClassName ().c_str (), max_iterations_);
     sac_->setMaxIterations (max_iterations_);
   }
+  if (sac_->getNumberOfThreads () != threads_)
+  {
+    PCL_DEBUG ("[pcl::%s::initSAC] Setting the number of threads to %u\n", getClassName ().c_str (), threads_);
+    sac_->setNumberOfThreads (threads_);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -85,7 +85,7 @@ namespace pcl
                             radius_min_ (-std::numeric_limits<double>::max()), radius_max_ (std::numeric_limits<double>::max()), 
                             samples_radius_ (0.0), samples_radius_search_ (),
                             eps_angle_ (0.0),
-                            axis_ (Eigen::Vector3f::Zero ()), max_iterations_ (50), probability_ (0.99)
+                            axis_ (Eigen::Vector3f::Zero ()), max_iterations_ (50), probability_ (0.99), threads_ (1)
       {
         //srand ((unsigned)time (0)); // set a random seed
       }
@@ -151,6 +151,17 @@ namespace pcl
       inline double 
       getProbability () const { return (probability_); }
 
+      /** \brief Set the number of threads that evaluate model hypotheses concurrently. Used
+        * by the SAC_RANSAC, SAC_MSAC, SAC_RMSAC and SAC_LMEDS methods.
+        * \param[in] nr_threads the number of threads to use (0 automatic, 1 serial)
+        */
+      inline void 
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+      /** \brief Get the number of threads that evaluate model hypotheses. */
+      inline unsigned int 
+      getNumberOfThreads () const { return (threads_); }
+
       /** \brief Set to true if a coefficient refinement is required.
         * \param[in] optimize true for enabling model coefficient refinement, false otherwise
         */
@@ -283,6 +294,9 @@ namespace pcl
       /** \brief Desired probability of choosing at least one sample free from outliers (user given parameter). */
       double probability_;
 
+      /** \brief The number of threads that evaluate model hypotheses (user given parameter). */
+      unsigned int threads_;
+
       /** \brief Class get name method. */
       virtual std::string 
       getClassName () const { return ("SACSegmentation"); }
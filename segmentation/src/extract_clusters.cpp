@@ -41,6 +41,8 @@
 #include <pcl/point_types.h>
 #include <pcl/segmentation/extract_clusters.h>
 #include <pcl/segmentation/impl/extract_clusters.hpp>
+#include <pcl/segmentation/extract_voxel_clusters.h>
+#include <pcl/segmentation/impl/extract_voxel_clusters.hpp>
 #include <pcl/segmentation/extract_labeled_clusters.h>
 #include <pcl/segmentation/impl/extract_labeled_clusters.hpp>
 
@@ -49,10 +51,14 @@
   PCL_INSTANTIATE(EuclideanClusterExtraction, (pcl::PointXYZ)(pcl::PointXYZI)(pcl::PointXYZRGBA)(pcl::PointXYZRGB))
   PCL_INSTANTIATE(extractEuclideanClusters, (pcl::PointXYZ)(pcl::PointXYZI)(pcl::PointXYZRGBA)(pcl::PointXYZRGB))
   PCL_INSTANTIATE(extractEuclideanClusters_indices, (pcl::PointXYZ)(pcl::PointXYZI)(pcl::PointXYZRGBA)(pcl::PointXYZRGB))
+  PCL_INSTANTIATE(extractEuclideanClustersParallel, (pcl::PointXYZ)(pcl::PointXYZI)(pcl::PointXYZRGBA)(pcl::PointXYZRGB))
+  PCL_INSTANTIATE(VoxelEuclideanClusterExtraction, (pcl::PointXYZ)(pcl::PointXYZI)(pcl::PointXYZRGBA)(pcl::PointXYZRGB))
 #else
   PCL_INSTANTIATE(EuclideanClusterExtraction, PCL_XYZ_POINT_TYPES)
   PCL_INSTANTIATE(extractEuclideanClusters, PCL_XYZ_POINT_TYPES)
   PCL_INSTANTIATE(extractEuclideanClusters_indices, PCL_XYZ_POINT_TYPES)
+  PCL_INSTANTIATE(extractEuclideanClustersParallel, PCL_XYZ_POINT_TYPES)
+  PCL_INSTANTIATE(VoxelEuclideanClusterExtraction, PCL_XYZ_POINT_TYPES)
 #endif
 PCL_INSTANTIATE(LabeledEuclideanClusterExtraction, PCL_XYZL_POINT_TYPES)
 PCL_INSTANTIATE(extractLabeledEuclideanClusters, PCL_XYZL_POINT_TYPES)
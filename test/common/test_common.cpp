@@ -1035,6 +1035,63 @@ TEST (PCL, computeMeanAndCovariance)
   EXPECT_EQ (covariance_matrix (2, 2), 1);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, computeMeanAndCovarianceVectorized)
+{
+  PointCloud<PointXYZ> cloud;
+  PointXYZ point;
+  std::vector <int> indices;
+  Eigen::Matrix3f covariance_matrix;
+  Eigen::Vector4f centroid;
+
+  // test only invalid points
+  point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN ();
+  cloud.push_back (point);
+  cloud.is_dense = false;
+  indices.push_back (0);
+  EXPECT_EQ (computeMeanAndCovarianceMatrixVectorized (cloud, indices, covariance_matrix, centroid), 0);
+  cloud.clear ();
+  indices.clear ();
+
+  // eight points around (1000, 1000, 1000), far enough from the origin to break the plain single pass in float
+  for (point.x = 999; point.x < 1002; point.x += 2)
+    for (point.y = 999; point.y < 1002; point.y += 2)
+      for (point.z = 999; point.z < 1002; point.z += 2)
+        cloud.push_back (point);
+  point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN ();
+  cloud.push_back (point);
+  cloud.is_dense = false;
+  for (int i = 8; i >= 0; --i)
+    indices.push_back (i);
+
+  EXPECT_EQ (computeMeanAndCovarianceMatrixVectorized (cloud, indices, covariance_matrix, centroid), 8);
+  EXPECT_EQ (centroid [0], 1000);
+  EXPECT_EQ (centroid [1], 1000);
+  EXPECT_EQ (centroid [2], 1000);
+  EXPECT_EQ (centroid [3], 0);
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      EXPECT_EQ (covariance_matrix (i, j), i == j ? 1 : 0);
+
+  // matches the two pass computation on the points with positive y values
+  indices.resize (4);
+  indices [0] = 2;
+  indices [1] = 3;
+  indices [2] = 6;
+  indices [3] = 7;
+  Eigen::Matrix3f covariance_matrix_two_pass;
+  Eigen::Vector4f centroid_two_pass;
+  compute3DCentroid (cloud, indices, centroid_two_pass);
+  computeCovarianceMatrixNormalized (cloud, indices, centroid_two_pass, covariance_matrix_two_pass);
+  EXPECT_EQ (computeMeanAndCovarianceMatrixVectorized (cloud, indices, covariance_matrix, centroid), 4);
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ (centroid [i], centroid_two_pass [i]);
+    for (int j = 0; j < 3; ++j)
+      EXPECT_EQ (covariance_matrix (i, j), covariance_matrix_two_pass (i, j));
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, CopyIfFieldExists)
 {
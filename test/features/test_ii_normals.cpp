@@ -490,6 +490,171 @@ TEST (PCL, IINormalEstimationSimple3DGradient)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IntegralImageThreadsAndSinglePrecision)
+{
+  const unsigned width = 640;
+  const unsigned height = 480;
+  const unsigned element_stride = 4;
+  const unsigned row_stride = width * element_stride;
+  float* data = new float[row_stride * height];
+  for (unsigned yIdx = 0; yIdx < height; ++yIdx)
+  {
+    for (unsigned xIdx = 0; xIdx < width; ++xIdx)
+    {
+      float* val = data + (yIdx * row_stride + xIdx * element_stride);
+      val[0] = 0.01f * static_cast<float> ((xIdx * 7 + yIdx * 13) % 101);
+      val[1] = 0.5f + 0.001f * static_cast<float> (yIdx);
+      val[2] = (xIdx % 17 == 3 && yIdx % 11 == 5) ? std::numeric_limits<float>::quiet_NaN () : 1.0f;
+      val[3] = 0.0f;
+    }
+  }
+
+  IntegralImage2D<float, 3> serial (true);
+  IntegralImage2D<float, 3> parallel (true);
+  IntegralImage2D<float, 3> single (true);
+  serial.setNumberOfThreads (1);
+  parallel.setNumberOfThreads (4);
+  single.setSinglePrecision (true);
+  EXPECT_TRUE (single.getSinglePrecision ());
+  serial.setInput (data, width, height, element_stride, row_stride);
+  parallel.setInput (data, width, height, element_stride, row_stride);
+  single.setInput (data, width, height, element_stride, row_stride);
+
+  for (unsigned yIdx = 0; yIdx < height - 9; yIdx += 7)
+  {
+    for (unsigned xIdx = 0; xIdx < width - 9; xIdx += 5)
+    {
+      // the result must not depend on the number of threads
+      EXPECT_EQ (serial.getFiniteElementsCount (xIdx, yIdx, 9, 9), parallel.getFiniteElementsCount (xIdx, yIdx, 9, 9));
+      EXPECT_EQ (serial.getFiniteElementsCount (xIdx, yIdx, 9, 9), single.getFiniteElementsCount (xIdx, yIdx, 9, 9));
+      IntegralImage2D<float, 3>::ElementType sum = serial.getFirstOrderSum (xIdx, yIdx, 9, 9);
+      IntegralImage2D<float, 3>::ElementType parallel_sum = parallel.getFirstOrderSum (xIdx, yIdx, 9, 9);
+      IntegralImage2D<float, 3>::ElementType single_sum = single.getFirstOrderSum (xIdx, yIdx, 9, 9);
+      IntegralImage2D<float, 3>::SecondOrderType so_sum = serial.getSecondOrderSum (xIdx, yIdx, 9, 9);
+      IntegralImage2D<float, 3>::SecondOrderType parallel_so_sum = parallel.getSecondOrderSum (xIdx, yIdx, 9, 9);
+      for (int i = 0; i < 3; ++i)
+      {
+        EXPECT_EQ (sum[i], parallel_sum[i]);
+        EXPECT_NEAR (sum[i], single_sum[i], 1e-1);
+      }
+      for (int i = 0; i < 6; ++i)
+        EXPECT_EQ (so_sum[i], parallel_so_sum[i]);
+    }
+  }
+
+  // a smaller input after a bigger one has to use its own dimensions
+  const unsigned small_width = 320;
+  const unsigned small_height = 240;
+  IntegralImage2D<float, 1> integral_image (false);
+  integral_image.setInput (data, width, height, element_stride, row_stride);
+  integral_image.setInput (data, small_width, small_height, element_stride, row_stride);
+  double ground_truth = 0;
+  for (unsigned yIdx = 0; yIdx < small_height; ++yIdx)
+    for (unsigned xIdx = 0; xIdx < small_width; ++xIdx)
+      ground_truth += data[yIdx * row_stride + xIdx * element_stride];
+  EXPECT_NEAR (ground_truth, integral_image.getFirstOrderSum (0, 0, small_width, small_height), 1e-6);
+  EXPECT_EQ (small_width * small_height, integral_image.getFiniteElementsCount (0, 0, small_width, small_height));
+
+  delete[] data;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IINormalEstimationOpenMP)
+{
+  PointCloud<PointXYZ>::Ptr surface (new PointCloud<PointXYZ>);
+  surface->width = 320;
+  surface->height = 240;
+  surface->points.resize (surface->width * surface->height);
+  for (unsigned v = 0; v < surface->height; ++v)
+  {
+    for (unsigned u = 0; u < surface->width; ++u)
+    {
+      PointXYZ &point = (*surface) (u, v);
+      point.z = 2.0f + 0.1f * sinf (0.05f * static_cast<float> (u)) * cosf (0.07f * static_cast<float> (v));
+      // a step and a hole, to get depth changes into the distance map
+      if (u > 200)
+        point.z += 0.5f;
+      if (u > 100 && u < 110 && v > 50 && v < 70)
+        point.z = std::numeric_limits<float>::quiet_NaN ();
+      point.x = (static_cast<float> (u) - 160.0f) * point.z / 525.0f;
+      point.y = (static_cast<float> (v) - 120.0f) * point.z / 525.0f;
+    }
+  }
+
+  IntegralImageNormalEstimation<PointXYZ, Normal>::NormalEstimationMethod methods[] =
+  {
+    ne.COVARIANCE_MATRIX, ne.AVERAGE_3D_GRADIENT, ne.AVERAGE_DEPTH_CHANGE, ne.SIMPLE_3D_GRADIENT
+  };
+
+  for (int method = 0; method < 4; ++method)
+  {
+    for (int policy = 0; policy < 2; ++policy)
+    {
+      // the mirror border policy does not support SIMPLE_3D_GRADIENT
+      if (policy == 1 && methods[method] == ne.SIMPLE_3D_GRADIENT)
+        continue;
+      for (int depth_dependent = 0; depth_dependent < 2; ++depth_dependent)
+      {
+        PointCloud<Normal> serial_output, parallel_output;
+        IntegralImageNormalEstimation<PointXYZ, Normal> serial, parallel;
+        serial.setNumberOfThreads (1);
+        parallel.setNumberOfThreads (4);
+        serial.setNormalEstimationMethod (methods[method]);
+        parallel.setNormalEstimationMethod (methods[method]);
+        serial.setBorderPolicy (policy == 0 ? serial.BORDER_POLICY_IGNORE : serial.BORDER_POLICY_MIRROR);
+        parallel.setBorderPolicy (policy == 0 ? parallel.BORDER_POLICY_IGNORE : parallel.BORDER_POLICY_MIRROR);
+        serial.setDepthDependentSmoothing (depth_dependent == 1);
+        parallel.setDepthDependentSmoothing (depth_dependent == 1);
+        serial.setInputCloud (surface);
+        parallel.setInputCloud (surface);
+        serial.compute (serial_output);
+        parallel.compute (parallel_output);
+
+        ASSERT_EQ (serial_output.points.size (), parallel_output.points.size ());
+        int nr_finite = 0;
+        for (size_t i = 0; i < serial_output.points.size (); ++i)
+        {
+          const Normal &s = serial_output.points[i];
+          const Normal &p = parallel_output.points[i];
+          EXPECT_EQ (pcl_isfinite (s.normal_x), pcl_isfinite (p.normal_x));
+          if (!pcl_isfinite (s.normal_x))
+            continue;
+          ++nr_finite;
+          EXPECT_EQ (s.normal_x, p.normal_x);
+          EXPECT_EQ (s.normal_y, p.normal_y);
+          EXPECT_EQ (s.normal_z, p.normal_z);
+          EXPECT_EQ (pcl_isfinite (s.curvature), pcl_isfinite (p.curvature));
+          if (pcl_isfinite (s.curvature))
+            EXPECT_EQ (s.curvature, p.curvature);
+        }
+        EXPECT_GT (nr_finite, 0);
+
+        for (size_t i = 0; i < serial_output.points.size (); ++i)
+          EXPECT_EQ (serial.getDistanceMap ()[i], parallel.getDistanceMap ()[i]);
+      }
+    }
+  }
+
+  // single precision integral images, as recommended for the gradient method
+  PointCloud<Normal> double_output, single_output;
+  IntegralImageNormalEstimation<PointXYZ, Normal> single;
+  single.setNormalEstimationMethod (single.AVERAGE_3D_GRADIENT);
+  single.setInputCloud (surface);
+  single.compute (double_output);
+  single.setSinglePrecisionIntegralImages (true);
+  single.setInputCloud (surface);
+  single.compute (single_output);
+  for (size_t i = 0; i < double_output.points.size (); ++i)
+  {
+    if (!pcl_isfinite (double_output.points[i].normal_x) || !pcl_isfinite (single_output.points[i].normal_x))
+      continue;
+    EXPECT_NEAR (double_output.points[i].normal_x, single_output.points[i].normal_x, 1e-3);
+    EXPECT_NEAR (double_output.points[i].normal_y, single_output.points[i].normal_y, 1e-3);
+    EXPECT_NEAR (double_output.points[i].normal_z, single_output.points[i].normal_z, 1e-3);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, IINormalEstimationSimple3DGradientUnorganized)
 {
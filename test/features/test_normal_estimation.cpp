@@ -176,6 +176,60 @@ TEST (PCL, NormalEstimationOpenMP)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NormalEstimationVectorizedCovariance)
+{
+  PointCloud<PointXYZ>::Ptr cloudptr = cloud.makeShared ();
+  PointCloud<Normal> normals, normals_vectorized, normals_omp_vectorized;
+
+  NormalEstimation<PointXYZ, Normal> n;
+  n.setInputCloud (cloudptr);
+  n.setSearchMethod (tree);
+  n.setKSearch (10);
+  n.compute (normals);
+  EXPECT_FALSE (n.getUseVectorizedCovariance ());
+  n.setUseVectorizedCovariance (true);
+  EXPECT_TRUE (n.getUseVectorizedCovariance ());
+  n.compute (normals_vectorized);
+
+  NormalEstimationOMP<PointXYZ, Normal> n_omp (4);
+  n_omp.setInputCloud (cloudptr);
+  n_omp.setSearchMethod (tree);
+  n_omp.setKSearch (10);
+  n_omp.setUseVectorizedCovariance (true);
+  n_omp.compute (normals_omp_vectorized);
+
+  ASSERT_EQ (normals_vectorized.points.size (), normals.points.size ());
+  ASSERT_EQ (normals_omp_vectorized.points.size (), normals.points.size ());
+  for (size_t i = 0; i < normals.points.size (); ++i)
+  {
+    for (int d = 0; d < 3; ++d)
+    {
+      EXPECT_NEAR (normals_vectorized.points[i].normal[d], normals.points[i].normal[d], 1e-3);
+      EXPECT_EQ (normals_omp_vectorized.points[i].normal[d], normals_vectorized.points[i].normal[d]);
+    }
+    EXPECT_NEAR (normals_vectorized.points[i].curvature, normals.points[i].curvature, 1e-3);
+    EXPECT_EQ (normals_omp_vectorized.points[i].curvature, normals_vectorized.points[i].curvature);
+  }
+
+  // Far away from the origin, the vectorized covariance keeps the accuracy of the normals
+  PointCloud<PointXYZ>::Ptr translated (new PointCloud<PointXYZ> (cloud));
+  for (size_t i = 0; i < translated->points.size (); ++i)
+    translated->points[i].getVector3fMap () += Eigen::Vector3f (10.0f, -10.0f, 5.0f);
+  search::KdTree<PointXYZ>::Ptr translated_tree (new search::KdTree<PointXYZ> (false));
+  translated_tree->setInputCloud (translated);
+  n.setInputCloud (translated);
+  n.setViewPoint (10.0f, -10.0f, 5.0f);
+  n.setSearchMethod (translated_tree);
+  n.compute (normals_vectorized);
+  for (size_t i = 0; i < normals.points.size (); ++i)
+  {
+    for (int d = 0; d < 3; ++d)
+      EXPECT_NEAR (normals_vectorized.points[i].normal[d], normals.points[i].normal[d], 1e-3);
+    EXPECT_NEAR (normals_vectorized.points[i].curvature, normals.points[i].curvature, 1e-3);
+  }
+}
+
 #ifndef PCL_ONLY_CORE_POINT_TYPES
   /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   TEST (PCL, NormalEstimationEigen)
@@ -263,6 +263,64 @@ TEST (PCL, PFHEstimation)
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PairFeatureBatch)
+{
+  // Estimate normals first
+  NormalEstimation<PointXYZ, Normal> n;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  n.setInputCloud (cloud.makeShared ());
+  n.setSearchMethod (tree);
+  n.setKSearch (10);
+  n.compute (*normals);
+
+  // An odd number of targets, so that both the vectorized loop and the remainder are used, plus degenerate pairs
+  const int p_idx = 0;
+  PairFeatureBatch batch;
+  for (int q_idx = 0; q_idx < 103; ++q_idx)
+    batch.push_back (cloud.points[q_idx], normals->points[q_idx]);
+  batch.push_back (cloud.points[p_idx], normals->points[p_idx]);
+  PointXYZ along_normal;
+  along_normal.getVector3fMap () = cloud.points[p_idx].getVector3fMap () + normals->points[p_idx].getNormalVector3fMap ();
+  batch.push_back (along_normal, normals->points[p_idx]);
+
+  int nr_valid = batch.compute (cloud.points[p_idx].getVector4fMap (), normals->points[p_idx].getNormalVector4fMap ());
+  ASSERT_EQ (batch.size (), batch.f1.size ());
+  ASSERT_EQ (batch.size (), batch.valid.size ());
+
+  int nr_expected = 0;
+  for (size_t i = 0; i < batch.size (); ++i)
+  {
+    PointXYZ q (batch.x[i], batch.y[i], batch.z[i]);
+    Normal nq (batch.normal_x[i], batch.normal_y[i], batch.normal_z[i]);
+    float f1, f2, f3, f4;
+    bool valid = computePairFeatures (cloud.points[p_idx].getVector4fMap (), normals->points[p_idx].getNormalVector4fMap (),
+                                      q.getVector4fMap (), nq.getNormalVector4fMap (), f1, f2, f3, f4);
+    EXPECT_EQ (valid, batch.valid[i] != 0);
+    nr_expected += valid;
+    if (!valid)
+    {
+      EXPECT_EQ (batch.f1[i], 0.0f);
+      EXPECT_EQ (batch.f2[i], 0.0f);
+      EXPECT_EQ (batch.f3[i], 0.0f);
+      EXPECT_EQ (batch.f4[i], 0.0f);
+      continue;
+    }
+    EXPECT_NEAR (batch.f1[i], f1, 1e-5);
+    EXPECT_NEAR (batch.f2[i], f2, 1e-5);
+    EXPECT_NEAR (batch.f3[i], f3, 1e-5);
+    EXPECT_NEAR (batch.f4[i], f4, 1e-6);
+  }
+  EXPECT_EQ (nr_valid, nr_expected);
+  EXPECT_EQ (batch.valid[103], 0);
+  EXPECT_EQ (batch.valid[104], 0);
+
+  // The batch is reused without reallocating its inputs
+  batch.clear ();
+  EXPECT_EQ (batch.size (), 0);
+  EXPECT_EQ (batch.compute (cloud.points[p_idx].getVector4fMap (), normals->points[p_idx].getNormalVector4fMap ()), 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, FPFHEstimation)
 {
   // Estimate normals first
@@ -497,6 +555,102 @@ TEST (PCL, FPFHEstimationOpenMP)
 
   testIndicesAndSearchSurface<FPFHEstimationOMP<PointXYZ, Normal, FPFHSignature33>, PointXYZ, Normal, FPFHSignature33>
   (cloud.makeShared (), normals, test_indices, 33);
+
+  // The parallel estimation gives the same signatures as the serial one
+  FPFHEstimation<PointXYZ, Normal, FPFHSignature33> fpfh_serial;
+  fpfh_serial.setInputNormals (normals);
+  fpfh_serial.setInputCloud (cloud.makeShared ());
+  fpfh_serial.setSearchMethod (tree);
+  PointCloud<FPFHSignature33> fpfhs_serial;
+  fpfh.setIndices (boost::shared_ptr<vector<int> > ());
+  for (int k = 0; k < 2; ++k)
+  {
+    if (k == 0)
+    {
+      fpfh.setKSearch (10);
+      fpfh_serial.setKSearch (10);
+    }
+    else
+    {
+      fpfh.setKSearch (0);
+      fpfh.setRadiusSearch (0.01);
+      fpfh_serial.setKSearch (0);
+      fpfh_serial.setRadiusSearch (0.01);
+    }
+    fpfh.compute (*fpfhs);
+    fpfh_serial.compute (fpfhs_serial);
+    ASSERT_EQ (fpfhs->points.size (), fpfhs_serial.points.size ());
+    for (size_t i = 0; i < fpfhs->points.size (); ++i)
+      for (int d = 0; d < 33; ++d)
+        if (pcl_isfinite (fpfhs_serial.points[i].histogram[d]))
+          EXPECT_EQ (fpfhs->points[i].histogram[d], fpfhs_serial.points[i].histogram[d]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, SearchNeighborhoods)
+{
+  // One batch search feeds both the normal and the FPFH estimation
+  boost::shared_ptr<search::Neighborhoods> neighborhoods (new search::Neighborhoods);
+  tree->radiusSearch (cloud, vector<int> (), 0.01, *neighborhoods);
+  ASSERT_EQ (neighborhoods->size (), cloud.points.size ());
+
+  NormalEstimation<PointXYZ, Normal> n;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ()), normals_cached (new PointCloud<Normal> ());
+  n.setInputCloud (cloud.makeShared ());
+  n.setSearchMethod (tree);
+  n.setRadiusSearch (0.01);
+  n.compute (*normals);
+  n.setSearchNeighborhoods (neighborhoods);
+  EXPECT_EQ (n.getSearchNeighborhoods (), neighborhoods);
+  n.compute (*normals_cached);
+  ASSERT_EQ (normals_cached->points.size (), normals->points.size ());
+  for (size_t i = 0; i < normals->points.size (); ++i)
+  {
+    for (int d = 0; d < 3; ++d)
+      if (pcl_isfinite (normals->points[i].normal[d]))
+        EXPECT_EQ (normals_cached->points[i].normal[d], normals->points[i].normal[d]);
+    if (pcl_isfinite (normals->points[i].curvature))
+      EXPECT_EQ (normals_cached->points[i].curvature, normals->points[i].curvature);
+  }
+
+  FPFHEstimation<PointXYZ, Normal, FPFHSignature33> fpfh;
+  PointCloud<FPFHSignature33> fpfhs, fpfhs_cached;
+  fpfh.setInputCloud (cloud.makeShared ());
+  fpfh.setInputNormals (normals);
+  fpfh.setSearchMethod (tree);
+  fpfh.setRadiusSearch (0.01);
+  fpfh.compute (fpfhs);
+  fpfh.setSearchNeighborhoods (neighborhoods);
+  fpfh.compute (fpfhs_cached);
+  ASSERT_EQ (fpfhs_cached.points.size (), fpfhs.points.size ());
+  for (size_t i = 0; i < fpfhs.points.size (); ++i)
+    for (int d = 0; d < 33; ++d)
+      if (pcl_isfinite (fpfhs.points[i].histogram[d]))
+        EXPECT_EQ (fpfhs_cached.points[i].histogram[d], fpfhs.points[i].histogram[d]);
+
+  FPFHEstimationOMP<PointXYZ, Normal, FPFHSignature33> fpfh_omp (2);
+  fpfh_omp.setInputCloud (cloud.makeShared ());
+  fpfh_omp.setInputNormals (normals);
+  fpfh_omp.setSearchMethod (tree);
+  fpfh_omp.setRadiusSearch (0.01);
+  fpfh_omp.setSearchNeighborhoods (neighborhoods);
+  fpfh_omp.compute (fpfhs_cached);
+  ASSERT_EQ (fpfhs_cached.points.size (), fpfhs.points.size ());
+  for (size_t i = 0; i < fpfhs.points.size (); ++i)
+    for (int d = 0; d < 33; ++d)
+      if (pcl_isfinite (fpfhs.points[i].histogram[d]))
+        EXPECT_EQ (fpfhs_cached.points[i].histogram[d], fpfhs.points[i].histogram[d]);
+
+  // Neighborhoods that do not cover the input cloud are ignored
+  boost::shared_ptr<search::Neighborhoods> partial (new search::Neighborhoods);
+  vector<int> half (indices.begin (), indices.begin () + indices.size () / 2);
+  tree->radiusSearch (cloud, half, 0.01, *partial);
+  n.setSearchNeighborhoods (partial);
+  n.compute (*normals_cached);
+  for (size_t i = 0; i < normals->points.size (); ++i)
+    if (pcl_isfinite (normals->points[i].normal[0]))
+      EXPECT_EQ (normals_cached->points[i].normal[0], normals->points[i].normal[0]);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
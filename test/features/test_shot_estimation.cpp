@@ -897,6 +897,72 @@ TEST (PCL,SHOTShapeAndColorEstimationOpenMP)
   testSHOTLocalReferenceFrame<SHOTColorEstimationOMP<PointXYZRGBA, Normal, SHOT1344>, PointXYZRGBA, Normal, SHOT1344> (cloudWithColors.makeShared (), normals, test_indices);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, SHOTShapeEstimationOpenMPSharedSearchAndLookupTable)
+{
+  // Estimate normals first
+  double mr = 0.002;
+  NormalEstimationOMP<PointXYZ, Normal> n;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  n.setInputCloud (cloud.makeShared ());
+  n.setSearchMethod (tree);
+  n.setRadiusSearch (20 * mr);
+  n.compute (*normals);
+
+  // Serial reference, estimating the frames with its own search
+  SHOTEstimation<PointXYZ, Normal, SHOT352> shot;
+  shot.setInputNormals (normals);
+  shot.setInputCloud (cloud.makeShared ());
+  shot.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  shot.setRadiusSearch (20 * mr);
+  PointCloud<SHOT352> shots;
+  shot.compute (shots);
+
+  // The frames and the descriptors are computed from the same sorted neighbor lists
+  SHOTEstimationOMP<PointXYZ, Normal, SHOT352> shot_omp;
+  shot_omp.setInputNormals (normals);
+  shot_omp.setInputCloud (cloud.makeShared ());
+  shot_omp.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  shot_omp.setRadiusSearch (20 * mr);
+  PointCloud<SHOT352> shots_omp;
+  shot_omp.compute (shots_omp);
+
+  ASSERT_EQ (shots.points.size (), shots_omp.points.size ());
+  for (size_t i = 0; i < shots.points.size (); ++i)
+    for (int j = 0; j < 9; ++j)
+      if (pcl_isfinite (shots.points[i].rf[j]))
+        ASSERT_EQ (shots.points[i].rf[j], shots_omp.points[i].rf[j]);
+      else
+        ASSERT_FALSE (pcl_isfinite (shots_omp.points[i].rf[j]));
+  for (size_t i = 0; i < shots.points.size (); ++i)
+    for (int j = 0; j < 352; ++j)
+      if (pcl_isfinite (shots.points[i].descriptor[j]))
+        ASSERT_EQ (shots.points[i].descriptor[j], shots_omp.points[i].descriptor[j]);
+
+  // The shared neighbors are released, and the search method is left as it was given
+  EXPECT_FALSE (shot_omp.getSearchNeighborhoods ());
+  shot_omp.setSearchMethod (tree);
+  shot_omp.compute (shots_omp);
+  EXPECT_FALSE (tree->getSortedResults ());
+
+  // The lookup table approximates the angles closely enough to leave the descriptors nearly unchanged
+  SHOTEstimationOMP<PointXYZ, Normal, SHOT352> shot_lut;
+  shot_lut.setInputNormals (normals);
+  shot_lut.setInputCloud (cloud.makeShared ());
+  shot_lut.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  shot_lut.setRadiusSearch (20 * mr);
+  shot_lut.setUseAngleLookupTable (true);
+  EXPECT_TRUE (shot_lut.getUseAngleLookupTable ());
+  PointCloud<SHOT352> shots_lut;
+  shot_lut.compute (shots_lut);
+
+  ASSERT_EQ (shots.points.size (), shots_lut.points.size ());
+  for (size_t i = 0; i < shots.points.size (); ++i)
+    for (int j = 0; j < 352; ++j)
+      if (pcl_isfinite (shots.points[i].descriptor[j]))
+        ASSERT_NEAR (shots.points[i].descriptor[j], shots_lut.points[i].descriptor[j], 1e-5);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL,3DSCEstimation)
 {
@@ -47,6 +47,7 @@
 #include <pcl/filters/sampling_surface_normal.h>
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/filters/voxel_grid_covariance.h>
+#include <pcl/filters/streaming_voxel_grid.h>
 #include <pcl/filters/extract_indices.h>
 #include <pcl/filters/project_inliers.h>
 #include <pcl/filters/radius_outlier_removal.h>
@@ -683,6 +684,131 @@ TEST (VoxelGrid, Filters)
   EXPECT_LE (output.points[neighbors2.at (0)].z - output.points[centroidIdx2].z, 0.02 * 2);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelGrid_Parallel, Filters)
+{
+  PointCloud<PointXYZ> output, output_parallel;
+  VoxelGrid<PointXYZ> grid;
+
+  grid.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid.setInputCloud (cloud);
+  grid.setSaveLeafLayout (true);
+  grid.filter (output);
+  vector<int> leaf_layout = grid.getLeafLayout ();
+
+  for (unsigned int nr_threads = 0; nr_threads < 5; ++nr_threads)
+  {
+    grid.setNumberOfThreads (nr_threads);
+    grid.filter (output_parallel);
+
+    // The parallel radix sort must produce exactly the same output as the serial implementation
+    ASSERT_EQ (output_parallel.points.size (), output.points.size ());
+    EXPECT_EQ (output_parallel.width, output.width);
+    for (size_t i = 0; i < output.points.size (); ++i)
+    {
+      EXPECT_EQ (output_parallel.points[i].x, output.points[i].x);
+      EXPECT_EQ (output_parallel.points[i].y, output.points[i].y);
+      EXPECT_EQ (output_parallel.points[i].z, output.points[i].z);
+    }
+    EXPECT_TRUE (grid.getLeafLayout () == leaf_layout);
+  }
+
+  // A leaf size this small overflows a 32 bit voxel index, but not the 64 bit one. Every point is given twice,
+  // so that the voxels still merge points and the output can not be mistaken for a copy of the input
+  PointCloud<PointXYZ>::Ptr doubled (new PointCloud<PointXYZ> (*cloud));
+  *doubled += *cloud;
+  const float leaf_size = 0.00001f;
+  const float inverse_leaf_size = 1.0f / leaf_size;
+  vector<pair<int, pair<int, int> > > voxels (doubled->points.size ());
+  for (size_t i = 0; i < doubled->points.size (); ++i)
+    voxels[i] = make_pair (static_cast<int> (floor (doubled->points[i].x * inverse_leaf_size)),
+                           make_pair (static_cast<int> (floor (doubled->points[i].y * inverse_leaf_size)),
+                                      static_cast<int> (floor (doubled->points[i].z * inverse_leaf_size))));
+  sort (voxels.begin (), voxels.end ());
+  const size_t nr_voxels = unique (voxels.begin (), voxels.end ()) - voxels.begin ();
+
+  grid.setNumberOfThreads (1);
+  grid.setSaveLeafLayout (false);
+  grid.setInputCloud (doubled);
+  grid.setLeafSize (leaf_size, leaf_size, leaf_size);
+  grid.filter (output);
+  EXPECT_LT (output.points.size (), doubled->points.size ());
+  EXPECT_EQ (output.points.size (), nr_voxels);
+
+  grid.setNumberOfThreads (4);
+  grid.filter (output_parallel);
+  ASSERT_EQ (output_parallel.points.size (), output.points.size ());
+  for (size_t i = 0; i < output.points.size (); ++i)
+  {
+    EXPECT_EQ (output_parallel.points[i].x, output.points[i].x);
+    EXPECT_EQ (output_parallel.points[i].y, output.points[i].y);
+    EXPECT_EQ (output_parallel.points[i].z, output.points[i].z);
+  }
+
+  // The leaf layout is addressed with integer indices, so it can not be saved for that many voxels
+  grid.setSaveLeafLayout (true);
+  grid.filter (output);
+  EXPECT_EQ (output.points.size (), doubled->points.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (StreamingVoxelGrid, Filters)
+{
+  PointCloud<PointXYZ> output, output_streaming;
+  VoxelGrid<PointXYZ> grid;
+  grid.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid.setInputCloud (cloud);
+  grid.filter (output);
+
+  StreamingVoxelGrid<PointXYZ> streaming_grid;
+  streaming_grid.setLeafSize (0.02f, 0.02f, 0.02f);
+
+  // Feed the cloud in batches, no voxel is finalized before the flush
+  const size_t batch_size = 50;
+  for (size_t i = 0; i < cloud->points.size (); i += batch_size)
+  {
+    PointCloud<PointXYZ> batch;
+    batch.points.assign (cloud->points.begin () + i, cloud->points.begin () + min (i + batch_size, cloud->points.size ()));
+    batch.width = static_cast<uint32_t> (batch.points.size ());
+    batch.height = 1;
+    streaming_grid.addPoints (batch, output_streaming);
+  }
+  EXPECT_EQ (int (output_streaming.points.size ()), 0);
+  EXPECT_EQ (streaming_grid.getNumberOfVoxels (), output.points.size ());
+
+  streaming_grid.flush (output_streaming);
+  EXPECT_EQ (int (streaming_grid.getNumberOfVoxels ()), 0);
+  EXPECT_EQ (int (output_streaming.width), 103);
+  EXPECT_EQ (int (output_streaming.height), 1);
+  EXPECT_EQ (bool (output_streaming.is_dense), true);
+
+  // Same centroids as VoxelGrid, in a different order
+  ASSERT_EQ (output_streaming.points.size (), output.points.size ());
+  for (size_t i = 0; i < output_streaming.points.size (); ++i)
+  {
+    float min_distance = FLT_MAX;
+    for (size_t j = 0; j < output.points.size (); ++j)
+      min_distance = min (min_distance, (output_streaming.points[i].getVector3fMap () - output.points[j].getVector3fMap ()).norm ());
+    EXPECT_NEAR (min_distance, 0, 1e-5);
+  }
+
+  // Bounded memory: voxels get finalized along the way
+  output_streaming.points.clear ();
+  streaming_grid.setMaximumNumberOfVoxels (20);
+  for (size_t i = 0; i < cloud->points.size (); i += batch_size)
+  {
+    PointCloud<PointXYZ> batch;
+    batch.points.assign (cloud->points.begin () + i, cloud->points.begin () + min (i + batch_size, cloud->points.size ()));
+    batch.width = static_cast<uint32_t> (batch.points.size ());
+    batch.height = 1;
+    streaming_grid.addPoints (batch, output_streaming);
+    EXPECT_LE (int (streaming_grid.getNumberOfVoxels ()), 20);
+  }
+  EXPECT_GT (int (output_streaming.points.size ()), 0);
+  streaming_grid.flush (output_streaming);
+  EXPECT_GE (output_streaming.points.size (), output.points.size ());
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (VoxelGrid_RGB, Filters)
 {
@@ -720,6 +720,200 @@ TEST (PCL, PCDReaderWriter)
   EXPECT_FLOAT_EQ (cloud.points[nr_p - 1].intensity, last.intensity); // test for fromROSMsg ()
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PCDReaderView)
+{
+  PointCloud<PointXYZI> cloud;
+  cloud.width  = 64;
+  cloud.height = 48;
+  cloud.points.resize (cloud.width * cloud.height);
+  cloud.sensor_origin_ = Eigen::Vector4f (1.0f, 2.0f, 3.0f, 0.0f);
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    cloud.points[i].x = static_cast<float> (i);
+    cloud.points[i].y = static_cast<float> (2 * i);
+    cloud.points[i].z = -static_cast<float> (i);
+    cloud.points[i].intensity = static_cast<float> (i % 255);
+  }
+
+  // Written from a PointCloud2 the on-disk layout is the one of PointXYZI: mapped in place
+  sensor_msgs::PointCloud2 cloud_blob;
+  toROSMsg (cloud, cloud_blob);
+  PCDWriter writer;
+  writer.writeBinary ("test_pcl_io_view.pcd", cloud_blob, cloud.sensor_origin_, cloud.sensor_orientation_);
+
+  PCDReader reader;
+  PCDCloudView<PointXYZI> view;
+  EXPECT_EQ (reader.readView ("test_pcl_io_view.pcd", view), 0);
+  EXPECT_TRUE (view.isMapped ());
+  EXPECT_EQ (view.width, cloud.width);
+  EXPECT_EQ (view.height, cloud.height);
+  ASSERT_EQ (view.size (), cloud.points.size ());
+  EXPECT_EQ (view.sensor_origin_, cloud.sensor_origin_);
+  for (size_t i = 0; i < view.size (); ++i)
+  {
+    EXPECT_EQ (view[i].x, cloud.points[i].x);
+    EXPECT_EQ (view[i].y, cloud.points[i].y);
+    EXPECT_EQ (view[i].z, cloud.points[i].z);
+    EXPECT_EQ (view[i].intensity, cloud.points[i].intensity);
+  }
+  EXPECT_EQ (view.at (3, 2).x, cloud.at (3, 2).x);
+
+  std::vector<int> indices;
+  indices.push_back (100);
+  indices.push_back (7);
+  PointCloud<PointXYZI> subset;
+  view.copyTo (indices, subset);
+  ASSERT_EQ (subset.points.size (), indices.size ());
+  EXPECT_EQ (subset.points[0].x, cloud.points[100].x);
+  EXPECT_EQ (subset.points[1].x, cloud.points[7].x);
+
+  // A different point type is read as a copy
+  PCDCloudView<PointXYZ> view_xyz;
+  EXPECT_EQ (reader.readView ("test_pcl_io_view.pcd", view_xyz), 0);
+  EXPECT_FALSE (view_xyz.isMapped ());
+  ASSERT_EQ (view_xyz.size (), cloud.points.size ());
+  EXPECT_EQ (view_xyz[42].y, cloud.points[42].y);
+
+  // The packed layout written by the templated writer and savePCDFileBinary is read as a copy
+  writer.writeBinary<PointXYZI> ("test_pcl_io_view.pcd", cloud);
+  EXPECT_EQ (reader.readView ("test_pcl_io_view.pcd", view), 0);
+  EXPECT_FALSE (view.isMapped ());
+  ASSERT_EQ (view.size (), cloud.points.size ());
+  EXPECT_EQ (view[42].intensity, cloud.points[42].intensity);
+
+  EXPECT_EQ (savePCDFileBinary ("test_pcl_io_view.pcd", cloud), 0);
+  EXPECT_EQ (reader.readView ("test_pcl_io_view.pcd", view), 0);
+  EXPECT_FALSE (view.isMapped ());
+
+  // The mappable layout keeps the padding of the point type
+  writer.writeBinaryMappable<PointXYZI> ("test_pcl_io_view.pcd", cloud);
+  EXPECT_EQ (reader.readView ("test_pcl_io_view.pcd", view), 0);
+  EXPECT_TRUE (view.isMapped ());
+  ASSERT_EQ (view.size (), cloud.points.size ());
+  EXPECT_EQ (view.width, cloud.width);
+  EXPECT_EQ (view.sensor_origin_, cloud.sensor_origin_);
+  EXPECT_EQ (view[42].z, cloud.points[42].z);
+  EXPECT_EQ (view[42].intensity, cloud.points[42].intensity);
+
+  // and is still read back correctly into a different point type
+  PointCloud<PointXYZ> cloud_xyz;
+  EXPECT_EQ (reader.read ("test_pcl_io_view.pcd", cloud_xyz), 0);
+  ASSERT_EQ (cloud_xyz.points.size (), cloud.points.size ());
+  EXPECT_EQ (cloud_xyz.points[7].y, cloud.points[7].y);
+
+  remove ("test_pcl_io_view.pcd");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PCDReaderWriterChunked)
+{
+  PointCloud<PointXYZI> cloud;
+  cloud.width  = 320;
+  cloud.height = 240;
+  cloud.points.resize (cloud.width * cloud.height);
+  cloud.is_dense = true;
+  cloud.sensor_origin_ = Eigen::Vector4f (1.0f, 2.0f, 3.0f, 0.0f);
+
+  srand (static_cast<unsigned int> (time (NULL)));
+  // The first half compresses well, the random second half is stored uncompressed
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    bool random = i >= cloud.points.size () / 2;
+    cloud.points[i].x = random ? static_cast<float> (1024 * rand () / (RAND_MAX + 1.0)) : 1.0f;
+    cloud.points[i].y = random ? static_cast<float> (1024 * rand () / (RAND_MAX + 1.0)) : 2.0f;
+    cloud.points[i].z = random ? static_cast<float> (1024 * rand () / (RAND_MAX + 1.0)) : 3.0f;
+    cloud.points[i].intensity = static_cast<float> (i);
+  }
+
+  PCDWriter writer;
+  writer.setNumberOfThreads (4);
+  // 1000 does not divide the number of points, so the last chunk is smaller
+  EXPECT_EQ (writer.writeBinaryChunked<PointXYZI> ("test_pcl_io_chunked.pcd", cloud, 1000), 0);
+
+  PCDReader reader;
+  for (unsigned int threads = 1; threads <= 4; threads += 3)
+  {
+    reader.setNumberOfThreads (threads);
+
+    PointCloud<PointXYZI> cloud_in;
+    EXPECT_EQ (reader.read<PointXYZI> ("test_pcl_io_chunked.pcd", cloud_in), 0);
+    EXPECT_EQ (cloud_in.width, cloud.width);
+    EXPECT_EQ (cloud_in.height, cloud.height);
+    EXPECT_EQ (cloud_in.sensor_origin_, cloud.sensor_origin_);
+    ASSERT_EQ (cloud_in.points.size (), cloud.points.size ());
+    for (size_t i = 0; i < cloud.points.size (); ++i)
+    {
+      EXPECT_EQ (cloud_in.points[i].x, cloud.points[i].x);
+      EXPECT_EQ (cloud_in.points[i].y, cloud.points[i].y);
+      EXPECT_EQ (cloud_in.points[i].z, cloud.points[i].z);
+      EXPECT_EQ (cloud_in.points[i].intensity, cloud.points[i].intensity);
+    }
+
+    // A range spanning several chunks, compressed and uncompressed ones
+    PointCloud<PointXYZI> range;
+    EXPECT_EQ (reader.readRange<PointXYZI> ("test_pcl_io_chunked.pcd", range, 37500, 2345), 0);
+    EXPECT_EQ (range.width, 2345);
+    EXPECT_EQ (range.height, 1);
+    ASSERT_EQ (range.points.size (), 2345);
+    for (size_t i = 0; i < range.points.size (); ++i)
+    {
+      EXPECT_EQ (range.points[i].x, cloud.points[37500 + i].x);
+      EXPECT_EQ (range.points[i].intensity, cloud.points[37500 + i].intensity);
+    }
+
+    // Ranges are clamped to the end of the cloud
+    EXPECT_EQ (reader.readRange<PointXYZI> ("test_pcl_io_chunked.pcd", range, 76000, 1000), 0);
+    ASSERT_EQ (range.points.size (), 800);
+    EXPECT_EQ (range.points[799].intensity, cloud.points.back ().intensity);
+    EXPECT_LT (reader.readRange<PointXYZI> ("test_pcl_io_chunked.pcd", range, 76800, 1), 0);
+
+    // An empty range reads nothing
+    EXPECT_EQ (reader.readRange<PointXYZI> ("test_pcl_io_chunked.pcd", range, 0, 0), 0);
+    EXPECT_EQ (range.width, 0);
+    EXPECT_EQ (range.height, 0);
+    EXPECT_TRUE (range.points.empty ());
+  }
+
+  // Ranges also work on plain binary files, read in place with the fields either packed, or padded like
+  // PointXYZI
+  PointCloud<PointXYZI> range;
+  for (int padded = 0; padded < 2; ++padded)
+  {
+    if (padded)
+      writer.writeBinaryMappable<PointXYZI> ("test_pcl_io_chunked.pcd", cloud);
+    else
+      writer.writeBinary<PointXYZI> ("test_pcl_io_chunked.pcd", cloud);
+    sensor_msgs::PointCloud2 header;
+    EXPECT_EQ (reader.readHeader ("test_pcl_io_chunked.pcd", header), 0);
+    EXPECT_EQ (header.point_step, padded ? sizeof (PointXYZI) : 4 * sizeof (float));
+
+    EXPECT_EQ (reader.readRange<PointXYZI> ("test_pcl_io_chunked.pcd", range, 100, 10), 0);
+    EXPECT_EQ (range.width, 10);
+    EXPECT_EQ (range.height, 1);
+    ASSERT_EQ (range.points.size (), 10);
+    for (size_t i = 0; i < range.points.size (); ++i)
+    {
+      EXPECT_EQ (range.points[i].x, cloud.points[100 + i].x);
+      EXPECT_EQ (range.points[i].y, cloud.points[100 + i].y);
+      EXPECT_EQ (range.points[i].z, cloud.points[100 + i].z);
+      EXPECT_EQ (range.points[i].intensity, cloud.points[100 + i].intensity);
+    }
+
+    EXPECT_EQ (reader.readRange<PointXYZI> ("test_pcl_io_chunked.pcd", range, 76790, 100), 0);
+    ASSERT_EQ (range.points.size (), 10);
+    EXPECT_EQ (range.points[9].x, cloud.points.back ().x);
+    EXPECT_EQ (range.points[9].intensity, cloud.points.back ().intensity);
+    EXPECT_LT (reader.readRange<PointXYZI> ("test_pcl_io_chunked.pcd", range, 76800, 1), 0);
+
+    EXPECT_EQ (reader.readRange<PointXYZI> ("test_pcl_io_chunked.pcd", range, 0, 0), 0);
+    EXPECT_EQ (range.width, 0);
+    EXPECT_TRUE (range.points.empty ());
+  }
+
+  remove ("test_pcl_io_chunked.pcd");
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, PCDReaderWriterEigen)
 {
@@ -39,6 +39,8 @@
 
 #include <gtest/gtest.h>
 
+#include <boost/filesystem.hpp>
+
 #include <pcl/point_types.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/features/normal_3d.h>
@@ -46,6 +48,7 @@
 #include <pcl/registration/registration.h>
 #include <pcl/registration/icp.h>
 #include <pcl/registration/icp_nl.h>
+#include <pcl/registration/gicp.h>
 #include <pcl/registration/transformation_estimation_point_to_plane.h>
 #include <pcl/registration/transformation_validation_euclidean.h>
 #include <pcl/registration/transformation_estimation_point_to_plane_lls.h>
@@ -54,6 +57,9 @@
 #include <pcl/features/ppf.h>
 #include <pcl/registration/ppf_registration.h>
 #include <pcl/registration/ndt.h>
+#include <pcl/registration/ndt_map.h>
+#include <pcl/registration/lum.h>
+#include <pcl/registration/voxel_hash_map.h>
 // We need Histogram<2> to function, so we'll explicitely add kdtree_flann.hpp here
 #include <pcl/kdtree/impl/kdtree_flann.hpp>
 //(pcl::Histogram<2>)
@@ -187,6 +193,152 @@ TEST (PCL, IterativeClosestPoint)
   EXPECT_EQ (transformation (3, 3), 1);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IterativeClosestPointThreads)
+{
+  IterativeClosestPoint<PointXYZ, PointXYZ> reg;
+  reg.setInputCloud (cloud_source.makeShared ());
+  reg.setInputTarget (cloud_target.makeShared ());
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  reg.setMaxCorrespondenceDistance (0.05);
+
+  PointCloud<PointXYZ> output_serial, output_parallel;
+  reg.setNumberOfThreads (1);
+  reg.align (output_serial);
+  Eigen::Matrix4f transformation_serial = reg.getFinalTransformation ();
+
+  reg.setNumberOfThreads (4);
+  reg.align (output_parallel);
+  Eigen::Matrix4f transformation_parallel = reg.getFinalTransformation ();
+
+  // The correspondences are gathered in the same order, so the result must be bit identical
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_EQ (transformation_serial (i, j), transformation_parallel (i, j));
+  EXPECT_NEAR (transformation_parallel (0, 0), 0.8806, 1e-3);
+  EXPECT_NEAR (transformation_parallel (2, 3), 0.04116, 1e-3);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, VoxelHashMap)
+{
+  const float leaf_size = 0.02f;
+  PointCloud<PointXYZ>::Ptr target (cloud_target.makeShared ());
+  registration::VoxelHashMap<PointXYZ> map (leaf_size);
+  map.setInputCloud (target);
+  EXPECT_EQ (map.getInputCloud ()->points.size (), target->points.size ());
+  EXPECT_GT (map.getNumberOfVoxels (), 0u);
+
+  // Adding the points incrementally must give the same map
+  PointCloud<PointXYZ> first_half, second_half;
+  for (size_t i = 0; i < target->points.size (); ++i)
+    (i < target->points.size () / 2 ? first_half : second_half).points.push_back (target->points[i]);
+  registration::VoxelHashMap<PointXYZ> incremental_map (leaf_size);
+  EXPECT_EQ (incremental_map.addPoints (first_half), first_half.points.size ());
+  EXPECT_EQ (incremental_map.addPoints (second_half), second_half.points.size ());
+  EXPECT_EQ (incremental_map.getNumberOfVoxels (), map.getNumberOfVoxels ());
+  ASSERT_EQ (incremental_map.getInputCloud ()->points.size (), target->points.size ());
+
+  std::vector<int> indices, incremental_indices;
+  std::vector<float> sqr_distances, incremental_sqr_distances;
+  for (size_t i = 0; i < cloud_source.points.size (); ++i)
+  {
+    const PointXYZ &query = cloud_source.points[i];
+
+    // Compare with a linear search
+    int nn_index = -1;
+    float nn_sqr_distance = std::numeric_limits<float>::max ();
+    std::vector<std::pair<float, int> > linear;
+    for (size_t j = 0; j < target->points.size (); ++j)
+    {
+      float sqr_distance = (target->points[j].getVector3fMap () - query.getVector3fMap ()).squaredNorm ();
+      if (sqr_distance < nn_sqr_distance)
+      {
+        nn_sqr_distance = sqr_distance;
+        nn_index = static_cast<int> (j);
+      }
+      if (sqr_distance <= 0.03f * 0.03f)
+        linear.push_back (std::make_pair (sqr_distance, static_cast<int> (j)));
+    }
+    std::sort (linear.begin (), linear.end ());
+
+    // The nearest neighbor is exact within the leaf size
+    int k = map.nearestKSearch (query, 1, indices, sqr_distances);
+    incremental_map.nearestKSearch (query, 1, incremental_indices, incremental_sqr_distances);
+    EXPECT_EQ (indices, incremental_indices);
+    if (nn_sqr_distance < leaf_size * leaf_size)
+    {
+      ASSERT_EQ (k, 1);
+      EXPECT_EQ (indices[0], nn_index);
+      EXPECT_EQ (sqr_distances[0], nn_sqr_distance);
+    }
+    else if (k == 1)
+      EXPECT_GE (sqr_distances[0], nn_sqr_distance);
+
+    // The radius search is exact for any radius
+    map.radiusSearch (query, 0.03, indices, sqr_distances);
+    ASSERT_EQ (indices.size (), linear.size ());
+    for (size_t j = 0; j < linear.size (); ++j)
+    {
+      EXPECT_EQ (indices[j], linear[j].second);
+      EXPECT_EQ (sqr_distances[j], linear[j].first);
+    }
+  }
+
+  // Full voxels do not take any more points
+  registration::VoxelHashMap<PointXYZ> sparse_map (leaf_size);
+  sparse_map.setMaxPointsPerVoxel (1);
+  EXPECT_EQ (sparse_map.addPoints (*target), map.getNumberOfVoxels ());
+  EXPECT_EQ (sparse_map.getInputCloud ()->points.size (), map.getNumberOfVoxels ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IterativeClosestPointVoxelHashMap)
+{
+  IterativeClosestPoint<PointXYZ, PointXYZ> reg;
+  reg.setInputCloud (cloud_source.makeShared ());
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  reg.setMaxCorrespondenceDistance (0.05);
+
+  // Use the map as an incrementally built target: the map cloud is given as target without rebuilding the map
+  registration::VoxelHashMap<PointXYZ>::Ptr map (new registration::VoxelHashMap<PointXYZ> (0.05f));
+  map->addPoints (cloud_target);
+  reg.setSearchMethodTarget (map, true);
+  reg.setInputTarget (map->getInputCloud ());
+  EXPECT_EQ (reg.getSearchMethodTarget (), map);
+
+  reg.align (cloud_reg);
+  EXPECT_EQ (int (cloud_reg.points.size ()), int (cloud_source.points.size ()));
+
+  Eigen::Matrix4f transformation = reg.getFinalTransformation ();
+  EXPECT_NEAR (transformation (0, 0), 0.8806,  1e-3);
+  EXPECT_NEAR (transformation (0, 2), -0.4724, 1e-3);
+  EXPECT_NEAR (transformation (0, 3), 0.03453, 1e-3);
+  EXPECT_NEAR (transformation (1, 1),  0.9992,   1e-3);
+  EXPECT_NEAR (transformation (2, 0),  0.4732,  1e-3);
+  EXPECT_NEAR (transformation (2, 3),  0.04116, 1e-3);
+
+  // The target is shared with the map, so points added after setting the target are found without setting it again
+  map->clear ();
+  PointCloud<PointXYZ> first_half, second_half;
+  first_half.points.assign (cloud_target.points.begin (), cloud_target.points.begin () + cloud_target.points.size () / 2);
+  second_half.points.assign (cloud_target.points.begin () + cloud_target.points.size () / 2, cloud_target.points.end ());
+  map->addPoints (first_half);
+  reg.setInputTarget (map->getInputCloud ());
+  EXPECT_EQ (reg.getInputTarget (), map->getInputCloud ());
+  map->addPoints (second_half);
+  ASSERT_EQ (reg.getInputTarget ()->points.size (), cloud_target.points.size ());
+
+  reg.setInputCloud (cloud_source.makeShared ());
+  reg.align (cloud_reg);
+  EXPECT_TRUE (reg.hasConverged ());
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_NEAR (reg.getFinalTransformation () (i, j), transformation (i, j), 1e-4);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, IterativeClosestPointNonLinear)
 {
@@ -294,6 +446,126 @@ TEST (PCL, IterativeClosestPoint_PointToPlane)
   EXPECT_LT (reg.getFitnessScore (), 0.001);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, GeneralizedIterativeClosestPoint)
+{
+  typedef PointXYZ PointT;
+  typedef GeneralizedIterativeClosestPoint<PointT, PointT> GICP;
+  PointCloud<PointT>::ConstPtr src = cloud_source.makeShared ();
+  PointCloud<PointT>::ConstPtr tgt = cloud_target.makeShared ();
+  PointCloud<PointT> output;
+
+  GICP reg;
+  reg.setInputCloud (src);
+  reg.setInputTarget (tgt);
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  reg.setNumberOfThreads (1);
+  EXPECT_FALSE (reg.getTargetCovariances ());
+  reg.align (output);
+  EXPECT_EQ (int (output.points.size ()), int (cloud_source.points.size ()));
+  EXPECT_LT (reg.getFitnessScore (), 0.0001);
+  Eigen::Matrix4f transformation = reg.getFinalTransformation ();
+
+  // The target covariances are kept for the next alignment, and the result does not depend on the number of
+  // threads
+  GICP::MatricesVectorPtr target_covariances = reg.getTargetCovariances ();
+  ASSERT_TRUE (target_covariances);
+  EXPECT_EQ (target_covariances->size (), cloud_target.points.size ());
+  reg.setInputCloud (src);
+  reg.setNumberOfThreads (4);
+  reg.align (output);
+  EXPECT_EQ (reg.getTargetCovariances (), target_covariances);
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_EQ (reg.getFinalTransformation () (i, j), transformation (i, j));
+
+  // Setting a target discards them
+  reg.setInputTarget (tgt);
+  EXPECT_FALSE (reg.getTargetCovariances ());
+
+  // Covariances computed from the surface normals
+  NormalEstimation<PointT, Normal> ne;
+  search::KdTree<PointT>::Ptr tree (new search::KdTree<PointT>);
+  ne.setSearchMethod (tree);
+  ne.setKSearch (20);
+  PointCloud<Normal> normals;
+  GICP::MatricesVectorPtr source_covariances (new GICP::MatricesVector);
+  ne.setInputCloud (src);
+  ne.compute (normals);
+  reg.computeCovariancesFromNormals (normals, *source_covariances);
+  target_covariances.reset (new GICP::MatricesVector);
+  ne.setInputCloud (tgt);
+  ne.compute (normals);
+  reg.computeCovariancesFromNormals (normals, *target_covariances);
+  ASSERT_EQ (target_covariances->size (), cloud_target.points.size ());
+  const Eigen::Vector3d normal = normals.points[0].getNormalVector3fMap ().cast<double> ();
+  EXPECT_NEAR (normal.dot ((*target_covariances)[0] * normal), 0.001, 1e-6);
+
+  reg.setInputCloud (src);
+  reg.setSourceCovariances (source_covariances);
+  reg.setTargetCovariances (target_covariances);
+  reg.align (output);
+  EXPECT_EQ (reg.getSourceCovariances (), source_covariances);
+  EXPECT_LT (reg.getFitnessScore (), 0.0001);
+
+  // Changing the neighborhood size keeps the given covariances, and discards the estimated ones
+  reg.setCorrespondenceRandomness (10);
+  EXPECT_EQ (reg.getSourceCovariances (), source_covariances);
+  EXPECT_EQ (reg.getTargetCovariances (), target_covariances);
+  reg.setInputCloud (src);
+  reg.align (output);
+  ASSERT_TRUE (reg.getSourceCovariances ());
+  reg.setCorrespondenceRandomness (20);
+  EXPECT_FALSE (reg.getSourceCovariances ());
+  EXPECT_EQ (reg.getTargetCovariances (), target_covariances);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, GeneralizedIterativeClosestPointLM)
+{
+  typedef PointXYZ PointT;
+  typedef GeneralizedIterativeClosestPoint<PointT, PointT> GICP;
+  PointCloud<PointT>::ConstPtr src = cloud_source.makeShared ();
+  PointCloud<PointT>::ConstPtr tgt = cloud_target.makeShared ();
+  PointCloud<PointT> output;
+
+  GICP reg;
+  EXPECT_EQ (reg.getOptimizer (), GICP::BFGS_OPTIMIZER);
+  reg.setOptimizer (GICP::LM_OPTIMIZER);
+  EXPECT_EQ (reg.getOptimizer (), GICP::LM_OPTIMIZER);
+  reg.setInputCloud (src);
+  reg.setInputTarget (tgt);
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  reg.setNumberOfThreads (1);
+  reg.align (output);
+  EXPECT_EQ (int (output.points.size ()), int (cloud_source.points.size ()));
+  EXPECT_LT (reg.getFitnessScore (), 0.0001);
+  Eigen::Matrix4f transformation = reg.getFinalTransformation ();
+
+  // The result does not depend on the number of threads
+  reg.setInputCloud (src);
+  reg.setNumberOfThreads (4);
+  reg.align (output);
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_EQ (reg.getFinalTransformation () (i, j), transformation (i, j));
+
+  // Recover a known transformation
+  Eigen::Affine3f delta_transformation (Eigen::Translation3f (0.01f, -0.02f, 0.015f) *
+                                        Eigen::AngleAxisf (0.1f, Eigen::Vector3f (0.2f, 1.0f, 0.3f).normalized ()));
+  PointCloud<PointT>::Ptr transformed (new PointCloud<PointT>);
+  transformPointCloud (cloud_source, *transformed, delta_transformation);
+  reg.setInputCloud (src);
+  reg.setInputTarget (transformed);
+  reg.align (output);
+  EXPECT_TRUE (reg.hasConverged ());
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_NEAR (reg.getFinalTransformation () (i, j), delta_transformation (i, j), 1e-4);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, NormalDistributionsTransform)
 {
@@ -320,6 +592,244 @@ TEST (PCL, NormalDistributionsTransform)
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NormalDistributionsTransformDirect)
+{
+  typedef PointNormal PointT;
+  PointCloud<PointT>::Ptr src (new PointCloud<PointT>);
+  copyPointCloud (cloud_source, *src);
+  PointCloud<PointT>::Ptr tgt (new PointCloud<PointT>);
+  copyPointCloud (cloud_target, *tgt);
+  PointCloud<PointT> output;
+
+  typedef NormalDistributionsTransform<PointT, PointT> NDT;
+  const NDT::NeighborSearchMethod methods[] = { NDT::KDTREE, NDT::DIRECT26, NDT::DIRECT7, NDT::DIRECT1 };
+  for (int m = 0; m < 4; ++m)
+  {
+    NDT reg;
+    reg.setStepSize (0.05);
+    reg.setResolution (0.025f);
+    reg.setInputCloud (src);
+    reg.setInputTarget (tgt);
+    reg.setMaximumIterations (50);
+    reg.setTransformationEpsilon (1e-8);
+    reg.setNeighborSearchMethod (methods[m]);
+    EXPECT_EQ (reg.getNeighborSearchMethod (), methods[m]);
+
+    // The result must not depend on the number of threads
+    reg.setNumberOfThreads (1);
+    reg.align (output);
+    Eigen::Matrix4f transformation_serial = reg.getFinalTransformation ();
+    reg.setNumberOfThreads (4);
+    reg.align (output);
+    Eigen::Matrix4f transformation_parallel = reg.getFinalTransformation ();
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+        EXPECT_EQ (transformation_serial (i, j), transformation_parallel (i, j));
+
+    EXPECT_EQ (int (output.points.size ()), int (cloud_source.points.size ()));
+    if (methods[m] != NDT::DIRECT1)
+      EXPECT_LT (reg.getFitnessScore (), 0.001);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NDTMap)
+{
+  // Inserting the target in two scans gives the voxels of VoxelGridCovariance
+  VoxelGridCovariance<PointXYZ> grid;
+  grid.setLeafSize (0.025f, 0.025f, 0.025f);
+  grid.setInputCloud (cloud_target.makeShared ());
+  grid.filter (true);
+
+  registration::NDTMap<PointXYZ> map (0.025f, 4);
+  const size_t half = cloud_target.points.size () / 2;
+  PointCloud<PointXYZ> scan;
+  scan.points.assign (cloud_target.points.begin (), cloud_target.points.begin () + half);
+  EXPECT_EQ (map.insert (scan), scan.points.size ());
+  scan.points.assign (cloud_target.points.begin () + half, cloud_target.points.end ());
+  EXPECT_EQ (map.insert (scan), scan.points.size ());
+  EXPECT_EQ (map.getNumberOfVoxels (), grid.getLeaves ().size ());
+
+  int nr_usable = 0;
+  typedef boost::unordered_map<size_t, VoxelGridCovariance<PointXYZ>::Leaf> GridLeaves;
+  for (GridLeaves::const_iterator it = grid.getLeaves ().begin (); it != grid.getLeaves ().end (); ++it)
+  {
+    const VoxelGridCovariance<PointXYZ>::Leaf &expected = it->second;
+    PointXYZ mean;
+    mean.getVector3fMap () = expected.mean_.cast<float> ();
+    const registration::NDTMap<PointXYZ>::Leaf *leaf = map.getLeaf (mean);
+    ASSERT_TRUE (leaf != NULL);
+    EXPECT_EQ (leaf->nr_points, expected.nr_points);
+    for (int i = 0; i < 3; ++i)
+      EXPECT_NEAR (leaf->mean_[i], expected.mean_[i], 1e-6);
+    if (expected.nr_points < map.getMinPointPerVoxel ())
+      continue;
+    ++nr_usable;
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        EXPECT_NEAR (leaf->icov_ (i, j), expected.icov_ (i, j), 1e-4 * expected.icov_.cwiseAbs ().maxCoeff ());
+  }
+  EXPECT_GT (nr_usable, 0);
+
+  // The saved tiles are read back around the current position, and unloaded away from it
+  const boost::filesystem::path map_directory =
+    boost::filesystem::temp_directory_path () / boost::filesystem::unique_path ("pcl_ndt_map_%%%%-%%%%-%%%%");
+  ASSERT_TRUE (boost::filesystem::create_directory (map_directory));
+  map.setMapDirectory (map_directory.string ());
+  EXPECT_TRUE (map.saveTiles ());
+  const Eigen::Vector3f position = cloud_target.points[0].getVector3fMap ();
+  registration::NDTMap<PointXYZ> loaded (0.025f, 4);
+  EXPECT_FALSE (loaded.updateActiveTiles (position, 1.0f));
+  loaded.setMapDirectory (map_directory.string ());
+  EXPECT_TRUE (loaded.updateActiveTiles (position, 1.0f));
+  EXPECT_EQ (loaded.getNumberOfVoxels (), map.getNumberOfVoxels ());
+  for (size_t i = 0; i < cloud_target.points.size (); ++i)
+  {
+    const registration::NDTMap<PointXYZ>::Leaf *leaf = loaded.getLeaf (cloud_target.points[i]);
+    const registration::NDTMap<PointXYZ>::Leaf *expected = map.getLeaf (cloud_target.points[i]);
+    ASSERT_TRUE (leaf != NULL);
+    EXPECT_EQ (leaf->nr_points, expected->nr_points);
+    EXPECT_EQ (leaf->mean_, expected->mean_);
+    EXPECT_EQ (leaf->icov_, expected->icov_);
+  }
+  EXPECT_TRUE (loaded.updateActiveTiles (Eigen::Vector3f (100.0f, 100.0f, 100.0f), 1.0f));
+  EXPECT_EQ (loaded.getNumberOfVoxels (), 0u);
+  EXPECT_TRUE (loaded.updateActiveTiles (position, 1.0f));
+  EXPECT_EQ (loaded.getNumberOfVoxels (), map.getNumberOfVoxels ());
+
+  // Points inserted into saved tiles are added to the saved voxels
+  registration::NDTMap<PointXYZ> combined (0.025f, 4);
+  combined.insert (cloud_target);
+  combined.insert (cloud_source);
+  registration::NDTMap<PointXYZ> appended (0.025f, 4);
+  appended.setMapDirectory (map_directory.string ());
+  appended.insert (cloud_source);
+  for (size_t i = 0; i < cloud_source.points.size (); ++i)
+  {
+    const registration::NDTMap<PointXYZ>::Leaf *leaf = appended.getLeaf (cloud_source.points[i]);
+    const registration::NDTMap<PointXYZ>::Leaf *expected = combined.getLeaf (cloud_source.points[i]);
+    ASSERT_TRUE (leaf != NULL);
+    EXPECT_EQ (leaf->nr_points, expected->nr_points);
+    for (int j = 0; j < 3; ++j)
+      EXPECT_NEAR (leaf->mean_[j], expected->mean_[j], 1e-6);
+  }
+
+  // Tiles saved with another resolution are rejected
+  registration::NDTMap<PointXYZ> other (0.05f, 4);
+  other.setMapDirectory (map_directory.string ());
+  EXPECT_FALSE (other.updateActiveTiles (position, 1.0f));
+
+  boost::filesystem::remove_all (map_directory);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NormalDistributionsTransformMap)
+{
+  typedef PointNormal PointT;
+  PointCloud<PointT>::Ptr src (new PointCloud<PointT>);
+  copyPointCloud (cloud_source, *src);
+  PointCloud<PointT>::Ptr tgt (new PointCloud<PointT>);
+  copyPointCloud (cloud_target, *tgt);
+  PointCloud<PointT> output;
+
+  registration::NDTMap<PointT>::Ptr map (new registration::NDTMap<PointT> (0.025f));
+  map->insert (*tgt);
+
+  // Aligning to the map gives the result of aligning to the target cloud
+  typedef NormalDistributionsTransform<PointT, PointT> NDT;
+  const NDT::NeighborSearchMethod methods[] = { NDT::KDTREE, NDT::DIRECT7 };
+  for (int m = 0; m < 2; ++m)
+  {
+    NDT reg;
+    reg.setStepSize (0.05);
+    reg.setResolution (0.025f);
+    reg.setInputCloud (src);
+    reg.setInputTarget (tgt);
+    reg.setMaximumIterations (50);
+    reg.setTransformationEpsilon (1e-8);
+    reg.setNeighborSearchMethod (methods[m]);
+    reg.align (output);
+    Eigen::Matrix4f transformation = reg.getFinalTransformation ();
+
+    NDT reg_map;
+    reg_map.setStepSize (0.05);
+    reg_map.setTargetMap (map);
+    EXPECT_EQ (reg_map.getResolution (), 0.025f);
+    EXPECT_EQ (reg_map.getTargetMap (), map);
+    reg_map.setInputCloud (src);
+    reg_map.setMaximumIterations (50);
+    reg_map.setTransformationEpsilon (1e-8);
+    reg_map.setNeighborSearchMethod (methods[m]);
+    reg_map.align (output);
+    EXPECT_EQ (int (output.points.size ()), int (cloud_source.points.size ()));
+    EXPECT_TRUE (reg_map.hasConverged ());
+    Eigen::Matrix4f transformation_map = reg_map.getFinalTransformation ();
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+        EXPECT_NEAR (transformation_map (i, j), transformation (i, j), 1e-3);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, LUM)
+{
+  // A loop of noisy views of the source cloud with a chord through its middle, starting from perturbed pose estimates
+  const int nr_views = 8;
+  std::vector<Eigen::Vector6f, Eigen::aligned_allocator<Eigen::Vector6f> > ground_truth (nr_views);
+  std::vector<PointCloud<PointXYZ>::Ptr> views (nr_views);
+  for (int i = 0; i < nr_views; ++i)
+  {
+    ground_truth[i] << 0.02f * float (i), -0.01f * float (i), 0.005f * float (i),
+                       0.02f * sinf (float (i)), 0.03f * (1.0f - cosf (float (i))), 0.05f * float (i);
+    if (i == 0)
+      ground_truth[i].setZero ();
+    views[i].reset (new PointCloud<PointXYZ>);
+    transformPointCloud (cloud_source, *views[i], getTransformation (ground_truth[i] (0), ground_truth[i] (1), ground_truth[i] (2),
+                                                                     ground_truth[i] (3), ground_truth[i] (4), ground_truth[i] (5)).inverse ());
+    // LUM needs some residual error on every edge
+    for (int j = 0; j < int (views[i]->points.size ()); ++j)
+    {
+      views[i]->points[j].x += 0.001f * sinf (float (7 * i + j));
+      views[i]->points[j].y += 0.001f * cosf (float (13 * i + 2 * j));
+      views[i]->points[j].z += 0.001f * sinf (float (3 * i + 5 * j));
+    }
+  }
+  CorrespondencesPtr corrs (new Correspondences);
+  for (int i = 0; i < int (cloud_source.points.size ()); ++i)
+    corrs->push_back (Correspondence (i, i, 0.0f));
+
+  std::vector<Eigen::Vector6f, Eigen::aligned_allocator<Eigen::Vector6f> > poses (nr_views);
+  for (unsigned int nr_threads = 1; nr_threads <= 4; nr_threads += 3)
+  {
+    registration::LUM<PointXYZ> lum;
+    lum.setMaxIterations (20);
+    lum.setNumberOfThreads (nr_threads);
+    for (int i = 0; i < nr_views; ++i)
+    {
+      Eigen::Vector6f offset;
+      offset << 0.01f, -0.005f, 0.008f, 0.02f, -0.01f, 0.015f;
+      lum.addPointCloud (views[i], i == 0 ? Eigen::Vector6f (Eigen::Vector6f::Zero ()) : Eigen::Vector6f (ground_truth[i] + float (i % 2 ? 1 : -1) * offset));
+    }
+    for (int i = 0; i < nr_views; ++i)
+      lum.setCorrespondences (i, (i + 1) % nr_views, corrs);
+    lum.setCorrespondences (0, nr_views / 2, corrs);
+    lum.compute ();
+
+    EXPECT_EQ (lum.getPose (0), Eigen::Vector6f (Eigen::Vector6f::Zero ()));
+    for (int i = 1; i < nr_views; ++i)
+    {
+      for (int j = 0; j < 6; ++j)
+        EXPECT_NEAR (lum.getPose (i) (j), ground_truth[i] (j), 1e-3);
+      // The result does not depend on the number of threads
+      if (nr_threads == 1)
+        poses[i] = lum.getPose (i);
+      else
+        EXPECT_EQ (lum.getPose (i), poses[i]);
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, TransformationEstimationPointToPlaneLLS)
 {
@@ -514,6 +1024,200 @@ TEST (PCL, PyramidFeatureHistogram)
   EXPECT_NEAR (similarity_value3, 0.87623238563537598, 1e-3);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PPFHashMapSearch)
+{
+  // Estimate normals and the point pair features of the model
+  PointCloud<PointXYZ>::Ptr cloud_model (cloud_source.makeShared ());
+  NormalEstimation<PointXYZ, Normal> normal_estimation;
+  normal_estimation.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ> ()));
+  normal_estimation.setKSearch (10);
+  normal_estimation.setInputCloud (cloud_model);
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  normal_estimation.compute (*normals);
+
+  PPFEstimation<PointXYZ, Normal, PPFSignature> ppf_estimator;
+  PointCloud<PPFSignature>::Ptr features (new PointCloud<PPFSignature> ());
+  ppf_estimator.setInputCloud (cloud_model);
+  ppf_estimator.setInputNormals (normals);
+  ppf_estimator.compute (*features);
+
+  const float angle_step = 12.0f / 180.0f * static_cast<float> (M_PI), distance_step = 0.005f;
+  PPFHashMapSearch search_serial (angle_step, distance_step), search_parallel (angle_step, distance_step);
+  search_serial.setNumberOfThreads (1);
+  search_serial.setInputFeatureCloud (features);
+  search_parallel.setNumberOfThreads (4);
+  search_parallel.setInputFeatureCloud (features);
+
+  float max_dist = -1.0f;
+  for (size_t k = 0; k < features->points.size (); ++k)
+    if (max_dist < features->points[k].f4)
+      max_dist = features->points[k].f4;
+  EXPECT_EQ (search_serial.getModelDiameter (), max_dist);
+  EXPECT_EQ (search_parallel.getModelDiameter (), max_dist);
+  ASSERT_EQ (search_parallel.alpha_m_.size (), cloud_model->points.size ());
+
+  // Compare the bins with a linear search
+  const size_t n = cloud_model->points.size ();
+  std::vector<std::pair<size_t, size_t> > indices_serial, indices_parallel, indices_linear;
+  for (size_t q = 1; q < features->points.size (); q += 211)
+  {
+    PPFSignature query = features->points[q];
+    if (!pcl_isfinite (query.f1))
+      continue;
+    int d[4] = { static_cast<int> (floor (query.f1 / angle_step)), static_cast<int> (floor (query.f2 / angle_step)),
+                 static_cast<int> (floor (query.f3 / angle_step)), static_cast<int> (floor (query.f4 / distance_step)) };
+    indices_linear.clear ();
+    for (size_t k = 0; k < features->points.size (); ++k)
+    {
+      const PPFSignature &f = features->points[k];
+      if (pcl_isfinite (f.f1) &&
+          static_cast<int> (floor (f.f1 / angle_step)) == d[0] && static_cast<int> (floor (f.f2 / angle_step)) == d[1] &&
+          static_cast<int> (floor (f.f3 / angle_step)) == d[2] && static_cast<int> (floor (f.f4 / distance_step)) == d[3])
+        indices_linear.push_back (std::pair<size_t, size_t> (k / n, k % n));
+    }
+
+    search_serial.nearestNeighborSearch (query.f1, query.f2, query.f3, query.f4, indices_serial);
+    search_parallel.nearestNeighborSearch (query.f1, query.f2, query.f3, query.f4, indices_parallel);
+    std::sort (indices_serial.begin (), indices_serial.end ());
+    EXPECT_EQ (indices_serial, indices_linear);
+    EXPECT_EQ (indices_parallel, indices_serial);
+    EXPECT_EQ (search_parallel.alpha_m_[q / n][q % n], query.alpha_m);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PPFHashMapSearchBinary)
+{
+  PointCloud<PointXYZ>::Ptr cloud_model (cloud_source.makeShared ());
+  NormalEstimation<PointXYZ, Normal> normal_estimation;
+  normal_estimation.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ> ()));
+  normal_estimation.setKSearch (10);
+  normal_estimation.setInputCloud (cloud_model);
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  normal_estimation.compute (*normals);
+
+  PPFEstimation<PointXYZ, Normal, PPFSignature> ppf_estimator;
+  PointCloud<PPFSignature>::Ptr features (new PointCloud<PPFSignature> ());
+  ppf_estimator.setInputCloud (cloud_model);
+  ppf_estimator.setInputNormals (normals);
+  ppf_estimator.compute (*features);
+
+  PPFHashMapSearch search (12.0f / 180.0f * static_cast<float> (M_PI), 0.005f);
+  EXPECT_FALSE (search.saveBinary ("ppf_hash_map.bin"));
+  search.setInputFeatureCloud (features);
+  EXPECT_TRUE (search.saveBinary ("ppf_hash_map.bin"));
+
+  // The steps given to the constructor are replaced by the saved ones
+  PPFHashMapSearch loaded (1.0f, 1.0f);
+  ASSERT_TRUE (loaded.loadBinary ("ppf_hash_map.bin"));
+  EXPECT_EQ (loaded.getAngleDiscretizationStep (), search.getAngleDiscretizationStep ());
+  EXPECT_EQ (loaded.getDistanceDiscretizationStep (), search.getDistanceDiscretizationStep ());
+  EXPECT_EQ (loaded.getModelDiameter (), search.getModelDiameter ());
+  // The angles of the identity pairs are NaN, so compare the bits
+  ASSERT_EQ (loaded.alpha_m_.size (), search.alpha_m_.size ());
+  for (size_t i = 0; i < search.alpha_m_.size (); ++i)
+  {
+    ASSERT_EQ (loaded.alpha_m_[i].size (), search.alpha_m_[i].size ());
+    EXPECT_EQ (memcmp (&loaded.alpha_m_[i][0], &search.alpha_m_[i][0], search.alpha_m_[i].size () * sizeof (float)), 0);
+  }
+
+  std::vector<std::pair<size_t, size_t> > indices, loaded_indices;
+  for (size_t q = 1; q < features->points.size (); q += 97)
+  {
+    PPFSignature query = features->points[q];
+    if (!pcl_isfinite (query.f1))
+      continue;
+    search.nearestNeighborSearch (query.f1, query.f2, query.f3, query.f4, indices);
+    loaded.nearestNeighborSearch (query.f1, query.f2, query.f3, query.f4, loaded_indices);
+    EXPECT_FALSE (indices.empty ());
+    EXPECT_EQ (loaded_indices, indices);
+  }
+
+  // Truncated or foreign data is rejected, and leaves the search structure as it was
+  std::stringstream stream;
+  ASSERT_TRUE (search.saveBinary (stream));
+  std::stringstream truncated (stream.str ().substr (0, stream.str ().size () / 2));
+  std::stringstream foreign ("# .PCD v0.7 - Point Cloud Data file format");
+  EXPECT_FALSE (loaded.loadBinary (truncated));
+  EXPECT_FALSE (loaded.loadBinary (foreign));
+  std::stringstream header_only (stream.str ().substr (0, 48));
+  EXPECT_FALSE (loaded.loadBinary (header_only));
+
+  // Headers declaring sizes which do not fit in the file are rejected before anything is allocated:
+  // nr_model_points, nr_buckets and nr_entries are stored after the magic, version and byte order
+  const uint64_t huge_sizes[][3] = { { uint64_t (1) << 32, 1, 0 },                             // n * n overflows to 0
+                                     { 1000000, 1, uint64_t (1000000) * 1000000 },             // n * n entries
+                                     { 1, uint64_t (1) << 60, 1 } };                           // buckets
+  for (size_t i = 0; i < sizeof (huge_sizes) / sizeof (huge_sizes[0]); ++i)
+  {
+    std::string data = stream.str ();
+    memcpy (&data[16], huge_sizes[i], sizeof (huge_sizes[i]));
+    std::stringstream huge (data);
+    EXPECT_FALSE (loaded.loadBinary (huge));
+  }
+  EXPECT_FALSE (loaded.loadBinary ("ppf_hash_map_missing.bin"));
+  EXPECT_EQ (loaded.getModelDiameter (), search.getModelDiameter ());
+  loaded.nearestNeighborSearch (features->points[1].f1, features->points[1].f2, features->points[1].f3, features->points[1].f4,
+                                loaded_indices);
+  search.nearestNeighborSearch (features->points[1].f1, features->points[1].f2, features->points[1].f3, features->points[1].f4,
+                                indices);
+  EXPECT_EQ (loaded_indices, indices);
+
+  remove ("ppf_hash_map.bin");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PPFRegistrationThreads)
+{
+  // Use the same cloud, rotated and translated, as the scene
+  PointCloud<PointXYZ>::Ptr cloud_model (cloud_source.makeShared ()), cloud_scene (new PointCloud<PointXYZ>);
+  Eigen::Affine3f scene_pose (Eigen::Translation3f (0.1f, 0.0f, 0.0f) * Eigen::AngleAxisf (0.5f, Eigen::Vector3f::UnitZ ()));
+  transformPointCloud (*cloud_model, *cloud_scene, scene_pose);
+
+  NormalEstimation<PointXYZ, Normal> normal_estimation;
+  normal_estimation.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ> ()));
+  normal_estimation.setKSearch (10);
+  PointCloud<Normal>::Ptr normals_model (new PointCloud<Normal> ()), normals_scene (new PointCloud<Normal> ());
+  normal_estimation.setInputCloud (cloud_model);
+  normal_estimation.compute (*normals_model);
+  normal_estimation.setInputCloud (cloud_scene);
+  normal_estimation.compute (*normals_scene);
+
+  PointCloud<PointNormal>::Ptr model (new PointCloud<PointNormal> ()), scene (new PointCloud<PointNormal> ());
+  concatenateFields (*cloud_model, *normals_model, *model);
+  concatenateFields (*cloud_scene, *normals_scene, *scene);
+
+  PPFEstimation<PointXYZ, Normal, PPFSignature> ppf_estimator;
+  PointCloud<PPFSignature>::Ptr features (new PointCloud<PPFSignature> ());
+  ppf_estimator.setInputCloud (cloud_model);
+  ppf_estimator.setInputNormals (normals_model);
+  ppf_estimator.compute (*features);
+
+  PPFHashMapSearch::Ptr hash_map_search (new PPFHashMapSearch (12.0f / 180.0f * static_cast<float> (M_PI), 0.005f));
+  hash_map_search->setInputFeatureCloud (features);
+
+  // The votes of every scene reference point do not depend on the thread that cast them
+  Eigen::Matrix4f transformation[2];
+  for (int t = 0; t < 2; ++t)
+  {
+    PPFRegistration<PointNormal, PointNormal> ppf_registration;
+    ppf_registration.setNumberOfThreads (t == 0 ? 1 : 4);
+    ppf_registration.setSceneReferencePointSamplingRate (10);
+    ppf_registration.setPositionClusteringThreshold (0.01f);
+    ppf_registration.setRotationClusteringThreshold (20.0f / 180.0f * static_cast<float> (M_PI));
+    ppf_registration.setSearchMethod (hash_map_search);
+    ppf_registration.setInputCloud (model);
+    ppf_registration.setInputTarget (scene);
+
+    PointCloud<PointNormal> cloud_output;
+    ppf_registration.align (cloud_output);
+    EXPECT_TRUE (ppf_registration.hasConverged ());
+    transformation[t] = ppf_registration.getFinalTransformation ();
+  }
+  EXPECT_EQ (transformation[0], transformation[1]);
+}
+
 // Suat G: disabled, since the transformation does not look correct.
 // ToDo: update transformation from the ground truth.
 #if 0
@@ -102,6 +102,43 @@ TEST (PCL, CorrespondenceEstimationReciprocal)
       EXPECT_EQ ((*correspondences)[i].index_match, correspondences_reciprocal[i][1]);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, CorrespondenceEstimationThreads)
+{
+  pcl::PointCloud<pcl::PointXYZ>::Ptr source (new pcl::PointCloud<pcl::PointXYZ>(cloud_source));
+  pcl::PointCloud<pcl::PointXYZ>::Ptr target (new pcl::PointCloud<pcl::PointXYZ>(cloud_target));
+
+  pcl::registration::CorrespondenceEstimation<pcl::PointXYZ, pcl::PointXYZ> corr_est;
+  corr_est.setInputCloud (source);
+  corr_est.setInputTarget (target);
+
+  // The correspondences must not depend on the number of threads, neither in content nor in order
+  pcl::Correspondences serial, serial_reciprocal, parallel, parallel_reciprocal;
+  corr_est.setNumberOfThreads (1);
+  corr_est.determineCorrespondences (serial, 0.01);
+  corr_est.determineReciprocalCorrespondences (serial_reciprocal);
+  corr_est.setNumberOfThreads (4);
+  corr_est.determineCorrespondences (parallel, 0.01);
+  corr_est.determineReciprocalCorrespondences (parallel_reciprocal);
+
+  EXPECT_LT (serial.size (), source->points.size ());
+  ASSERT_EQ (serial.size (), parallel.size ());
+  for (size_t i = 0; i < serial.size (); ++i)
+  {
+    EXPECT_EQ (serial[i].index_query, parallel[i].index_query);
+    EXPECT_EQ (serial[i].index_match, parallel[i].index_match);
+    EXPECT_EQ (serial[i].distance, parallel[i].distance);
+  }
+
+  EXPECT_EQ (int (serial_reciprocal.size ()), nr_reciprocal_correspondences);
+  ASSERT_EQ (serial_reciprocal.size (), parallel_reciprocal.size ());
+  for (size_t i = 0; i < serial_reciprocal.size (); ++i)
+  {
+    EXPECT_EQ (serial_reciprocal[i].index_query, parallel_reciprocal[i].index_query);
+    EXPECT_EQ (serial_reciprocal[i].index_match, parallel_reciprocal[i].index_match);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, CorrespondenceRejectorDistance)
 {
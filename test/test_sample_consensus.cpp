@@ -46,6 +46,7 @@
 #include <pcl/sample_consensus/msac.h>
 #include <pcl/sample_consensus/rmsac.h>
 #include <pcl/sample_consensus/mlesac.h>
+#include <pcl/sample_consensus/sprt.h>
 #include <pcl/sample_consensus/sac_model.h>
 #include <pcl/sample_consensus/sac_model_plane.h>
 #include <pcl/sample_consensus/sac_model_sphere.h>
@@ -58,6 +59,8 @@
 #include <pcl/sample_consensus/sac_model_parallel_plane.h>
 #include <pcl/sample_consensus/sac_model_normal_parallel_plane.h>
 #include <pcl/features/normal_3d.h>
+#include <pcl/common/centroid.h>
+#include <pcl/common/distances.h>
 
 using namespace pcl;
 using namespace pcl::io;
@@ -131,6 +134,33 @@ void verifyPlaneSac (ModelType & model, SacType & sac, unsigned int inlier_numbe
   EXPECT_NEAR (proj_points.points[50].z,  0.0587, refined_tol);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename SacType>
+void compareThreadedPlaneSac (SacType &serial, SacType &parallel, float tol = 5e-2f, float inliers_tol = 5e-2f)
+{
+  srand (0);
+  serial.setNumberOfThreads (1);
+  ASSERT_TRUE (serial.computeModel ());
+  srand (0);
+  parallel.setNumberOfThreads (4);
+  ASSERT_TRUE (parallel.computeModel ());
+
+  Eigen::VectorXf coeff, coeff_parallel;
+  serial.getModelCoefficients (coeff);
+  parallel.getModelCoefficients (coeff_parallel);
+  ASSERT_EQ (int (coeff_parallel.size ()), 4);
+  // The same plane can be given with opposite normals
+  if (coeff.dot (coeff_parallel) < 0)
+    coeff_parallel = -coeff_parallel;
+  for (int i = 0; i < 4; ++i)
+    EXPECT_NEAR (coeff_parallel[i], coeff[i], tol);
+
+  std::vector<int> inliers, inliers_parallel;
+  serial.getInliers (inliers);
+  parallel.getInliers (inliers_parallel);
+  EXPECT_NEAR (double (inliers_parallel.size ()), double (inliers.size ()), inliers_tol * double (inliers.size ()));
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (SampleConsensusModelPlane, Base)
 {
@@ -155,6 +185,93 @@ TEST (SampleConsensusModelPlane, Base)
   ASSERT_EQ (indices->size (), indices_.size ());
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename ModelPtr> void
+verifyDistanceKernels (const ModelPtr &model, const Eigen::VectorXf &coefficients, const std::vector<double> &expected)
+{
+  std::vector<double> distances;
+  model->getDistancesToModel (coefficients, distances);
+  ASSERT_EQ (expected.size (), distances.size ());
+  for (size_t i = 0; i < distances.size (); ++i)
+    EXPECT_NEAR (expected[i], distances[i], 1e-4);
+
+  // Use the median distance as threshold, and check that the inliers are consistent with the distances
+  std::vector<double> sorted_distances (distances);
+  std::nth_element (sorted_distances.begin (), sorted_distances.begin () + sorted_distances.size () / 2, sorted_distances.end ());
+  double threshold = sorted_distances[sorted_distances.size () / 2];
+  std::vector<int> expected_inliers;
+  for (size_t i = 0; i < distances.size (); ++i)
+    if (distances[i] < threshold)
+      expected_inliers.push_back ((*model->getIndices ())[i]);
+
+  std::vector<int> inliers;
+  model->selectWithinDistance (coefficients, threshold, inliers);
+  EXPECT_GT (inliers.size (), 0);
+  EXPECT_EQ (expected_inliers, inliers);
+  EXPECT_EQ (int (inliers.size ()), model->countWithinDistance (coefficients, threshold));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (SampleConsensusModel, DistanceKernels)
+{
+  // An odd number of shuffled indices goes through both the SIMD packets and the remaining points
+  boost::shared_ptr<vector<int> > indices (new vector<int>);
+  for (size_t i = 0; i < indices_.size (); i += 3)
+    indices->push_back (indices_[i]);
+  if (indices->size () % 2 == 0)
+    indices->pop_back ();
+  std::reverse (indices->begin (), indices->end ());
+
+  Eigen::Vector4f centroid;
+  compute3DCentroid (*cloud_, *indices, centroid);
+  std::vector<double> expected (indices->size ());
+
+  Eigen::VectorXf plane (4);
+  plane << plane_coeffs_[0], plane_coeffs_[1], plane_coeffs_[2], 1.0f;
+  plane /= plane.head<3> ().norm ();
+  for (size_t i = 0; i < indices->size (); ++i)
+  {
+    const PointXYZ &p = cloud_->points[(*indices)[i]];
+    expected[i] = fabs (plane.dot (Eigen::Vector4f (p.x, p.y, p.z, 1)));
+  }
+  SampleConsensusModelPlanePtr plane_model (new SampleConsensusModelPlane<PointXYZ> (cloud_, *indices));
+  verifyDistanceKernels (plane_model, plane, expected);
+
+  Eigen::VectorXf sphere (4);
+  sphere << centroid[0], centroid[1], centroid[2], 0.1f;
+  for (size_t i = 0; i < indices->size (); ++i)
+    expected[i] = fabs ((cloud_->points[(*indices)[i]].getVector3fMap () - sphere.head<3> ()).norm () - sphere[3]);
+  SampleConsensusModelSpherePtr sphere_model (new SampleConsensusModelSphere<PointXYZ> (cloud_, *indices));
+  verifyDistanceKernels (sphere_model, sphere, expected);
+
+  Eigen::VectorXf line (6);
+  line << centroid[0], centroid[1], centroid[2], 0.2f, 1.0f, -0.3f;
+  Eigen::Vector4f line_pt (line[0], line[1], line[2], 0), line_dir (line[3], line[4], line[5], 0);
+  for (size_t i = 0; i < indices->size (); ++i)
+    expected[i] = sqrt (sqrPointToLineDistance (cloud_->points[(*indices)[i]].getVector4fMap (), line_pt, line_dir));
+  SampleConsensusModelLinePtr line_model (new SampleConsensusModelLine<PointXYZ> (cloud_, *indices));
+  verifyDistanceKernels (line_model, line, expected);
+
+  Eigen::VectorXf cylinder (7);
+  cylinder << centroid[0], centroid[1], centroid[2], 0.2f, 1.0f, -0.3f, 0.05f;
+  const double weight = 0.1;
+  for (size_t i = 0; i < indices->size (); ++i)
+  {
+    Eigen::Vector4f pt = cloud_->points[(*indices)[i]].getVector4fMap ();
+    pt[3] = 0;
+    Eigen::Vector4f n (normals_->points[(*indices)[i]].normal_x, normals_->points[(*indices)[i]].normal_y, normals_->points[(*indices)[i]].normal_z, 0);
+    double d_euclid = fabs (sqrt (sqrPointToLineDistance (pt, line_pt, line_dir)) - cylinder[6]);
+    Eigen::Vector4f dir = pt - (line_pt + (pt - line_pt).dot (line_dir) / line_dir.dot (line_dir) * line_dir);
+    double d_normal = getAngle3D (n, dir);
+    d_normal = (std::min) (d_normal, M_PI - d_normal);
+    expected[i] = fabs (weight * d_normal + (1 - weight) * d_euclid);
+  }
+  SampleConsensusModelCylinderPtr cylinder_model (new SampleConsensusModelCylinder<PointXYZ, Normal> (cloud_, *indices));
+  cylinder_model->setInputNormals (normals_);
+  cylinder_model->setNormalDistanceWeight (weight);
+  verifyDistanceKernels (cylinder_model, cylinder, expected);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (RANSAC, Base)
 {
@@ -247,6 +364,72 @@ TEST (RMSAC, SampleConsensusModelPlane)
   verifyPlaneSac(model, sac, 600, 1.0f, 1.0f, 0.01f);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (SPRT, SampleConsensusModelPlane)
+{
+  srand (0);
+  // Create a shared plane model pointer directly
+  SampleConsensusModelPlanePtr model (new SampleConsensusModelPlane<PointXYZ> (cloud_));
+
+  // Counting the inliers of a subset must agree with the full count
+  std::vector<int> samples;
+  int iterations = 0;
+  Eigen::VectorXf coeff;
+  model->getSamples (iterations, samples);
+  ASSERT_TRUE (model->computeModelCoefficients (samples, coeff));
+  boost::shared_ptr<vector<int> > subset (new vector<int> (model->getIndices ()->begin (), model->getIndices ()->begin () + 100));
+  int nr_subset = model->countIndicesWithinDistance (coeff, 0.03, subset);
+  EXPECT_EQ (model->getIndices ()->size (), cloud_->points.size ());
+  EXPECT_EQ (nr_subset, model->countIndicesWithinDistance (coeff, 0.03, model->getIndices ()) -
+                        model->countIndicesWithinDistance (coeff, 0.03, boost::shared_ptr<vector<int> > (new vector<int> (
+                          model->getIndices ()->begin () + 100, model->getIndices ()->end ()))));
+  EXPECT_EQ (model->countWithinDistance (coeff, 0.03), model->countIndicesWithinDistance (coeff, 0.03, model->getIndices ()));
+
+  // Create the SPRT object
+  SPRTSampleConsensus<PointXYZ> sac (model, 0.03);
+  sac.setBlockSize (32);
+  ASSERT_EQ (sac.getBlockSize (), 32u);
+
+  verifyPlaneSac (model, sac);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (SAC, MultiThreaded)
+{
+  // Create a shared plane model pointer directly
+  SampleConsensusModelPlanePtr model (new SampleConsensusModelPlane<PointXYZ> (cloud_));
+
+  RandomSampleConsensus<PointXYZ> ransac (model, 0.03);
+  ransac.setNumberOfThreads (4);
+  ASSERT_EQ (ransac.getNumberOfThreads (), 4u);
+  verifyPlaneSac (model, ransac);
+
+  LeastMedianSquares<PointXYZ> lmeds (model, 0.03);
+  lmeds.setNumberOfThreads (4);
+  verifyPlaneSac (model, lmeds);
+
+  MEstimatorSampleConsensus<PointXYZ> msac (model, 0.03);
+  msac.setNumberOfThreads (4);
+  verifyPlaneSac (model, msac);
+
+  // The best hypothesis depends on the thread schedule, but it has to be as good as the single threaded one
+  RandomSampleConsensus<PointXYZ> ransac_serial (SampleConsensusModelPlanePtr (new SampleConsensusModelPlane<PointXYZ> (cloud_)), 0.03);
+  RandomSampleConsensus<PointXYZ> ransac_parallel (SampleConsensusModelPlanePtr (new SampleConsensusModelPlane<PointXYZ> (cloud_)), 0.03);
+  compareThreadedPlaneSac (ransac_serial, ransac_parallel);
+
+  MEstimatorSampleConsensus<PointXYZ> msac_serial (SampleConsensusModelPlanePtr (new SampleConsensusModelPlane<PointXYZ> (cloud_)), 0.03);
+  MEstimatorSampleConsensus<PointXYZ> msac_parallel (SampleConsensusModelPlanePtr (new SampleConsensusModelPlane<PointXYZ> (cloud_)), 0.03);
+  compareThreadedPlaneSac (msac_serial, msac_parallel);
+
+  // With the default pre-test fraction (10%) nearly every hypothesis is rejected once k is set, so that
+  // RMSAC keeps whichever model came first: use a pre-test of a few points
+  RandomizedMEstimatorSampleConsensus<PointXYZ> rmsac_serial (SampleConsensusModelPlanePtr (new SampleConsensusModelPlane<PointXYZ> (cloud_)), 0.03);
+  RandomizedMEstimatorSampleConsensus<PointXYZ> rmsac_parallel (SampleConsensusModelPlanePtr (new SampleConsensusModelPlane<PointXYZ> (cloud_)), 0.03);
+  rmsac_serial.setFractionNrPretest (0.1);
+  rmsac_parallel.setFractionNrPretest (0.1);
+  compareThreadedPlaneSac (rmsac_serial, rmsac_parallel);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (RANSAC, SampleConsensusModelNormalParallelPlane)
 {
@@ -65,6 +65,8 @@ using namespace std;
 #define TEST_ORGANIZED_SPARSE_VIEW_KNN                1
 #define TEST_ORGANIZED_SPARSE_COMPLETE_RADIUS         1
 #define TEST_ORGANIZED_SPARSE_VIEW_RADIUS             1
+#define TEST_unorganized_sparse_cloud_BATCH           1
+#define TEST_ORGANIZED_SPARSE_BATCH                   1
 
 #if EXCESSIVE_TESTING
 /** \brief number of points used for creating unordered point clouds */
@@ -411,6 +413,71 @@ testRadiusSearch (typename PointCloud<PointT>::ConstPtr point_cloud, vector<sear
   }
 }
 
+/** \brief does batched KNN and radius search with different numbers of threads and tests whether the results are
+  * identical to the ones returned by the corresponding single query searches
+  * \param cloud the input point cloud
+  * \param search_methods vector of all search methods to be tested
+  * \param query_indices indices of query points in the point cloud
+  */
+template<typename PointT> void
+testBatchSearch (typename PointCloud<PointT>::ConstPtr point_cloud, vector<search::Search<PointT>*> search_methods,
+                 const vector<int>& query_indices)
+{
+  for (size_t sIdx = 0; sIdx < search_methods.size (); ++sIdx)
+  {
+    search::Search<PointT>& search = *search_methods [sIdx];
+    search.setInputCloud (point_cloud);
+
+    vector<int> indices;
+    vector<float> distances;
+    bool passed = true;
+    for (unsigned threads = 1; threads <= 4; threads += 3)
+    {
+      search.setNumberOfThreads (threads);
+
+      search::Neighborhoods knn;
+      search.nearestKSearch (*point_cloud, query_indices, 8, knn);
+      passed = passed && knn.size () == query_indices.size ();
+      for (size_t qIdx = 0; passed && qIdx < query_indices.size (); ++qIdx)
+      {
+        indices.clear ();
+        distances.clear ();
+        if (isFinite (point_cloud->points [query_indices [qIdx]]))
+          search.nearestKSearch (point_cloud->points [query_indices [qIdx]], 8, indices, distances);
+        passed = knn.getNumberOfNeighbors (qIdx) == indices.size () &&
+                 equal (indices.begin (), indices.end (), knn.indices.begin () + knn.offsets [qIdx]) &&
+                 equal (distances.begin (), distances.end (), knn.sqr_distances.begin () + knn.offsets [qIdx]);
+      }
+
+      // an empty index list queries every point of the cloud
+      search::Neighborhoods radius;
+      search.radiusSearch (*point_cloud, vector<int> (), 0.04, radius);
+      passed = passed && radius.size () == point_cloud->size ();
+      for (size_t qIdx = 0; passed && qIdx < point_cloud->size (); ++qIdx)
+      {
+        indices.clear ();
+        distances.clear ();
+        if (isFinite (point_cloud->points [qIdx]))
+          search.radiusSearch (point_cloud->points [qIdx], 0.04, indices, distances);
+        passed = radius.getNumberOfNeighbors (qIdx) == indices.size () &&
+                 equal (indices.begin (), indices.end (), radius.indices.begin () + radius.offsets [qIdx]) &&
+                 equal (distances.begin (), distances.end (), radius.sqr_distances.begin () + radius.offsets [qIdx]);
+      }
+    }
+    search.setNumberOfThreads (0);
+
+    // a number of threads given to the batch search itself leaves the one of the search method untouched
+    search::Neighborhoods knn_1, knn_3;
+    search.nearestKSearch (*point_cloud, query_indices, 8, knn_1, 1);
+    search.nearestKSearch (*point_cloud, query_indices, 8, knn_3, 3);
+    passed = passed && knn_1.offsets == knn_3.offsets && knn_1.indices == knn_3.indices &&
+             search.getNumberOfThreads () == 0;
+
+    cout << search.getName () << ": " << (passed?"passed":"failed") << endl;
+    EXPECT_TRUE (passed);
+  }
+}
+
 #if TEST_unorganized_dense_cloud_COMPLETE_KNN
 // Test search on unorganized point clouds
 TEST (PCL, unorganized_dense_cloud_Complete_KNN)
@@ -517,6 +584,20 @@ TEST (PCL, Organized_Sparse_View_Radius)
 }
 #endif
 
+#if TEST_unorganized_sparse_cloud_BATCH
+TEST (PCL, unorganized_sparse_cloud_Batch)
+{
+  testBatchSearch (unorganized_sparse_cloud, unorganized_search_methods, unorganized_sparse_cloud_query_indices);
+}
+#endif
+
+#if TEST_ORGANIZED_SPARSE_BATCH
+TEST (PCL, Organized_Sparse_Batch)
+{
+  testBatchSearch (organized_sparse_cloud, organized_search_methods, organized_sparse_query_indices);
+}
+#endif
+
 /** \brief create subset of point in cloud to use as query points
   * \param[out] query_indices resulting query indices - not guaranteed to have size of query_count but guaranteed not to exceed that value
   * \param cloud input cloud required to check for nans and to get number of points
@@ -43,8 +43,11 @@
 #include <pcl/point_cloud.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/search/search.h>
+#include <pcl/search/kdtree.h>
 #include <pcl/features/normal_3d.h>
 
+#include <pcl/segmentation/extract_clusters.h>
+#include <pcl/segmentation/extract_voxel_clusters.h>
 #include <pcl/segmentation/extract_polygonal_prism_data.h>
 #include <pcl/segmentation/segment_differences.h>
 #include <pcl/segmentation/region_growing.h>
@@ -386,6 +389,75 @@ TEST (ExtractPolygonalPrism, Segmentation)
   EXPECT_EQ (static_cast<int> (output.indices.size ()), 0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (EuclideanClusterExtraction, Parallel)
+{
+  search::KdTree<PointXYZ>::Ptr tree (new search::KdTree<PointXYZ>);
+
+  EuclideanClusterExtraction<PointXYZ> ec;
+  ec.setInputCloud (cloud_);
+  ec.setSearchMethod (tree);
+  ec.setClusterTolerance (0.005);
+  ec.setMinClusterSize (5);
+
+  std::vector<PointIndices> serial_clusters;
+  ec.extract (serial_clusters);
+  EXPECT_GT (static_cast<int> (serial_clusters.size ()), 0);
+
+  for (unsigned int nr_threads = 0; nr_threads <= 4; nr_threads += 2)
+  {
+    ec.setNumberOfThreads (nr_threads);
+    std::vector<PointIndices> parallel_clusters;
+    ec.extract (parallel_clusters);
+
+    ASSERT_EQ (serial_clusters.size (), parallel_clusters.size ());
+    for (size_t i = 0; i < serial_clusters.size (); ++i)
+      EXPECT_EQ (serial_clusters[i].indices, parallel_clusters[i].indices);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelEuclideanClusterExtraction, Segmentation)
+{
+  EuclideanClusterExtraction<PointXYZ> ec;
+  ec.setInputCloud (cloud_);
+  ec.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  ec.setClusterTolerance (0.005);
+  ec.setMinClusterSize (5);
+  std::vector<PointIndices> ec_clusters;
+  ec.extract (ec_clusters);
+
+  VoxelEuclideanClusterExtraction<PointXYZ> vc;
+  vc.setInputCloud (cloud_);
+  vc.setClusterTolerance (0.005);
+  vc.setMinClusterSize (5);
+
+  // Checking the distances inside the voxels gives the exact clusters
+  vc.setApproximate (false);
+  std::vector<PointIndices> exact_clusters;
+  vc.extract (exact_clusters);
+  ASSERT_EQ (ec_clusters.size (), exact_clusters.size ());
+  for (size_t i = 0; i < ec_clusters.size (); ++i)
+    EXPECT_EQ (ec_clusters[i].indices, exact_clusters[i].indices);
+
+  // The approximation can only merge clusters
+  vc.setMinClusterSize (1);
+  vc.extract (exact_clusters);
+  vc.setApproximate (true);
+  std::vector<PointIndices> approximate_clusters;
+  vc.extract (approximate_clusters);
+  EXPECT_LE (approximate_clusters.size (), exact_clusters.size ());
+
+  std::vector<int> labels (cloud_->points.size (), -1);
+  for (size_t i = 0; i < approximate_clusters.size (); ++i)
+    for (size_t j = 0; j < approximate_clusters[i].indices.size (); ++j)
+      labels[approximate_clusters[i].indices[j]] = static_cast<int> (i);
+  for (size_t i = 0; i < exact_clusters.size (); ++i)
+    for (size_t j = 0; j < exact_clusters[i].indices.size (); ++j)
+      EXPECT_EQ (labels[exact_clusters[i].indices[0]], labels[exact_clusters[i].indices[j]]);
+  EXPECT_EQ (static_cast<int> (std::count (labels.begin (), labels.end (), -1)), 0);
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
@@ -0,0 +1,189 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <sensor_msgs/PointCloud2.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <pcl/sample_consensus/sac_model_plane.h>
+#include <pcl/sample_consensus/sac_model_sphere.h>
+#include <pcl/sample_consensus/sac_model_line.h>
+#include <pcl/sample_consensus/sac_model_cylinder.h>
+#include <pcl/sample_consensus/sac_model_simd.h>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace pcl::console;
+
+int default_hypotheses = 200;
+double default_threshold = 0.01;
+double min_time = 500.0;
+
+void
+printHelp (int, char **argv)
+{
+  print_error ("Syntax is: %s input.pcd <options>\n", argv[0]);
+  print_info ("  where options are:\n");
+  print_info ("                     -hypotheses X = the number of random models to count the inliers of (default: "); 
+  print_value ("%d", default_hypotheses); print_info (")\n");
+  print_info ("                     -threshold X  = the inlier distance threshold (default: "); 
+  print_value ("%f", default_threshold); print_info (")\n");
+  print_info ("  The cylinder model is only benchmarked if the input has normals.\n");
+}
+
+bool
+loadCloud (const std::string &filename, sensor_msgs::PointCloud2 &cloud)
+{
+  TicToc tt;
+  print_highlight ("Loading "); print_value ("%s ", filename.c_str ());
+
+  tt.tic ();
+  if (loadPCDFile (filename, cloud) < 0)
+    return (false);
+  print_info ("[done, "); print_value ("%g", tt.toc ()); print_info (" ms : "); print_value ("%d", cloud.width * cloud.height); print_info (" points]\n");
+  print_info ("Available dimensions: "); print_value ("%s\n", pcl::getFieldsList (cloud).c_str ());
+
+  return (true);
+}
+
+template <typename ModelT> void
+benchmark (const std::string &name, ModelT &model, int nr_hypotheses, double threshold)
+{
+  // Draw the hypotheses first, so that only the inlier counting is timed
+  std::vector<Eigen::VectorXf> hypotheses;
+  std::vector<int> samples;
+  Eigen::VectorXf coefficients;
+  int iterations = 0;
+  for (int i = 0; i < 10 * nr_hypotheses && static_cast<int> (hypotheses.size ()) < nr_hypotheses; ++i)
+  {
+    model.getSamples (iterations, samples);
+    if (!samples.empty () && model.computeModelCoefficients (samples, coefficients))
+      hypotheses.push_back (coefficients);
+  }
+  if (hypotheses.empty ())
+  {
+    print_warn ("Could not fit any %s model to the input.\n", name.c_str ());
+    return;
+  }
+
+  // Repeat the whole set until the timing is meaningful for small clouds
+  TicToc tt;
+  tt.tic ();
+  size_t nr_inliers = 0;
+  int nr_rounds = 0;
+  double time = 0;
+  do
+  {
+    for (size_t i = 0; i < hypotheses.size (); ++i)
+      nr_inliers += model.countWithinDistance (hypotheses[i], threshold);
+    ++nr_rounds;
+    time = tt.toc ();
+  }
+  while (time < min_time);
+
+  double nr_models = static_cast<double> (nr_rounds) * static_cast<double> (hypotheses.size ());
+  double nr_points = nr_models * static_cast<double> (model.getIndices ()->size ());
+  print_highlight ("%-8s ", name.c_str ());
+  print_value ("%g", nr_models); print_info (" models in "); print_value ("%g", time); print_info (" ms : ");
+  print_value ("%.1f", nr_points / time / 1000.0); print_info (" Mpoints/s, ");
+  print_value ("%.1f", static_cast<double> (nr_inliers) / nr_models); print_info (" inliers per model\n");
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  print_info ("Measure the inlier counting throughput of the sample consensus models. For more information, use: %s -h\n", argv[0]);
+
+  if (argc < 2)
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  // Parse the command line arguments for .pcd files
+  std::vector<int> p_file_indices = parse_file_extension_argument (argc, argv, ".pcd");
+  if (p_file_indices.size () != 1)
+  {
+    print_error ("Need one input PCD file to continue.\n");
+    return (-1);
+  }
+
+  // Command line parsing
+  int nr_hypotheses = default_hypotheses;
+  double threshold = default_threshold;
+  parse_argument (argc, argv, "-hypotheses", nr_hypotheses);
+  parse_argument (argc, argv, "-threshold", threshold);
+
+#if defined __AVX__
+  print_info ("Distance kernels: "); print_value ("AVX"); print_info (", %d points per packet\n", int (detail::SAC_PACKET_SIZE));
+#elif defined __SSE2__
+  print_info ("Distance kernels: "); print_value ("SSE2"); print_info (", %d points per packet\n", int (detail::SAC_PACKET_SIZE));
+#else
+  print_info ("Distance kernels: "); print_value ("scalar\n");
+#endif
+
+  // Load the input file
+  sensor_msgs::PointCloud2 blob;
+  if (!loadCloud (argv[p_file_indices[0]], blob)) 
+    return (-1);
+  PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
+  fromROSMsg (blob, *cloud);
+
+  SampleConsensusModelPlane<PointXYZ> plane (cloud);
+  benchmark ("plane", plane, nr_hypotheses, threshold);
+  SampleConsensusModelSphere<PointXYZ> sphere (cloud);
+  benchmark ("sphere", sphere, nr_hypotheses, threshold);
+  SampleConsensusModelLine<PointXYZ> line (cloud);
+  benchmark ("line", line, nr_hypotheses, threshold);
+
+  if (pcl::getFieldIndex (blob, "normal_x") != -1)
+  {
+    PointCloud<Normal>::Ptr normals (new PointCloud<Normal>);
+    fromROSMsg (blob, *normals);
+    SampleConsensusModelCylinder<PointXYZ, Normal> cylinder (cloud);
+    cylinder.setInputNormals (normals);
+    cylinder.setNormalDistanceWeight (0.1);
+    benchmark ("cylinder", cylinder, nr_hypotheses, threshold);
+  }
+
+  return (0);
+}
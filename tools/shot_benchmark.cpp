@@ -0,0 +1,179 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <sensor_msgs/PointCloud2.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/shot.h>
+#include <pcl/features/shot_omp.h>
+#include <pcl/features/shot_lrf_omp.h>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace pcl::console;
+
+double default_radius = 0.01;
+int default_threads = 0;
+
+void
+printHelp (int, char **argv)
+{
+  print_error ("Syntax is: %s input.pcd <options>\n", argv[0]);
+  print_info ("  where options are:\n");
+  print_info ("                     -radius X  = the radius of the SHOT support, also used for the normals if the input has none (default: ");
+  print_value ("%f", default_radius); print_info (")\n");
+  print_info ("                     -threads X = the number of threads of the parallel estimators, 0 for automatic (default: ");
+  print_value ("%d", default_threads); print_info (")\n");
+}
+
+bool
+loadCloud (const std::string &filename, sensor_msgs::PointCloud2 &cloud)
+{
+  TicToc tt;
+  print_highlight ("Loading "); print_value ("%s ", filename.c_str ());
+
+  tt.tic ();
+  if (loadPCDFile (filename, cloud) < 0)
+    return (false);
+  print_info ("[done, "); print_value ("%g", tt.toc ()); print_info (" ms : "); print_value ("%d", cloud.width * cloud.height); print_info (" points]\n");
+  print_info ("Available dimensions: "); print_value ("%s\n", pcl::getFieldsList (cloud).c_str ());
+
+  return (true);
+}
+
+template <typename EstimatorT> void
+benchmark (const std::string &name, EstimatorT &estimator)
+{
+  // Use a fresh tree for every estimator, so that its construction is part of the measured time
+  estimator.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+
+  PointCloud<SHOT352> descriptors;
+  TicToc tt;
+  tt.tic ();
+  estimator.compute (descriptors);
+  double time = tt.toc ();
+
+  size_t nr_valid = 0;
+  for (size_t i = 0; i < descriptors.points.size (); ++i)
+    if (pcl_isfinite (descriptors.points[i].descriptor[0]))
+      ++nr_valid;
+
+  print_highlight ("%-28s ", name.c_str ());
+  print_value ("%d", static_cast<int> (descriptors.points.size ())); print_info (" descriptors in "); print_value ("%g", time); print_info (" ms : ");
+  print_value ("%.0f", static_cast<double> (descriptors.points.size ()) / time * 1000.0); print_info (" descriptors/s, ");
+  print_value ("%d", static_cast<int> (nr_valid)); print_info (" valid\n");
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  print_info ("Measure the throughput of the SHOT descriptor estimators. For more information, use: %s -h\n", argv[0]);
+
+  if (argc < 2)
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  // Parse the command line arguments for .pcd files
+  std::vector<int> p_file_indices = parse_file_extension_argument (argc, argv, ".pcd");
+  if (p_file_indices.size () != 1)
+  {
+    print_error ("Need one input PCD file to continue.\n");
+    return (-1);
+  }
+
+  // Command line parsing
+  double radius = default_radius;
+  int threads = default_threads;
+  parse_argument (argc, argv, "-radius", radius);
+  parse_argument (argc, argv, "-threads", threads);
+  print_info ("Using a radius of: "); print_value ("%f", radius); print_info (" and "); print_value ("%d", threads); print_info (" threads\n");
+
+  // Load the input file
+  sensor_msgs::PointCloud2 blob;
+  if (!loadCloud (argv[p_file_indices[0]], blob))
+    return (-1);
+  PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
+  fromROSMsg (blob, *cloud);
+
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal>);
+  if (pcl::getFieldIndex (blob, "normal_x") != -1)
+    fromROSMsg (blob, *normals);
+  else
+  {
+    NormalEstimationOMP<PointXYZ, Normal> ne (threads);
+    ne.setInputCloud (cloud);
+    ne.setRadiusSearch (radius);
+    ne.compute (*normals);
+  }
+
+  SHOTEstimation<PointXYZ, Normal, SHOT352> shot;
+  shot.setInputCloud (cloud);
+  shot.setInputNormals (normals);
+  shot.setRadiusSearch (radius);
+  benchmark ("serial", shot);
+  shot.setUseAngleLookupTable (true);
+  benchmark ("serial, angle table", shot);
+
+  SHOTEstimationOMP<PointXYZ, Normal, SHOT352> shot_omp (threads);
+  shot_omp.setInputCloud (cloud);
+  shot_omp.setInputNormals (normals);
+  shot_omp.setRadiusSearch (radius);
+  benchmark ("parallel", shot_omp);
+  shot_omp.setUseAngleLookupTable (true);
+  benchmark ("parallel, angle table", shot_omp);
+
+  // Reference frames computed beforehand, e.g. shared with another descriptor, are not part of the measured time
+  PointCloud<ReferenceFrame>::Ptr frames (new PointCloud<ReferenceFrame>);
+  SHOTLocalReferenceFrameEstimationOMP<PointXYZ, ReferenceFrame> lrf;
+  lrf.setNumberOfThreads (threads);
+  lrf.setInputCloud (cloud);
+  lrf.setRadiusSearch (radius);
+  lrf.compute (*frames);
+  shot_omp.setInputReferenceFrames (frames);
+  benchmark ("parallel, given frames", shot_omp);
+
+  return (0);
+}